@@ -0,0 +1,215 @@
+#include "AnalysisTap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+// Number of analysis frames published per second of sample data.
+constexpr long kFramesPerSecond = 60;
+
+// Number of analysis frames retained (this needs to cover the output latency).
+constexpr size_t kFrameCount = 128;
+
+// Duration over which the levels are calculated, in seconds.
+constexpr double kLevelSeconds = 0.05;
+
+// Duration of the sample history, in seconds (this needs to cover the output latency).
+constexpr double kHistorySeconds = 2.5;
+
+AnalysisTap::AnalysisTap( const long sampleRate, const uint32_t channels ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_HistoryChannels( std::min( channels, kMaxChannels ) ),
+	m_HopFrames( static_cast<size_t>( std::max( 1l, sampleRate / kFramesPerSecond ) ) ),
+	m_LevelFrames( static_cast<size_t>( std::max( 1.0, sampleRate * kLevelSeconds ) ) ),
+	m_HistoryFrames( std::bit_ceil( std::max( { static_cast<size_t>( std::max( 0.0, sampleRate * kHistorySeconds ) ), kFFTSize, m_LevelFrames } ) ) ),
+	m_History(),
+	m_Frames(),
+	m_FFT( kFFTSize, FFT::Window::Hann ),
+	m_FFTInput( kFFTSize )
+{
+	if ( ( sampleRate <= 0 ) || ( 0 == channels ) ) {
+		throw std::runtime_error( "AnalysisTap format not supported" );
+	}
+	m_History.resize( m_HistoryFrames * m_HistoryChannels, 0 );
+	m_Frames = std::make_unique<Frame[]>( kFrameCount );
+}
+
+AnalysisTap::~AnalysisTap()
+{
+}
+
+uint32_t AnalysisTap::GetChannels() const
+{
+	return m_Channels;
+}
+
+void AnalysisTap::Process( const float* buffer, const size_t frames )
+{
+	if ( nullptr == buffer ) {
+		return;
+	}
+	size_t framesRemaining = frames;
+	uint64_t writePosition = m_WritePosition.load( std::memory_order_relaxed );
+	while ( framesRemaining > 0 ) {
+		// Write up to the end of the current hop, so that each analysis frame is aligned to a hop boundary.
+		const size_t framesToWrite = std::min( framesRemaining, m_HopFrames - static_cast<size_t>( writePosition % m_HopFrames ) );
+		for ( size_t frame = 0; frame < framesToWrite; frame++, buffer += m_Channels ) {
+			float* history = m_History.data() + ( ( writePosition + frame ) & ( m_HistoryFrames - 1 ) ) * m_HistoryChannels;
+			std::copy( buffer, buffer + m_HistoryChannels, history );
+		}
+		framesRemaining -= framesToWrite;
+		writePosition += framesToWrite;
+		m_WritePosition.store( writePosition, std::memory_order_release );
+		if ( 0 == ( writePosition % m_HopFrames ) ) {
+			Analyse();
+		}
+	}
+}
+
+void AnalysisTap::Analyse()
+{
+	const uint64_t writePosition = m_WritePosition.load( std::memory_order_relaxed );
+	const uint64_t index = m_FrameCount.load( std::memory_order_relaxed );
+	Frame& frame = m_Frames[ index % kFrameCount ];
+
+	const uint64_t sequence = frame.Sequence.load( std::memory_order_relaxed );
+	frame.Sequence.store( sequence + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	frame.Position = writePosition;
+
+	// Levels.
+	const size_t levelFrames = static_cast<size_t>( std::min<uint64_t>( m_LevelFrames, writePosition ) );
+	std::array<float, 2> peak = {};
+	std::array<float, 2> sumSquares = {};
+	for ( uint64_t position = writePosition - levelFrames; position < writePosition; position++ ) {
+		const float* history = m_History.data() + ( position & ( m_HistoryFrames - 1 ) ) * m_HistoryChannels;
+		for ( uint32_t channel = 0; channel < m_HistoryChannels; channel++ ) {
+			const float sample = history[ channel ];
+			peak[ channel & 1 ] = std::max( peak[ channel & 1 ], std::fabs( sample ) );
+			sumSquares[ channel & 1 ] += sample * sample;
+		}
+	}
+	Levels& levels = frame.OutputLevels;
+	levels.LeftPeak = peak[ 0 ];
+	levels.LeftRMS = ( levelFrames > 0 ) ? std::sqrt( sumSquares[ 0 ] / ( levelFrames * ( ( m_HistoryChannels + 1 ) / 2 ) ) ) : 0;
+	if ( m_HistoryChannels > 1 ) {
+		levels.RightPeak = peak[ 1 ];
+		levels.RightRMS = ( levelFrames > 0 ) ? std::sqrt( sumSquares[ 1 ] / ( levelFrames * ( m_HistoryChannels / 2 ) ) ) : 0;
+	} else {
+		levels.RightPeak = levels.LeftPeak;
+		levels.RightRMS = levels.LeftRMS;
+	}
+
+	CalculateFFT( frame );
+
+	frame.Sequence.store( sequence + 2, std::memory_order_release );
+	m_FrameCount.store( index + 1, std::memory_order_release );
+}
+
+void AnalysisTap::CalculateFFT( Frame& frame )
+{
+	// Mix the most recent sample data down to mono.
+	const uint64_t writePosition = frame.Position;
+	const float channelScale = 1.0f / m_HistoryChannels;
+	for ( size_t n = 0; n < kFFTSize; n++ ) {
+		float sample = 0;
+		if ( writePosition + n >= kFFTSize ) {
+			const uint64_t position = writePosition + n - kFFTSize;
+			const float* history = m_History.data() + ( position & ( m_HistoryFrames - 1 ) ) * m_HistoryChannels;
+			for ( uint32_t channel = 0; channel < m_HistoryChannels; channel++ ) {
+				sample += history[ channel ];
+			}
+			sample *= channelScale;
+		}
+		m_FFTInput[ n ] = sample;
+	}
+	m_FFT.Magnitudes( m_FFTInput.data(), frame.FFT.data() );
+}
+
+int64_t AnalysisTap::GetFrameIndex( const double position ) const
+{
+	const uint64_t frameCount = m_FrameCount.load( std::memory_order_acquire );
+	if ( 0 == frameCount ) {
+		return -1;
+	}
+
+	// Use the first frame whose analysis window ends at or after the position, so that the frame includes the sample data being heard.
+	const uint64_t streamPosition = static_cast<uint64_t>( std::max( 0.0, std::round( position * m_SampleRate ) ) );
+	const uint64_t index = std::max<uint64_t>( 1, ( streamPosition + m_HopFrames - 1 ) / m_HopFrames ) - 1;
+
+	// The oldest slot might be being overwritten by the next frame.
+	const uint64_t oldestIndex = ( frameCount >= kFrameCount ) ? ( frameCount - kFrameCount + 1 ) : 0;
+	return static_cast<int64_t>( std::clamp( index, oldestIndex, frameCount - 1 ) );
+}
+
+template<typename Copy>
+bool AnalysisTap::ReadFrame( const int64_t index, Copy copy ) const
+{
+	if ( index < 0 ) {
+		return false;
+	}
+	const Frame& frame = m_Frames[ static_cast<size_t>( index ) % kFrameCount ];
+	const uint64_t sequence = frame.Sequence.load( std::memory_order_acquire );
+	if ( 0 != ( sequence & 1 ) ) {
+		return false;
+	}
+	const bool expectedPosition = ( frame.Position == ( static_cast<uint64_t>( index ) + 1 ) * m_HopFrames );
+	copy( frame );
+	std::atomic_thread_fence( std::memory_order_acquire );
+	return expectedPosition && ( sequence == frame.Sequence.load( std::memory_order_relaxed ) );
+}
+
+bool AnalysisTap::GetLevels( const double position, Levels& levels ) const
+{
+	return ReadFrame( GetFrameIndex( position ), [ &levels ] ( const Frame& frame )
+		{
+			levels = frame.OutputLevels;
+		} );
+}
+
+bool AnalysisTap::GetFFT( const double position, std::vector<float>& fft ) const
+{
+	fft.resize( kFFTBins );
+	const bool success = ReadFrame( GetFrameIndex( position ), [ &fft ] ( const Frame& frame )
+		{
+			std::copy( frame.FFT.begin(), frame.FFT.end(), fft.begin() );
+		} );
+	if ( !success ) {
+		fft.clear();
+	}
+	return success;
+}
+
+bool AnalysisTap::GetSamples( const double position, const size_t frames, std::vector<float>& samples, long& channels ) const
+{
+	samples.clear();
+	channels = static_cast<long>( m_HistoryChannels );
+	const uint64_t writePosition = m_WritePosition.load( std::memory_order_acquire );
+	if ( ( 0 == frames ) || ( frames > ( m_HistoryFrames / 2 ) ) || ( writePosition < frames ) ) {
+		return false;
+	}
+
+	// Get the sample data about to be heard, limited to what has been written.
+	const uint64_t streamPosition = static_cast<uint64_t>( std::max( 0.0, std::round( position * m_SampleRate ) ) );
+	const uint64_t startPosition = std::min( streamPosition + frames, writePosition ) - frames;
+	if ( writePosition - startPosition > m_HistoryFrames - m_HopFrames ) {
+		return false;
+	}
+
+	samples.resize( frames * m_HistoryChannels );
+	for ( size_t frame = 0; frame < frames; frame++ ) {
+		const float* history = m_History.data() + ( ( startPosition + frame ) & ( m_HistoryFrames - 1 ) ) * m_HistoryChannels;
+		std::copy( history, history + m_HistoryChannels, samples.begin() + frame * m_HistoryChannels );
+	}
+
+	// Check that the sample data was not overwritten while copying (the writer can be up to one hop ahead of the published write position).
+	std::atomic_thread_fence( std::memory_order_acquire );
+	if ( m_WritePosition.load( std::memory_order_relaxed ) + m_HopFrames - startPosition > m_HistoryFrames ) {
+		samples.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "FFT.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Analysis stage in the output sample pipeline, which feeds all the visuals.
+// Sample data is passed in from the output callback, and at regular intervals (hops) the peak & RMS levels and the FFT magnitudes are calculated once,
+// and published to a lock free ring of frames, time stamped with their stream position. A history of recent sample data is also retained.
+// The visuals read the frame, or sample data, which aligns with the stream position currently being heard.
+class AnalysisTap
+{
+public:
+	// FFT size, in samples.
+	static constexpr size_t kFFTSize = 4096;
+
+	// Number of FFT magnitude bins.
+	static constexpr size_t kFFTBins = kFFTSize / 2;
+
+	// Maximum number of channels retained in the sample history (additional channels are ignored).
+	static constexpr uint32_t kMaxChannels = 8;
+
+	// Output levels. Left levels are from the even channels, and right levels from the odd channels (mono is reported on both sides).
+	struct Levels {
+		float LeftPeak = 0;
+		float RightPeak = 0;
+		float LeftRMS = 0;
+		float RightRMS = 0;
+	};
+
+	// 'sampleRate' - stream sample rate.
+	// 'channels' - stream channel count.
+	// Throws a std::runtime_error exception if the format is not supported.
+	AnalysisTap( const long sampleRate, const uint32_t channels );
+
+	virtual ~AnalysisTap();
+
+	// Returns the stream channel count.
+	uint32_t GetChannels() const;
+
+	// Adds sample data to the analysis stage (called by the output callback, and must not be called concurrently).
+	// 'buffer' - sample data, interleaved at the stream channel count.
+	// 'frames' - number of sample frames.
+	void Process( const float* buffer, const size_t frames );
+
+	// Gets the output 'levels' at the stream 'position' (in seconds).
+	// Returns false if no analysis is available for the position.
+	bool GetLevels( const double position, Levels& levels ) const;
+
+	// Gets the 'fft' magnitudes at the stream 'position' (in seconds).
+	// Returns false if no analysis is available for the position.
+	bool GetFFT( const double position, std::vector<float>& fft ) const;
+
+	// Gets sample data starting at the stream 'position' (in seconds).
+	// 'frames' - number of sample frames to get.
+	// 'samples' - out, interleaved sample data.
+	// 'channels' - out, number of channels in the sample data.
+	// Returns false if no sample data is available for the position.
+	bool GetSamples( const double position, const size_t frames, std::vector<float>& samples, long& channels ) const;
+
+private:
+	// Analysis frame.
+	struct Frame {
+		std::atomic<uint64_t> Sequence = 0;    // Odd while the frame is being written.
+		uint64_t Position = 0;                 // Stream position at the end of the analysis window, in sample frames.
+		Levels OutputLevels;                   // Output levels.
+		std::array<float, kFFTBins> FFT = {};  // FFT magnitudes.
+	};
+
+	// Calculates and publishes the analysis frame for the hop which ends at the current write position.
+	void Analyse();
+
+	// Calculates the FFT magnitudes of the most recent sample data into the 'frame'.
+	void CalculateFFT( Frame& frame );
+
+	// Returns the index of the frame which aligns with the stream 'position' (in seconds), or -1 if there is no frame available.
+	int64_t GetFrameIndex( const double position ) const;
+
+	// Reads the frame with the 'index', using the 'copy' function to copy out the required parts of the frame.
+	// Returns false if the frame was overwritten while reading.
+	template<typename Copy>
+	bool ReadFrame( const int64_t index, Copy copy ) const;
+
+	// Stream sample rate.
+	const long m_SampleRate;
+
+	// Stream channel count.
+	const uint32_t m_Channels;
+
+	// Number of channels retained in the sample history.
+	const uint32_t m_HistoryChannels;
+
+	// Number of sample frames between each analysis frame.
+	const size_t m_HopFrames;
+
+	// Number of sample frames over which the levels are calculated.
+	const size_t m_LevelFrames;
+
+	// Number of sample frames in the history (a power of two).
+	const size_t m_HistoryFrames;
+
+	// Sample history, interleaved at the history channel count.
+	std::vector<float> m_History;
+
+	// Total number of sample frames written to the history.
+	std::atomic<uint64_t> m_WritePosition = 0;
+
+	// Analysis frames.
+	std::unique_ptr<Frame[]> m_Frames;
+
+	// Total number of analysis frames published.
+	std::atomic<uint64_t> m_FrameCount = 0;
+
+	// FFT.
+	FFT m_FFT;
+
+	// FFT input, mixed down to mono.
+	std::vector<float> m_FFTInput;
+};
@@ -0,0 +1,341 @@
+#include "ChannelMixer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#define CHANNEL_MIXER_SSE
+#include <immintrin.h>
+#endif
+
+using Speaker = ChannelMixer::Speaker;
+
+// -3dB gain.
+constexpr float kMinus3dB = 0.70710678f;
+
+// -6dB gain.
+constexpr float kMinus6dB = 0.5f;
+
+// Describes how a speaker is folded into one or two other speakers, when it is not present in the output layout.
+// The first fold for a speaker whose target(s) are present in the output layout is used.
+struct Fold {
+	Speaker Source;
+	Speaker Target;
+	Speaker PairedTarget;    // Same as the target, if there is only a single target.
+	float Gain;
+};
+
+// Speaker folds, in order of preference.
+// The LFE channel is dropped if it is not present in the output layout.
+constexpr std::array kFolds = {
+	Fold{ Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontCenter, 1.0f },
+	Fold{ Speaker::FrontRight, Speaker::FrontCenter, Speaker::FrontCenter, 1.0f },
+	Fold{ Speaker::FrontCenter, Speaker::FrontLeft, Speaker::FrontRight, kMinus3dB },
+	Fold{ Speaker::FrontLeftOfCenter, Speaker::FrontLeft, Speaker::FrontLeft, 1.0f },
+	Fold{ Speaker::FrontLeftOfCenter, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::FrontRightOfCenter, Speaker::FrontRight, Speaker::FrontRight, 1.0f },
+	Fold{ Speaker::FrontRightOfCenter, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::BackLeft, Speaker::SideLeft, Speaker::SideLeft, 1.0f },
+	Fold{ Speaker::BackLeft, Speaker::FrontLeft, Speaker::FrontLeft, kMinus3dB },
+	Fold{ Speaker::BackLeft, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::BackRight, Speaker::SideRight, Speaker::SideRight, 1.0f },
+	Fold{ Speaker::BackRight, Speaker::FrontRight, Speaker::FrontRight, kMinus3dB },
+	Fold{ Speaker::BackRight, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::BackCenter, Speaker::BackLeft, Speaker::BackRight, 1.0f },
+	Fold{ Speaker::BackCenter, Speaker::SideLeft, Speaker::SideRight, kMinus3dB },
+	Fold{ Speaker::BackCenter, Speaker::FrontLeft, Speaker::FrontRight, kMinus6dB },
+	Fold{ Speaker::BackCenter, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::SideLeft, Speaker::BackLeft, Speaker::BackLeft, 1.0f },
+	Fold{ Speaker::SideLeft, Speaker::FrontLeft, Speaker::FrontLeft, kMinus3dB },
+	Fold{ Speaker::SideLeft, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::SideRight, Speaker::BackRight, Speaker::BackRight, 1.0f },
+	Fold{ Speaker::SideRight, Speaker::FrontRight, Speaker::FrontRight, kMinus3dB },
+	Fold{ Speaker::SideRight, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::TopFrontLeft, Speaker::FrontLeft, Speaker::FrontLeft, kMinus3dB },
+	Fold{ Speaker::TopFrontLeft, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::TopFrontRight, Speaker::FrontRight, Speaker::FrontRight, kMinus3dB },
+	Fold{ Speaker::TopFrontRight, Speaker::FrontCenter, Speaker::FrontCenter, kMinus3dB },
+	Fold{ Speaker::TopBackLeft, Speaker::BackLeft, Speaker::BackLeft, kMinus3dB },
+	Fold{ Speaker::TopBackLeft, Speaker::SideLeft, Speaker::SideLeft, kMinus3dB },
+	Fold{ Speaker::TopBackLeft, Speaker::FrontLeft, Speaker::FrontLeft, kMinus6dB },
+	Fold{ Speaker::TopBackLeft, Speaker::FrontCenter, Speaker::FrontCenter, kMinus6dB },
+	Fold{ Speaker::TopBackRight, Speaker::BackRight, Speaker::BackRight, kMinus3dB },
+	Fold{ Speaker::TopBackRight, Speaker::SideRight, Speaker::SideRight, kMinus3dB },
+	Fold{ Speaker::TopBackRight, Speaker::FrontRight, Speaker::FrontRight, kMinus6dB },
+	Fold{ Speaker::TopBackRight, Speaker::FrontCenter, Speaker::FrontCenter, kMinus6dB }
+};
+
+ChannelMixer::ChannelMixer( const uint32_t inputChannels, const uint32_t outputChannels, const Order inputOrder, const Order outputOrder ) :
+	m_InputChannels( inputChannels ),
+	m_OutputChannels( outputChannels ),
+	m_Stride( ( outputChannels + 3 ) & ~3u ),
+	m_Matrix( static_cast<size_t>( inputChannels ) * m_Stride, 0.0f ),
+	m_ChannelMap()
+{
+	if ( ( 0 == m_InputChannels ) || ( 0 == m_OutputChannels ) || ( m_InputChannels > kMaxChannels ) || ( m_OutputChannels > kMaxChannels ) ) {
+		throw std::runtime_error( "ChannelMixer does not support channel count" );
+	}
+	BuildMatrix( GetLayout( m_InputChannels, inputOrder ), GetLayout( m_OutputChannels, outputOrder ) );
+	ChooseMethod();
+}
+
+ChannelMixer::~ChannelMixer()
+{
+}
+
+ChannelMixer::Layout ChannelMixer::GetLayout( const uint32_t channels, const Order order )
+{
+	static const std::map<uint32_t, Layout> kWaveLayouts = {
+		{ 1, { Speaker::FrontCenter } },
+		{ 2, { Speaker::FrontLeft, Speaker::FrontRight } },
+		{ 3, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter } },
+		{ 4, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight } },
+		{ 5, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::BackLeft, Speaker::BackRight } },
+		{ 6, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackLeft, Speaker::BackRight } },
+		{ 7, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackCenter, Speaker::SideLeft, Speaker::SideRight } },
+		{ 8, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackLeft, Speaker::BackRight, Speaker::SideLeft, Speaker::SideRight } },
+		{ 10, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackLeft, Speaker::BackRight,
+			Speaker::TopFrontLeft, Speaker::TopFrontRight, Speaker::TopBackLeft, Speaker::TopBackRight } },
+		{ 12, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackLeft, Speaker::BackRight, Speaker::SideLeft, Speaker::SideRight,
+			Speaker::TopFrontLeft, Speaker::TopFrontRight, Speaker::TopBackLeft, Speaker::TopBackRight } },
+		{ 14, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LFE, Speaker::BackLeft, Speaker::BackRight, Speaker::FrontLeftOfCenter, Speaker::FrontRightOfCenter,
+			Speaker::SideLeft, Speaker::SideRight, Speaker::TopFrontLeft, Speaker::TopFrontRight, Speaker::TopBackLeft, Speaker::TopBackRight } }
+	};
+
+	static const std::map<uint32_t, Layout> kVorbisLayouts = {
+		{ 1, { Speaker::FrontCenter } },
+		{ 2, { Speaker::FrontLeft, Speaker::FrontRight } },
+		{ 3, { Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontRight } },
+		{ 4, { Speaker::FrontLeft, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight } },
+		{ 5, { Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight } },
+		{ 6, { Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight, Speaker::LFE } },
+		{ 7, { Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontRight, Speaker::SideLeft, Speaker::SideRight, Speaker::BackCenter, Speaker::LFE } },
+		{ 8, { Speaker::FrontLeft, Speaker::FrontCenter, Speaker::FrontRight, Speaker::SideLeft, Speaker::SideRight, Speaker::BackLeft, Speaker::BackRight, Speaker::LFE } }
+	};
+
+	const auto& layouts = ( Order::Vorbis == order ) ? kVorbisLayouts : kWaveLayouts;
+	if ( const auto layout = layouts.find( channels ); layouts.end() != layout ) {
+		return layout->second;
+	}
+	return {};
+}
+
+uint32_t ChannelMixer::GetInputChannels() const
+{
+	return m_InputChannels;
+}
+
+uint32_t ChannelMixer::GetOutputChannels() const
+{
+	return m_OutputChannels;
+}
+
+bool ChannelMixer::IsPassThrough() const
+{
+	return Method::PassThrough == m_Method;
+}
+
+float ChannelMixer::GetCoefficient( const uint32_t input, const uint32_t output ) const
+{
+	return ( ( input < m_InputChannels ) && ( output < m_OutputChannels ) ) ? m_Matrix[ input * m_Stride + output ] : 0.0f;
+}
+
+void ChannelMixer::BuildMatrix( const Layout& inputLayout, const Layout& outputLayout )
+{
+	if ( inputLayout.empty() || outputLayout.empty() ) {
+		// With no standard layout, pass through as many channels as possible.
+		for ( uint32_t channel = 0; channel < std::min( m_InputChannels, m_OutputChannels ); channel++ ) {
+			m_Matrix[ channel * m_Stride + channel ] = 1.0f;
+		}
+		return;
+	}
+
+	const auto findOutput = [ &outputLayout ] ( const Speaker speaker ) -> int32_t {
+		const auto position = std::find( outputLayout.begin(), outputLayout.end(), speaker );
+		return ( outputLayout.end() != position ) ? static_cast<int32_t>( position - outputLayout.begin() ) : -1;
+	};
+
+	for ( uint32_t input = 0; input < m_InputChannels; input++ ) {
+		float* coefficients = m_Matrix.data() + input * m_Stride;
+		const Speaker speaker = inputLayout[ input ];
+		if ( const int32_t output = findOutput( speaker ); output >= 0 ) {
+			coefficients[ output ] = 1.0f;
+		} else if ( ( 1 == m_InputChannels ) && ( findOutput( Speaker::FrontLeft ) >= 0 ) && ( findOutput( Speaker::FrontRight ) >= 0 ) ) {
+			// A mono source is played at full level on both front speakers.
+			coefficients[ findOutput( Speaker::FrontLeft ) ] = 1.0f;
+			coefficients[ findOutput( Speaker::FrontRight ) ] = 1.0f;
+		} else {
+			for ( const auto& fold : kFolds ) {
+				if ( fold.Source == speaker ) {
+					const int32_t target = findOutput( fold.Target );
+					const int32_t pairedTarget = findOutput( fold.PairedTarget );
+					if ( ( target >= 0 ) && ( pairedTarget >= 0 ) ) {
+						coefficients[ target ] += fold.Gain;
+						if ( pairedTarget != target ) {
+							coefficients[ pairedTarget ] += fold.Gain;
+						}
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// The coefficients are not normalised (which would make a 5.1 downmix about 7.7dB quieter), instead the output is clipped when a channel can exceed unity gain.
+	for ( uint32_t output = 0; !m_Clip && ( output < m_OutputChannels ); output++ ) {
+		float gain = 0;
+		for ( uint32_t input = 0; input < m_InputChannels; input++ ) {
+			gain += std::fabs( m_Matrix[ input * m_Stride + output ] );
+		}
+		m_Clip = ( gain > 1.0f );
+	}
+}
+
+void ChannelMixer::ChooseMethod()
+{
+	// Use a channel map if each output channel is either a copy of a single input channel, or silent.
+	m_ChannelMap.assign( m_OutputChannels, -1 );
+	bool isChannelMap = true;
+	for ( uint32_t output = 0; isChannelMap && ( output < m_OutputChannels ); output++ ) {
+		for ( uint32_t input = 0; isChannelMap && ( input < m_InputChannels ); input++ ) {
+			const float coefficient = m_Matrix[ input * m_Stride + output ];
+			if ( 1.0f == coefficient ) {
+				isChannelMap = ( -1 == m_ChannelMap[ output ] );
+				m_ChannelMap[ output ] = static_cast<int32_t>( input );
+			} else {
+				isChannelMap = ( 0.0f == coefficient );
+			}
+		}
+	}
+
+	if ( isChannelMap ) {
+		bool isPassThrough = ( m_InputChannels == m_OutputChannels );
+		for ( uint32_t channel = 0; isPassThrough && ( channel < m_OutputChannels ); channel++ ) {
+			isPassThrough = ( static_cast<int32_t>( channel ) == m_ChannelMap[ channel ] );
+		}
+		m_Method = isPassThrough ? Method::PassThrough : Method::ChannelMap;
+	} else {
+		m_ChannelMap.clear();
+		m_Method = Method::Matrix;
+	}
+}
+
+void ChannelMixer::Process( const float* input, float* output, const size_t frames ) const
+{
+	switch ( m_Method ) {
+		case Method::PassThrough: {
+			if ( input != output ) {
+				std::copy( input, input + frames * m_InputChannels, output );
+			}
+			break;
+		}
+		case Method::ChannelMap: {
+			ProcessChannelMap( input, output, frames );
+			break;
+		}
+		case Method::Matrix: {
+			ProcessMatrix( input, output, frames );
+			break;
+		}
+	}
+}
+
+void ChannelMixer::ProcessChannelMap( const float* input, float* output, const size_t frames ) const
+{
+	// Each frame is read in full before it is written, and frames are processed from the end of the buffer when upmixing, to allow for in-place remixing.
+	std::array<float, kMaxChannels> frame;
+	const bool reverse = ( m_OutputChannels > m_InputChannels );
+	for ( size_t index = 0; index < frames; index++ ) {
+		const size_t frameIndex = reverse ? ( frames - 1 - index ) : index;
+		const float* in = input + frameIndex * m_InputChannels;
+		float* out = output + frameIndex * m_OutputChannels;
+		std::copy( in, in + m_InputChannels, frame.begin() );
+		for ( uint32_t channel = 0; channel < m_OutputChannels; channel++ ) {
+			const int32_t source = m_ChannelMap[ channel ];
+			out[ channel ] = ( source >= 0 ) ? frame[ source ] : 0.0f;
+		}
+	}
+}
+
+void ChannelMixer::ProcessMatrix( const float* input, float* output, const size_t frames ) const
+{
+	// Each frame is read in full before it is written, and frames are processed from the end of the buffer when upmixing, to allow for in-place remixing.
+	const bool reverse = ( m_OutputChannels > m_InputChannels );
+	const float* matrix = m_Matrix.data();
+
+#ifdef CHANNEL_MIXER_SSE
+	const __m128 clipMin = _mm_set1_ps( -1.0f );
+	const __m128 clipMax = _mm_set1_ps( 1.0f );
+	size_t index = 0;
+	if ( ( 2 == m_OutputChannels ) && !reverse ) {
+		// Stereo output (the most common downmix), two frames at a time.
+		for ( ; ( index + 2 ) <= frames; index += 2 ) {
+			const float* in = input + index * m_InputChannels;
+			__m128 sum = _mm_setzero_ps();
+			for ( uint32_t channel = 0; channel < m_InputChannels; channel++ ) {
+				const __m128 coefficients = _mm_castpd_ps( _mm_load1_pd( reinterpret_cast<const double*>( matrix + channel * m_Stride ) ) );
+				const __m128 samples = _mm_set_ps( in[ m_InputChannels + channel ], in[ m_InputChannels + channel ], in[ channel ], in[ channel ] );
+				sum = _mm_add_ps( sum, _mm_mul_ps( samples, coefficients ) );
+			}
+			_mm_storeu_ps( output + index * 2, m_Clip ? _mm_min_ps( _mm_max_ps( sum, clipMin ), clipMax ) : sum );
+		}
+	}
+
+	constexpr uint32_t kMaxVectors = kMaxChannels / 4;
+	const uint32_t vectorCount = m_Stride / 4;
+	const uint32_t remainder = m_OutputChannels % 4;
+	__m128 sums[ kMaxVectors ];
+	alignas( 16 ) float last[ 4 ];
+	for ( ; index < frames; index++ ) {
+		const size_t frameIndex = reverse ? ( frames - 1 - index ) : index;
+		const float* in = input + frameIndex * m_InputChannels;
+		float* out = output + frameIndex * m_OutputChannels;
+		for ( uint32_t vector = 0; vector < vectorCount; vector++ ) {
+			sums[ vector ] = _mm_setzero_ps();
+		}
+		for ( uint32_t channel = 0; channel < m_InputChannels; channel++ ) {
+			const __m128 sample = _mm_set1_ps( in[ channel ] );
+			const float* coefficients = matrix + channel * m_Stride;
+			for ( uint32_t vector = 0; vector < vectorCount; vector++ ) {
+				sums[ vector ] = _mm_add_ps( sums[ vector ], _mm_mul_ps( sample, _mm_loadu_ps( coefficients + vector * 4 ) ) );
+			}
+		}
+		if ( m_Clip ) {
+			for ( uint32_t vector = 0; vector < vectorCount; vector++ ) {
+				sums[ vector ] = _mm_min_ps( _mm_max_ps( sums[ vector ], clipMin ), clipMax );
+			}
+		}
+		const uint32_t fullVectors = ( 0 == remainder ) ? vectorCount : ( vectorCount - 1 );
+		for ( uint32_t vector = 0; vector < fullVectors; vector++ ) {
+			_mm_storeu_ps( out + vector * 4, sums[ vector ] );
+		}
+		if ( 0 != remainder ) {
+			_mm_store_ps( last, sums[ fullVectors ] );
+			std::copy( last, last + remainder, out + fullVectors * 4 );
+		}
+	}
+#else
+	std::array<float, kMaxChannels> frame;
+	for ( size_t index = 0; index < frames; index++ ) {
+		const size_t frameIndex = reverse ? ( frames - 1 - index ) : index;
+		const float* in = input + frameIndex * m_InputChannels;
+		float* out = output + frameIndex * m_OutputChannels;
+		std::copy( in, in + m_InputChannels, frame.begin() );
+		std::fill( out, out + m_OutputChannels, 0.0f );
+		for ( uint32_t channel = 0; channel < m_InputChannels; channel++ ) {
+			const float* coefficients = matrix + channel * m_Stride;
+			for ( uint32_t outputChannel = 0; outputChannel < m_OutputChannels; outputChannel++ ) {
+				out[ outputChannel ] += frame[ channel ] * coefficients[ outputChannel ];
+			}
+		}
+		if ( m_Clip ) {
+			for ( uint32_t outputChannel = 0; outputChannel < m_OutputChannels; outputChannel++ ) {
+				out[ outputChannel ] = std::clamp( out[ outputChannel ], -1.0f, 1.0f );
+			}
+		}
+	}
+#endif
+}
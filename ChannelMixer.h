@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Matrix based channel remixing (reordering, upmixing & downmixing) of interleaved floating point samples.
+// The mixing matrix is built from the speaker positions of the input & output channel layouts, using standard downmix coefficients
+// (speakers folded into a pair of outputs, such as the centre into front left & right, and surrounds into the front, are mixed at -3dB).
+// Downmixed output is clipped to +/-1.0f, rather than the matrix being normalised, so that downmixes are not made quieter.
+// Reordering & duplicating channels is performed by a channel map, otherwise the matrix is applied using SIMD instructions where available.
+class ChannelMixer
+{
+public:
+	// Speaker position.
+	enum class Speaker {
+		FrontLeft,
+		FrontRight,
+		FrontCenter,
+		LFE,
+		BackLeft,
+		BackRight,
+		FrontLeftOfCenter,
+		FrontRightOfCenter,
+		BackCenter,
+		SideLeft,
+		SideRight,
+		TopFrontLeft,
+		TopFrontRight,
+		TopBackLeft,
+		TopBackRight
+	};
+
+	// Channel layout, as the speaker position of each channel.
+	using Layout = std::vector<Speaker>;
+
+	// Channel ordering convention.
+	enum class Order {
+		Wave,     // WAVEFORMATEXTENSIBLE ordering, as used by BASS, FLAC, WavPack & FFmpeg.
+		Vorbis    // Vorbis ordering, as used by Opus.
+	};
+
+	// Maximum supported channel count.
+	static constexpr uint32_t kMaxChannels = 32;
+
+	// 'inputChannels' - input channel count.
+	// 'outputChannels' - output channel count.
+	// 'inputOrder' - input channel ordering.
+	// 'outputOrder' - output channel ordering.
+	// Throws a std::runtime_error exception if a channel count is not supported.
+	ChannelMixer( const uint32_t inputChannels, const uint32_t outputChannels, const Order inputOrder = Order::Wave, const Order outputOrder = Order::Wave );
+
+	virtual ~ChannelMixer();
+
+	// Returns the layout of 'channels' with the channel 'order', or an empty layout if there is no standard layout for the channel count.
+	static Layout GetLayout( const uint32_t channels, const Order order = Order::Wave );
+
+	// Returns the input channel count.
+	uint32_t GetInputChannels() const;
+
+	// Returns the output channel count.
+	uint32_t GetOutputChannels() const;
+
+	// Returns whether samples are passed through unchanged.
+	bool IsPassThrough() const;
+
+	// Returns the mixing coefficient applied to the 'input' channel for the 'output' channel.
+	float GetCoefficient( const uint32_t input, const uint32_t output ) const;
+
+	// Remixes sample data.
+	// 'input' - input samples.
+	// 'output' - output samples, which can be the same buffer as the 'input' provided it is large enough to hold the output.
+	// 'frames' - number of sample frames to remix.
+	void Process( const float* input, float* output, const size_t frames ) const;
+
+private:
+	// Remixing method.
+	enum class Method {
+		PassThrough,    // Samples are copied unchanged.
+		ChannelMap,     // Each output channel is a copy of a single input channel (or silence).
+		Matrix          // Each output channel is a weighted sum of the input channels.
+	};
+
+	// Builds the mixing matrix for the input & output 'layouts'.
+	void BuildMatrix( const Layout& inputLayout, const Layout& outputLayout );
+
+	// Chooses the remixing method for the mixing matrix.
+	void ChooseMethod();
+
+	// Remixes using the channel map.
+	void ProcessChannelMap( const float* input, float* output, const size_t frames ) const;
+
+	// Remixes using the mixing matrix.
+	void ProcessMatrix( const float* input, float* output, const size_t frames ) const;
+
+	// Input channel count.
+	const uint32_t m_InputChannels;
+
+	// Output channel count.
+	const uint32_t m_OutputChannels;
+
+	// Number of coefficients per input channel in the mixing matrix (the output channel count, padded to a multiple of 4).
+	const uint32_t m_Stride;
+
+	// Mixing matrix, containing the output channel coefficients for each input channel.
+	std::vector<float> m_Matrix;
+
+	// Input channel for each output channel, when using a channel map (or -1 for silence).
+	std::vector<int32_t> m_ChannelMap;
+
+	// Remixing method.
+	Method m_Method = Method::Matrix;
+
+	// Whether the output is clipped, because the mixing matrix can exceed unity gain for an output channel.
+	bool m_Clip = false;
+};
@@ -323,7 +323,7 @@ bool Converter::JoinTracksHandler( const bool addToLibrary )
 		m_StatusTrack.store( currentTrack );
 		try {
 			const Decoder::Ptr decoder = OpenDecoder( *track );
-			const auto resampler = std::make_unique<Resampler>( decoder, 0, joinSampleRate, joinChannels );
+			const auto resampler = std::make_unique<Resampler>( decoder, 0, joinSampleRate, joinChannels, Resampler::GetQuality( Decoder::Context::Input ) );
 
 			const long sampleRate = resampler->GetOutputSampleRate();
 			const long channels = resampler->GetOutputChannels();
@@ -505,7 +505,7 @@ bool Converter::EncodeTracksHandler( const bool addToLibrary )
 						if ( !outputFilename.empty() ) {
 							try {
 								const Decoder::Ptr decoder = OpenDecoder( item );
-								const auto resampler = std::make_unique<Resampler>( decoder, 0, decoder->GetSampleRate(), decoder->GetChannels() );
+								const auto resampler = std::make_unique<Resampler>( decoder, 0, decoder->GetSampleRate(), decoder->GetChannels(), Resampler::GetQuality( Decoder::Context::Input ) );
 
 								const long sampleRate = resampler->GetOutputSampleRate();
 								const long channels = resampler->GetOutputChannels();
@@ -0,0 +1,110 @@
+#include "CrossfadeAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Maximum number of analyses to keep in memory.
+constexpr size_t kCacheSize = 64;
+
+KeyedCache<CrossfadeAnalysis::Key, CrossfadeAnalysis::Track, CrossfadeAnalysis::Analysis> CrossfadeAnalysis::s_Cache( kCacheSize );
+
+double CrossfadeAnalysis::GetCrossfadePosition( const Analysis& analysis, const double seekOffset, const double rmsRatio )
+{
+	if ( ( analysis.SampleRate <= 0 ) || ( analysis.WindowSize <= 0 ) ) {
+		return 0;
+	}
+
+	// When seeking, the calculation starts from the window containing the seek position.
+	const int64_t seekFrame = static_cast<int64_t>( seekOffset * analysis.SampleRate );
+	const size_t firstWindow = ( seekOffset > 0 ) ? static_cast<size_t>( std::max<int64_t>( 0, ( seekFrame - analysis.StartFrame ) / analysis.WindowSize ) ) : 0;
+
+	double cumulativeTotal = 0;
+	double cumulativeFrames = 0;
+	std::optional<int64_t> crossfadeFrame;
+	for ( size_t window = firstWindow; window < analysis.Envelope.size(); window++ ) {
+		const int64_t windowStart = analysis.StartFrame + static_cast<int64_t>( window ) * analysis.WindowSize;
+		const int64_t windowFrames = std::min<int64_t>( analysis.WindowSize, analysis.EndFrame - windowStart );
+		if ( windowFrames <= 0 ) {
+			break;
+		}
+		const double meanSquare = analysis.Envelope[ window ];
+		cumulativeTotal += meanSquare * windowFrames;
+		cumulativeFrames += static_cast<double>( windowFrames );
+
+		const double windowRMS = std::sqrt( meanSquare );
+		const double cumulativeRMS = std::sqrt( cumulativeTotal / cumulativeFrames );
+		if ( ( windowRMS > cumulativeRMS ) || ( ( cumulativeRMS > 0 ) && ( ( windowRMS / cumulativeRMS ) > rmsRatio ) ) ) {
+			crossfadeFrame = windowStart + windowFrames;
+		}
+	}
+
+	double crossfadePosition = 0;
+	if ( crossfadeFrame ) {
+		const double playbackStart = ( seekOffset > 0 ) ? seekOffset : ( static_cast<double>( analysis.StartFrame ) / analysis.SampleRate );
+		crossfadePosition = std::max( 0.0, static_cast<double>( *crossfadeFrame ) / analysis.SampleRate - playbackStart );
+	}
+	return crossfadePosition;
+}
+
+std::optional<CrossfadeAnalysis::Analysis> CrossfadeAnalysis::Get( const MediaInfo& mediaInfo, const float threshold )
+{
+	std::optional<Analysis> analysis;
+	if ( const auto track = SilenceOffsets::GetTrack( mediaInfo ); track ) {
+		analysis = s_Cache.Get( { track->Filename, track->CueStart, track->CueEnd }, *track );
+		if ( analysis && ( analysis->Threshold != threshold ) ) {
+			// The leading silence was skipped using a different threshold.
+			analysis.reset();
+		}
+	}
+	return analysis;
+}
+
+void CrossfadeAnalysis::Set( const MediaInfo& mediaInfo, const Analysis& analysis )
+{
+	if ( const auto track = SilenceOffsets::GetTrack( mediaInfo ); track ) {
+		s_Cache.Set( { track->Filename, track->CueStart, track->CueEnd }, *track, analysis );
+	}
+}
+
+void CrossfadeAnalysis::SetStore( LoadCallback load, SaveCallback save )
+{
+	s_Cache.SetStore( load, save );
+}
+
+void CrossfadeAnalysis::SaveAll()
+{
+	s_Cache.SaveAll();
+}
+
+std::vector<uint8_t> CrossfadeAnalysis::Serialise( const std::vector<float>& envelope )
+{
+	// Each window is stored as a little-endian 32-bit floating point value.
+	std::vector<uint8_t> blob;
+	blob.reserve( envelope.size() * sizeof( float ) );
+	for ( const float value : envelope ) {
+		uint32_t bits = 0;
+		std::memcpy( &bits, &value, sizeof( bits ) );
+		for ( int byte = 0; byte < 4; byte++ ) {
+			blob.push_back( static_cast<uint8_t>( bits >> ( 8 * byte ) ) );
+		}
+	}
+	return blob;
+}
+
+bool CrossfadeAnalysis::Deserialise( const void* blob, const size_t size, std::vector<float>& envelope )
+{
+	if ( ( ( nullptr == blob ) && ( size > 0 ) ) || ( 0 != ( size % sizeof( float ) ) ) ) {
+		return false;
+	}
+	const uint8_t* data = static_cast<const uint8_t*>( blob );
+	envelope.resize( size / sizeof( float ) );
+	for ( auto& value : envelope ) {
+		uint32_t bits = 0;
+		for ( int byte = 0; byte < 4; byte++ ) {
+			bits |= static_cast<uint32_t>( *data++ ) << ( 8 * byte );
+		}
+		std::memcpy( &value, &bits, sizeof( value ) );
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "KeyedCache.h"
+#include "SilenceOffsets.h"
+
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+// Crossfade analysis for tracks, consisting of the RMS envelope from which the crossfade position is derived.
+// Analyses are cached in memory, and can optionally be persisted using a store (such as the media library), so that crossfade positions are available without decoding.
+class CrossfadeAnalysis
+{
+public:
+	// Identifies a track, along with the file modification time & size to which an analysis applies.
+	using Track = SilenceOffsets::Track;
+
+	// Crossfade analysis for a track.
+	struct Analysis {
+		float Threshold = 0;          // Sample magnitude at or below which a sample was considered to be silent, when skipping leading silence.
+		long SampleRate = 0;          // Sample rate of the decoded track.
+		long WindowSize = 0;          // Number of sample frames in each envelope window.
+		int64_t StartFrame = 0;       // Sample frame at which the envelope starts (following any leading silence).
+		int64_t EndFrame = 0;         // Sample frame at which the envelope ends.
+		std::vector<float> Envelope;  // Mean square sample value of each window.
+	};
+
+	// Loads the 'analysis' for a 'track', returning whether an analysis was loaded.
+	using LoadCallback = std::function<bool( const Track& /*track*/, Analysis& /*analysis*/ )>;
+
+	// Saves the 'analysis' for a 'track'.
+	using SaveCallback = std::function<void( const Track& /*track*/, const Analysis& /*analysis*/ )>;
+
+	// Returns the crossfade position, in seconds, from an 'analysis'.
+	// 'seekOffset' - initial playback position in seconds, or zero if playback starts from the beginning of the track (following any leading silence).
+	// 'rmsRatio' - the ratio of window RMS to cumulative RMS above which a window is considered to be part of the track (rather than the fade out).
+	// Returns the position relative to the start of playback, or zero if no crossfade position was found.
+	static double GetCrossfadePosition( const Analysis& analysis, const double seekOffset, const double rmsRatio );
+
+	// Returns the crossfade analysis for the 'mediaInfo' track, or nullopt if an analysis using the silence 'threshold' is not known.
+	static std::optional<Analysis> Get( const MediaInfo& mediaInfo, const float threshold );
+
+	// Sets the crossfade 'analysis' for the 'mediaInfo' track.
+	static void Set( const MediaInfo& mediaInfo, const Analysis& analysis );
+
+	// Sets the callbacks used to 'load' and 'save' analyses (either can be nullptr).
+	static void SetStore( LoadCallback load, SaveCallback save );
+
+	// Saves all modified analyses to the store.
+	static void SaveAll();
+
+	// Serialises an 'envelope' to a binary blob.
+	static std::vector<uint8_t> Serialise( const std::vector<float>& envelope );
+
+	// Deserialises an envelope from a binary 'blob' of 'size' bytes, returning whether the blob was valid.
+	static bool Deserialise( const void* blob, const size_t size, std::vector<float>& envelope );
+
+private:
+	// Cache key, consisting of the file name, cue start & cue end.
+	using Key = std::tuple<std::wstring, long, long>;
+
+	// Analysis cache.
+	static KeyedCache<Key, Track, Analysis> s_Cache;
+};
@@ -2,12 +2,65 @@
 
 #include "Utility.h"
 
+// Maximum number of idle statements held in the statement cache (across the main connection and the reader pool).
+constexpr size_t kMaxCachedStatements = 128;
+
+// Maximum number of connections in the reader pool.
+constexpr size_t kMaxReaders = 4;
+
+// Maximum size of the memory mapped I/O region for each on-disk connection, in bytes.
+constexpr long long kMmapSize = 256ll * 1024 * 1024;
+
+// Page cache size for the main connection, in KiB.
+constexpr int kCacheSize = 16384;
+
+// Page cache size for each reader connection, in KiB.
+constexpr int kReaderCacheSize = 4096;
+
+// Time for which a reader connection will retry when the database is locked (which in WAL mode only happens during recovery), in milliseconds.
+constexpr int kReaderBusyTimeout = 1000;
+
+// Sets the page cache 'size' (in KiB) and, for an on-disk 'database', the memory mapped I/O size.
+static void SetCacheSize( sqlite3* database, const int size, const bool disk )
+{
+	const std::string query = "PRAGMA cache_size=-" + std::to_string( size ) + ";" + ( disk ? ( "PRAGMA mmap_size=" + std::to_string( kMmapSize ) + ";" ) : std::string() );
+	sqlite3_exec( database, query.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+}
+
+// Switches the on-disk 'database' to WAL journaling, returning true if the database is now using WAL journaling.
+static bool EnableWAL( sqlite3* database )
+{
+	bool enabled = false;
+	sqlite3_stmt* stmt = nullptr;
+	if ( SQLITE_OK == sqlite3_prepare_v2( database, "PRAGMA journal_mode=WAL;", -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+			const char* mode = reinterpret_cast<const char*>( sqlite3_column_text( stmt, 0 /*columnIndex*/ ) );
+			enabled = ( nullptr != mode ) && ( 0 == _stricmp( mode, "wal" ) );
+		}
+		sqlite3_finalize( stmt );
+	}
+	if ( enabled ) {
+		// In WAL mode, a normal sync level is still safe from corruption, and only the most recent commits can be lost on power failure.
+		sqlite3_exec( database, "PRAGMA synchronous=NORMAL;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	}
+	return enabled;
+}
+
 Database::Database( const std::wstring& filename, const Mode mode ) :
 	m_Database( nullptr ),
 	m_Filename( filename ),
 	m_Mode( ( filename.empty() && ( Mode::Disk == mode ) ) ? Mode::Memory : mode ),
 	m_LogMutex(),
-	m_Log()
+	m_Log(),
+	m_StatementMutex(),
+	m_Statements(),
+	m_StatementCacheEnabled( true ),
+	m_WAL( false ),
+	m_ReaderMutex(),
+	m_Readers(),
+	m_ReaderPoolEnabled( true ),
+	m_WriteMutex(),
+	m_WriteScopeDepth( 0 )
 {
 	int result = sqlite3_config( SQLITE_CONFIG_LOG, ErrorLogCallback, this );
 	result = sqlite3_initialize();
@@ -66,10 +119,22 @@ Database::Database( const std::wstring& filename, const Mode mode ) :
 			}
 		}
 	}
+
+	if ( nullptr != m_Database ) {
+		if ( Mode::Disk == m_Mode ) {
+			m_WAL = EnableWAL( m_Database );
+		}
+		SetCacheSize( m_Database, kCacheSize, Mode::Disk == m_Mode );
+	}
 }
 
 Database::~Database()
 {
+	ClearStatementCache();
+	for ( const auto& reader : m_Readers ) {
+		sqlite3_close( reader.Connection );
+	}
+	m_Readers.clear();
 	if ( nullptr != m_Database ) {
 		if ( !m_Filename.empty() && ( Mode::Disk != m_Mode ) ) {
 			// Write out the temporary database to disk.
@@ -113,6 +178,188 @@ sqlite3* Database::GetDatabase()
 	return m_Database;
 }
 
+int Database::PrepareStatement( const std::string& query, sqlite3_stmt** statement )
+{
+	if ( nullptr == statement ) {
+		return SQLITE_MISUSE;
+	}
+	*statement = nullptr;
+	{
+		std::lock_guard<std::mutex> lock( m_StatementMutex );
+		if ( const auto cached = m_Statements.find( { m_Database, query } ); m_Statements.end() != cached ) {
+			*statement = cached->second;
+			m_Statements.erase( cached );
+			return SQLITE_OK;
+		}
+	}
+	return sqlite3_prepare_v3( m_Database, query.c_str(), -1 /*nByte*/, SQLITE_PREPARE_PERSISTENT, statement, nullptr /*tail*/ );
+}
+
+int Database::PrepareReadStatement( const std::string& query, sqlite3_stmt** statement )
+{
+	if ( nullptr == statement ) {
+		return SQLITE_MISUSE;
+	}
+	sqlite3* reader = AcquireReader();
+	if ( nullptr == reader ) {
+		return PrepareStatement( query, statement );
+	}
+	*statement = nullptr;
+	{
+		std::lock_guard<std::mutex> lock( m_StatementMutex );
+		if ( const auto cached = m_Statements.find( { reader, query } ); m_Statements.end() != cached ) {
+			*statement = cached->second;
+			m_Statements.erase( cached );
+			return SQLITE_OK;
+		}
+	}
+	const int result = sqlite3_prepare_v3( reader, query.c_str(), -1 /*nByte*/, SQLITE_PREPARE_PERSISTENT, statement, nullptr /*tail*/ );
+	if ( ( SQLITE_OK != result ) || ( nullptr == *statement ) ) {
+		if ( nullptr != *statement ) {
+			sqlite3_finalize( *statement );
+			*statement = nullptr;
+		}
+		ReleaseReader( reader );
+	}
+	return result;
+}
+
+void Database::ReleaseStatement( sqlite3_stmt* statement )
+{
+	if ( nullptr != statement ) {
+		sqlite3_reset( statement );
+		sqlite3_clear_bindings( statement );
+		sqlite3* connection = sqlite3_db_handle( statement );
+		bool cached = false;
+		{
+			std::lock_guard<std::mutex> lock( m_StatementMutex );
+			if ( m_StatementCacheEnabled && ( m_Statements.size() < kMaxCachedStatements ) ) {
+				if ( const char* query = sqlite3_sql( statement ); nullptr != query ) {
+					m_Statements.insert( { { connection, query }, statement } );
+					cached = true;
+				}
+			}
+		}
+		if ( !cached ) {
+			sqlite3_finalize( statement );
+		}
+		if ( m_Database != connection ) {
+			ReleaseReader( connection );
+		}
+	}
+}
+
+void Database::SetStatementCacheEnabled( const bool enabled )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_StatementMutex );
+		m_StatementCacheEnabled = enabled;
+	}
+	if ( !enabled ) {
+		ClearStatementCache();
+	}
+}
+
+void Database::SetReaderPoolEnabled( const bool enabled )
+{
+	std::lock_guard<std::mutex> lock( m_ReaderMutex );
+	m_ReaderPoolEnabled = enabled;
+}
+
+std::recursive_mutex& Database::GetWriteMutex()
+{
+	return m_WriteMutex;
+}
+
+bool Database::IsWriteScopeActive() const
+{
+	return m_WriteScopeDepth > 0;
+}
+
+Database::WriteScope::WriteScope( Database& database ) :
+	m_Database( database )
+{
+	m_Database.m_WriteMutex.lock();
+	if ( 0 == m_Database.m_WriteScopeDepth++ ) {
+		// Any transaction open on the main connection belongs to the library writer, so commit it now (the writer detects that its transaction has been ended elsewhere).
+		if ( sqlite3* database = m_Database.GetDatabase(); ( nullptr != database ) && ( 0 == sqlite3_get_autocommit( database ) ) ) {
+			sqlite3_exec( database, "COMMIT TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+		}
+	}
+}
+
+Database::WriteScope::~WriteScope()
+{
+	--m_Database.m_WriteScopeDepth;
+	m_Database.m_WriteMutex.unlock();
+}
+
+sqlite3* Database::OpenReader()
+{
+	sqlite3* reader = nullptr;
+	// Each reader connection is only ever used by one thread at a time, so it does not need its own mutex.
+	if ( SQLITE_OK == sqlite3_open_v2( WideStringToUTF8( m_Filename ).c_str(), &reader, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL /*vfs*/ ) ) {
+		sqlite3_busy_timeout( reader, kReaderBusyTimeout );
+		SetCacheSize( reader, kReaderCacheSize, true /*disk*/ );
+	} else {
+		sqlite3_close( reader );
+		reader = nullptr;
+	}
+	return reader;
+}
+
+sqlite3* Database::AcquireReader()
+{
+	std::lock_guard<std::mutex> lock( m_ReaderMutex );
+	if ( !m_WAL || !m_ReaderPoolEnabled ) {
+		return nullptr;
+	}
+	const std::thread::id thread = std::this_thread::get_id();
+	Reader* available = nullptr;
+	for ( auto& reader : m_Readers ) {
+		if ( !reader.InUse ) {
+			if ( thread == reader.Thread ) {
+				available = &reader;
+				break;
+			} else if ( nullptr == available ) {
+				available = &reader;
+			}
+		}
+	}
+	if ( ( nullptr == available ) && ( m_Readers.size() < kMaxReaders ) ) {
+		if ( sqlite3* connection = OpenReader(); nullptr != connection ) {
+			available = &m_Readers.emplace_back();
+			available->Connection = connection;
+		}
+	}
+	if ( nullptr != available ) {
+		available->Thread = thread;
+		available->InUse = true;
+		return available->Connection;
+	}
+	return nullptr;
+}
+
+void Database::ReleaseReader( sqlite3* connection )
+{
+	std::lock_guard<std::mutex> lock( m_ReaderMutex );
+	for ( auto& reader : m_Readers ) {
+		if ( connection == reader.Connection ) {
+			reader.InUse = false;
+			break;
+		}
+	}
+}
+
+void Database::ClearStatementCache()
+{
+	std::lock_guard<std::mutex> lock( m_StatementMutex );
+	for ( const auto& [key, statement] : m_Statements ) {
+		sqlite3_finalize( statement );
+	}
+	m_Statements.clear();
+}
+
 void Database::AppendToErrorLog( const int errorCode, const std::string& message )
 {
 	std::lock_guard<std::mutex> lock( m_LogMutex );
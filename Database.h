@@ -5,8 +5,11 @@
 #include <sqlite3.h>
 
 #include <list>
+#include <map>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 class Database
 {
@@ -14,11 +17,30 @@ public:
 	// Database access mode.
 	enum class Mode
 	{
-		Disk,   // Direct access from disk.
+		Disk,   // Direct access from disk (using WAL journaling, with a pool of read only connections).
 		Temp,   // Use a temporary (disk & memory cached) copy of the database, which gets flushed back out to disk when closed.
 		Memory  // Use a pure in-memory copy of the database, which gets flushed back out to disk when closed.
 	};
 
+	// Exclusive use of the main connection for writes which must not become part of a batched transaction (see LibraryWriter).
+	// Any batched transaction is committed when the outermost scope is created, and batched writes wait until the scope has ended.
+	// Scopes can be nested, and any write (or transaction) made within a scope is committed independently of batched writes.
+	class WriteScope
+	{
+	public:
+		// 'database' - database.
+		WriteScope( Database& database );
+
+		virtual ~WriteScope();
+
+		WriteScope( const WriteScope& ) = delete;
+		WriteScope& operator=( const WriteScope& ) = delete;
+
+	private:
+		// Database.
+		Database& m_Database;
+	};
+
 	// 'filename' - database file name.
 	// 'mode' - database access mode (if Disk mode is specified and 'filename' is empty, then Memory mode will be used).
 	Database( const std::wstring& filename, const Mode mode );
@@ -28,13 +50,58 @@ public:
 	// Returns the SQLite database.
 	sqlite3* GetDatabase();
 
+	// Prepares a 'statement' for the 'query', reusing a previously compiled statement from the statement cache if one is available.
+	// The statement is for the exclusive use of the caller, and must be released using ReleaseStatement (rather than sqlite3_finalize).
+	// Returns the SQLite result code.
+	int PrepareStatement( const std::string& query, sqlite3_stmt** statement );
+
+	// Resets the 'statement', clears its bindings, and returns it to the statement cache (or finalizes it, if the cache is full or disabled).
+	void ReleaseStatement( sqlite3_stmt* statement );
+
+	// Sets whether the statement cache is 'enabled' (any cached statements are finalized when the cache is disabled).
+	void SetStatementCacheEnabled( const bool enabled );
+
+	// Prepares a read only 'statement' for the 'query' using a connection from the reader pool, which is neither blocked by, nor sees, uncommitted writes.
+	// If the reader pool is unavailable (the database is not in Disk mode, or is not using WAL journaling), or all reader connections are in use, the main connection is used.
+	// The statement is for the exclusive use of the caller, and must be released using ReleaseStatement (rather than sqlite3_finalize).
+	// Returns the SQLite result code.
+	int PrepareReadStatement( const std::string& query, sqlite3_stmt** statement );
+
+	// Sets whether the reader pool is 'enabled'.
+	void SetReaderPoolEnabled( const bool enabled );
+
+	// Returns the mutex which serialises writes on the main connection (recursive, to allow for nested writes).
+	std::recursive_mutex& GetWriteMutex();
+
+	// Returns whether the calling thread is within a write scope (the write mutex must be held).
+	bool IsWriteScopeActive() const;
+
 private:
+	// Reader pool connection.
+	struct Reader {
+		sqlite3* Connection = nullptr;          // Read only connection.
+		std::thread::id Thread;                 // The thread which last used the connection.
+		bool InUse = false;                     // Whether the connection is in use.
+	};
+
+	// Opens a read only connection to the on-disk database, returning nullptr if the connection could not be opened.
+	sqlite3* OpenReader();
+
+	// Takes a connection from the reader pool (preferring the connection last used by the calling thread), returning nullptr if there is no connection available.
+	sqlite3* AcquireReader();
+
+	// Returns the reader 'connection' to the reader pool.
+	void ReleaseReader( sqlite3* connection );
+
 	// Appends an 'errorCode' & 'message' entry to the error log.
 	void AppendToErrorLog( const int errorCode, const std::string& message );
 
 	// SQLite error callback.
 	static void ErrorLogCallback( void* arg, int errorCode, const char* message );
 
+	// Finalizes all cached statements.
+	void ClearStatementCache();
+
 	// SQLite database.
 	sqlite3* m_Database;
 
@@ -49,4 +116,31 @@ private:
 
 	// Error log, pairing a SQLite error code with the error description.
 	std::list<std::pair<int, std::string>> m_Log;
+
+	// Statement cache mutex.
+	std::mutex m_StatementMutex;
+
+	// Statement cache, mapping connection & query text to idle compiled statements (a query can have more than one, if it was in use on several threads at once).
+	std::multimap<std::pair<sqlite3*, std::string>, sqlite3_stmt*> m_Statements;
+
+	// Whether the statement cache is enabled.
+	bool m_StatementCacheEnabled;
+
+	// Whether the on-disk database is using WAL journaling (which is required for the reader pool).
+	bool m_WAL;
+
+	// Reader pool mutex.
+	std::mutex m_ReaderMutex;
+
+	// Reader pool.
+	std::vector<Reader> m_Readers;
+
+	// Whether the reader pool is enabled.
+	bool m_ReaderPoolEnabled;
+
+	// Serialises writes on the main connection.
+	std::recursive_mutex m_WriteMutex;
+
+	// Nesting depth of the current write scope.
+	size_t m_WriteScopeDepth;
 };
@@ -1,13 +1,18 @@
 #include "Decoder.h"
 
+#include "SampleConversion.h"
 #include "Settings.h"
 
 #include "ebur128.h"
 
 #include <windows.h>
 
+#include <algorithm>
 #include <string>
 
+// Number of sample frames read at a time when skipping silence.
+constexpr long kSilenceBlockSize = 4096;
+
 Decoder::Decoder( const Context context ) :
 	m_Duration( 0 ),
 	m_SampleRate( 0 ),
@@ -116,17 +121,30 @@ std::optional<float> Decoder::CalculateTrackGain( CanContinue canContinue, const
 	return trackGain;
 }
 
-void Decoder::SkipSilence()
+int64_t Decoder::SkipSilence( const float threshold )
 {
+	int64_t skippedFrames = 0;
 	if ( m_Channels > 0 ) {
-		std::vector<float> buffer( m_Channels );
-		bool silence = true;
-		while ( silence && ReadSamples( buffer.data(), 1 /*sampleCount*/ ) > 0 ) {
-			for ( auto sample = buffer.begin(); silence && ( sample != buffer.end() ); sample++ ) {
-				silence = ( 0 == *sample );
+		std::vector<float> buffer( kSilenceBlockSize * m_Channels );
+		long samplesRead = ReadSamples( buffer.data(), kSilenceBlockSize );
+		while ( samplesRead > 0 ) {
+			const size_t sampleCount = static_cast<size_t>( samplesRead ) * m_Channels;
+			const size_t firstSample = SampleConversion::FindFirstAboveThreshold( buffer.data(), sampleCount, threshold );
+			if ( firstSample < sampleCount ) {
+				// Retain the remainder of the block, from the first non-silent frame onwards, for the next read.
+				const size_t firstFrame = firstSample / m_Channels;
+				skippedFrames += firstFrame;
+				buffer.resize( sampleCount );
+				buffer.erase( buffer.begin(), buffer.begin() + firstFrame * m_Channels );
+				m_PendingSamples = std::move( buffer );
+				m_PendingOffset = 0;
+				break;
 			}
+			skippedFrames += samplesRead;
+			samplesRead = ReadSamples( buffer.data(), kSilenceBlockSize );
 		}
 	}
+	return skippedFrames;
 }
 
 bool Decoder::SupportsStreamTitles() const
@@ -141,16 +159,33 @@ std::pair<float /*seconds*/, std::wstring /*title*/> Decoder::GetStreamTitle()
 
 long Decoder::ReadSamples( float* buffer, const long requestedSamples )
 {
-	const long samplesToRead = m_SamplesRemaining ? static_cast<long>( std::min<int64_t>( requestedSamples, *m_SamplesRemaining ) ) : requestedSamples;
-	const long samplesRead = Read( buffer, samplesToRead );
+	long pendingSamples = 0;
+	if ( !m_PendingSamples.empty() && ( m_Channels > 0 ) ) {
+		// Return any sample data which was read ahead when skipping silence (this has already been accounted for in the remaining samples).
+		pendingSamples = std::min( requestedSamples, static_cast<long>( ( m_PendingSamples.size() - m_PendingOffset ) / m_Channels ) );
+		std::copy_n( m_PendingSamples.data() + m_PendingOffset, pendingSamples * m_Channels, buffer );
+		m_PendingOffset += pendingSamples * m_Channels;
+		if ( m_PendingOffset >= m_PendingSamples.size() ) {
+			m_PendingSamples.clear();
+			m_PendingOffset = 0;
+		}
+		if ( pendingSamples == requestedSamples ) {
+			return pendingSamples;
+		}
+	}
+
+	const long samplesToRead = m_SamplesRemaining ? static_cast<long>( std::min<int64_t>( requestedSamples - pendingSamples, *m_SamplesRemaining ) ) : ( requestedSamples - pendingSamples );
+	const long samplesRead = Read( buffer + pendingSamples * m_Channels, samplesToRead );
 	if ( m_SamplesRemaining ) {
 		*m_SamplesRemaining -= samplesRead;
 	}
-	return samplesRead;
+	return pendingSamples + samplesRead;
 }
 
 double Decoder::SetPosition( const double position )
 {
+	m_PendingSamples.clear();
+	m_PendingOffset = 0;
 	double offset = 0;
 	if ( m_SampleStart && ( GetSampleRate() > 0 ) ) {
 		m_SamplesRemaining.reset();
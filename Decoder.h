@@ -4,6 +4,7 @@
 #include <memory>
 #include <optional>
 #include <stdexcept>
+#include <vector>
 
 // Decoder interface.
 class Decoder
@@ -42,8 +43,10 @@ public:
 	// 'secondslimit' - number of seconds to devote to calculating an estimate, or 0 to perform a complete calculation.
 	virtual std::optional<float> CalculateTrackGain( CanContinue canContinue, const float secondsLimit = 0 );
 
-	// Skips any leading silence.
-	void SkipSilence();
+	// Skips any leading silence, returning the number of sample frames which were skipped.
+	// 'threshold' - sample magnitude at or below which a sample is considered to be silent.
+	// The first non-silent frame is returned by the next read.
+	int64_t SkipSilence( const float threshold = 0 );
 
 	// Returns whether stream titles are supported.
 	virtual bool SupportsStreamTitles() const;
@@ -123,6 +126,12 @@ private:
 	// Remaining number of samples to read (for tracks from cue files).
 	std::optional<int64_t> m_SamplesRemaining;
 
+	// Sample data which has been read ahead of the current position when skipping silence, to be returned by the next read.
+	std::vector<float> m_PendingSamples;
+
+	// Offset of the next sample to return from the pending sample data.
+	size_t m_PendingOffset = 0;
+
 	// Decoder context.
 	const Context m_Context;
 };
@@ -0,0 +1,192 @@
+#include "DecoderBenchmark.h"
+
+#include "bass.h"
+
+#include "MediaInfo.h"
+#include "Utility.h"
+
+#include "json.hpp"
+
+#include <Psapi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <set>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Number of sample frames to read from the decoder at a time.
+constexpr long kReadFrames = 4096;
+
+// Number of random seeks to perform for each file.
+constexpr size_t kSeekCount = 32;
+
+// Random seed for the seek positions, so that each run seeks to the same positions.
+constexpr uint32_t kSeekSeed = 1974;
+
+// Returns the number of seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Returns the 'percentile' (0 to 100) of the 'values', or zero if there are no values.
+static double GetPercentile( std::vector<double> values, const double percentile )
+{
+	if ( values.empty() ) {
+		return 0;
+	}
+	std::sort( values.begin(), values.end() );
+	const size_t index = static_cast<size_t>( std::lround( ( values.size() - 1 ) * percentile / 100 ) );
+	return values[ std::min( index, values.size() - 1 ) ];
+}
+
+DecoderBenchmark::DecoderBenchmark( const Handlers& handlers ) :
+	m_Handlers( handlers )
+{
+}
+
+DecoderBenchmark::~DecoderBenchmark()
+{
+}
+
+DecoderBenchmark::Results DecoderBenchmark::Run( const std::filesystem::path& folder ) const
+{
+	// Decoding via BASS requires initialisation, but does not need an output device.
+	const bool bassInitialised = BASS_Init( 0 /*device*/, 48000 /*freq*/, 0 /*flags*/, NULL /*hwnd*/, NULL /*dsGUID*/ );
+
+	const std::set<std::wstring> extensions = m_Handlers.GetAllSupportedFileExtensions();
+	std::set<std::filesystem::path> filenames;
+	std::error_code ec;
+	for ( const auto& entry : std::filesystem::recursive_directory_iterator( folder, ec ) ) {
+		if ( entry.is_regular_file( ec ) && ( extensions.end() != extensions.find( GetFileExtension( entry.path() ) ) ) ) {
+			filenames.insert( entry.path() );
+		}
+	}
+
+	Results results;
+	for ( const auto& filename : filenames ) {
+		results.push_back( Benchmark( filename ) );
+	}
+
+	if ( bassInitialised ) {
+		BASS_Free();
+	}
+	return results;
+}
+
+DecoderBenchmark::Result DecoderBenchmark::Benchmark( const std::filesystem::path& filename ) const
+{
+	Result result;
+	result.Filename = filename;
+	result.Format = GetFileExtension( filename );
+	std::error_code ec;
+	result.FileSize = std::filesystem::file_size( filename, ec );
+
+	const MediaInfo mediaInfo( filename );
+	Decoder::Ptr decoder = m_Handlers.OpenDecoder( mediaInfo, Decoder::Context::Output );
+	if ( !decoder ) {
+		return result;
+	}
+	result.Opened = true;
+	result.SampleRate = decoder->GetSampleRate();
+	result.Channels = decoder->GetChannels();
+	result.BitsPerSample = decoder->GetBPS();
+	result.Duration = decoder->GetDuration();
+	if ( ( result.SampleRate <= 0 ) || ( result.Channels <= 0 ) ) {
+		return result;
+	}
+
+	// Decode the whole file.
+	std::vector<float> buffer( static_cast<size_t>( kReadFrames ) * result.Channels );
+	auto start = std::chrono::steady_clock::now();
+	long framesRead = decoder->ReadSamples( buffer.data(), kReadFrames );
+	while ( framesRead > 0 ) {
+		result.DecodedFrames += static_cast<uint64_t>( framesRead );
+		framesRead = decoder->ReadSamples( buffer.data(), kReadFrames );
+	}
+	result.DecodeSeconds = GetElapsedSeconds( start );
+	if ( result.DecodeSeconds > 0 ) {
+		result.DecodeMBPerSecond = result.FileSize / ( 1024.0 * 1024.0 ) / result.DecodeSeconds;
+		result.RealtimeFactor = ( static_cast<double>( result.DecodedFrames ) / result.SampleRate ) / result.DecodeSeconds;
+	}
+
+	// Seek to random positions, reading the first block after each seek.
+	if ( result.Duration > 0 ) {
+		std::mt19937 engine( kSeekSeed );
+		std::uniform_real_distribution<double> distribution( 0, result.Duration );
+		for ( size_t seek = 0; seek < kSeekCount; seek++ ) {
+			const double position = distribution( engine );
+			start = std::chrono::steady_clock::now();
+			decoder->SetPosition( position );
+			decoder->ReadSamples( buffer.data(), kReadFrames );
+			result.SeekMilliseconds.push_back( 1000 * GetElapsedSeconds( start ) );
+		}
+	}
+	decoder.reset();
+
+	// Calculate the track gain, using a separate decoder as the gain calculator would.
+	if ( const Decoder::Ptr gainDecoder = m_Handlers.OpenDecoder( mediaInfo, Decoder::Context::Temporary ); gainDecoder ) {
+		start = std::chrono::steady_clock::now();
+		result.TrackGain = gainDecoder->CalculateTrackGain( [] () { return true; } );
+		result.GainSeconds = GetElapsedSeconds( start );
+	}
+
+	return result;
+}
+
+bool DecoderBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+
+		PROCESS_MEMORY_COUNTERS memProcess = {};
+		memProcess.cb = sizeof( PROCESS_MEMORY_COUNTERS );
+		if ( GetProcessMemoryInfo( GetCurrentProcess(), &memProcess, memProcess.cb ) ) {
+			doc[ "peakWorkingSetBytes" ] = static_cast<uint64_t>( memProcess.PeakWorkingSetSize );
+		}
+
+		nlohmann::json files = nlohmann::json::array();
+		for ( const auto& result : results ) {
+			nlohmann::json file;
+			file[ "filename" ] = WideStringToUTF8( result.Filename );
+			file[ "format" ] = WideStringToUTF8( result.Format );
+			file[ "opened" ] = result.Opened;
+			if ( result.Opened ) {
+				file[ "sampleRate" ] = result.SampleRate;
+				file[ "channels" ] = result.Channels;
+				if ( result.BitsPerSample ) {
+					file[ "bitsPerSample" ] = *result.BitsPerSample;
+				}
+				file[ "durationSeconds" ] = result.Duration;
+				file[ "fileBytes" ] = result.FileSize;
+				file[ "decodedFrames" ] = result.DecodedFrames;
+				file[ "decodeSeconds" ] = result.DecodeSeconds;
+				file[ "decodeMBPerSecond" ] = result.DecodeMBPerSecond;
+				file[ "realtimeFactor" ] = result.RealtimeFactor;
+				file[ "seekCount" ] = result.SeekMilliseconds.size();
+				file[ "seekMilliseconds" ] = {
+					{ "p50", GetPercentile( result.SeekMilliseconds, 50 ) },
+					{ "p90", GetPercentile( result.SeekMilliseconds, 90 ) },
+					{ "p99", GetPercentile( result.SeekMilliseconds, 99 ) },
+					{ "max", GetPercentile( result.SeekMilliseconds, 100 ) }
+				};
+				file[ "gainSeconds" ] = result.GainSeconds;
+				if ( result.TrackGain ) {
+					file[ "trackGain" ] = *result.TrackGain;
+				}
+			}
+			files.push_back( file );
+		}
+		doc[ "files" ] = files;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good();
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
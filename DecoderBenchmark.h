@@ -0,0 +1,57 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "Handlers.h"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Measures the decoding performance of the audio format handlers, for a corpus of audio files.
+// The benchmark is run headless using the '-benchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class DecoderBenchmark
+{
+public:
+	// Benchmark results for a single file.
+	struct Result {
+		std::wstring Filename;                  // Filename.
+		std::wstring Format;                    // File extension.
+		bool Opened = false;                    // Whether a decoder could be opened for the file.
+		long SampleRate = 0;                    // Sample rate.
+		long Channels = 0;                      // Channel count.
+		std::optional<long> BitsPerSample;      // Bits per sample (if relevant).
+		float Duration = 0;                     // Duration reported by the decoder, in seconds.
+		uint64_t FileSize = 0;                  // File size, in bytes.
+		uint64_t DecodedFrames = 0;             // Number of sample frames decoded.
+		double DecodeSeconds = 0;               // Wall clock time to decode the whole file, in seconds.
+		double DecodeMBPerSecond = 0;           // Decode speed, in megabytes of file data per wall clock second.
+		double RealtimeFactor = 0;              // Decode speed, in decoded seconds per wall clock second.
+		std::vector<double> SeekMilliseconds;   // Time taken for each random seek (including reading the first block after the seek), in milliseconds.
+		double GainSeconds = 0;                 // Wall clock time to calculate the track gain, in seconds.
+		std::optional<float> TrackGain;         // Calculated track gain, in dB.
+	};
+
+	// Benchmark results for all files.
+	using Results = std::vector<Result>;
+
+	// 'handlers' - audio format handlers.
+	DecoderBenchmark( const Handlers& handlers );
+
+	virtual ~DecoderBenchmark();
+
+	// Runs the benchmark for all supported files in the 'folder' (including subfolders), returning the results.
+	Results Run( const std::filesystem::path& folder ) const;
+
+	// Writes the benchmark 'results' to a JSON 'filename', together with the peak memory usage of the process.
+	// Returns true if the results were written.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+
+private:
+	// Runs the benchmark for a single 'filename'.
+	Result Benchmark( const std::filesystem::path& filename ) const;
+
+	// Audio format handlers.
+	const Handlers& m_Handlers;
+};
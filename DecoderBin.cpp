@@ -1,14 +1,12 @@
 #include "DecoderBin.h"
 
-#include "Utility.h"
+#include "SampleConversion.h"
 
 DecoderBin::DecoderBin( const std::wstring& filename, const Context context ) :
 	Decoder( context ),
-	m_Stream( filename, std::ios::binary )
+	m_Source( FileSource::Open( filename ) )
 {
-	m_Stream.seekg( 0, std::ios::end );
-	const auto filesize = m_Stream.tellg();
-	m_Stream.seekg( 0, std::ios::beg );
+	const uint64_t filesize = m_Source ? m_Source->GetSize() : 0;
 	if ( filesize > 0 ) {
 		SetBPS( 16 );
 		SetChannels( 2 );
@@ -21,21 +19,17 @@ DecoderBin::DecoderBin( const std::wstring& filename, const Context context ) :
 
 long DecoderBin::Read( float* buffer, const long sampleCount )
 {
-	const long bytesToRead = sampleCount * GetChannels() * ( *GetBPS() / 8 );
-	m_Buffer.resize( bytesToRead );
-	m_Stream.read( m_Buffer.data(), bytesToRead );
-	const auto bytesRead = m_Stream.gcount();
-	const long samplesRead = static_cast<long>( bytesRead / GetChannels() / ( *GetBPS() / 8 ) );
-	short* samples = reinterpret_cast<short*>( m_Buffer.data() );
-	for ( long i = 0; i < samplesRead * GetChannels(); i++ ) {
-		buffer[ i ] = Signed16ToFloat( samples[ i ] );
-	}
+	// Convert directly from the file data, without an intermediate copy.
+	const long frameSize = GetChannels() * ( *GetBPS() / 8 );
+	const auto data = m_Source->ReadSpan( static_cast<size_t>( sampleCount ) * frameSize );
+	const long samplesRead = static_cast<long>( data.size() / frameSize );
+	SampleConversion::Signed16ToFloat( reinterpret_cast<const int16_t*>( data.data() ), buffer, static_cast<size_t>( samplesRead ) * GetChannels() );
 	return samplesRead;
 }
 
 double DecoderBin::Seek( const double position )
 {
 	const size_t offset = static_cast<size_t>( position * GetSampleRate() * GetChannels() * ( *GetBPS() / 8 ) );
-	m_Stream.seekg( offset - offset % ( GetChannels() * ( *GetBPS() / 8 ) ), std::ios::beg );
+	m_Source->SetPosition( offset - offset % ( GetChannels() * ( *GetBPS() / 8 ) ) );
 	return position;
 }
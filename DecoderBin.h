@@ -1,10 +1,9 @@
 #pragma once
 
 #include "Decoder.h"
+#include "FileSource.h"
 
 #include <string>
-#include <fstream>
-#include <vector>
 
 // Decoder for raw audio data from bin/cue files (44100Hz, 16-bit, stereo).
 class DecoderBin : public Decoder
@@ -26,9 +25,6 @@ public:
 	double Seek( const double position ) override;
 
 private:
-	// File stream.
-	std::ifstream m_Stream;
-
-	// Scratch buffer.
-	std::vector<char> m_Buffer;
+	// File source.
+	FileSource::Ptr m_Source;
 };
@@ -1,6 +1,8 @@
 #include "DecoderCDDA.h"
 
-#include "Utility.h"
+#include "SampleConversion.h"
+
+#include <algorithm>
 
 DecoderCDDA::DecoderCDDA( const CDDAMedia& cddaMedia, const long track, const Context context ) :
 	Decoder( context ),
@@ -33,9 +35,12 @@ long DecoderCDDA::Read( float* buffer, const long sampleCount )
 	long outputBufPos = 0;
 	while ( samplesRead < sampleCount ) {
 		if ( m_CurrentBufPos < m_Buffer.size() ) {
-			buffer[ outputBufPos++ ] = Signed16ToFloat( m_Buffer[ m_CurrentBufPos++ ] );
-			buffer[ outputBufPos++ ] = Signed16ToFloat( m_Buffer[ m_CurrentBufPos++ ] );
-			++samplesRead;
+			// Convert as much of the current sector as is required.
+			const long frames = std::min<long>( sampleCount - samplesRead, static_cast<long>( ( m_Buffer.size() - m_CurrentBufPos ) / 2 ) );
+			SampleConversion::Signed16ToFloat( m_Buffer.data() + m_CurrentBufPos, buffer + outputBufPos, static_cast<size_t>( frames ) * 2 );
+			m_CurrentBufPos += frames * 2;
+			outputBufPos += frames * 2;
+			samplesRead += frames;
 		} else {
 			if ( ( m_CurrentSector < m_SectorEnd ) && ( m_CDDAMedia.Read( m_Handle, m_CurrentSector++, true /*useCache*/, m_Buffer ) ) ) {
 				m_CurrentBufPos = 0;
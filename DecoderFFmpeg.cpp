@@ -2,6 +2,8 @@
 
 #include "Utility.h"
 
+#include <cmath>
+
 extern "C"
 {
 #include <libavcodec/avcodec.h>
@@ -9,6 +11,15 @@ extern "C"
 #include <libswresample/swresample.h>
 }
 
+// Minimum interval between seek index points, in seconds.
+constexpr double kSeekIndexInterval = 1.0;
+
+// Maximum distance of a seek point before a seek position, in seconds (beyond which it is quicker to let the demuxer search the file).
+constexpr double kSeekIndexMaximumDistance = 2 * kSeekIndexInterval;
+
+// Minimum number of samples to decode (and discard) before a seek position.
+constexpr int64_t kMinimumSeekPreroll = 2048;
+
 DecoderFFmpeg::DecoderFFmpeg( const std::wstring& filename, const Context context ) :
 	Decoder( context )
 {
@@ -37,6 +48,10 @@ DecoderFFmpeg::DecoderFFmpeg( const std::wstring& filename, const Context contex
 								} else {
 									SetDuration( static_cast<float>( m_FormatContext->duration ) / AV_TIME_BASE );
 								}
+								m_TimeBase = stream->time_base;
+								m_StartTime = ( AV_NOPTS_VALUE != stream->start_time ) ? stream->start_time : 0;
+								m_SeekPreroll = std::max<int64_t>( { kMinimumSeekPreroll, codecParams->seek_preroll, codecParams->frame_size } );
+								m_CanSeekByPosition = ( nullptr != m_FormatContext->iformat ) && ( 0 == ( m_FormatContext->iformat->flags & AVFMT_NO_BYTE_SEEK ) );
 
 								m_DecoderContext = avcodec_alloc_context3( codec );
 								if ( nullptr != m_DecoderContext ) {
@@ -73,6 +88,8 @@ DecoderFFmpeg::DecoderFFmpeg( const std::wstring& filename, const Context contex
 		FreeContexts();
 		throw std::runtime_error( "DecoderFFmpeg could not load file" );
 	}
+
+	m_SeekIndex = SeekIndex::Get( filename );
 }
 
 DecoderFFmpeg::~DecoderFFmpeg()
@@ -99,19 +116,63 @@ void DecoderFFmpeg::FreeContexts()
 	}
 }
 
+int64_t DecoderFFmpeg::TimestampToSample( const int64_t timestamp ) const
+{
+	return av_rescale_q( timestamp - m_StartTime, m_TimeBase, { 1, static_cast<int>( GetSampleRate() ) } );
+}
+
+int64_t DecoderFFmpeg::SampleToTimestamp( const int64_t sample ) const
+{
+	return m_StartTime + av_rescale_q( sample, { 1, static_cast<int>( GetSampleRate() ) }, m_TimeBase );
+}
+
+int64_t DecoderFFmpeg::GetReadPosition() const
+{
+	return m_DecodePosition - static_cast<int64_t>( ( m_Buffer.size() - m_BufferPosition ) / GetChannels() );
+}
+
+void DecoderFFmpeg::AddSeekPoint()
+{
+	if ( m_SeekIndex && ( nullptr != m_Packet ) && ( m_StreamIndex == m_Packet->stream_index ) && ( AV_PKT_FLAG_KEY & m_Packet->flags ) && ( AV_NOPTS_VALUE != m_Packet->pts ) ) {
+		const int64_t interval = static_cast<int64_t>( kSeekIndexInterval * GetSampleRate() );
+		m_SeekIndex->Add( TimestampToSample( m_Packet->pts ), { m_Packet->pos, m_Packet->pts }, interval );
+	}
+}
+
 void DecoderFFmpeg::ConvertSampleData( const AVFrame* frame )
 {
 	if ( nullptr == frame )
 		return;
 
+	int64_t frameStart = m_DecodePosition;
+	if ( m_SyncToTimestamp ) {
+		if ( AV_NOPTS_VALUE != frame->best_effort_timestamp ) {
+			frameStart = TimestampToSample( frame->best_effort_timestamp );
+		}
+		m_SyncToTimestamp = false;
+	}
+
 	const size_t previousBufferSize = m_Buffer.size();
 	m_Buffer.resize( previousBufferSize + frame->nb_samples * GetChannels() );
 	uint8_t* buffer = reinterpret_cast<uint8_t*>( m_Buffer.data() + previousBufferSize );
 	const int samples = swr_convert( m_ResamplerContext, &buffer, frame->nb_samples, frame->data, frame->nb_samples );
 	if ( samples > 0 ) {
 		m_Buffer.resize( previousBufferSize + samples * GetChannels() );
+		m_DecodePosition = frameStart + samples;
 	} else {
 		m_Buffer.resize( previousBufferSize );
+		m_DecodePosition = frameStart;
+	}
+
+	if ( m_SeekTarget ) {
+		// Discard any samples before the seek position.
+		if ( m_DecodePosition <= *m_SeekTarget ) {
+			m_Buffer.resize( previousBufferSize );
+		} else {
+			const int64_t discard = std::max<int64_t>( 0, *m_SeekTarget - frameStart );
+			m_Buffer.erase( m_Buffer.begin() + previousBufferSize, m_Buffer.begin() + previousBufferSize + discard * GetChannels() );
+			m_SeekTarget.reset();
+		}
 	}
 }
 
@@ -126,6 +187,7 @@ bool DecoderFFmpeg::Decode()
 			m_Packet = nullptr;
 		}
 		if ( ( nullptr == m_Packet ) || ( m_StreamIndex == m_Packet->stream_index ) ) {
+			AddSeekPoint();
 			int result = avcodec_send_packet( m_DecoderContext, m_Packet );
 			while ( result >= 0 ) {
 				result = avcodec_receive_frame( m_DecoderContext, m_Frame );
@@ -163,6 +225,42 @@ double DecoderFFmpeg::Seek( const double position )
 {
 	m_Buffer.clear();
 	m_BufferPosition = 0;
-	const int64_t ts( position * AV_TIME_BASE );
-	return ( avformat_seek_file( m_FormatContext, -1, INT64_MIN, ts, ts, 0 ) < 0 ) ? 0 : position;
+	m_SeekTarget.reset();
+
+	const int64_t targetSample = std::max<int64_t>( 0, std::llround( position * GetSampleRate() ) );
+	const int64_t prerollSample = std::max<int64_t>( 0, targetSample - m_SeekPreroll );
+
+	// Use the seek index where there is a point close enough to the seek position (seeking by byte position avoids a demuxer search, if the format supports it).
+	// In all cases the decode position is synced to the first decoded frame timestamp, and seek points continue to be recorded (so that a sparse index is filled in).
+	bool seeked = false;
+	const int64_t maximumDistance = static_cast<int64_t>( kSeekIndexMaximumDistance * GetSampleRate() );
+	if ( const auto seekPoint = m_SeekIndex ? m_SeekIndex->Find( prerollSample, maximumDistance ) : std::nullopt; seekPoint ) {
+		const auto& [sample, point] = *seekPoint;
+		if ( m_CanSeekByPosition && ( point.Offset >= 0 ) ) {
+			seeked = ( av_seek_frame( m_FormatContext, m_StreamIndex, point.Offset, AVSEEK_FLAG_BYTE ) >= 0 );
+		} else {
+			seeked = ( avformat_seek_file( m_FormatContext, m_StreamIndex, INT64_MIN, point.Hint, point.Hint, 0 ) >= 0 );
+		}
+		m_DecodePosition = sample;
+	}
+	if ( !seeked ) {
+		const int64_t timestamp = SampleToTimestamp( prerollSample );
+		seeked = ( avformat_seek_file( m_FormatContext, m_StreamIndex, INT64_MIN, timestamp, timestamp, 0 ) >= 0 );
+		m_DecodePosition = prerollSample;
+	}
+	if ( !seeked ) {
+		return 0;
+	}
+	m_SyncToTimestamp = true;
+
+	avcodec_flush_buffers( m_DecoderContext );
+	if ( nullptr == m_Packet ) {
+		m_Packet = av_packet_alloc();
+	}
+
+	// Decode up to the requested position, so that the actual position can be returned.
+	m_SeekTarget = targetSample;
+	Decode();
+	m_SeekTarget.reset();
+	return static_cast<double>( GetReadPosition() ) / GetSampleRate();
 }
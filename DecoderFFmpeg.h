@@ -1,9 +1,15 @@
 #pragma once
 
 #include "Decoder.h"
+#include "SeekIndex.h"
 
 #include <string>
 
+extern "C"
+{
+#include <libavutil/rational.h>
+}
+
 struct AVCodecContext;
 struct AVFormatContext;
 struct AVFrame;
@@ -27,10 +33,23 @@ public:
 	long Read( float* buffer, const long sampleCount ) override;
 
 	// Seeks to a 'position' in the stream, in seconds.
+	// Seeking is sample accurate, with decoded samples being discarded up to the requested position.
 	// Returns the new position in seconds.
 	double Seek( const double position ) override;
 
 private:
+	// Converts a stream 'timestamp' to a sample position.
+	int64_t TimestampToSample( const int64_t timestamp ) const;
+
+	// Converts a 'sample' position to a stream timestamp.
+	int64_t SampleToTimestamp( const int64_t sample ) const;
+
+	// Returns the sample position of the next sample to be read.
+	int64_t GetReadPosition() const;
+
+	// Adds a seek point for the current packet to the seek index.
+	void AddSeekPoint();
+
 	// Deccodes the next chunk of data into the sample buffer, returning whether any data was decoded.
 	bool Decode();
 
@@ -63,4 +82,28 @@ private:
 
 	// Current buffer position.
 	size_t m_BufferPosition = 0;
+
+	// Stream time base.
+	AVRational m_TimeBase = {};
+
+	// Stream start time, in stream time base units.
+	int64_t m_StartTime = 0;
+
+	// The number of samples to decode (and discard) before a seek position, to allow the decoder to settle.
+	int64_t m_SeekPreroll = 0;
+
+	// Sample position of the end of the sample buffer.
+	int64_t m_DecodePosition = 0;
+
+	// Sample position up to which decoded samples are to be discarded, following a seek.
+	std::optional<int64_t> m_SeekTarget;
+
+	// Indicates whether the decode position should be synchronised to the timestamp of the next decoded frame.
+	bool m_SyncToTimestamp = false;
+
+	// Indicates whether the file format supports seeking by byte position.
+	bool m_CanSeekByPosition = false;
+
+	// Seek index for the file (the point offset is the packet byte position, and the point hint is the packet timestamp).
+	SeekIndex::Ptr m_SeekIndex;
 };
@@ -1,16 +1,26 @@
 #include "DecoderFlac.h"
 
+#include "SampleConversion.h"
+#include "StreamProbe.h"
+
+// Minimum interval between seek index points, in seconds.
+constexpr double kSeekIndexInterval = 1.0;
+
+// Maximum distance of a seek point before a seek position, in seconds (beyond which it is quicker to search the file).
+constexpr double kSeekIndexMaximumDistance = 2 * kSeekIndexInterval;
+
 DecoderFlac::DecoderFlac( const std::wstring& filename, const Context context ) :
 	Decoder( context ),
 	FLAC::Decoder::Stream(),
-	m_FileStream(),
+	m_FileSource(),
 	m_FLACFrame(),
 	m_FrameBuffer(),
 	m_FramePos( 0 ),
-	m_Valid( false )
+	m_Valid( false ),
+	m_SeekIndex()
 {
-	m_FileStream.open( filename, std::ios::binary | std::ios::in );
-	if ( m_FileStream.is_open() ) {
+	m_FileSource = FileSource::Open( filename );
+	if ( m_FileSource ) {
 		if ( init() == FLAC__STREAM_DECODER_INIT_STATUS_OK ) {
 			process_until_end_of_metadata();
 		}
@@ -18,9 +28,10 @@ DecoderFlac::DecoderFlac( const std::wstring& filename, const Context context )
 
 	if ( m_Valid ) {
 		SetBitrate( CalculateBitrate() );
+		m_SeekIndex = SeekIndex::Get( filename );
 	} else {
 		finish();
-		m_FileStream.close();
+		m_FileSource.reset();
 		throw std::runtime_error( "DecoderFlac could not load file" );
 	}
 }
@@ -28,7 +39,6 @@ DecoderFlac::DecoderFlac( const std::wstring& filename, const Context context )
 DecoderFlac::~DecoderFlac()
 {
 	finish();
-	m_FileStream.close();
 }
 
 long DecoderFlac::Read( float* buffer, const long sampleCount )
@@ -59,7 +69,10 @@ double DecoderFlac::Seek( const double position )
 	double seekPosition = 0;
 	m_FramePos = 0;
 	m_FLACFrame = {};
-	if ( ( GetSampleRate() > 0 ) && seek_absolute( static_cast<FLAC__uint64>( position * GetSampleRate() ) ) ) {
+	const FLAC__uint64 sample = static_cast<FLAC__uint64>( std::max( 0.0, position ) * GetSampleRate() );
+	if ( ( GetSampleRate() > 0 ) && SeekUsingIndex( sample ) ) {
+		seekPosition = static_cast<double>( m_FLACFrame.header.number.sample_number + m_FramePos ) / GetSampleRate();
+	} else if ( ( GetSampleRate() > 0 ) && seek_absolute( sample ) ) {
 		seekPosition = static_cast<double>( m_FLACFrame.header.number.sample_number ) / GetSampleRate();
 	} else {
 		reset();
@@ -68,42 +81,48 @@ double DecoderFlac::Seek( const double position )
 	return seekPosition;
 }
 
-std::optional<float> DecoderFlac::CalculateBitrate()
+bool DecoderFlac::SeekUsingIndex( const FLAC__uint64 sample )
 {
-	std::optional<float> bitrate;
-	if ( const float duration = GetDuration(); ( duration > 0 ) && m_FileStream.good() ) {
-		const auto initial = m_FileStream.tellg();
-
-		m_FileStream.seekg( 0, std::ios_base::end );
-		const long long filesize = m_FileStream.tellg();
-		m_FileStream.seekg( 0, std::ios_base::beg );
-
-		std::vector<char> block( 4 );
-		m_FileStream.read( block.data(), 4 );
-		if ( ( 'f' == block[ 0 ] ) && ( 'L' == block[ 1 ] ) && ( 'a' == block[ 2 ] ) && ( 'C' == block[ 3 ] ) ) {
-			m_FileStream.read( block.data(), 4 );
-			while ( m_FileStream.good() ) {
-				const long long currentPos = m_FileStream.tellg();
-				const unsigned long blockSize = ( static_cast<unsigned char>( block[ 1 ] ) << 16 ) | ( static_cast<unsigned char>( block[ 2 ] ) << 8 ) | static_cast<unsigned char>( block[ 3 ] );
-				if ( ( currentPos + blockSize ) < filesize ) {
-					const bool lastBlock = block[ 0 ] & 0x80;
-					if ( lastBlock ) {
-						const long long streamsize = filesize - currentPos - blockSize;
-						bitrate = ( streamsize * 8 ) / ( duration * 1000 );
-						break;
-					}
-				} else {
-					break;
-				}
-				m_FileStream.seekg( blockSize, std::ios_base::cur );
-				m_FileStream.read( block.data(), 4 );
-			};
+	const int64_t maximumDistance = static_cast<int64_t>( kSeekIndexMaximumDistance * GetSampleRate() );
+	const auto seekPoint = m_SeekIndex ? m_SeekIndex->Find( static_cast<int64_t>( sample ), maximumDistance ) : std::nullopt;
+	if ( !seekPoint || ( seekPoint->second.Offset < 0 ) ) {
+		return false;
+	}
+
+	// Restart decoding from the indexed frame, then decode forward to the frame containing the seek position.
+	const auto& [pointSample, point] = *seekPoint;
+	if ( !flush() ) {
+		return false;
+	}
+	m_FileSource->SetPosition( static_cast<uint64_t>( point.Offset ) );
+	bool firstFrame = true;
+	while ( process_single() && ( m_FLACFrame.header.blocksize > 0 ) ) {
+		const FLAC__uint64 frameStart = m_FLACFrame.header.number.sample_number;
+		if ( firstFrame && ( frameStart != static_cast<FLAC__uint64>( pointSample ) ) ) {
+			// The seek point does not match the stream.
+			break;
+		}
+		firstFrame = false;
+		if ( ( frameStart + m_FLACFrame.header.blocksize ) > sample ) {
+			m_FramePos = static_cast<uint32_t>( sample - frameStart );
+			return true;
 		}
+	}
+
+	m_FramePos = 0;
+	m_FLACFrame = {};
+	flush();
+	return false;
+}
 
-		if ( !m_FileStream.good() ) {
-			m_FileStream.clear();
+std::optional<float> DecoderFlac::CalculateBitrate()
+{
+	std::optional<float> bitrate;
+	if ( const float duration = GetDuration(); ( duration > 0 ) && m_FileSource ) {
+		if ( const auto audioOffset = StreamProbe::GetFLACAudioOffset( *m_FileSource ); audioOffset ) {
+			const long long streamsize = static_cast<long long>( m_FileSource->GetSize() - *audioOffset );
+			bitrate = ( streamsize * 8 ) / ( duration * 1000 );
 		}
-		m_FileStream.seekg( initial );
 	}
 	return bitrate;
 }
@@ -111,12 +130,11 @@ std::optional<float> DecoderFlac::CalculateBitrate()
 FLAC__StreamDecoderReadStatus DecoderFlac::read_callback( FLAC__byte buf[], size_t * size )
 {
 	FLAC__StreamDecoderReadStatus status = FLAC__STREAM_DECODER_READ_STATUS_ABORT;
-	if ( m_FileStream.eof() ) {
+	if ( m_FileSource->IsEOF() ) {
 		*size = 0;
 		status = FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
 	} else {
-		m_FileStream.read( reinterpret_cast<char*>( buf ), *size );
-		*size = static_cast<size_t>( m_FileStream.gcount() );
+		*size = m_FileSource->Read( buf, *size );
 		if ( *size > 0 ) {
 			status = FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
 		}
@@ -126,37 +144,24 @@ FLAC__StreamDecoderReadStatus DecoderFlac::read_callback( FLAC__byte buf[], size
 
 FLAC__StreamDecoderSeekStatus DecoderFlac::seek_callback( FLAC__uint64 pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	m_FileStream.seekg( pos, std::ios_base::beg );
-	return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+	return m_FileSource->SetPosition( pos ) ? FLAC__STREAM_DECODER_SEEK_STATUS_OK : FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
 }
 
 FLAC__StreamDecoderTellStatus DecoderFlac::tell_callback( FLAC__uint64 * pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	*pos = m_FileStream.tellg();
+	*pos = m_FileSource->GetPosition();
 	return FLAC__STREAM_DECODER_TELL_STATUS_OK;
 }
 
 FLAC__StreamDecoderLengthStatus DecoderFlac::length_callback( FLAC__uint64 * pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	const std::streampos currentPos = m_FileStream.tellg();
-	m_FileStream.seekg( 0, std::ios_base::end );
-	*pos = m_FileStream.tellg();
-	m_FileStream.seekg( currentPos );
+	*pos = m_FileSource->GetSize();
 	return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
 }
 
 bool DecoderFlac::eof_callback()
 {
-	const bool eof = m_FileStream.eof();
+	const bool eof = m_FileSource->IsEOF();
 	return eof;
 }
 
@@ -164,11 +169,12 @@ FLAC__StreamDecoderWriteStatus DecoderFlac::write_callback( const FLAC__Frame *
 {
 	m_FLACFrame = *frame;
 	m_FrameBuffer.resize( m_FLACFrame.header.blocksize * m_FLACFrame.header.channels );
-	uint32_t offset = 0;
-	for ( uint32_t sample = 0; sample < m_FLACFrame.header.blocksize; sample++ ) {
-		for ( uint32_t channel = 0; channel < m_FLACFrame.header.channels; channel++ ) {
-			m_FrameBuffer[ offset++ ] = static_cast<float>( buffer[ channel ][ sample ] ) / ( 1ul << ( m_FLACFrame.header.bits_per_sample - 1ul ) );
-		}
+	SampleConversion::PlanarSigned32ToFloat( buffer, m_FrameBuffer.data(), m_FLACFrame.header.blocksize, m_FLACFrame.header.channels, m_FLACFrame.header.bits_per_sample );
+
+	// The decode position is the end of this frame, which is the start of the next frame.
+	if ( FLAC__uint64 position = 0; m_SeekIndex && ( m_FLACFrame.header.sample_rate > 0 ) && get_decode_position( &position ) ) {
+		const int64_t nextFrameStart = static_cast<int64_t>( m_FLACFrame.header.number.sample_number + m_FLACFrame.header.blocksize );
+		m_SeekIndex->Add( nextFrameStart, { static_cast<int64_t>( position ), 0 }, static_cast<int64_t>( kSeekIndexInterval * m_FLACFrame.header.sample_rate ) );
 	}
 	return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
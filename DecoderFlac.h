@@ -1,9 +1,10 @@
 #pragma once
 #include "Decoder.h"
+#include "FileSource.h"
+#include "SeekIndex.h"
 
 #include "FLAC++\all.h"
 
-#include <fstream>
 #include <vector>
 
 // FLAC decoder
@@ -24,6 +25,7 @@ public:
 	long Read( float* buffer, const long sampleCount ) override;
 
 	// Seeks to a 'position' in the stream, in seconds.
+	// The seek index is used where possible, falling back to a search of the stream.
 	// Returns the new position in seconds.
 	double Seek( const double position ) override;
 
@@ -42,8 +44,11 @@ private:
 	// Calculates the bitrate of the FLAC stream (returns nullopt if the bitrate was not calculated).
 	std::optional<float> CalculateBitrate();
 
-	// Input file stream.
-	std::ifstream m_FileStream;
+	// Seeks to the 'sample' position using the seek index, returning whether the seek was successful.
+	bool SeekUsingIndex( const FLAC__uint64 sample );
+
+	// Input file source.
+	FileSource::Ptr m_FileSource;
 
 	// Current FLAC frame.
 	FLAC__Frame m_FLACFrame;
@@ -56,4 +61,7 @@ private:
 
 	// Indicates whether this is a valid FLAC stream.
 	bool m_Valid;
+
+	// Seek index for the file (the point offset is the byte position of a frame).
+	SeekIndex::Ptr m_SeekIndex;
 };
@@ -2,24 +2,67 @@
 
 #include "Utility.h"
 
+#include <vector>
+
+// Minimum interval between seek index points, in samples.
+constexpr ogg_int64_t kSeekIndexInterval = 48000;
+
+// Maximum distance of a seek point before a seek position, in samples (beyond which it is quicker to search the file).
+constexpr ogg_int64_t kSeekIndexMaximumDistance = 2 * kSeekIndexInterval;
+
+// Number of samples to decode (and discard) before a seek position, to allow the decoder to converge.
+constexpr ogg_int64_t kSeekPreroll = 3840;
+
+// Additional samples to allow for before a seek point, as decoding resumes from the page following the indexed byte position.
+constexpr ogg_int64_t kSeekPageAllowance = 48000;
+
+// Opus file callbacks, which read from a file source.
+static int ReadSource( void* stream, unsigned char* ptr, int nbytes )
+{
+	return ( nbytes > 0 ) ? static_cast<int>( static_cast<FileSource*>( stream )->Read( ptr, static_cast<size_t>( nbytes ) ) ) : 0;
+}
+
+static int SeekSource( void* stream, opus_int64 offset, int whence )
+{
+	FileSource* source = static_cast<FileSource*>( stream );
+	const opus_int64 origin = ( SEEK_CUR == whence ) ? static_cast<opus_int64>( source->GetPosition() ) : ( ( SEEK_END == whence ) ? static_cast<opus_int64>( source->GetSize() ) : 0 );
+	const opus_int64 position = origin + offset;
+	return ( ( position >= 0 ) && source->SetPosition( static_cast<uint64_t>( position ) ) ) ? 0 : -1;
+}
+
+static opus_int64 TellSource( void* stream )
+{
+	return static_cast<opus_int64>( static_cast<FileSource*>( stream )->GetPosition() );
+}
+
+static const OpusFileCallbacks s_SourceCallbacks = { ReadSource, SeekSource, TellSource, nullptr /*close*/ };
+
 DecoderOpus::DecoderOpus( const std::wstring& filename, const Context context ) :
 	Decoder( context ),
-	m_OpusFile( nullptr )
+	m_Source( FileSource::Open( filename ) ),
+	m_OpusFile( nullptr ),
+	m_SeekIndex(),
+	m_ChannelMixer()
 {
 	int error = 0;
-	const std::string filepath = WideStringToUTF8( filename );
-	m_OpusFile = op_open_file( filepath.c_str(), &error );
+	if ( m_Source ) {
+		m_OpusFile = op_open_callbacks( m_Source.get(), &s_SourceCallbacks, nullptr /*initialData*/, 0 /*initialBytes*/, &error );
+	}
 	if ( nullptr != m_OpusFile ) {
 		const OpusHead* head = op_head( m_OpusFile, -1 /*link*/ );
 		if ( nullptr != head ) {
 			SetSampleRate( 48000 );
 			SetChannels( head->channel_count );
+			if ( ( head->channel_count > 2 ) && ( head->channel_count <= 8 ) ) {
+				m_ChannelMixer = std::make_unique<ChannelMixer>( static_cast<uint32_t>( head->channel_count ), static_cast<uint32_t>( head->channel_count ), ChannelMixer::Order::Vorbis, ChannelMixer::Order::Wave );
+			}
 			const ogg_int64_t pcmTotal = op_pcm_total( m_OpusFile, -1 /*link*/ );
 			SetDuration( static_cast<float>( pcmTotal ) / 48000 );
 			const opus_int32 bitrate = op_bitrate( m_OpusFile, -1 );
 			if ( bitrate > 0 ) {
 				SetBitrate( static_cast<float>( bitrate ) / 1000 );
 			}
+			m_SeekIndex = SeekIndex::Get( filename );
 		}
 	} else {
 		throw std::runtime_error( "DecoderOpus could not load file" );
@@ -44,85 +87,15 @@ long DecoderOpus::Read( float* buffer, const long sampleCount )
 			const int result = op_read_float( m_OpusFile, buffer + samplesRead * channels, bufSize, nullptr /*link*/ );
 			if ( result > 0 ) {
 				// For multi-channel streams, change from Opus to BASS channel ordering.
-				switch ( channels ) {
-					case 3: {
-						// (left, center, right) ->
-						// (left, right, center)
-						int offset = samplesRead * channels;
-						for ( int n = 0; n < result; n++, offset += channels ) {
-							std::swap( buffer[ offset + 1 ], buffer[ offset + 2 ] );
-						}
-						break;
-					}
-					case 5: {
-						// (front left, front center, front right, rear left, rear right) ->
-						// (front left, front right, front center, rear left, rear right)
-						int offset = samplesRead * channels;
-						for ( int n = 0; n < result; n++, offset += channels ) {
-							std::swap( buffer[ offset + 1 ], buffer[ offset + 2 ] );
-						}
-						break;
-					}
-					case 6: {
-						// (front left, front center, front right, rear left, rear right, LFE) ->
-						// (front left, front right, front center, LFE, rear left, rear right)
-						int offset = samplesRead * channels;
-						for ( int n = 0; n < result; n++, offset += channels ) {
-							std::swap( buffer[ offset + 1 ], buffer[ offset + 2 ] );
-							const float rearL = buffer[ offset + 3 ];
-							const float rearR = buffer[ offset + 4 ];
-							const float lfe = buffer[ offset + 5 ];
-							buffer[ offset + 3 ] = lfe;
-							buffer[ offset + 4 ] = rearL;
-							buffer[ offset + 5 ] = rearR;
-						}
-						break;
-					}
-					case 7: {
-						// (front left, front center, front right, side left, side right, rear center, LFE) ->
-						// (front left, front right, front center, LFE, rear center, side left, side right)
-						int offset = samplesRead * channels;
-						for ( int n = 0; n < result; n++, offset += channels ) {
-							std::swap( buffer[ offset + 1 ], buffer[ offset + 2 ] );
-							const float sideL = buffer[ offset + 3 ];
-							const float sideR = buffer[ offset + 4 ];
-							const float rearC = buffer[ offset + 5 ];
-							const float lfe = buffer[ offset + 6 ];
-							buffer[ offset + 3 ] = lfe;
-							buffer[ offset + 4 ] = rearC;
-							buffer[ offset + 5 ] = sideL;
-							buffer[ offset + 6 ] = sideR;
-						}
-						break;
-					}
-					case 8: {
-						// (front left, front center, front right, side left, side right, rear left, rear right, LFE) ->
-						// (front left, front right, front center, LFE, rear left, rear right, side left, side right)
-						int offset = samplesRead * channels;
-						for ( int n = 0; n < result; n++, offset += channels ) {
-							std::swap( buffer[ offset + 1 ], buffer[ offset + 2 ] );
-							const float sideL = buffer[ offset + 3 ];
-							const float sideR = buffer[ offset + 4 ];
-							const float rearL = buffer[ offset + 5 ];
-							const float rearR = buffer[ offset + 6 ];
-							const float lfe = buffer[ offset + 7 ];
-							buffer[ offset + 3 ] = lfe;
-							buffer[ offset + 4 ] = rearL;
-							buffer[ offset + 5 ] = rearR;
-							buffer[ offset + 6 ] = sideL;
-							buffer[ offset + 7 ] = sideR;
-						}
-						break;
-					}
-					default: {
-						break;
-					}
+				if ( m_ChannelMixer ) {
+					m_ChannelMixer->Process( buffer + samplesRead * channels, buffer + samplesRead * channels, static_cast<size_t>( result ) );
 				}
 				samplesRead += result;
 			} else {
 				break;
 			}
 		}
+		AddSeekPoint();
 	}
 	return samplesRead;
 }
@@ -130,6 +103,44 @@ long DecoderOpus::Read( float* buffer, const long sampleCount )
 double DecoderOpus::Seek( const double position )
 {
 	const ogg_int64_t offset = static_cast<ogg_int64_t>( position * GetSampleRate() );
+	if ( SeekUsingIndex( offset ) ) {
+		return position;
+	}
 	const double seekPosition = ( 0 == op_pcm_seek( m_OpusFile, offset ) ) ? position : 0;
 	return seekPosition;
 }
+
+bool DecoderOpus::SeekUsingIndex( const ogg_int64_t sample )
+{
+	const auto seekPoint = m_SeekIndex ? m_SeekIndex->Find( sample - kSeekPreroll - kSeekPageAllowance, kSeekIndexMaximumDistance ) : std::nullopt;
+	if ( !seekPoint || ( seekPoint->second.Offset < 0 ) || ( 0 != op_raw_seek( m_OpusFile, seekPoint->second.Offset ) ) ) {
+		return false;
+	}
+
+	// Decode forward to the seek position, provided decoding has resumed far enough before it for the decoder to converge.
+	ogg_int64_t position = op_pcm_tell( m_OpusFile );
+	if ( ( position < 0 ) || ( position > ( sample - kSeekPreroll ) ) ) {
+		return false;
+	}
+	const long channels = std::max<long>( 1, GetChannels() );
+	const ogg_int64_t discardSize = 5760;
+	std::vector<float> discard( discardSize * channels );
+	while ( position < sample ) {
+		const int samplesToRead = static_cast<int>( std::min( sample - position, discardSize ) );
+		const int result = op_read_float( m_OpusFile, discard.data(), samplesToRead * channels, nullptr /*link*/ );
+		if ( result <= 0 ) {
+			return false;
+		}
+		position += result;
+	}
+	return true;
+}
+
+void DecoderOpus::AddSeekPoint()
+{
+	if ( m_SeekIndex ) {
+		if ( const ogg_int64_t sample = op_pcm_tell( m_OpusFile ), offset = op_raw_tell( m_OpusFile ); ( sample >= 0 ) && ( offset >= 0 ) ) {
+			m_SeekIndex->Add( sample, { offset, 0 }, kSeekIndexInterval );
+		}
+	}
+}
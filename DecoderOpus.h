@@ -1,6 +1,10 @@
 #pragma once
+#include "ChannelMixer.h"
 #include "Decoder.h"
+#include "FileSource.h"
+#include "SeekIndex.h"
 
+#include <memory>
 #include <string>
 
 #include "Opusfile.h"
@@ -23,10 +27,26 @@ public:
 	long Read( float* buffer, const long sampleCount ) override;
 
 	// Seeks to a 'position' in the stream, in seconds.
+	// The seek index is used where possible, falling back to a search of the stream.
 	// Returns the new position in seconds.
 	double Seek( const double position ) override;
 
 private:
+	// Seeks to the 'sample' position using the seek index, returning whether the seek was successful.
+	bool SeekUsingIndex( const ogg_int64_t sample );
+
+	// Adds a seek point for the current position to the seek index.
+	void AddSeekPoint();
+
+	// Opus file source.
+	FileSource::Ptr m_Source;
+
 	// Opus file
 	OggOpusFile* m_OpusFile;
+
+	// Seek index for the file (the point offset is the byte position of the next page to be read).
+	SeekIndex::Ptr m_SeekIndex;
+
+	// Channel mixer, used to change from Opus to BASS channel ordering for multi-channel streams.
+	std::unique_ptr<ChannelMixer> m_ChannelMixer;
 };
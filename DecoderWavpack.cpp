@@ -1,15 +1,83 @@
 #include "DecoderWavpack.h"
 
+#include "SampleConversion.h"
 #include "Utility.h"
 
+#include <cstring>
+#include <vector>
+
+// WavPack file open flags.
+constexpr int kOpenFlags = OPEN_WVC | OPEN_NORMALIZE | OPEN_DSD_AS_PCM;
+
+// Minimum interval between seek index points, in seconds.
+constexpr double kSeekIndexInterval = 1.0;
+
+// Maximum distance of a seek point before a seek position, in seconds (beyond which it is quicker to let the library search the file).
+constexpr double kSeekIndexMaximumDistance = 2 * kSeekIndexInterval;
+
+// Number of samples to decode (and discard) at a time, when decoding forward from a seek point.
+constexpr uint32_t kSeekDiscardSize = 4096;
+
+// WavPack stream reader callbacks, which read from a file source.
+static int32_t ReadSource( void* id, void* data, int32_t bcount )
+{
+	return ( bcount > 0 ) ? static_cast<int32_t>( static_cast<FileSource*>( id )->Read( data, static_cast<size_t>( bcount ) ) ) : 0;
+}
+
+static int64_t GetSourcePosition( void* id )
+{
+	return static_cast<int64_t>( static_cast<FileSource*>( id )->GetPosition() );
+}
+
+static int SetSourcePositionAbsolute( void* id, int64_t pos )
+{
+	return ( ( pos >= 0 ) && static_cast<FileSource*>( id )->SetPosition( static_cast<uint64_t>( pos ) ) ) ? 0 : -1;
+}
+
+static int SetSourcePositionRelative( void* id, int64_t delta, int mode )
+{
+	FileSource* source = static_cast<FileSource*>( id );
+	const int64_t origin = ( SEEK_CUR == mode ) ? static_cast<int64_t>( source->GetPosition() ) : ( ( SEEK_END == mode ) ? static_cast<int64_t>( source->GetSize() ) : 0 );
+	return SetSourcePositionAbsolute( id, origin + delta );
+}
+
+static int PushBackSourceByte( void* id, int c )
+{
+	FileSource* source = static_cast<FileSource*>( id );
+	return ( ( source->GetPosition() > 0 ) && source->SetPosition( source->GetPosition() - 1 ) ) ? c : EOF;
+}
+
+static int64_t GetSourceLength( void* id )
+{
+	return static_cast<int64_t>( static_cast<FileSource*>( id )->GetSize() );
+}
+
+static int CanSeekSource( void* )
+{
+	return 1;
+}
+
+static WavpackStreamReader64 s_SourceReader = {
+	ReadSource, nullptr /*write_bytes*/, GetSourcePosition, SetSourcePositionAbsolute, SetSourcePositionRelative,
+	PushBackSourceByte, GetSourceLength, CanSeekSource, nullptr /*truncate_here*/, nullptr /*close*/
+};
+
 DecoderWavpack::DecoderWavpack( const std::wstring& filename, const Context context ) :
 	Decoder( context ),
-	m_Context( nullptr )
+	m_Source( FileSource::Open( filename ) ),
+	m_CorrectionSource(),
+	m_Context( nullptr ),
+	m_IndexContext( nullptr ),
+	m_SourcePosition( 0 ),
+	m_CorrectionSourcePosition( 0 ),
+	m_SeekIndex()
 {
-	char* error = nullptr;
-	const int flags = OPEN_WVC | OPEN_NORMALIZE | OPEN_DSD_AS_PCM | OPEN_FILE_UTF8;
+	char error[ 80 ] = {};
 	const int offset = 0;
-	m_Context = WavpackOpenFileInput( WideStringToUTF8( filename ).c_str(), error, flags, offset );
+	if ( m_Source ) {
+		m_CorrectionSource = FileSource::Open( filename + L"c" );
+		m_Context = WavpackOpenFileInputEx64( &s_SourceReader, m_Source.get(), m_CorrectionSource.get(), error, kOpenFlags, offset );
+	}
 	if ( nullptr != m_Context ) {
 		SetBPS( static_cast<long>( WavpackGetBitsPerSample( m_Context ) ) );
 		SetChannels( static_cast<long>( WavpackGetNumChannels( m_Context ) ) );
@@ -18,6 +86,11 @@ DecoderWavpack::DecoderWavpack( const std::wstring& filename, const Context cont
 			SetDuration( static_cast<float>( WavpackGetNumSamples64( m_Context ) ) / GetSampleRate() );
 		}
 		SetBitrate( static_cast<float>( WavpackGetAverageBitrate( m_Context, TRUE /*count_wvc*/ ) / 1000 ) );
+
+		// DSD block positions are not in PCM sample units, so DSD files are not indexed.
+		if ( !( WavpackGetQualifyMode( m_Context ) & QMODE_DSD_AUDIO ) ) {
+			m_SeekIndex = SeekIndex::Get( filename );
+		}
 	} else {
 		throw std::runtime_error( "DecoderWavpack could not load file" );
 	}
@@ -25,20 +98,24 @@ DecoderWavpack::DecoderWavpack( const std::wstring& filename, const Context cont
 
 DecoderWavpack::~DecoderWavpack()
 {
+	if ( nullptr != m_IndexContext ) {
+		WavpackCloseFile( m_IndexContext );
+	}
 	WavpackCloseFile( m_Context );
 }
 
 long DecoderWavpack::Read( float* buffer, const long sampleCount )
 {
-	const long samplesRead = ( sampleCount > 0 ) ? static_cast<long>( WavpackUnpackSamples( m_Context, reinterpret_cast<int32_t*>( buffer ), sampleCount ) ) : 0;
-	if ( !( WavpackGetMode( m_Context ) & MODE_FLOAT ) ) {
-		int32_t* nativeBuffer = reinterpret_cast<int32_t*>( buffer );
-		const long bufferSize = samplesRead * GetChannels();
-		const int bitsPerSample = WavpackGetBytesPerSample( m_Context ) * 8;
-		for ( long index = 0; index < bufferSize; index++ ) {
-			buffer[ index ] = static_cast<float>( nativeBuffer[ index ] ) / ( 1 << ( bitsPerSample - 1 ) );
-		}
+	WavpackContext* context = ( nullptr != m_IndexContext ) ? m_IndexContext : m_Context;
+	const long samplesRead = ( sampleCount > 0 ) ? static_cast<long>( WavpackUnpackSamples( context, reinterpret_cast<int32_t*>( buffer ), sampleCount ) ) : 0;
+	if ( !( WavpackGetMode( context ) & MODE_FLOAT ) ) {
+		// Convert in place.
+		const int32_t* nativeBuffer = reinterpret_cast<const int32_t*>( buffer );
+		const size_t bufferSize = static_cast<size_t>( samplesRead ) * GetChannels();
+		const uint32_t bitsPerSample = static_cast<uint32_t>( WavpackGetBytesPerSample( m_Context ) * 8 );
+		SampleConversion::Signed32ToFloat( nativeBuffer, buffer, bufferSize, bitsPerSample );
 	}
+	AddSeekPoint();
 	return samplesRead;
 }
 
@@ -46,8 +123,103 @@ double DecoderWavpack::Seek( const double position )
 {
 	double seekPosition = position;
 	const int64_t samplePosition = static_cast<int64_t>( position * GetSampleRate() );
-	if ( 0 == WavpackSeekSample64( m_Context, samplePosition ) ) {
-		seekPosition = 0;
+	if ( !SeekUsingIndex( samplePosition ) ) {
+		CloseIndexContext();
+		if ( 0 == WavpackSeekSample64( m_Context, samplePosition ) ) {
+			seekPosition = 0;
+		}
 	}
 	return seekPosition;
 }
+
+bool DecoderWavpack::SeekUsingIndex( const int64_t sample )
+{
+	const int64_t maximumDistance = static_cast<int64_t>( kSeekIndexMaximumDistance * GetSampleRate() );
+	const auto seekPoint = m_SeekIndex ? m_SeekIndex->Find( sample, maximumDistance ) : std::nullopt;
+	if ( !seekPoint || ( seekPoint->second.Offset < 0 ) || ( m_CorrectionSource && ( seekPoint->second.Hint <= 0 ) ) ) {
+		return false;
+	}
+
+	// The library has no way to resume decoding from a block position, so open a separate context (in streaming mode) at the indexed block.
+	// The main context is left as it is, so that it can be used for any seek which cannot use the index.
+	CloseIndexContext();
+	const uint64_t sourcePosition = m_Source->GetPosition();
+	const uint64_t correctionSourcePosition = m_CorrectionSource ? m_CorrectionSource->GetPosition() : 0;
+	const auto& [pointSample, point] = *seekPoint;
+	bool success = m_Source->SetPosition( static_cast<uint64_t>( point.Offset ) ) && ( !m_CorrectionSource || m_CorrectionSource->SetPosition( static_cast<uint64_t>( point.Hint ) ) );
+	WavpackContext* context = nullptr;
+	if ( success ) {
+		char error[ 80 ] = {};
+		const int offset = 0;
+		context = WavpackOpenFileInputEx64( &s_SourceReader, m_Source.get(), m_CorrectionSource.get(), error, kOpenFlags | OPEN_STREAMING, offset );
+		success = ( nullptr != context ) && ( WavpackGetSampleIndex64( context ) == pointSample ) && ( WavpackGetNumChannels( context ) == GetChannels() ) && ( static_cast<long>( WavpackGetSampleRate( context ) ) == GetSampleRate() );
+	}
+
+	// Decode forward to the seek position.
+	if ( success ) {
+		std::vector<int32_t> discard( kSeekDiscardSize * static_cast<size_t>( GetChannels() ) );
+		for ( int64_t position = pointSample; success && ( position < sample ); ) {
+			const uint32_t samplesRead = WavpackUnpackSamples( context, discard.data(), static_cast<uint32_t>( std::min<int64_t>( kSeekDiscardSize, sample - position ) ) );
+			success = ( samplesRead > 0 );
+			position += samplesRead;
+		}
+	}
+
+	if ( success ) {
+		m_IndexContext = context;
+		m_SourcePosition = sourcePosition;
+		m_CorrectionSourcePosition = correctionSourcePosition;
+	} else {
+		if ( nullptr != context ) {
+			WavpackCloseFile( context );
+		}
+		m_Source->SetPosition( sourcePosition );
+		if ( m_CorrectionSource ) {
+			m_CorrectionSource->SetPosition( correctionSourcePosition );
+		}
+	}
+	return success;
+}
+
+void DecoderWavpack::CloseIndexContext()
+{
+	if ( nullptr != m_IndexContext ) {
+		WavpackCloseFile( m_IndexContext );
+		m_IndexContext = nullptr;
+		m_Source->SetPosition( m_SourcePosition );
+		if ( m_CorrectionSource ) {
+			m_CorrectionSource->SetPosition( m_CorrectionSourcePosition );
+		}
+	}
+}
+
+void DecoderWavpack::AddSeekPoint()
+{
+	// Blocks are read whole, so following a read the file position is usually at the start of the next block.
+	if ( m_SeekIndex && ( GetSampleRate() > 0 ) ) {
+		const uint64_t offset = m_Source->GetPosition();
+		if ( const auto blockIndex = GetBlockIndex( *m_Source, offset ); blockIndex ) {
+			SeekIndex::Point point = { static_cast<int64_t>( offset ), 0 };
+			if ( m_CorrectionSource ) {
+				const uint64_t correctionOffset = m_CorrectionSource->GetPosition();
+				if ( GetBlockIndex( *m_CorrectionSource, correctionOffset ) != blockIndex ) {
+					return;
+				}
+				point.Hint = static_cast<int64_t>( correctionOffset );
+			}
+			m_SeekIndex->Add( *blockIndex, point, static_cast<int64_t>( kSeekIndexInterval * GetSampleRate() ) );
+		}
+	}
+}
+
+std::optional<int64_t> DecoderWavpack::GetBlockIndex( FileSource& source, const uint64_t offset )
+{
+	if ( const auto data = source.GetSpan( offset, sizeof( WavpackHeader ) ); sizeof( WavpackHeader ) == data.size() ) {
+		WavpackHeader header = {};
+		std::memcpy( &header, data.data(), sizeof( WavpackHeader ) );
+		if ( ( 0 == std::memcmp( header.ckID, "wvpk", 4 ) ) && ( INITIAL_BLOCK & header.flags ) && ( header.block_samples > 0 ) ) {
+			return GET_BLOCK_INDEX( header );
+		}
+	}
+	return std::nullopt;
+}
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Decoder.h"
+#include "FileSource.h"
+#include "SeekIndex.h"
 
 #include "wavpack.h"
 
+#include <optional>
 #include <string>
 
 class DecoderWavpack : public Decoder
@@ -27,6 +30,36 @@ public:
 	double Seek( const double position ) override;
 
 private:
-	// WavPack context.
+	// Seeks to the 'sample' position by opening a context at the nearest indexed block and decoding forward, returning whether the seek was successful.
+	bool SeekUsingIndex( const int64_t sample );
+
+	// Closes any context opened at an indexed block, and restores the file positions of the main context.
+	void CloseIndexContext();
+
+	// Adds a seek point to the seek index, if the file position is at the start of a block.
+	void AddSeekPoint();
+
+	// Returns the sample position of the initial block at the 'offset' in the 'source', or nullopt if there is no initial block at the offset.
+	static std::optional<int64_t> GetBlockIndex( FileSource& source, const uint64_t offset );
+
+	// WavPack file source.
+	FileSource::Ptr m_Source;
+
+	// WavPack correction file source (or nullptr if there is no correction file).
+	FileSource::Ptr m_CorrectionSource;
+
+	// WavPack context, opened at the start of the file.
 	WavpackContext* m_Context;
+
+	// WavPack context opened (in streaming mode) at an indexed block following a seek, or nullptr if the main context is in use.
+	WavpackContext* m_IndexContext;
+
+	// File source position of the main context, while the index context is in use.
+	uint64_t m_SourcePosition;
+
+	// Correction file source position of the main context, while the index context is in use.
+	uint64_t m_CorrectionSourcePosition;
+
+	// Seek index for the file (the point offset is the block byte position, and the point hint is the correction file block byte position).
+	SeekIndex::Ptr m_SeekIndex;
 };
@@ -2,6 +2,8 @@
 
 #include "Utility.h"
 
+#include <stdexcept>
+
 extern "C"
 {
 #include "libavformat/avformat.h"
@@ -61,6 +63,13 @@ bool EncoderFFmpeg::Open( std::wstring& filename, const long sampleRate, const l
 								m_BytesPerSample = static_cast<uint32_t>( av_get_bytes_per_sample( m_avcodecContext->sample_fmt ) );
 								if ( ( m_OutputSampleRate > 0 ) && ( m_OutputChannels > 0 ) && ( m_BytesPerSample > 0 ) ) {
 									m_SampleBuffers.resize( m_OutputChannels );
+									if ( channels != m_OutputChannels ) {
+										// Remix using the channel mixer (rather than the FFmpeg resampler), so that the downmix is consistent with playback.
+										try {
+											m_ChannelMixer = std::make_unique<ChannelMixer>( static_cast<uint32_t>( channels ), static_cast<uint32_t>( m_OutputChannels ) );
+										} catch ( const std::runtime_error& ) {
+										}
+									}
 
 									m_pts = 0;
 									avStream->time_base.den = m_avcodecContext->sample_rate;
@@ -73,8 +82,8 @@ bool EncoderFFmpeg::Open( std::wstring& filename, const long sampleRate, const l
 									if ( avcodec_open2( m_avcodecContext, avCodec, nullptr ) >= 0 ) {
 										if ( avcodec_parameters_from_context( avStream->codecpar, m_avcodecContext ) >= 0 ) {
 											if ( avformat_write_header( m_avformatContext, nullptr ) >= 0 ) {
-												const AVChannelLayout srcLayout = GetChannelLayout( channels );
 												const AVChannelLayout dstLayout = m_avcodecContext->ch_layout;
+												const AVChannelLayout srcLayout = m_ChannelMixer ? dstLayout : GetChannelLayout( channels );
 												constexpr AVSampleFormat srcSampleFormat = AV_SAMPLE_FMT_FLT;
 												const AVSampleFormat dstSampleFormat = m_avcodecContext->sample_fmt;
 												if ( swr_alloc_set_opts2( &m_swrContext, &dstLayout, dstSampleFormat, m_avcodecContext->sample_rate, &srcLayout, srcSampleFormat, m_InputSampleRate, 0, nullptr ) >= 0 ) {
@@ -103,6 +112,11 @@ bool EncoderFFmpeg::Open( std::wstring& filename, const long sampleRate, const l
 
 bool EncoderFFmpeg::Write( float* inputSamples, const long inputSampleCount )
 {
+	if ( m_ChannelMixer && ( nullptr != inputSamples ) && ( inputSampleCount > 0 ) ) {
+		m_MixBuffer.resize( static_cast<size_t>( m_OutputChannels ) * inputSampleCount );
+		m_ChannelMixer->Process( inputSamples, m_MixBuffer.data(), static_cast<size_t>( inputSampleCount ) );
+		inputSamples = m_MixBuffer.data();
+	}
 	return EncodeSamples( inputSamples, inputSampleCount );
 }
 
@@ -133,6 +147,7 @@ void EncoderFFmpeg::FreeContexts()
 	if ( nullptr != m_swrContext ) {
 		swr_free( &m_swrContext );
 	}
+	m_ChannelMixer.reset();
 }
 
 bool EncoderFFmpeg::EncodeSamples( float* inputSamples, const long inputSampleCount )
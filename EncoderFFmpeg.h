@@ -2,6 +2,9 @@
 
 #include "Encoder.h"
 
+#include "ChannelMixer.h"
+
+#include <memory>
 #include <vector>
 
 struct AVCodecContext;
@@ -82,4 +85,6 @@ private:
 	int m_OutputSampleRate = 0;
 	int m_OutputChannels = 0;
 	std::vector<std::vector<uint8_t>> m_SampleBuffers;
+	std::unique_ptr<ChannelMixer> m_ChannelMixer;
+	std::vector<float> m_MixBuffer;
 };
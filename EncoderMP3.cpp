@@ -1,7 +1,5 @@
 #include "EncoderMP3.h"
 
-#include "bassmix.h"
-
 #include <stdexcept>
 
 void null_report_function( const char* /*format*/, va_list /*ap*/ )
@@ -32,24 +30,18 @@ bool EncoderMP3::Open( std::wstring& filename, const long sampleRate, const long
 
 		lame_set_bWriteVbrTag( m_flags, 1 );
 
-		m_inputChannels = channels;
-
-		// Convert 6.1 files to 7.1, so that they are downmixed correctly.
-		m_convert61to71 = ( 7 == m_inputChannels );
-		if ( m_convert61to71 ) {
-			m_inputChannels = 8;
-		}
-
-		const int outputChannels = std::min<int>( m_inputChannels, 2 );
+		const int outputChannels = std::min<int>( channels, 2 );
 
 		success = ( 0 == lame_set_num_channels( m_flags, outputChannels ) );
 		( 0 == lame_set_in_samplerate( m_flags, static_cast<int>( sampleRate ) ) ) &&
 			( 0 == lame_init_params( m_flags ) );
 
-		if ( success && ( outputChannels < m_inputChannels ) ) {
-			m_decoderStream = BASS_StreamCreate( sampleRate, m_inputChannels, BASS_SAMPLE_FLOAT | BASS_STREAM_DECODE, STREAMPROC_PUSH, this );
-			m_mixerStream = BASS_Mixer_StreamCreate( sampleRate, outputChannels, BASS_SAMPLE_FLOAT | BASS_STREAM_DECODE );
-			success = ( 0 != m_decoderStream ) && ( 0 != m_mixerStream ) && ( 0 != BASS_Mixer_StreamAddChannel( m_mixerStream, m_decoderStream, BASS_MIXER_CHAN_DOWNMIX ) );
+		if ( success && ( outputChannels < channels ) ) {
+			try {
+				m_channelMixer = std::make_unique<ChannelMixer>( static_cast<uint32_t>( channels ), static_cast<uint32_t>( outputChannels ) );
+			} catch ( const std::runtime_error& ) {
+				success = false;
+			}
 		}
 
 		if ( success ) {
@@ -61,15 +53,7 @@ bool EncoderMP3::Open( std::wstring& filename, const long sampleRate, const long
 		if ( !success ) {
 			lame_close( m_flags );
 			m_flags = nullptr;
-
-			if ( 0 != m_mixerStream ) {
-				BASS_StreamFree( m_mixerStream );
-				m_mixerStream = 0;
-			}
-			if ( 0 != m_decoderStream ) {
-				BASS_StreamFree( m_decoderStream );
-				m_decoderStream = 0;
-			}
+			m_channelMixer.reset();
 		}
 	}
 	return success;
@@ -79,33 +63,10 @@ bool EncoderMP3::Write( float* samples, const long sampleCount )
 {
 	const int outputChannels = lame_get_num_channels( m_flags );
 
-	if ( outputChannels < m_inputChannels ) {
-		if ( m_convert61to71 ) {
-			// Copy the back centre channel to the back left & back right channels.
-			m_convertedBuffer.resize( sampleCount * 8 );
-			for ( long sample = sampleCount - 1; sample >= 0; sample-- ) {
-				const long srcOffset = sample * 7;
-				const long destOffset = sample * 8;
-				m_convertedBuffer[ destOffset + 7 ] = samples[ srcOffset + 6 ];
-				m_convertedBuffer[ destOffset + 6 ] = samples[ srcOffset + 5 ];
-				m_convertedBuffer[ destOffset + 5 ] = samples[ srcOffset + 4 ];
-				m_convertedBuffer[ destOffset + 4 ] = samples[ srcOffset + 4 ];
-				m_convertedBuffer[ destOffset + 3 ] = samples[ srcOffset + 3 ];
-				m_convertedBuffer[ destOffset + 2 ] = samples[ srcOffset + 2 ];
-				m_convertedBuffer[ destOffset + 1 ] = samples[ srcOffset + 1 ];
-				m_convertedBuffer[ destOffset + 0 ] = samples[ srcOffset + 0 ];
-			}
-			samples = m_convertedBuffer.data();
-		}
-
-		const DWORD decodeBufferSize = sampleCount * m_inputChannels * 4;
-		const DWORD mixBufferSize = outputChannels * sampleCount;
-		m_mixBuffer.resize( outputChannels * sampleCount );
-		if ( ( BASS_StreamPutData( m_decoderStream, samples, decodeBufferSize ) == decodeBufferSize ) && ( BASS_ChannelGetData( m_mixerStream, m_mixBuffer.data(), mixBufferSize * 4 ) == ( mixBufferSize * 4 ) ) ) {
-			samples = m_mixBuffer.data();
-		} else {
-			samples = nullptr;
-		}
+	if ( m_channelMixer ) {
+		m_mixBuffer.resize( static_cast<size_t>( outputChannels ) * sampleCount );
+		m_channelMixer->Process( samples, m_mixBuffer.data(), static_cast<size_t>( sampleCount ) );
+		samples = m_mixBuffer.data();
 	}
 
 	bool success = ( nullptr != samples );
@@ -141,15 +102,7 @@ void EncoderMP3::Close()
 		m_file = nullptr;
 	}
 
-	if ( 0 != m_mixerStream ) {
-		BASS_StreamFree( m_mixerStream );
-		m_mixerStream = 0;
-	}
-
-	if ( 0 != m_decoderStream ) {
-		BASS_StreamFree( m_decoderStream );
-		m_decoderStream = 0;
-	}
+	m_channelMixer.reset();
 }
 
 int EncoderMP3::GetVBRQuality( const std::string& settings )
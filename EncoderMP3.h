@@ -1,10 +1,13 @@
 #pragma once
 
+#include "stdafx.h"
+
+#include "ChannelMixer.h"
 #include "Encoder.h"
 
-#include "bass.h"
 #include "lame.h"
 
+#include <memory>
 #include <vector>
 
 // LAME MP3 encoder
@@ -51,18 +54,6 @@ private:
 	// Mix buffer, used when downsampling to stereo.
 	std::vector<float> m_mixBuffer;
 
-	// Input channel count.
-	long m_inputChannels = 0;
-
-	// Mixer stream, used when downsampling to stereo.
-	HSTREAM m_mixerStream = 0;
-
-	// Decoder stream, used when downsampling to stereo.
-	HSTREAM m_decoderStream = 0;
-
-	// Whether to convert incoming data from 6.1 channels to 7.1 channels.
-	bool m_convert61to71 = false;
-
-	// Input sample buffer, when converted from 6.1 to 7.1.
-	std::vector<float> m_convertedBuffer;
+	// Channel mixer, used when downsampling to stereo.
+	std::unique_ptr<ChannelMixer> m_channelMixer;
 };
@@ -14,7 +14,8 @@ EncoderOpus::EncoderOpus() :
 	Encoder(),
 	m_Channels( 0 ),
 	m_OpusEncoder( nullptr ),
-	m_Callbacks( {} )
+	m_Callbacks( {} ),
+	m_ChannelMixer()
 {
 }
 
@@ -57,6 +58,9 @@ bool EncoderOpus::Open( std::wstring& filename, const long sampleRate, const lon
 			if ( nullptr != m_OpusEncoder ) {
 				const int bitrate = 1000 * GetBitrate( settings );
 				ope_encoder_ctl( m_OpusEncoder, OPUS_SET_BITRATE( bitrate ) );
+				if ( 1 == family ) {
+					m_ChannelMixer = std::make_unique<ChannelMixer>( static_cast<uint32_t>( m_Channels ), static_cast<uint32_t>( m_Channels ), ChannelMixer::Order::Wave, ChannelMixer::Order::Vorbis );
+				}
 			} else {
 				fclose( f );
 			}
@@ -70,79 +74,8 @@ bool EncoderOpus::Open( std::wstring& filename, const long sampleRate, const lon
 bool EncoderOpus::Write( float* samples, const long sampleCount )
 {
 	// For multi-channel streams, change from BASS to Opus channel ordering.
-	switch ( m_Channels ) {
-		case 3: {
-			// (left, right, center) ->
-			// (left, center, right)
-			long offset = 0;
-			for ( long n = 0; n < sampleCount; n++, offset += m_Channels ) {
-				std::swap( samples[ offset + 1 ], samples[ offset + 2 ] );
-			}
-			break;
-		}
-		case 5: {
-			// (front left, front right, front center, rear left, rear right) ->
-			// (front left, front center, front right, rear left, rear right)
-			long offset = 0;
-			for ( long n = 0; n < sampleCount; n++, offset += m_Channels ) {
-				std::swap( samples[ offset + 1 ], samples[ offset + 2 ] );
-			}
-			break;
-		}
-		case 6: {
-			// (front left, front right, front center, LFE, rear left, rear right) ->
-			// (front left, front center, front right, rear left, rear right, LFE)
-			long offset = 0;
-			for ( long n = 0; n < sampleCount; n++, offset += m_Channels ) {
-				std::swap( samples[ offset + 1 ], samples[ offset + 2 ] );
-				const float lfe = samples[ offset + 3 ];
-				const float rearL = samples[ offset + 4 ];
-				const float rearR = samples[ offset + 5 ];
-				samples[ offset + 3 ] = rearL;
-				samples[ offset + 4 ] = rearR;
-				samples[ offset + 5 ] = lfe;
-			}
-			break;
-		}
-		case 7: {
-			// (front left, front right, front center, LFE, rear center, side left, side right) ->
-			// (front left, front center, front right, side left, side right, rear center, LFE)
-			long offset = 0;
-			for ( long n = 0; n < sampleCount; n++, offset += m_Channels ) {
-				std::swap( samples[ offset + 1 ], samples[ offset + 2 ] );
-				const float lfe = samples[ offset + 3 ];
-				const float rearC = samples[ offset + 4 ];
-				const float sideL = samples[ offset + 5 ];
-				const float sideR = samples[ offset + 6 ];
-				samples[ offset + 3 ] = sideL;
-				samples[ offset + 4 ] = sideR;
-				samples[ offset + 5 ] = rearC;
-				samples[ offset + 6 ] = lfe;
-			}
-			break;
-		}
-		case 8: {
-			// (front left, front right, front center, LFE, rear left, rear right, side left, side right) ->
-			// (front left, front center, front right, side left, side right, rear left, rear right, LFE)
-			long offset = 0;
-			for ( long n = 0; n < sampleCount; n++, offset += m_Channels ) {
-				std::swap( samples[ offset + 1 ], samples[ offset + 2 ] );
-				const float lfe = samples[ offset + 3 ];
-				const float rearL = samples[ offset + 4 ];
-				const float rearR = samples[ offset + 5 ];
-				const float sideL = samples[ offset + 6 ];
-				const float sideR = samples[ offset + 7 ];
-				samples[ offset + 3 ] = sideL;
-				samples[ offset + 4 ] = sideR;
-				samples[ offset + 5 ] = rearL;
-				samples[ offset + 6 ] = rearR;
-				samples[ offset + 7 ] = lfe;
-			}
-			break;
-		}
-		default: {
-			break;
-		}
+	if ( m_ChannelMixer ) {
+		m_ChannelMixer->Process( samples, samples, static_cast<size_t>( sampleCount ) );
 	}
 	const bool success = ( OPE_OK == ope_encoder_write_float( m_OpusEncoder, samples, sampleCount ) );
 	return success;
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "ChannelMixer.h"
 #include "Encoder.h"
 
 #include "opusenc.h"
 
+#include <memory>
+
 // Opus encoder
 class EncoderOpus : public Encoder
 {
@@ -62,4 +65,7 @@ private:
 
 	// Opus encoder callbacks.
 	OpusEncCallbacks m_Callbacks;
+
+	// Channel mixer, used to change from BASS to Opus channel ordering for multi-channel streams.
+	std::unique_ptr<ChannelMixer> m_ChannelMixer;
 };
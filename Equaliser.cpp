@@ -0,0 +1,254 @@
+#include "Equaliser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <stdexcept>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#define EQUALISER_SSE
+#include <immintrin.h>
+#endif
+
+// Maximum centre frequency, as a proportion of the sample rate (higher frequencies are clamped, rather than the band being dropped).
+constexpr double kMaxCentreRatio = 0.45;
+
+// Minimum & maximum bandwidth, in semitones.
+constexpr double kMinBandwidth = 1.0;
+constexpr double kMaxBandwidth = 36.0;
+
+// Filter state magnitude below which the state is flushed to zero, to avoid denormals when decaying to silence.
+constexpr float kDenormalThreshold = 1.0e-20f;
+
+#ifdef EQUALISER_SSE
+
+// Loads the first 'lanes' (1 to 4) samples from 'input'.
+static __m128 LoadLanes( const float* input, const uint32_t lanes )
+{
+	switch ( lanes ) {
+		case 1: {
+			return _mm_load_ss( input );
+		}
+		case 2: {
+			return _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>( input ) ) );
+		}
+		case 3: {
+			return _mm_movelh_ps( _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>( input ) ) ), _mm_load_ss( input + 2 ) );
+		}
+		default: {
+			return _mm_loadu_ps( input );
+		}
+	}
+}
+
+// Stores the first 'lanes' (1 to 4) samples of 'value' to 'output'.
+static void StoreLanes( float* output, const __m128 value, const uint32_t lanes )
+{
+	switch ( lanes ) {
+		case 1: {
+			_mm_store_ss( output, value );
+			break;
+		}
+		case 2: {
+			_mm_store_sd( reinterpret_cast<double*>( output ), _mm_castps_pd( value ) );
+			break;
+		}
+		case 3: {
+			_mm_store_sd( reinterpret_cast<double*>( output ), _mm_castps_pd( value ) );
+			_mm_store_ss( output + 2, _mm_movehl_ps( value, value ) );
+			break;
+		}
+		default: {
+			_mm_storeu_ps( output, value );
+			break;
+		}
+	}
+}
+
+// Returns the filter 'state', with any denormal values flushed to zero.
+static __m128 FlushDenormals( const __m128 state )
+{
+	const __m128 magnitude = _mm_andnot_ps( _mm_set1_ps( -0.0f ), state );
+	return _mm_and_ps( state, _mm_cmpge_ps( magnitude, _mm_set1_ps( kDenormalThreshold ) ) );
+}
+
+#endif
+
+Equaliser::Equaliser( const long sampleRate, const uint32_t channels ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_PaddedChannels( ( channels + 3 ) & ~3u ),
+	m_UseSIMD( IsSIMDAvailable() ),
+	m_PendingParameters(),
+	m_PendingMutex(),
+	m_Parameters(),
+	m_State()
+{
+	if ( ( sampleRate <= 0 ) || ( 0 == channels ) || ( channels > kMaxChannels ) ) {
+		throw std::runtime_error( "Equaliser format not supported" );
+	}
+	m_State.resize( kMaxBands * 2 * m_PaddedChannels, 0 );
+}
+
+Equaliser::~Equaliser()
+{
+}
+
+Equaliser::Coefficients Equaliser::CalculateCoefficients( const double frequency, const double gain, const double bandwidth ) const
+{
+	// Peaking EQ filter, from the Audio EQ Cookbook by Robert Bristow-Johnson.
+	const double centre = std::clamp( frequency, 1.0, kMaxCentreRatio * m_SampleRate );
+	const double octaves = std::clamp( bandwidth, kMinBandwidth, kMaxBandwidth ) / 12;
+	const double A = std::pow( 10.0, gain / 40 );
+	const double w0 = 2 * std::numbers::pi * centre / m_SampleRate;
+	const double cosw0 = std::cos( w0 );
+	const double sinw0 = std::sin( w0 );
+	const double alpha = sinw0 * std::sinh( std::numbers::ln2 / 2 * octaves * w0 / sinw0 );
+
+	const double a0 = 1 + alpha / A;
+	Coefficients coefficients;
+	coefficients.B0 = static_cast<float>( ( 1 + alpha * A ) / a0 );
+	coefficients.B1 = static_cast<float>( -2 * cosw0 / a0 );
+	coefficients.B2 = static_cast<float>( ( 1 - alpha * A ) / a0 );
+	coefficients.A1 = static_cast<float>( -2 * cosw0 / a0 );
+	coefficients.A2 = static_cast<float>( ( 1 - alpha / A ) / a0 );
+	return coefficients;
+}
+
+void Equaliser::SetSettings( const Settings::EQ& settings )
+{
+	Parameters parameters;
+	if ( settings.Enabled ) {
+		for ( const auto& [frequency, gain] : settings.Gains ) {
+			if ( parameters.BandCount >= kMaxBands ) {
+				break;
+			}
+			const size_t band = parameters.BandCount++;
+			if ( 0 != gain ) {
+				parameters.Bands[ band ] = CalculateCoefficients( frequency, gain, settings.Bandwidth );
+				parameters.Active[ band ] = true;
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock( m_PendingMutex );
+	m_PendingParameters = parameters;
+	m_PendingChanged = true;
+}
+
+void Equaliser::Process( float* buffer, const size_t frames )
+{
+	if ( m_PendingMutex.try_lock() ) {
+		if ( m_PendingChanged ) {
+			// Clear the state for any bands which are becoming active, and retain it for the others, so that gain changes do not cause discontinuities.
+			for ( size_t band = 0; band < kMaxBands; band++ ) {
+				if ( m_PendingParameters.Active[ band ] && !m_Parameters.Active[ band ] ) {
+					const auto state = m_State.begin() + band * 2 * m_PaddedChannels;
+					std::fill( state, state + 2 * m_PaddedChannels, 0.0f );
+				}
+			}
+			m_Parameters = m_PendingParameters;
+			m_PendingChanged = false;
+		}
+		m_PendingMutex.unlock();
+	}
+
+	if ( ( nullptr != buffer ) && ( frames > 0 ) ) {
+		for ( size_t band = 0; band < m_Parameters.BandCount; band++ ) {
+			if ( m_Parameters.Active[ band ] ) {
+				ProcessBand( m_Parameters.Bands[ band ], band, buffer, frames );
+			}
+		}
+	}
+}
+
+void Equaliser::ProcessBand( const Coefficients& coefficients, const size_t band, float* buffer, const size_t frames )
+{
+	float* z1 = m_State.data() + band * 2 * m_PaddedChannels;
+	float* z2 = z1 + m_PaddedChannels;
+
+#ifdef EQUALISER_SSE
+	if ( m_UseSIMD ) {
+		const __m128 b0 = _mm_set1_ps( coefficients.B0 );
+		const __m128 b1 = _mm_set1_ps( coefficients.B1 );
+		const __m128 b2 = _mm_set1_ps( coefficients.B2 );
+		const __m128 a1 = _mm_set1_ps( coefficients.A1 );
+		const __m128 a2 = _mm_set1_ps( coefficients.A2 );
+		for ( uint32_t firstChannel = 0; firstChannel < m_Channels; firstChannel += 4 ) {
+			const uint32_t lanes = std::min<uint32_t>( 4, m_Channels - firstChannel );
+			__m128 state1 = _mm_loadu_ps( z1 + firstChannel );
+			__m128 state2 = _mm_loadu_ps( z2 + firstChannel );
+			float* sample = buffer + firstChannel;
+			for ( size_t frame = 0; frame < frames; frame++, sample += m_Channels ) {
+				const __m128 x = LoadLanes( sample, lanes );
+				const __m128 y = _mm_add_ps( _mm_mul_ps( b0, x ), state1 );
+				state1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( b1, x ), _mm_mul_ps( a1, y ) ), state2 );
+				state2 = _mm_sub_ps( _mm_mul_ps( b2, x ), _mm_mul_ps( a2, y ) );
+				StoreLanes( sample, y, lanes );
+			}
+			_mm_storeu_ps( z1 + firstChannel, FlushDenormals( state1 ) );
+			_mm_storeu_ps( z2 + firstChannel, FlushDenormals( state2 ) );
+		}
+		return;
+	}
+#endif
+
+	for ( uint32_t channel = 0; channel < m_Channels; channel++ ) {
+		float state1 = z1[ channel ];
+		float state2 = z2[ channel ];
+		float* sample = buffer + channel;
+		for ( size_t frame = 0; frame < frames; frame++, sample += m_Channels ) {
+			const float x = *sample;
+			const float y = coefficients.B0 * x + state1;
+			state1 = coefficients.B1 * x - coefficients.A1 * y + state2;
+			state2 = coefficients.B2 * x - coefficients.A2 * y;
+			*sample = y;
+		}
+		z1[ channel ] = ( std::fabs( state1 ) < kDenormalThreshold ) ? 0 : state1;
+		z2[ channel ] = ( std::fabs( state2 ) < kDenormalThreshold ) ? 0 : state2;
+	}
+}
+
+bool Equaliser::IsSIMDAvailable()
+{
+#ifdef EQUALISER_SSE
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Equaliser::SetUseSIMD( const bool useSIMD )
+{
+	m_UseSIMD = useSIMD && IsSIMDAvailable();
+	return m_UseSIMD;
+}
+
+uint32_t Equaliser::GetChannels() const
+{
+	return m_Channels;
+}
+
+double Equaliser::GetResponse( const double frequency ) const
+{
+	Parameters parameters;
+	{
+		std::lock_guard<std::mutex> lock( m_PendingMutex );
+		parameters = m_PendingParameters;
+	}
+
+	const double w = 2 * std::numbers::pi * frequency / m_SampleRate;
+	const std::complex<double> z1 = std::polar( 1.0, -w );
+	const std::complex<double> z2 = z1 * z1;
+	double response = 0;
+	for ( size_t band = 0; band < parameters.BandCount; band++ ) {
+		if ( parameters.Active[ band ] ) {
+			const Coefficients& c = parameters.Bands[ band ];
+			const std::complex<double> numerator = static_cast<double>( c.B0 ) + static_cast<double>( c.B1 ) * z1 + static_cast<double>( c.B2 ) * z2;
+			const std::complex<double> denominator = 1.0 + static_cast<double>( c.A1 ) * z1 + static_cast<double>( c.A2 ) * z2;
+			response += 20 * std::log10( std::abs( numerator / denominator ) );
+		}
+	}
+	return response;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Settings.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Parametric EQ for interleaved floating point samples, as a cascade of peaking biquad filters (one per band).
+// Filters use the transposed direct form II structure, and are applied to several channels at once using SIMD instructions where available.
+// Settings can be changed from any thread, and are picked up by the processing thread without it ever blocking.
+class Equaliser
+{
+public:
+	// Maximum supported number of bands.
+	static constexpr size_t kMaxBands = 32;
+
+	// Maximum supported channel count.
+	static constexpr uint32_t kMaxChannels = 32;
+
+	// 'sampleRate' - sample rate of the audio to process.
+	// 'channels' - channel count of the audio to process.
+	// Throws a std::runtime_error exception if the sample rate or channel count is not supported.
+	Equaliser( const long sampleRate, const uint32_t channels );
+
+	virtual ~Equaliser();
+
+	// Sets the EQ 'settings' (the preamp is not applied by the equaliser).
+	// Changes take effect from the next call to Process.
+	void SetSettings( const Settings::EQ& settings );
+
+	// Applies the EQ, in place, to 'frames' of interleaved samples in the 'buffer'.
+	void Process( float* buffer, const size_t frames );
+
+	// Returns the channel count of the audio to process.
+	uint32_t GetChannels() const;
+
+	// Returns the magnitude response of the EQ, in dB, at a 'frequency' in Hz, for the most recent settings.
+	double GetResponse( const double frequency ) const;
+
+	// Returns whether SIMD instructions are available to apply the EQ.
+	static bool IsSIMDAvailable();
+
+	// Sets whether to 'useSIMD' instructions to apply the EQ, where available (intended for benchmarking).
+	// Must not be called while audio is being processed.
+	// Returns whether SIMD instructions will be used.
+	bool SetUseSIMD( const bool useSIMD );
+
+private:
+	// Biquad filter coefficients, normalised so that a0 is one.
+	struct Coefficients {
+		float B0 = 1.0f;
+		float B1 = 0;
+		float B2 = 0;
+		float A1 = 0;
+		float A2 = 0;
+	};
+
+	// Filter parameters for all bands.
+	struct Parameters {
+		std::array<Coefficients, kMaxBands> Bands = {};   // Coefficients for each band.
+		std::array<bool, kMaxBands> Active = {};          // Whether each band modifies the signal (bands with no gain are skipped).
+		size_t BandCount = 0;                             // Number of bands.
+	};
+
+	// Returns the peaking filter coefficients for a band with a centre 'frequency' in Hz, a 'gain' in dB & a 'bandwidth' in semitones.
+	Coefficients CalculateCoefficients( const double frequency, const double gain, const double bandwidth ) const;
+
+	// Applies the 'coefficients' for a 'band' to the 'buffer'.
+	void ProcessBand( const Coefficients& coefficients, const size_t band, float* buffer, const size_t frames );
+
+	// Sample rate.
+	const long m_SampleRate;
+
+	// Channel count.
+	const uint32_t m_Channels;
+
+	// Channel count padded to a multiple of 4, for the filter state layout.
+	const uint32_t m_PaddedChannels;
+
+	// Whether to apply the EQ using SIMD instructions.
+	bool m_UseSIMD;
+
+	// Parameters most recently set (protected by the pending mutex).
+	Parameters m_PendingParameters;
+
+	// Whether the pending parameters have changed since they were last picked up by the processing thread (protected by the pending mutex).
+	bool m_PendingChanged = false;
+
+	// Pending parameters mutex (the processing thread only ever tries to lock this).
+	mutable std::mutex m_PendingMutex;
+
+	// Parameters in use by the processing thread.
+	Parameters m_Parameters;
+
+	// Filter state, with the first & second delay elements for each padded channel, for each band.
+	std::vector<float> m_State;
+};
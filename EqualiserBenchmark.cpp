@@ -0,0 +1,231 @@
+#include "EqualiserBenchmark.h"
+
+#include "Equaliser.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Maximum allowed difference between the measured & calculated response, in dB.
+constexpr double kMaxResponseError = 0.01;
+
+// Maximum allowed difference between the SIMD & scalar path output samples.
+constexpr double kMaxPathDifference = 1e-5;
+
+// Sine wave amplitude.
+constexpr float kAmplitude = 0.5f;
+
+// Sine wave duration, in seconds (the response is measured over the second half, once the filters have settled).
+constexpr double kSineSeconds = 1.0;
+
+// Number of frames processed in one go.
+constexpr size_t kBlockFrames = 1024;
+
+// Sample rate used for timing.
+constexpr long kTimingSampleRate = 44100;
+
+// Duration of audio processed when timing, in seconds.
+constexpr size_t kTimingSeconds = 60;
+
+// Sample rates at which the response is checked.
+static const std::vector<long> s_SampleRates = { 22050, 44100, 48000, 96000 };
+
+// Channel counts at which the response is checked.
+static const std::vector<uint32_t> s_ResponseChannels = { 1, 2, 3, 6, 8 };
+
+// Channel counts at which the equaliser is timed.
+static const std::vector<uint32_t> s_TimingChannels = { 1, 2, 6, 8 };
+
+// Frequencies at which the response is checked, in Hz (at each band centre, and in between).
+static const std::vector<double> s_Frequencies = { 50, 80, 106, 140, 187, 250, 354, 500, 707, 1000, 1414, 2000, 2828, 4000, 5657, 8000, 10583, 14000, 18000 };
+
+// Returns the seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Returns enabled EQ settings, with alternately boosted & cut bands.
+static Settings::EQ GetSettings()
+{
+	Settings::EQ settings;
+	settings.Enabled = true;
+	float gain = Settings::EQ::MaxGain;
+	for ( auto& [frequency, bandGain] : settings.Gains ) {
+		bandGain = gain;
+		gain = ( gain > 0 ) ? ( gain * -0.5f ) : ( gain * -1.5f );
+	}
+	return settings;
+}
+
+// Applies the 'equaliser' to the 'buffer', a block at a time (as the output does).
+static void Process( Equaliser& equaliser, std::vector<float>& buffer )
+{
+	const size_t channels = equaliser.GetChannels();
+	const size_t frames = buffer.size() / channels;
+	for ( size_t frame = 0; frame < frames; frame += kBlockFrames ) {
+		equaliser.Process( buffer.data() + frame * channels, std::min( kBlockFrames, frames - frame ) );
+	}
+}
+
+// Returns a sine wave of a 'frequency' in Hz, with a different phase for each channel.
+static std::vector<float> GetSine( const double frequency, const long sampleRate, const uint32_t channels )
+{
+	const size_t frames = static_cast<size_t>( kSineSeconds * sampleRate );
+	std::vector<float> buffer( frames * channels );
+	for ( size_t frame = 0; frame < frames; frame++ ) {
+		for ( uint32_t channel = 0; channel < channels; channel++ ) {
+			buffer[ frame * channels + channel ] = kAmplitude * static_cast<float>( std::sin( 2 * std::numbers::pi * frequency * frame / sampleRate + channel ) );
+		}
+	}
+	return buffer;
+}
+
+// Returns the maximum difference between the response measured by filtering sine waves & the response calculated by the equaliser, in dB.
+// Also updates the 'maxPathDifference' between the SIMD & scalar path output samples, when using the SIMD path.
+static double CheckResponse( const long sampleRate, const uint32_t channels, const bool useSIMD, double& maxPathDifference )
+{
+	const Settings::EQ settings = GetSettings();
+	double maxError = 0;
+	for ( const double frequency : s_Frequencies ) {
+		if ( frequency >= ( sampleRate / 2 ) ) {
+			continue;
+		}
+		Equaliser equaliser( sampleRate, channels );
+		equaliser.SetUseSIMD( useSIMD );
+		equaliser.SetSettings( settings );
+		std::vector<float> buffer = GetSine( frequency, sampleRate, channels );
+		Process( equaliser, buffer );
+
+		const size_t frames = buffer.size() / channels;
+		const double inputRMS = kAmplitude / std::numbers::sqrt2;
+		const double response = equaliser.GetResponse( frequency );
+		for ( uint32_t channel = 0; channel < channels; channel++ ) {
+			double total = 0;
+			for ( size_t frame = frames / 2; frame < frames; frame++ ) {
+				const double sample = buffer[ frame * channels + channel ];
+				total += sample * sample;
+			}
+			const double outputRMS = std::sqrt( total / ( frames - frames / 2 ) );
+			maxError = std::max( maxError, std::fabs( 20 * std::log10( outputRMS / inputRMS ) - response ) );
+		}
+
+		if ( useSIMD ) {
+			Equaliser scalarEqualiser( sampleRate, channels );
+			scalarEqualiser.SetUseSIMD( false );
+			scalarEqualiser.SetSettings( settings );
+			std::vector<float> scalarBuffer = GetSine( frequency, sampleRate, channels );
+			Process( scalarEqualiser, scalarBuffer );
+			for ( size_t sample = 0; sample < buffer.size(); sample++ ) {
+				maxPathDifference = std::max( maxPathDifference, static_cast<double>( std::fabs( buffer[ sample ] - scalarBuffer[ sample ] ) ) );
+			}
+		}
+	}
+	return maxError;
+}
+
+// Returns the time taken to apply all bands, in nanoseconds per frame.
+static double TimeEqualiser( const uint32_t channels, const bool useSIMD )
+{
+	Equaliser equaliser( kTimingSampleRate, channels );
+	equaliser.SetUseSIMD( useSIMD );
+	equaliser.SetSettings( GetSettings() );
+	std::vector<float> buffer = GetSine( 1000, kTimingSampleRate, channels );
+	const size_t frames = buffer.size() / channels;
+	const size_t iterations = static_cast<size_t>( kTimingSeconds / kSineSeconds );
+	const auto start = std::chrono::steady_clock::now();
+	for ( size_t iteration = 0; iteration < iterations; iteration++ ) {
+		Process( equaliser, buffer );
+	}
+	return GetElapsedSeconds( start ) * 1e9 / ( iterations * frames );
+}
+
+EqualiserBenchmark::Results EqualiserBenchmark::Run()
+{
+	Results results;
+	results.SIMDAvailable = Equaliser::IsSIMDAvailable();
+	std::vector<bool> paths = { false };
+	if ( results.SIMDAvailable ) {
+		paths.push_back( true );
+	}
+
+	for ( const long sampleRate : s_SampleRates ) {
+		for ( const uint32_t channels : s_ResponseChannels ) {
+			for ( const bool useSIMD : paths ) {
+				ResponseResult result;
+				result.SampleRate = sampleRate;
+				result.Channels = channels;
+				result.SIMD = useSIMD;
+				result.MaxError = CheckResponse( sampleRate, channels, useSIMD, results.MaxPathDifference );
+				results.Responses.push_back( result );
+			}
+		}
+	}
+
+	for ( const uint32_t channels : s_TimingChannels ) {
+		for ( const bool useSIMD : paths ) {
+			TimingResult result;
+			result.Channels = channels;
+			result.SIMD = useSIMD;
+			result.NanosecondsPerFrame = TimeEqualiser( channels, useSIMD );
+			results.Timings.push_back( result );
+		}
+	}
+	return results;
+}
+
+bool EqualiserBenchmark::Passed( const Results& results )
+{
+	const bool responsesPassed = std::all_of( results.Responses.begin(), results.Responses.end(), [] ( const ResponseResult& result )
+		{
+			return result.MaxError <= kMaxResponseError;
+		} );
+	return responsesPassed && ( results.MaxPathDifference <= kMaxPathDifference );
+}
+
+bool EqualiserBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+		doc[ "simdAvailable" ] = results.SIMDAvailable;
+
+		nlohmann::json responses = nlohmann::json::array();
+		for ( const auto& result : results.Responses ) {
+			nlohmann::json response;
+			response[ "sampleRate" ] = result.SampleRate;
+			response[ "channels" ] = result.Channels;
+			response[ "simd" ] = result.SIMD;
+			response[ "maxError" ] = result.MaxError;
+			responses.push_back( response );
+		}
+		doc[ "responses" ] = responses;
+		doc[ "maxAllowedResponseError" ] = kMaxResponseError;
+		doc[ "maxPathDifference" ] = results.MaxPathDifference;
+		doc[ "maxAllowedPathDifference" ] = kMaxPathDifference;
+
+		nlohmann::json timings = nlohmann::json::array();
+		for ( const auto& result : results.Timings ) {
+			nlohmann::json timing;
+			timing[ "channels" ] = result.Channels;
+			timing[ "simd" ] = result.SIMD;
+			timing[ "nanosecondsPerFrame" ] = result.NanosecondsPerFrame;
+			timings.push_back( timing );
+		}
+		doc[ "timings" ] = timings;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
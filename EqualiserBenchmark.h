@@ -0,0 +1,46 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <vector>
+
+// Checks the correctness, and measures the performance, of the equaliser.
+// The response measured by filtering sine waves is checked against the response calculated by the equaliser, for both the SIMD & scalar paths, at several sample rates & channel counts.
+// The benchmark is run headless using the '-eqbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class EqualiserBenchmark
+{
+public:
+	// Response check results for a single configuration.
+	struct ResponseResult {
+		long SampleRate = 0;                    // Sample rate.
+		uint32_t Channels = 0;                  // Channel count.
+		bool SIMD = false;                      // Whether the SIMD path was used.
+		double MaxError = 0;                    // Maximum difference between the measured & calculated response, in dB.
+	};
+
+	// Timing results for a single configuration.
+	struct TimingResult {
+		uint32_t Channels = 0;                  // Channel count.
+		bool SIMD = false;                      // Whether the SIMD path was used.
+		double NanosecondsPerFrame = 0;         // Time taken to apply all bands, in nanoseconds per frame.
+	};
+
+	// Benchmark results.
+	struct Results {
+		bool SIMDAvailable = false;             // Whether the SIMD path is available.
+		std::vector<ResponseResult> Responses;  // Response check results.
+		double MaxPathDifference = 0;           // Maximum difference between the SIMD & scalar path output samples.
+		std::vector<TimingResult> Timings;      // Timing results.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are within tolerance.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are within tolerance.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
@@ -0,0 +1,382 @@
+#include "FFT.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#define FFT_SSE
+#include <immintrin.h>
+#endif
+
+// Number of mantissa bits used to index the logarithm lookup table.
+constexpr int kLog10MantissaBits = 7;
+
+#ifdef FFT_SSE
+
+// Multiplies the complex values 'a' & 'b', with separate real and imaginary parts, into 'r' & 'i'.
+static inline void ComplexMultiply( const __m128 ar, const __m128 ai, const __m128 br, const __m128 bi, __m128& r, __m128& i )
+{
+	r = _mm_sub_ps( _mm_mul_ps( ar, br ), _mm_mul_ps( ai, bi ) );
+	i = _mm_add_ps( _mm_mul_ps( ar, bi ), _mm_mul_ps( ai, br ) );
+}
+
+// Radix-4 butterfly of the inputs 'a' to 'd', with twiddle factors 'w1' to 'w3', into the outputs 'y0' to 'y3'.
+static inline void Butterfly4(
+	const __m128 ar, const __m128 ai, const __m128 br, const __m128 bi, const __m128 cr, const __m128 ci, const __m128 dr, const __m128 di,
+	const __m128 w1r, const __m128 w1i, const __m128 w2r, const __m128 w2i, const __m128 w3r, const __m128 w3i,
+	__m128& y0r, __m128& y0i, __m128& y1r, __m128& y1i, __m128& y2r, __m128& y2i, __m128& y3r, __m128& y3i )
+{
+	const __m128 apcr = _mm_add_ps( ar, cr );
+	const __m128 apci = _mm_add_ps( ai, ci );
+	const __m128 amcr = _mm_sub_ps( ar, cr );
+	const __m128 amci = _mm_sub_ps( ai, ci );
+	const __m128 bpdr = _mm_add_ps( br, dr );
+	const __m128 bpdi = _mm_add_ps( bi, di );
+	const __m128 bmdr = _mm_sub_ps( br, dr );
+	const __m128 bmdi = _mm_sub_ps( bi, di );
+	y0r = _mm_add_ps( apcr, bpdr );
+	y0i = _mm_add_ps( apci, bpdi );
+	ComplexMultiply( w1r, w1i, _mm_add_ps( amcr, bmdi ), _mm_sub_ps( amci, bmdr ), y1r, y1i );
+	ComplexMultiply( w2r, w2i, _mm_sub_ps( apcr, bpdr ), _mm_sub_ps( apci, bpdi ), y2r, y2i );
+	ComplexMultiply( w3r, w3i, _mm_sub_ps( amcr, bmdi ), _mm_add_ps( amci, bmdr ), y3r, y3i );
+}
+
+#endif
+
+// Radix-4 butterfly of the inputs 'a' to 'd', with twiddle factors 'w1' to 'w3', into the outputs 'y0' to 'y3'.
+static inline void Butterfly4( const std::complex<float> a, const std::complex<float> b, const std::complex<float> c, const std::complex<float> d,
+	const std::complex<float> w1, const std::complex<float> w2, const std::complex<float> w3,
+	std::complex<float>& y0, std::complex<float>& y1, std::complex<float>& y2, std::complex<float>& y3 )
+{
+	const std::complex<float> apc = a + c;
+	const std::complex<float> amc = a - c;
+	const std::complex<float> bpd = b + d;
+	const std::complex<float> jbmd( -( b.imag() - d.imag() ), b.real() - d.real() );
+	y0 = apc + bpd;
+	y1 = w1 * ( amc - jbmd );
+	y2 = w2 * ( apc - bpd );
+	y3 = w3 * ( amc + jbmd );
+}
+
+FFT::FFT( const size_t size, const Window window ) :
+	m_Size( size ),
+	m_ComplexSize( size / 2 ),
+	m_Window( size ),
+	m_Stages(),
+	m_Twiddles(),
+	m_SplitRe( size / 2 ),
+	m_SplitIm( size / 2 ),
+	m_WorkRe(),
+	m_WorkIm(),
+	m_BinsRe( size / 2 + 1 ),
+	m_BinsIm( size / 2 + 1 )
+{
+	if ( ( size < kMinSize ) || ( size > kMaxSize ) || !std::has_single_bit( size ) ) {
+		throw std::runtime_error( "FFT size not supported" );
+	}
+
+	// Periodic window functions.
+	for ( size_t n = 0; n < m_Size; n++ ) {
+		const double x = 2 * std::numbers::pi * n / m_Size;
+		double value = 1;
+		switch ( window ) {
+			case Window::Hann: {
+				value = 0.5 - 0.5 * std::cos( x );
+				break;
+			}
+			case Window::Hamming: {
+				value = 0.54 - 0.46 * std::cos( x );
+				break;
+			}
+			case Window::Blackman: {
+				value = 0.42 - 0.5 * std::cos( x ) + 0.08 * std::cos( 2 * x );
+				break;
+			}
+			default: {
+				break;
+			}
+		}
+		m_Window[ n ] = static_cast<float>( value );
+	}
+
+	// Radix-4 stages, followed by a final radix-2 stage when the complex transform size is not a power of four.
+	size_t length = m_ComplexSize;
+	size_t stride = 1;
+	while ( length > 1 ) {
+		const size_t radix = ( 0 == ( length % 4 ) ) ? 4 : 2;
+		m_Stages.push_back( { radix, length, stride, m_Twiddles.size() } );
+		if ( 4 == radix ) {
+			const size_t m = length / 4;
+			m_Twiddles.resize( m_Twiddles.size() + 6 * m );
+			float* twiddles = m_Twiddles.data() + m_Stages.back().Twiddles;
+			for ( size_t p = 0; p < m; p++ ) {
+				for ( size_t k = 1; k <= 3; k++ ) {
+					const double angle = -2 * std::numbers::pi * k * p / length;
+					twiddles[ ( 2 * k - 2 ) * m + p ] = static_cast<float>( std::cos( angle ) );
+					twiddles[ ( 2 * k - 1 ) * m + p ] = static_cast<float>( std::sin( angle ) );
+				}
+			}
+		}
+		length /= radix;
+		stride *= radix;
+	}
+
+	for ( size_t k = 0; k < m_ComplexSize; k++ ) {
+		const double angle = -2 * std::numbers::pi * k / m_Size;
+		m_SplitRe[ k ] = static_cast<float>( std::cos( angle ) );
+		m_SplitIm[ k ] = static_cast<float>( std::sin( angle ) );
+	}
+
+	for ( size_t buffer = 0; buffer < 2; buffer++ ) {
+		m_WorkRe[ buffer ].resize( m_ComplexSize );
+		m_WorkIm[ buffer ].resize( m_ComplexSize );
+	}
+}
+
+FFT::~FFT()
+{
+}
+
+size_t FFT::GetSize() const
+{
+	return m_Size;
+}
+
+size_t FFT::GetBins() const
+{
+	return m_ComplexSize;
+}
+
+void FFT::Transform( const float* input, std::complex<float>* output )
+{
+	Pack( input );
+	Unpack( TransformComplex() );
+	for ( size_t bin = 0; bin <= m_ComplexSize; bin++ ) {
+		output[ bin ] = { m_BinsRe[ bin ], m_BinsIm[ bin ] };
+	}
+}
+
+void FFT::Magnitudes( const float* input, float* magnitudes )
+{
+	Pack( input );
+	Unpack( TransformComplex() );
+	const float scale = 2.0f / m_Size;
+	size_t bin = 0;
+#ifdef FFT_SSE
+	const __m128 scaleVector = _mm_set1_ps( scale );
+	for ( ; bin < m_ComplexSize; bin += 4 ) {
+		const __m128 re = _mm_loadu_ps( m_BinsRe.data() + bin );
+		const __m128 im = _mm_loadu_ps( m_BinsIm.data() + bin );
+		_mm_storeu_ps( magnitudes + bin, _mm_mul_ps( scaleVector, _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( re, re ), _mm_mul_ps( im, im ) ) ) ) );
+	}
+#endif
+	for ( ; bin < m_ComplexSize; bin++ ) {
+		magnitudes[ bin ] = scale * std::sqrt( m_BinsRe[ bin ] * m_BinsRe[ bin ] + m_BinsIm[ bin ] * m_BinsIm[ bin ] );
+	}
+}
+
+void FFT::Pack( const float* input )
+{
+	float* re = m_WorkRe[ 0 ].data();
+	float* im = m_WorkIm[ 0 ].data();
+	const float* window = m_Window.data();
+	size_t n = 0;
+#ifdef FFT_SSE
+	for ( ; n < m_ComplexSize; n += 4, input += 8, window += 8 ) {
+		const __m128 first = _mm_mul_ps( _mm_loadu_ps( input ), _mm_loadu_ps( window ) );
+		const __m128 second = _mm_mul_ps( _mm_loadu_ps( input + 4 ), _mm_loadu_ps( window + 4 ) );
+		_mm_storeu_ps( re + n, _mm_shuffle_ps( first, second, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+		_mm_storeu_ps( im + n, _mm_shuffle_ps( first, second, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+	}
+#endif
+	for ( ; n < m_ComplexSize; n++, input += 2, window += 2 ) {
+		re[ n ] = input[ 0 ] * window[ 0 ];
+		im[ n ] = input[ 1 ] * window[ 1 ];
+	}
+}
+
+size_t FFT::TransformComplex()
+{
+	size_t source = 0;
+	for ( const auto& stage : m_Stages ) {
+		const size_t destination = 1 - source;
+		if ( 4 == stage.Radix ) {
+			Radix4( stage, m_WorkRe[ source ].data(), m_WorkIm[ source ].data(), m_WorkRe[ destination ].data(), m_WorkIm[ destination ].data() );
+		} else {
+			Radix2( stage, m_WorkRe[ source ].data(), m_WorkIm[ source ].data(), m_WorkRe[ destination ].data(), m_WorkIm[ destination ].data() );
+		}
+		source = destination;
+	}
+	return source;
+}
+
+void FFT::Radix4( const Stage& stage, const float* sourceRe, const float* sourceIm, float* destinationRe, float* destinationIm ) const
+{
+	const size_t m = stage.Length / 4;
+	const size_t s = stage.Stride;
+	const float* w1r = m_Twiddles.data() + stage.Twiddles;
+	const float* w1i = w1r + m;
+	const float* w2r = w1i + m;
+	const float* w2i = w2r + m;
+	const float* w3r = w2i + m;
+	const float* w3i = w3r + m;
+
+#ifdef FFT_SSE
+	if ( ( 1 == s ) && ( 0 == ( m % 4 ) ) ) {
+		// First stage, so vectorise across the sub-transforms and transpose the outputs.
+		for ( size_t p = 0; p < m; p += 4 ) {
+			__m128 y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+			Butterfly4(
+				_mm_loadu_ps( sourceRe + p ), _mm_loadu_ps( sourceIm + p ), _mm_loadu_ps( sourceRe + p + m ), _mm_loadu_ps( sourceIm + p + m ),
+				_mm_loadu_ps( sourceRe + p + 2 * m ), _mm_loadu_ps( sourceIm + p + 2 * m ), _mm_loadu_ps( sourceRe + p + 3 * m ), _mm_loadu_ps( sourceIm + p + 3 * m ),
+				_mm_loadu_ps( w1r + p ), _mm_loadu_ps( w1i + p ), _mm_loadu_ps( w2r + p ), _mm_loadu_ps( w2i + p ), _mm_loadu_ps( w3r + p ), _mm_loadu_ps( w3i + p ),
+				y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i );
+			_MM_TRANSPOSE4_PS( y0r, y1r, y2r, y3r );
+			_MM_TRANSPOSE4_PS( y0i, y1i, y2i, y3i );
+			float* outputRe = destinationRe + 4 * p;
+			float* outputIm = destinationIm + 4 * p;
+			_mm_storeu_ps( outputRe, y0r );
+			_mm_storeu_ps( outputRe + 4, y1r );
+			_mm_storeu_ps( outputRe + 8, y2r );
+			_mm_storeu_ps( outputRe + 12, y3r );
+			_mm_storeu_ps( outputIm, y0i );
+			_mm_storeu_ps( outputIm + 4, y1i );
+			_mm_storeu_ps( outputIm + 8, y2i );
+			_mm_storeu_ps( outputIm + 12, y3i );
+		}
+		return;
+	}
+	if ( 0 == ( s % 4 ) ) {
+		// Later stages, so vectorise within each sub-transform, where the twiddle factors are constant.
+		for ( size_t p = 0; p < m; p++ ) {
+			const __m128 tw1r = _mm_set1_ps( w1r[ p ] );
+			const __m128 tw1i = _mm_set1_ps( w1i[ p ] );
+			const __m128 tw2r = _mm_set1_ps( w2r[ p ] );
+			const __m128 tw2i = _mm_set1_ps( w2i[ p ] );
+			const __m128 tw3r = _mm_set1_ps( w3r[ p ] );
+			const __m128 tw3i = _mm_set1_ps( w3i[ p ] );
+			const size_t input = s * p;
+			const size_t output = 4 * s * p;
+			const size_t inputStep = s * m;
+			for ( size_t q = 0; q < s; q += 4 ) {
+				__m128 y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+				const size_t i0 = input + q;
+				Butterfly4(
+					_mm_loadu_ps( sourceRe + i0 ), _mm_loadu_ps( sourceIm + i0 ), _mm_loadu_ps( sourceRe + i0 + inputStep ), _mm_loadu_ps( sourceIm + i0 + inputStep ),
+					_mm_loadu_ps( sourceRe + i0 + 2 * inputStep ), _mm_loadu_ps( sourceIm + i0 + 2 * inputStep ), _mm_loadu_ps( sourceRe + i0 + 3 * inputStep ), _mm_loadu_ps( sourceIm + i0 + 3 * inputStep ),
+					tw1r, tw1i, tw2r, tw2i, tw3r, tw3i,
+					y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i );
+				const size_t o0 = output + q;
+				_mm_storeu_ps( destinationRe + o0, y0r );
+				_mm_storeu_ps( destinationIm + o0, y0i );
+				_mm_storeu_ps( destinationRe + o0 + s, y1r );
+				_mm_storeu_ps( destinationIm + o0 + s, y1i );
+				_mm_storeu_ps( destinationRe + o0 + 2 * s, y2r );
+				_mm_storeu_ps( destinationIm + o0 + 2 * s, y2i );
+				_mm_storeu_ps( destinationRe + o0 + 3 * s, y3r );
+				_mm_storeu_ps( destinationIm + o0 + 3 * s, y3i );
+			}
+		}
+		return;
+	}
+#endif
+
+	for ( size_t p = 0; p < m; p++ ) {
+		const std::complex<float> w1( w1r[ p ], w1i[ p ] );
+		const std::complex<float> w2( w2r[ p ], w2i[ p ] );
+		const std::complex<float> w3( w3r[ p ], w3i[ p ] );
+		for ( size_t q = 0; q < s; q++ ) {
+			const size_t i0 = q + s * p;
+			const size_t i1 = i0 + s * m;
+			const size_t i2 = i1 + s * m;
+			const size_t i3 = i2 + s * m;
+			std::complex<float> y0, y1, y2, y3;
+			Butterfly4( { sourceRe[ i0 ], sourceIm[ i0 ] }, { sourceRe[ i1 ], sourceIm[ i1 ] }, { sourceRe[ i2 ], sourceIm[ i2 ] }, { sourceRe[ i3 ], sourceIm[ i3 ] },
+				w1, w2, w3, y0, y1, y2, y3 );
+			const size_t o0 = q + 4 * s * p;
+			destinationRe[ o0 ] = y0.real();
+			destinationIm[ o0 ] = y0.imag();
+			destinationRe[ o0 + s ] = y1.real();
+			destinationIm[ o0 + s ] = y1.imag();
+			destinationRe[ o0 + 2 * s ] = y2.real();
+			destinationIm[ o0 + 2 * s ] = y2.imag();
+			destinationRe[ o0 + 3 * s ] = y3.real();
+			destinationIm[ o0 + 3 * s ] = y3.imag();
+		}
+	}
+}
+
+void FFT::Radix2( const Stage& stage, const float* sourceRe, const float* sourceIm, float* destinationRe, float* destinationIm ) const
+{
+	// The radix-2 stage is only ever the final stage, where the sub-transform length is 2 and the twiddle factor is 1.
+	const size_t s = stage.Stride;
+	size_t q = 0;
+#ifdef FFT_SSE
+	for ( ; ( q + 4 ) <= s; q += 4 ) {
+		const __m128 ar = _mm_loadu_ps( sourceRe + q );
+		const __m128 ai = _mm_loadu_ps( sourceIm + q );
+		const __m128 br = _mm_loadu_ps( sourceRe + q + s );
+		const __m128 bi = _mm_loadu_ps( sourceIm + q + s );
+		_mm_storeu_ps( destinationRe + q, _mm_add_ps( ar, br ) );
+		_mm_storeu_ps( destinationIm + q, _mm_add_ps( ai, bi ) );
+		_mm_storeu_ps( destinationRe + q + s, _mm_sub_ps( ar, br ) );
+		_mm_storeu_ps( destinationIm + q + s, _mm_sub_ps( ai, bi ) );
+	}
+#endif
+	for ( ; q < s; q++ ) {
+		const float ar = sourceRe[ q ];
+		const float ai = sourceIm[ q ];
+		const float br = sourceRe[ q + s ];
+		const float bi = sourceIm[ q + s ];
+		destinationRe[ q ] = ar + br;
+		destinationIm[ q ] = ai + bi;
+		destinationRe[ q + s ] = ar - br;
+		destinationIm[ q + s ] = ai - bi;
+	}
+}
+
+void FFT::Unpack( const size_t buffer )
+{
+	// The complex transform Z of the even (E) & odd (O) samples gives E[k] = (Z[k] + conj(Z[M-k])) / 2 and O[k] = (Z[k] - conj(Z[M-k])) / 2i,
+	// from which the real transform X[k] = E[k] + W^k.O[k].
+	const float* re = m_WorkRe[ buffer ].data();
+	const float* im = m_WorkIm[ buffer ].data();
+	m_BinsRe[ 0 ] = re[ 0 ] + im[ 0 ];
+	m_BinsIm[ 0 ] = 0;
+	m_BinsRe[ m_ComplexSize ] = re[ 0 ] - im[ 0 ];
+	m_BinsIm[ m_ComplexSize ] = 0;
+	for ( size_t k = 1; k < m_ComplexSize; k++ ) {
+		const size_t j = m_ComplexSize - k;
+		const float evenRe = 0.5f * ( re[ k ] + re[ j ] );
+		const float evenIm = 0.5f * ( im[ k ] - im[ j ] );
+		const float oddRe = 0.5f * ( im[ k ] + im[ j ] );
+		const float oddIm = -0.5f * ( re[ k ] - re[ j ] );
+		m_BinsRe[ k ] = evenRe + m_SplitRe[ k ] * oddRe - m_SplitIm[ k ] * oddIm;
+		m_BinsIm[ k ] = evenIm + m_SplitRe[ k ] * oddIm + m_SplitIm[ k ] * oddRe;
+	}
+}
+
+Log10Lookup::Log10Lookup() :
+	m_Table( size_t( 1 ) << ( 8 + kLog10MantissaBits ) )
+{
+	// Each entry holds the logarithm of the value at the centre of its range.
+	constexpr uint32_t shift = 23 - kLog10MantissaBits;
+	for ( uint32_t index = 0; index < m_Table.size(); index++ ) {
+		const float value = std::bit_cast<float>( ( index << shift ) | ( 1u << ( shift - 1 ) ) );
+		m_Table[ index ] = std::isfinite( value ) ? static_cast<float>( std::log10( static_cast<double>( value ) ) ) : std::log10( std::numeric_limits<float>::max() );
+	}
+}
+
+Log10Lookup::~Log10Lookup()
+{
+}
+
+float Log10Lookup::operator()( const float value ) const
+{
+	constexpr uint32_t shift = 23 - kLog10MantissaBits;
+	return m_Table[ ( std::bit_cast<uint32_t>( value ) & 0x7fffffff ) >> shift ];
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <complex>
+#include <vector>
+
+// Real input fast Fourier transform, using a radix-4 Stockham (autosort) complex transform of half the size, with SSE where available.
+class FFT
+{
+public:
+	// Window function applied to the input.
+	enum class Window {
+		Rectangular,
+		Hann,
+		Hamming,
+		Blackman
+	};
+
+	// Minimum transform size.
+	static constexpr size_t kMinSize = 32;
+
+	// Maximum transform size.
+	static constexpr size_t kMaxSize = 65536;
+
+	// 'size' - transform size, which must be a power of two between the minimum and maximum sizes.
+	// 'window' - window function to apply to the input.
+	// Throws a std::runtime_error exception if the size is not supported.
+	FFT( const size_t size, const Window window );
+
+	virtual ~FFT();
+
+	// Returns the transform size.
+	size_t GetSize() const;
+
+	// Returns the number of magnitude bins (half the transform size).
+	size_t GetBins() const;
+
+	// Transforms the 'input' (transform size samples, to which the window is applied) into the 'output' (half the transform size plus one bins, from DC to Nyquist).
+	void Transform( const float* input, std::complex<float>* output );
+
+	// Calculates the 'magnitudes' (one per bin, excluding Nyquist) of the 'input' (transform size samples, to which the window is applied).
+	// Magnitudes are scaled by 2/size, so that a full scale sine wave at a bin centre has a magnitude equal to the coherent gain of the window.
+	void Magnitudes( const float* input, float* magnitudes );
+
+private:
+	// Complex transform stage.
+	struct Stage {
+		size_t Radix;       // Stage radix (2 or 4).
+		size_t Length;      // Sub-transform length.
+		size_t Stride;      // Stride between sub-transforms.
+		size_t Twiddles;    // Offset of the stage twiddle factors, which are stored as blocks of real and imaginary parts for W^p, W^2p & W^3p.
+	};
+
+	// Applies the window to the 'input' and packs it into the complex work buffer, with even samples as real parts and odd samples as imaginary parts.
+	void Pack( const float* input );
+
+	// Performs the complex transform of the work buffer, returning the index of the buffer containing the result.
+	size_t TransformComplex();
+
+	// Performs a radix-4 'stage', from the 'source' buffer to the 'destination' buffer.
+	void Radix4( const Stage& stage, const float* sourceRe, const float* sourceIm, float* destinationRe, float* destinationIm ) const;
+
+	// Performs a radix-2 'stage', from the 'source' buffer to the 'destination' buffer.
+	void Radix2( const Stage& stage, const float* sourceRe, const float* sourceIm, float* destinationRe, float* destinationIm ) const;
+
+	// Splits the complex transform result in the 'buffer' into the real transform bins.
+	void Unpack( const size_t buffer );
+
+	// Transform size.
+	const size_t m_Size;
+
+	// Complex transform size (half the transform size).
+	const size_t m_ComplexSize;
+
+	// Window coefficients.
+	std::vector<float> m_Window;
+
+	// Complex transform stages.
+	std::vector<Stage> m_Stages;
+
+	// Complex transform twiddle factors.
+	std::vector<float> m_Twiddles;
+
+	// Real and imaginary parts of the twiddle factors used to split the complex transform result.
+	std::vector<float> m_SplitRe;
+	std::vector<float> m_SplitIm;
+
+	// Ping-pong work buffers, with separate real and imaginary parts.
+	std::vector<float> m_WorkRe[ 2 ];
+	std::vector<float> m_WorkIm[ 2 ];
+
+	// Real and imaginary parts of the real transform bins (DC to Nyquist).
+	std::vector<float> m_BinsRe;
+	std::vector<float> m_BinsIm;
+};
+
+// Base 10 logarithm approximation, using a lookup table indexed by the exponent & leading mantissa bits of the (absolute) value.
+// The result is within 0.002 of the exact value, which is ample for display purposes.
+class Log10Lookup
+{
+public:
+	Log10Lookup();
+
+	virtual ~Log10Lookup();
+
+	// Returns the approximate base 10 logarithm of the absolute 'value' (very small values, including zero, return around -40).
+	float operator()( const float value ) const;
+
+private:
+	// Lookup table.
+	std::vector<float> m_Table;
+};
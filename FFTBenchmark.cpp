@@ -0,0 +1,193 @@
+#include "FFTBenchmark.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <numbers>
+#include <random>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Largest transform size which is checked against the reference DFT (larger sizes are only timed).
+constexpr size_t kMaxReferenceSize = 8192;
+
+// Maximum allowed transform error, relative to the largest reference magnitude.
+constexpr double kMaxTransformError = 1e-5;
+
+// Maximum allowed logarithm lookup error.
+constexpr double kMaxLog10Error = 0.002;
+
+// Number of input samples to transform when timing each size.
+constexpr size_t kTimingSamples = 1 << 24;
+
+// Number of values used to check & time the logarithm lookup.
+constexpr size_t kLog10Values = 1 << 20;
+
+// Random seed for the input data, so that each run uses the same input.
+constexpr uint32_t kSeed = 1974;
+
+// Window functions, and their names in the results file.
+static const std::vector<std::pair<FFT::Window, const char*>> s_Windows = {
+	{ FFT::Window::Rectangular, "rectangular" },
+	{ FFT::Window::Hann, "hann" },
+	{ FFT::Window::Hamming, "hamming" },
+	{ FFT::Window::Blackman, "blackman" }
+};
+
+// Returns the reference (periodic) 'window' coefficient for sample 'n' of a transform of 'size'.
+static double GetWindowCoefficient( const FFT::Window window, const size_t n, const size_t size )
+{
+	const double x = 2 * std::numbers::pi * n / size;
+	switch ( window ) {
+		case FFT::Window::Hann: {
+			return 0.5 - 0.5 * std::cos( x );
+		}
+		case FFT::Window::Hamming: {
+			return 0.54 - 0.46 * std::cos( x );
+		}
+		case FFT::Window::Blackman: {
+			return 0.42 - 0.5 * std::cos( x ) + 0.08 * std::cos( 2 * x );
+		}
+		default: {
+			return 1;
+		}
+	}
+}
+
+// Returns the maximum error of the 'fft' output for the 'input', against a double precision reference DFT, relative to the largest reference magnitude.
+static double CheckTransform( FFT& fft, const FFT::Window window, const std::vector<float>& input )
+{
+	const size_t size = fft.GetSize();
+	std::vector<std::complex<float>> output( size / 2 + 1 );
+	fft.Transform( input.data(), output.data() );
+
+	std::vector<double> windowed( size );
+	std::vector<std::complex<double>> twiddles( size );
+	for ( size_t n = 0; n < size; n++ ) {
+		windowed[ n ] = input[ n ] * GetWindowCoefficient( window, n, size );
+		twiddles[ n ] = std::polar( 1.0, -2 * std::numbers::pi * n / size );
+	}
+
+	double maxMagnitude = 0;
+	double maxError = 0;
+	for ( size_t k = 0; k < output.size(); k++ ) {
+		std::complex<double> reference = 0;
+		for ( size_t n = 0; n < size; n++ ) {
+			reference += windowed[ n ] * twiddles[ ( k * n ) % size ];
+		}
+		maxMagnitude = std::max( maxMagnitude, std::abs( reference ) );
+		maxError = std::max( maxError, std::abs( reference - std::complex<double>( output[ k ] ) ) );
+	}
+	return ( maxMagnitude > 0 ) ? ( maxError / maxMagnitude ) : maxError;
+}
+
+// Returns the time taken by the 'fft' to calculate the magnitudes of the 'input', in nanoseconds per transform.
+static double TimeTransform( FFT& fft, const std::vector<float>& input )
+{
+	std::vector<float> magnitudes( fft.GetBins() );
+	const size_t iterations = std::max<size_t>( 1, kTimingSamples / fft.GetSize() );
+	const auto start = std::chrono::steady_clock::now();
+	for ( size_t iteration = 0; iteration < iterations; iteration++ ) {
+		fft.Magnitudes( input.data(), magnitudes.data() );
+	}
+	return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / iterations;
+}
+
+FFTBenchmark::Results FFTBenchmark::Run()
+{
+	Results results;
+	std::mt19937 engine( kSeed );
+	std::uniform_real_distribution<float> sampleDistribution( -1, 1 );
+	for ( size_t size = FFT::kMinSize; size <= FFT::kMaxSize; size *= 2 ) {
+		std::vector<float> input( size );
+		for ( auto& sample : input ) {
+			sample = sampleDistribution( engine );
+		}
+		for ( const auto& [window, name] : s_Windows ) {
+			FFT fft( size, window );
+			Result result;
+			result.Size = size;
+			result.Window = window;
+			if ( size <= kMaxReferenceSize ) {
+				result.MaxError = CheckTransform( fft, window, input );
+			}
+			result.NanosecondsPerTransform = TimeTransform( fft, input );
+			results.Transforms.push_back( result );
+		}
+	}
+
+	// Check the logarithm lookup over the range of values shown by the visuals, and beyond.
+	const Log10Lookup log10;
+	std::uniform_real_distribution<float> exponentDistribution( -12, 4 );
+	std::vector<float> values( kLog10Values );
+	for ( auto& value : values ) {
+		value = std::pow( 10.0f, exponentDistribution( engine ) );
+	}
+	for ( const auto value : values ) {
+		results.Log10MaxError = std::max( results.Log10MaxError, std::fabs( log10( value ) - std::log10( static_cast<double>( value ) ) ) );
+	}
+	float total = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for ( const auto value : values ) {
+		total += log10( value );
+	}
+	results.Log10NanosecondsPerValue = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / values.size();
+
+	// Prevent the timing loop from being optimised away.
+	if ( std::isnan( total ) ) {
+		results.Log10MaxError = total;
+	}
+	return results;
+}
+
+bool FFTBenchmark::Passed( const Results& results )
+{
+	const bool transformsPassed = std::all_of( results.Transforms.begin(), results.Transforms.end(), [] ( const Result& result )
+		{
+			return !result.MaxError || ( *result.MaxError <= kMaxTransformError );
+		} );
+	return transformsPassed && ( results.Log10MaxError <= kMaxLog10Error );
+}
+
+bool FFTBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+
+		nlohmann::json transforms = nlohmann::json::array();
+		for ( const auto& result : results.Transforms ) {
+			nlohmann::json transform;
+			transform[ "size" ] = result.Size;
+			const auto window = std::find_if( s_Windows.begin(), s_Windows.end(), [ &result ] ( const auto& entry ) { return entry.first == result.Window; } );
+			if ( s_Windows.end() != window ) {
+				transform[ "window" ] = window->second;
+			}
+			if ( result.MaxError ) {
+				transform[ "maxError" ] = *result.MaxError;
+			}
+			transform[ "nanosecondsPerTransform" ] = result.NanosecondsPerTransform;
+			transforms.push_back( transform );
+		}
+		doc[ "transforms" ] = transforms;
+		doc[ "maxAllowedTransformError" ] = kMaxTransformError;
+
+		doc[ "log10" ] = {
+			{ "maxError", results.Log10MaxError },
+			{ "maxAllowedError", kMaxLog10Error },
+			{ "nanosecondsPerValue", results.Log10NanosecondsPerValue }
+		};
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "FFT.h"
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// Checks the correctness, and measures the performance, of the FFT & logarithm lookup used by the visuals.
+// The benchmark is run headless using the '-fftbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class FFTBenchmark
+{
+public:
+	// Benchmark results for a single transform size & window.
+	struct Result {
+		size_t Size = 0;                        // Transform size.
+		FFT::Window Window = FFT::Window::Hann; // Window function.
+		std::optional<double> MaxError;         // Maximum error against a reference DFT, relative to the largest reference magnitude (if checked).
+		double NanosecondsPerTransform = 0;     // Time taken to calculate the magnitudes, in nanoseconds per transform.
+	};
+
+	// Benchmark results.
+	struct Results {
+		std::vector<Result> Transforms;         // Transform results.
+		double Log10MaxError = 0;               // Maximum absolute error of the logarithm lookup.
+		double Log10NanosecondsPerValue = 0;    // Time taken by the logarithm lookup, in nanoseconds per value.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are within tolerance.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are within tolerance.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
@@ -0,0 +1,160 @@
+#include "FileSource.h"
+
+#include <algorithm>
+
+// Read-ahead buffer size, for files which are not memory mapped.
+constexpr size_t kReadAheadSize = 0x100000;
+
+// Maximum size of file to memory map (limited for 32-bit builds, where address space is scarce).
+constexpr uint64_t kMaximumMappedSize = ( sizeof( void* ) > 4 ) ? 0x4000000000ull : 0x10000000ull;
+
+FileSource::FileSource( const std::filesystem::path& filepath, const std::optional<Backend> backend )
+{
+	// Allow other readers & writers, as for a standard file stream (the mapping prevents the file being truncated while it is open).
+	m_File = CreateFile( filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr /*securityAttributes*/, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr /*template*/ );
+	if ( INVALID_HANDLE_VALUE == m_File ) {
+		throw std::runtime_error( "FileSource could not open file" );
+	}
+
+	LARGE_INTEGER size = {};
+	if ( !GetFileSizeEx( m_File, &size ) ) {
+		CloseHandle( m_File );
+		throw std::runtime_error( "FileSource could not open file" );
+	}
+	m_Size = static_cast<uint64_t>( size.QuadPart );
+
+	const bool mapFile = backend ? ( Backend::Mapped == *backend ) : IsMappable( filepath );
+	if ( !mapFile || !Map() ) {
+		m_Buffer.resize( kReadAheadSize );
+	}
+}
+
+FileSource::~FileSource()
+{
+	if ( nullptr != m_MappedData ) {
+		UnmapViewOfFile( m_MappedData );
+	}
+	if ( nullptr != m_Mapping ) {
+		CloseHandle( m_Mapping );
+	}
+	if ( INVALID_HANDLE_VALUE != m_File ) {
+		CloseHandle( m_File );
+	}
+}
+
+FileSource::Ptr FileSource::Open( const std::filesystem::path& filepath, const std::optional<Backend> backend )
+{
+	try {
+		return std::make_unique<FileSource>( filepath, backend );
+	} catch ( const std::runtime_error& ) {
+	}
+	return nullptr;
+}
+
+bool FileSource::IsMappable( const std::filesystem::path& filepath )
+{
+	// Reading a mapped file raises an exception, rather than returning an error, if an I/O error occurs.
+	// So only map files on fixed drives, where I/O errors are unlikely.
+	const std::wstring root = filepath.root_path().wstring();
+	return !root.empty() && ( DRIVE_FIXED == GetDriveType( root.c_str() ) );
+}
+
+bool FileSource::Map()
+{
+	if ( ( 0 == m_Size ) || ( m_Size > kMaximumMappedSize ) ) {
+		return false;
+	}
+	m_Mapping = CreateFileMapping( m_File, nullptr /*securityAttributes*/, PAGE_READONLY, 0 /*maximumSizeHigh*/, 0 /*maximumSizeLow*/, nullptr /*name*/ );
+	if ( nullptr != m_Mapping ) {
+		m_MappedData = static_cast<const uint8_t*>( MapViewOfFile( m_Mapping, FILE_MAP_READ, 0 /*offsetHigh*/, 0 /*offsetLow*/, 0 /*bytesToMap*/ ) );
+		if ( nullptr == m_MappedData ) {
+			CloseHandle( m_Mapping );
+			m_Mapping = nullptr;
+		}
+	}
+	return ( nullptr != m_MappedData );
+}
+
+FileSource::Backend FileSource::GetBackend() const
+{
+	return ( nullptr != m_MappedData ) ? Backend::Mapped : Backend::Buffered;
+}
+
+uint64_t FileSource::GetSize() const
+{
+	return m_Size;
+}
+
+uint64_t FileSource::GetPosition() const
+{
+	return m_Position;
+}
+
+bool FileSource::SetPosition( const uint64_t position )
+{
+	m_Position = std::min( position, m_Size );
+	return ( position <= m_Size );
+}
+
+bool FileSource::IsEOF() const
+{
+	return ( m_Position >= m_Size );
+}
+
+size_t FileSource::Read( void* buffer, const size_t size )
+{
+	uint8_t* output = static_cast<uint8_t*>( buffer );
+	size_t bytesRead = 0;
+	while ( bytesRead < size ) {
+		// Read in chunks no larger than the read-ahead buffer, so that a large read does not grow the buffer.
+		const auto data = ReadSpan( std::min( size - bytesRead, ( nullptr != m_MappedData ) ? size : kReadAheadSize ) );
+		if ( data.empty() ) {
+			break;
+		}
+		std::copy( data.begin(), data.end(), output + bytesRead );
+		bytesRead += data.size();
+	}
+	return bytesRead;
+}
+
+std::span<const uint8_t> FileSource::ReadSpan( const size_t size )
+{
+	const auto data = GetSpan( m_Position, size );
+	m_Position += data.size();
+	return data;
+}
+
+std::span<const uint8_t> FileSource::GetSpan( const uint64_t offset, const size_t size )
+{
+	if ( offset >= m_Size ) {
+		return {};
+	}
+	const size_t available = static_cast<size_t>( std::min<uint64_t>( size, m_Size - offset ) );
+	if ( nullptr != m_MappedData ) {
+		return { m_MappedData + offset, available };
+	}
+	return Fill( offset, available );
+}
+
+std::span<const uint8_t> FileSource::Fill( const uint64_t offset, const size_t size )
+{
+	if ( ( offset < m_BufferOffset ) || ( ( offset + size ) > ( m_BufferOffset + m_BufferSize ) ) ) {
+		// Refill the buffer from the requested offset, reading ahead as far as the buffer allows.
+		if ( size > m_Buffer.size() ) {
+			m_Buffer.resize( size );
+		}
+		m_BufferOffset = offset;
+		m_BufferSize = 0;
+		LARGE_INTEGER position = {};
+		position.QuadPart = static_cast<LONGLONG>( offset );
+		if ( SetFilePointerEx( m_File, position, nullptr /*newPosition*/, FILE_BEGIN ) ) {
+			const DWORD bytesToRead = static_cast<DWORD>( std::min<uint64_t>( m_Buffer.size(), m_Size - offset ) );
+			DWORD bytesRead = 0;
+			if ( ReadFile( m_File, m_Buffer.data(), bytesToRead, &bytesRead, nullptr /*overlapped*/ ) ) {
+				m_BufferSize = bytesRead;
+			}
+		}
+	}
+	const size_t bufferPosition = static_cast<size_t>( offset - m_BufferOffset );
+	return { m_Buffer.data() + bufferPosition, std::min( size, m_BufferSize - std::min( bufferPosition, m_BufferSize ) ) };
+}
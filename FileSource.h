@@ -0,0 +1,100 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Read-only file source, providing decoders and tag parsers with direct access to file data.
+// Local files are memory mapped where possible, so that reads become slices of the mapping rather than system calls.
+// Otherwise (e.g. for network & removable drives, or files too large to map), data is read through a large read-ahead buffer.
+class FileSource
+{
+public:
+	// File source pointer type.
+	using Ptr = std::unique_ptr<FileSource>;
+
+	// Data access method.
+	enum class Backend {
+		Mapped,     // The whole file is memory mapped.
+		Buffered    // The file is read through a read-ahead buffer.
+	};
+
+	// 'filepath' - file to open.
+	// 'backend' - the data access method to use, or nullopt to choose the most appropriate method for the file.
+	// Throws a std::runtime_error exception if the file could not be opened.
+	FileSource( const std::filesystem::path& filepath, const std::optional<Backend> backend = std::nullopt );
+
+	FileSource( const FileSource& ) = delete;
+	FileSource& operator=( const FileSource& ) = delete;
+
+	virtual ~FileSource();
+
+	// Returns a file source for 'filepath', or nullptr if the file could not be opened.
+	// 'backend' - the data access method to use, or nullopt to choose the most appropriate method for the file.
+	static Ptr Open( const std::filesystem::path& filepath, const std::optional<Backend> backend = std::nullopt );
+
+	// Returns the data access method being used.
+	Backend GetBackend() const;
+
+	// Returns the file size, in bytes.
+	uint64_t GetSize() const;
+
+	// Returns the current read position, in bytes.
+	uint64_t GetPosition() const;
+
+	// Sets the current read 'position', in bytes, returning whether the position is within the file (or at the end of the file).
+	bool SetPosition( const uint64_t position );
+
+	// Returns whether the current read position is at the end of the file.
+	bool IsEOF() const;
+
+	// Reads up to 'size' bytes into the 'buffer' from the current read position, returning the number of bytes read.
+	size_t Read( void* buffer, const size_t size );
+
+	// Returns a view of up to 'size' bytes from the current read position, and advances the read position past the returned data.
+	// The returned view is only valid until the next call to the file source (unless the file is memory mapped).
+	std::span<const uint8_t> ReadSpan( const size_t size );
+
+	// Returns a view of up to 'size' bytes starting at the 'offset', without changing the current read position.
+	// The returned view is only valid until the next call to the file source (unless the file is memory mapped).
+	std::span<const uint8_t> GetSpan( const uint64_t offset, const size_t size );
+
+private:
+	// Maps the whole file into memory, returning whether the mapping was successful.
+	bool Map();
+
+	// Ensures that the read-ahead buffer holds as many as possible of the 'size' bytes starting at the 'offset'.
+	// Returns a view of the buffered data.
+	std::span<const uint8_t> Fill( const uint64_t offset, const size_t size );
+
+	// Returns whether the 'filepath' is on a drive which is suitable for memory mapping.
+	static bool IsMappable( const std::filesystem::path& filepath );
+
+	// File handle.
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+
+	// File mapping handle.
+	HANDLE m_Mapping = nullptr;
+
+	// Start of the mapped file data (or nullptr if the file is not mapped).
+	const uint8_t* m_MappedData = nullptr;
+
+	// File size.
+	uint64_t m_Size = 0;
+
+	// Current read position.
+	uint64_t m_Position = 0;
+
+	// Read-ahead buffer.
+	std::vector<uint8_t> m_Buffer;
+
+	// File offset of the start of the read-ahead buffer.
+	uint64_t m_BufferOffset = 0;
+
+	// Number of valid bytes in the read-ahead buffer.
+	size_t m_BufferSize = 0;
+};
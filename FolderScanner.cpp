@@ -0,0 +1,151 @@
+#include "FolderScanner.h"
+
+#include <algorithm>
+#include <thread>
+
+FolderScanner::FolderScanner( Enumerator enumerator, StopPredicate stopPredicate ) :
+	m_Enumerator( enumerator ),
+	m_StopPredicate( stopPredicate ),
+	m_FoldersScanned( 0 )
+{
+}
+
+FolderScanner::~FolderScanner()
+{
+}
+
+size_t FolderScanner::Scan( const std::vector<Volume>& volumes, FileCallback fileCallback )
+{
+	m_FoldersScanned = 0;
+	std::vector<std::unique_ptr<Group>> groups;
+	std::vector<std::thread> threads;
+	for ( const auto& volume : volumes ) {
+		Group& group = *groups.emplace_back( std::make_unique<Group>() );
+		const size_t threadCount = std::max<size_t>( 1, volume.Threads );
+		for ( size_t index = 0; index < threadCount; index++ ) {
+			group.Workers.emplace_back( std::make_unique<Worker>() );
+		}
+		group.Workers.front()->Folders.push_back( volume.Root );
+		group.Pending = 1;
+		for ( size_t index = 0; index < threadCount; index++ ) {
+			threads.emplace_back( &FolderScanner::Handler, this, std::ref( group ), index, std::cref( fileCallback ) );
+		}
+	}
+	for ( auto& thread : threads ) {
+		thread.join();
+	}
+	return m_FoldersScanned;
+}
+
+void FolderScanner::Handler( Group& group, const size_t index, const FileCallback& fileCallback )
+{
+	Worker& worker = *group.Workers[ index ];
+	std::vector<std::filesystem::path> folders;
+	std::vector<File> files;
+	std::filesystem::path folder;
+	while ( true ) {
+		if ( TakeFolder( group, index, folder ) ) {
+			if ( !m_StopPredicate || !m_StopPredicate() ) {
+				folders.clear();
+				files.clear();
+				m_Enumerator( folder, folders, files );
+				++m_FoldersScanned;
+
+				// Make the subfolders available to the other threads, before passing on the files.
+				if ( !folders.empty() ) {
+					group.Pending += folders.size();
+					{
+						std::lock_guard<std::mutex> lock( worker.Mutex );
+						for ( auto& subfolder : folders ) {
+							worker.Folders.push_back( std::move( subfolder ) );
+						}
+					}
+					Notify( group );
+				}
+				if ( fileCallback ) {
+					for ( auto& file : files ) {
+						fileCallback( std::move( file ) );
+					}
+				}
+			}
+			if ( 1 == group.Pending.fetch_sub( 1 ) ) {
+				// The scan of the volume has finished.
+				Notify( group );
+			}
+		} else {
+			std::unique_lock<std::mutex> lock( group.Mutex );
+			group.Condition.wait( lock, [ &group ] () { return ( 0 == group.Pending ) || HasFolders( group ); } );
+			if ( 0 == group.Pending ) {
+				break;
+			}
+		}
+	}
+}
+
+bool FolderScanner::TakeFolder( Group& group, const size_t index, std::filesystem::path& folder )
+{
+	{
+		Worker& worker = *group.Workers[ index ];
+		std::lock_guard<std::mutex> lock( worker.Mutex );
+		if ( !worker.Folders.empty() ) {
+			folder = std::move( worker.Folders.back() );
+			worker.Folders.pop_back();
+			return true;
+		}
+	}
+	const size_t workerCount = group.Workers.size();
+	for ( size_t offset = 1; offset < workerCount; offset++ ) {
+		Worker& victim = *group.Workers[ ( index + offset ) % workerCount ];
+		std::lock_guard<std::mutex> lock( victim.Mutex );
+		if ( !victim.Folders.empty() ) {
+			folder = std::move( victim.Folders.front() );
+			victim.Folders.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FolderScanner::HasFolders( Group& group )
+{
+	for ( auto& worker : group.Workers ) {
+		std::lock_guard<std::mutex> lock( worker->Mutex );
+		if ( !worker->Folders.empty() ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void FolderScanner::Notify( Group& group )
+{
+	// Acquire the idle thread mutex, so that the notification cannot be missed by a thread which is about to wait.
+	{
+		std::lock_guard<std::mutex> lock( group.Mutex );
+	}
+	group.Condition.notify_all();
+}
+
+void FolderScanner::EnumerateFolder( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<File>& files )
+{
+	std::error_code ec;
+	for ( std::filesystem::directory_iterator entry( folder, std::filesystem::directory_options::skip_permission_denied, ec ), end; !ec && ( end != entry ); entry.increment( ec ) ) {
+		std::error_code entryError;
+		if ( entry->is_symlink( entryError ) ) {
+			continue;
+		}
+		if ( entry->is_directory( entryError ) ) {
+			folders.push_back( entry->path() );
+		} else if ( entry->is_regular_file( entryError ) ) {
+			// Directory entries cache the last write time & size, where the platform provides them with the enumeration (as it does on Windows).
+			File& file = files.emplace_back();
+			file.Path = entry->path();
+			if ( const auto filetime = entry->last_write_time( entryError ); !entryError ) {
+				file.Filetime = static_cast<long long>( filetime.time_since_epoch().count() );
+			}
+			if ( const auto filesize = entry->file_size( entryError ); !entryError ) {
+				file.Filesize = static_cast<long long>( filesize );
+			}
+		}
+	}
+}
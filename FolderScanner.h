@@ -0,0 +1,92 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Parallel folder scanner.
+// Each volume is scanned by its own group of threads, which bounds the concurrency per volume, and each thread has its own deque of folders to scan.
+// A thread takes the most recently added folder from its own deque and, when that is empty, steals the least recently added folder from another thread in the group.
+// Files are passed on as soon as each folder has been enumerated, so that they can be processed while the scan continues.
+class FolderScanner
+{
+public:
+	// A file found by the scan.
+	struct File {
+		std::filesystem::path Path;             // File path.
+		long long Filetime = 0;                 // Last modified time (as a FILETIME value, on Windows).
+		long long Filesize = 0;                 // File size, in bytes.
+	};
+
+	// A volume to scan.
+	struct Volume {
+		std::filesystem::path Root;             // Root folder.
+		size_t Threads = 1;                     // Number of threads with which to scan the volume.
+	};
+
+	// Enumerates a 'folder', adding any subfolders to scan to 'folders', and any files to pass on to 'files'.
+	using Enumerator = std::function<void( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<File>& files )>;
+
+	// Returns whether the scan should stop.
+	using StopPredicate = std::function<bool()>;
+
+	// Called for each 'file' found by the scan (from the scanning threads, so this can be called concurrently).
+	using FileCallback = std::function<void( File&& file )>;
+
+	// 'enumerator' - folder enumerator.
+	// 'stopPredicate' - checked before enumerating each folder (once the scan is stopped, the remaining folders are discarded).
+	FolderScanner( Enumerator enumerator, StopPredicate stopPredicate );
+
+	virtual ~FolderScanner();
+
+	// Scans the 'volumes', calling the 'fileCallback' for each file found.
+	// Returns the number of folders enumerated, once the scan has finished (or has been stopped).
+	size_t Scan( const std::vector<Volume>& volumes, FileCallback fileCallback );
+
+	// Portable folder enumerator, which passes on all regular files, and follows all subfolders (apart from symbolic links).
+	static void EnumerateFolder( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<File>& files );
+
+private:
+	// Scanning thread state.
+	struct Worker {
+		std::mutex Mutex;                               // Deque mutex.
+		std::deque<std::filesystem::path> Folders;      // Folders waiting to be scanned.
+	};
+
+	// Group of scanning threads for a volume.
+	struct Group {
+		std::vector<std::unique_ptr<Worker>> Workers;   // Scanning thread state.
+		std::atomic<size_t> Pending = 0;                // Number of folders which are waiting to be, or are being, scanned.
+		std::mutex Mutex;                               // Idle thread mutex.
+		std::condition_variable Condition;              // Signalled when folders are added, or the scan of the volume has finished.
+	};
+
+	// Scanning thread handler, for the worker with the 'index' in the 'group'.
+	void Handler( Group& group, const size_t index, const FileCallback& fileCallback );
+
+	// Takes the next 'folder' to scan for the worker with the 'index' in the 'group', stealing from the other workers in the group if necessary.
+	// Returns false if there are no folders waiting to be scanned.
+	static bool TakeFolder( Group& group, const size_t index, std::filesystem::path& folder );
+
+	// Returns whether any workers in the 'group' have folders waiting to be scanned.
+	static bool HasFolders( Group& group );
+
+	// Wakes any idle threads in the 'group'.
+	static void Notify( Group& group );
+
+	// Folder enumerator.
+	const Enumerator m_Enumerator;
+
+	// Stop predicate.
+	const StopPredicate m_StopPredicate;
+
+	// Number of folders enumerated by the current scan.
+	std::atomic<size_t> m_FoldersScanned;
+};
@@ -0,0 +1,192 @@
+#include "FormatSniffer.h"
+
+#include "stdafx.h"
+
+#include <array>
+#include <cstring>
+#include <string_view>
+
+// ID3v2 tag header & footer size.
+constexpr uint32_t kID3v2HeaderSize = 10;
+
+// ID3v2 footer present flag.
+constexpr uint8_t kID3v2FooterFlag = 0x10;
+
+// Ogg page header size, excluding the segment table.
+constexpr size_t kOggPageHeaderSize = 27;
+
+// Offset of the signature in a ProTracker module.
+constexpr size_t kMODSignatureOffset = 1080;
+
+// Offset of the signature in a Scream Tracker 3 module.
+constexpr size_t kS3MSignatureOffset = 44;
+
+// Returns whether the 'header' contains the 'signature' at the 'offset'.
+static bool Matches( const std::span<const uint8_t> header, const size_t offset, const std::string_view signature )
+{
+	return ( ( offset + signature.size() ) <= header.size() ) && ( 0 == std::memcmp( header.data() + offset, signature.data(), signature.size() ) );
+}
+
+// Returns whether the 'header' starts with a valid MPEG audio frame header.
+// 'isADTS' - out, whether the frame is an AAC ADTS frame header (rather than an MPEG layer I, II or III frame header).
+static bool IsMPEGFrame( const std::span<const uint8_t> header, bool& isADTS )
+{
+	if ( ( header.size() < 4 ) || ( 0xff != header[ 0 ] ) || ( 0xe0 != ( header[ 1 ] & 0xe0 ) ) ) {
+		return false;
+	}
+	const uint8_t version = ( header[ 1 ] >> 3 ) & 0x3;
+	const uint8_t layer = ( header[ 1 ] >> 1 ) & 0x3;
+	if ( 0 == layer ) {
+		// ADTS uses a 12 bit sync word, with a zero layer.
+		isADTS = ( 0xf0 == ( header[ 1 ] & 0xf0 ) ) && ( ( ( header[ 2 ] >> 2 ) & 0xf ) < 13 );
+		return isADTS;
+	}
+	isADTS = false;
+	const uint8_t bitrateIndex = header[ 2 ] >> 4;
+	const uint8_t sampleRateIndex = ( header[ 2 ] >> 2 ) & 0x3;
+	return ( 1 != version ) && ( 0xf != bitrateIndex ) && ( 0x3 != sampleRateIndex );
+}
+
+// Returns the canonical file extension for the first logical stream in an Ogg 'header', or an empty string if the codec was not recognised.
+static std::wstring SniffOgg( const std::span<const uint8_t> header )
+{
+	if ( header.size() > kOggPageHeaderSize ) {
+		const size_t packetOffset = kOggPageHeaderSize + header[ kOggPageHeaderSize - 1 ];
+		if ( Matches( header, packetOffset, "OpusHead" ) ) {
+			return L"opus";
+		}
+		if ( Matches( header, packetOffset, "\x01vorbis" ) ) {
+			return L"ogg";
+		}
+		if ( Matches( header, packetOffset, "\x7f" "FLAC" ) ) {
+			return L"oga";
+		}
+	}
+	return {};
+}
+
+uint32_t FormatSniffer::GetID3v2Size( const std::span<const uint8_t> header )
+{
+	uint32_t tagSize = 0;
+	if ( Matches( header, 0, "ID3" ) && ( header.size() >= kID3v2HeaderSize ) ) {
+		// The tag size is stored as a 28 bit 'syncsafe' integer, excluding the header & footer.
+		const bool syncsafe = ( 0 == ( ( header[ 6 ] | header[ 7 ] | header[ 8 ] | header[ 9 ] ) & 0x80 ) );
+		if ( syncsafe ) {
+			tagSize = kID3v2HeaderSize + ( header[ 6 ] << 21 ) + ( header[ 7 ] << 14 ) + ( header[ 8 ] << 7 ) + header[ 9 ];
+			if ( header[ 5 ] & kID3v2FooterFlag ) {
+				tagSize += kID3v2HeaderSize;
+			}
+		}
+	}
+	return tagSize;
+}
+
+std::wstring FormatSniffer::Sniff( const std::span<const uint8_t> header )
+{
+	if ( Matches( header, 0, "fLaC" ) ) {
+		return L"flac";
+	}
+	if ( Matches( header, 0, "OggS" ) ) {
+		return SniffOgg( header );
+	}
+	if ( Matches( header, 0, "wvpk" ) ) {
+		return L"wv";
+	}
+	if ( Matches( header, 0, "RIFF" ) || Matches( header, 0, "RF64" ) ) {
+		if ( Matches( header, 8, "WAVE" ) ) {
+			return L"wav";
+		}
+		if ( Matches( header, 8, "RMID" ) ) {
+			return L"mid";
+		}
+		if ( Matches( header, 8, "AVI " ) ) {
+			return L"avi";
+		}
+		return {};
+	}
+	if ( Matches( header, 0, "FORM" ) && ( Matches( header, 8, "AIFF" ) || Matches( header, 8, "AIFC" ) ) ) {
+		return L"aiff";
+	}
+	if ( Matches( header, 4, "ftyp" ) ) {
+		return L"m4a";
+	}
+	if ( Matches( header, 0, "MThd" ) ) {
+		return L"mid";
+	}
+	if ( Matches( header, 0, "DSD " ) ) {
+		return L"dsf";
+	}
+	if ( Matches( header, 0, "FRM8" ) && Matches( header, 12, "DSD " ) ) {
+		return L"dsd";
+	}
+	if ( Matches( header, 0, "MAC " ) ) {
+		return L"ape";
+	}
+	if ( Matches( header, 0, "TTA1" ) ) {
+		return L"tta";
+	}
+	if ( Matches( header, 0, "MPCK" ) || Matches( header, 0, "MP+" ) ) {
+		return L"mpc";
+	}
+	if ( Matches( header, 0, "ajkg" ) ) {
+		return L"shn";
+	}
+	if ( Matches( header, 0, "\x1a\x45\xdf\xa3" ) ) {
+		return L"mkv";
+	}
+	if ( Matches( header, 0, "\x30\x26\xb2\x75\x8e\x66\xcf\x11" ) ) {
+		return L"asf";
+	}
+	if ( Matches( header, 0, "Extended Module: " ) ) {
+		return L"xm";
+	}
+	if ( Matches( header, 0, "IMPM" ) ) {
+		return L"it";
+	}
+	if ( Matches( header, 0, "MO3" ) ) {
+		return L"mo3";
+	}
+	if ( Matches( header, 0, "MTM\x10" ) ) {
+		return L"mtm";
+	}
+	if ( Matches( header, kS3MSignatureOffset, "SCRM" ) ) {
+		return L"s3m";
+	}
+	for ( const auto& signature : { "M.K.", "M!K!", "FLT4", "FLT8", "4CHN", "6CHN", "8CHN" } ) {
+		if ( Matches( header, kMODSignatureOffset, signature ) ) {
+			return L"mod";
+		}
+	}
+	if ( bool isADTS = false; IsMPEGFrame( header, isADTS ) ) {
+		return isADTS ? L"aac" : L"mp3";
+	}
+	return {};
+}
+
+std::wstring FormatSniffer::Sniff( const std::wstring& filename )
+{
+	std::wstring format;
+	const DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+	const HANDLE handle = CreateFile( filename.c_str(), GENERIC_READ, shareMode, NULL /*security*/, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL /*template*/ );
+	if ( INVALID_HANDLE_VALUE != handle ) {
+		std::array<uint8_t, kHeaderSize> buffer = {};
+		DWORD bytesRead = 0;
+		if ( ReadFile( handle, buffer.data(), kHeaderSize, &bytesRead, NULL /*overlapped*/ ) ) {
+			std::span<const uint8_t> header( buffer.data(), bytesRead );
+			if ( const uint32_t tagSize = GetID3v2Size( header ); tagSize > 0 ) {
+				// Identify the format from the data following the tag (typically MP3, but sometimes FLAC).
+				LARGE_INTEGER position = {};
+				position.QuadPart = tagSize;
+				bytesRead = 0;
+				if ( SetFilePointerEx( handle, position, NULL /*newPosition*/, FILE_BEGIN ) && ReadFile( handle, buffer.data(), kHeaderSize, &bytesRead, NULL /*overlapped*/ ) ) {
+					header = std::span<const uint8_t>( buffer.data(), bytesRead );
+				} else {
+					header = {};
+				}
+			}
+			format = Sniff( header );
+		}
+		CloseHandle( handle );
+	}
+	return format;
+}
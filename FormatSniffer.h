@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Identifies audio file formats from their content (magic bytes), independently of the file extension.
+// The start of the file is read once, and all format signatures are matched against the same buffer.
+class FormatSniffer
+{
+public:
+	// Number of bytes read from the start of a file (or following an ID3v2 tag) to identify the format.
+	static constexpr uint32_t kHeaderSize = 0x1000;
+
+	// Returns the canonical file extension (as a lowercase string) of the format of 'filename',
+	// or an empty string if the file could not be read or the format was not recognised.
+	static std::wstring Sniff( const std::wstring& filename );
+
+	// Returns the canonical file extension (as a lowercase string) of the format of the file 'header',
+	// or an empty string if the format was not recognised.
+	static std::wstring Sniff( const std::span<const uint8_t> header );
+
+	// Returns the total size of the ID3v2 tag at the start of the file 'header', or zero if there is no tag.
+	static uint32_t GetID3v2Size( const std::span<const uint8_t> header );
+};
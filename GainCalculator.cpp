@@ -1,5 +1,6 @@
 #include "GainCalculator.h"
 
+#include "Metrics.h"
 #include "Utility.h"
 
 #include "ebur128.h"
@@ -146,6 +147,7 @@ void GainCalculator::Handler()
 						while ( 0 != item.ID ) {
 							Decoder::Ptr decoder = OpenDecoder( item );
 							if ( decoder ) {
+								const Metrics::Timer timer( Metrics::Histogram::GainCalculation );
 								const unsigned int channels = static_cast<unsigned int>( decoder->GetChannels() );
 								const unsigned long samplerate = static_cast<unsigned long>( decoder->GetSampleRate() );
 								ebur128_state* r128State = ebur128_init( channels, samplerate, EBUR128_MODE_I );
@@ -274,6 +276,7 @@ std::optional<float> GainCalculator::CalculateTrackGain( const Playlist::Item& i
 	if ( ( nullptr != canContinue ) && !IsURL( item.Info.GetFilename() ) ) {
 		const Decoder::Ptr decoder = handlers.OpenDecoder( item.Info, Decoder::Context::Temporary );
 		if ( decoder ) {
+			const Metrics::Timer timer( Metrics::Histogram::GainCalculation );
 			gain = decoder->CalculateTrackGain( canContinue );
 		}
 	}
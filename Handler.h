@@ -3,11 +3,13 @@
 
 #include "Decoder.h"
 #include "Encoder.h"
+#include "StreamProbe.h"
 #include "Tag.h"
 
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -46,6 +48,12 @@ public:
 	// Returns a decoder for 'filename' in the specified 'context', or nullptr if a decoder cannot be created.
 	virtual Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const = 0;
 
+	// Returns the stream properties of 'filename' by parsing container headers only, or nullopt if a decoder is needed to determine them.
+	virtual std::optional<StreamProbe::Info> Probe( const std::wstring& /*filename*/ ) const
+	{
+		return std::nullopt;
+	}
+
 	// Returns an encoder, or nullptr if an encoder cannot be created.
 	virtual Encoder::Ptr OpenEncoder() const = 0;
 
@@ -182,6 +182,12 @@ Decoder::Ptr HandlerBass::OpenDecoder( const std::wstring& filename, const Decod
 	return stream;
 }
 
+std::optional<StreamProbe::Info> HandlerBass::Probe( const std::wstring& filename ) const
+{
+	// Only uncompressed WAV files can be probed, other formats require the BASS decoder.
+	return ( L"wav" == GetFileExtension( filename ) ) ? StreamProbe::ProbeRIFF( filename ) : std::nullopt;
+}
+
 Encoder::Ptr HandlerBass::OpenEncoder() const
 {
 	return nullptr;
@@ -29,6 +29,9 @@ public:
 	// Returns a decoder for 'filename' in the specified 'context', or nullptr if a decoder cannot be created.
 	Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const override;
 
+	// Returns the stream properties of 'filename' by parsing container headers only, or nullopt if a decoder is needed to determine them.
+	std::optional<StreamProbe::Info> Probe( const std::wstring& filename ) const override;
+
 	// Returns an encoder, or nullptr if an encoder cannot be created.
 	Encoder::Ptr OpenEncoder() const override;
 
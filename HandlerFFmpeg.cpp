@@ -48,6 +48,14 @@ Decoder::Ptr HandlerFFmpeg::OpenDecoder( const std::wstring& filename, const Dec
 	return stream;
 }
 
+std::optional<StreamProbe::Info> HandlerFFmpeg::Probe( const std::wstring& filename ) const
+{
+	// Only MP4 files can be probed, other formats require the FFmpeg decoder.
+	const std::wstring extension = GetFileExtension( filename );
+	const bool isMP4 = ( L"m4a" == extension ) || ( L"m4b" == extension ) || ( L"mp4" == extension ) || ( L"mov" == extension );
+	return isMP4 ? StreamProbe::ProbeMP4( filename ) : std::nullopt;
+}
+
 Encoder::Ptr HandlerFFmpeg::OpenEncoder() const
 {
 	return nullptr;
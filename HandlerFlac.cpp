@@ -350,6 +350,11 @@ Decoder::Ptr HandlerFlac::OpenDecoder( const std::wstring& filename, const Decod
 	return stream;
 }
 
+std::optional<StreamProbe::Info> HandlerFlac::Probe( const std::wstring& filename ) const
+{
+	return StreamProbe::ProbeFLAC( filename );
+}
+
 Encoder::Ptr HandlerFlac::OpenEncoder() const
 {
 	Encoder::Ptr encoder( new EncoderFlac() );
@@ -179,6 +179,11 @@ Decoder::Ptr HandlerOpus::OpenDecoder( const std::wstring& filename, const Decod
 	return stream;
 }
 
+std::optional<StreamProbe::Info> HandlerOpus::Probe( const std::wstring& filename ) const
+{
+	return StreamProbe::ProbeOpus( filename );
+}
+
 Encoder::Ptr HandlerOpus::OpenEncoder() const
 {
 	Encoder::Ptr encoder( new EncoderOpus() );
@@ -189,6 +189,11 @@ Decoder::Ptr HandlerWavpack::OpenDecoder( const std::wstring& filename, const De
 	return stream;
 }
 
+std::optional<StreamProbe::Info> HandlerWavpack::Probe( const std::wstring& filename ) const
+{
+	return StreamProbe::ProbeWavPack( filename );
+}
+
 Encoder::Ptr HandlerWavpack::OpenEncoder() const
 {
 	return nullptr;
@@ -12,13 +12,20 @@
 #include "HandlerOpenMPT.h"
 
 #include "DecoderBin.h"
+#include "FormatSniffer.h"
 
 #include "Library.h"
+#include "Metrics.h"
 #include "Settings.h"
 #include "ShellMetadata.h"
 #include "Utility.h"
 #include "TagReader.h"
 
+#include <filesystem>
+
+// Maximum number of entries in the format cache.
+constexpr size_t kMaxFormatCacheSize = 0x1000;
+
 Handlers::Handlers() :
 	m_HandlerBASS( new HandlerBass() ),
 	m_HandlerFFmpeg( new HandlerFFmpeg() ),
@@ -58,10 +65,9 @@ Handlers::~Handlers()
 {
 }
 
-Handler::Ptr Handlers::FindDecoderHandler( const std::wstring& filename ) const
+Handler::Ptr Handlers::FindDecoderHandlerForExtension( const std::wstring& extension ) const
 {
 	Handler::Ptr handler;
-	const std::wstring extension = GetFileExtension( filename );
 	std::lock_guard<std::mutex> lock( m_MutexDecoders );
 	for ( auto decoder = m_Decoders.begin(); !handler && ( decoder != m_Decoders.end() ); decoder++ ) {
 		std::set<std::wstring> extensions = decoder->get()->GetSupportedFileExtensions();
@@ -74,6 +80,57 @@ Handler::Ptr Handlers::FindDecoderHandler( const std::wstring& filename ) const
 	return handler;
 }
 
+Handler::Ptr Handlers::SelectDecoderHandler( const std::wstring& filename, const bool useCache, bool& cached ) const
+{
+	cached = false;
+	const std::wstring extension = GetFileExtension( filename );
+	const auto key = std::make_pair( std::filesystem::path( filename ).parent_path().native(), extension );
+	std::wstring format;
+	if ( useCache ) {
+		std::lock_guard<std::mutex> lock( m_MutexFormatCache );
+		if ( const auto entry = m_FormatCache.find( key ); m_FormatCache.end() != entry ) {
+			format = entry->second;
+			cached = true;
+		}
+	}
+
+	if ( cached ) {
+		Metrics::Increment( Metrics::Counter::SniffCacheHits );
+	} else {
+		format = FormatSniffer::Sniff( filename );
+		if ( format.empty() ) {
+			Metrics::Increment( Metrics::Counter::SniffMisses );
+			format = extension;
+		} else {
+			Metrics::Increment( Metrics::Counter::SniffHits );
+		}
+		std::lock_guard<std::mutex> lock( m_MutexFormatCache );
+		if ( m_FormatCache.size() >= kMaxFormatCacheSize ) {
+			m_FormatCache.clear();
+		}
+		m_FormatCache.insert_or_assign( key, format );
+	}
+
+	Handler::Ptr handler = FindDecoderHandlerForExtension( format );
+	if ( !handler && ( format != extension ) ) {
+		// None of the handlers explicitly support the identified format, so use the catch all.
+		handler = m_HandlerFFmpeg;
+	}
+	return handler;
+}
+
+Handler::Ptr Handlers::ResniffDecoderHandler( const std::wstring& filename, const Handler::Ptr& handler, const bool cached ) const
+{
+	if ( cached ) {
+		// The format of other files in the same folder does not apply to this one, so identify the format from the file content.
+		bool resniffCached = false;
+		if ( Handler::Ptr sniffedHandler = SelectDecoderHandler( filename, false /*useCache*/, resniffCached ); sniffedHandler != handler ) {
+			return sniffedHandler;
+		}
+	}
+	return nullptr;
+}
+
 Decoder::Ptr Handlers::OpenDecoder( const MediaInfo& mediaInfo, const Decoder::Context context, const bool applyCues ) const
 {
 	Decoder::Ptr decoder;
@@ -87,13 +144,21 @@ Decoder::Ptr Handlers::OpenDecoder( const MediaInfo& mediaInfo, const Decoder::C
 				decoder = std::make_shared<DecoderBin>( filename, context );
 			} catch ( const std::runtime_error& ) {}
 		} else {
-			Handler::Ptr handler = FindDecoderHandler( filename );
+			bool cached = false;
+			Handler::Ptr handler = SelectDecoderHandler( filename, true /*useCache*/, cached );
 			if ( handler ) {
 				decoder = handler->OpenDecoder( filename, context );
 			}
-			if ( !decoder && m_HandlerFFmpeg && ( handler != m_HandlerFFmpeg ) ) {
-				// Try the FFmpeg handler as a catch all.
-				decoder = m_HandlerFFmpeg->OpenDecoder( filename, context );
+			if ( !decoder ) {
+				Metrics::Increment( Metrics::Counter::SniffFallbacks );
+				if ( const Handler::Ptr sniffedHandler = ResniffDecoderHandler( filename, handler, cached ); sniffedHandler ) {
+					handler = sniffedHandler;
+					decoder = handler->OpenDecoder( filename, context );
+				}
+				if ( !decoder && m_HandlerFFmpeg && ( handler != m_HandlerFFmpeg ) ) {
+					// Try the FFmpeg handler as a catch all.
+					decoder = m_HandlerFFmpeg->OpenDecoder( filename, context );
+				}
 			}
 		}
 		if ( decoder && applyCues ) {
@@ -103,15 +168,39 @@ Decoder::Ptr Handlers::OpenDecoder( const MediaInfo& mediaInfo, const Decoder::C
 	return decoder;
 }
 
+std::optional<StreamProbe::Info> Handlers::Probe( const MediaInfo& mediaInfo ) const
+{
+	const auto& filename = mediaInfo.GetFilename();
+	if ( filename.empty() || IsURL( filename ) || ( mediaInfo.GetCueStart() && ( L"bin" == GetFileExtension( filename ) ) ) ) {
+		return std::nullopt;
+	}
+	bool cached = false;
+	const Handler::Ptr handler = SelectDecoderHandler( filename, true /*useCache*/, cached );
+	std::optional<StreamProbe::Info> info = handler ? handler->Probe( filename ) : std::nullopt;
+	if ( !info ) {
+		if ( const Handler::Ptr sniffedHandler = ResniffDecoderHandler( filename, handler, cached ); sniffedHandler ) {
+			info = sniffedHandler->Probe( filename );
+		}
+	}
+	return info;
+}
+
 bool Handlers::GetTags( const std::wstring& filename, Tags& tags ) const
 {
 	bool success = false;
 	if ( !IsURL( filename ) ) {
 		tags.clear();
-		Handler::Ptr handler = FindDecoderHandler( filename );
+		bool cached = false;
+		Handler::Ptr handler = SelectDecoderHandler( filename, true /*useCache*/, cached );
 		if ( handler ) {
 			success = handler->GetTags( filename, tags );
 		}
+		if ( !success ) {
+			if ( const Handler::Ptr sniffedHandler = ResniffDecoderHandler( filename, handler, cached ); sniffedHandler ) {
+				tags.clear();
+				success = sniffedHandler->GetTags( filename, tags );
+			}
+		}
 		if ( !success ) {
 			TagReader tagReader( filename );
 			if ( const auto fileTags = tagReader.GetTags(); fileTags.has_value() ) {
@@ -159,8 +248,15 @@ bool Handlers::SetTags( const MediaInfo& mediaInfo, Library& library ) const
 
 		if ( !tagsToWrite.empty() ) {
 			const FILETIME lastModified = m_PreserveLastModifiedTime ? GetLastModifiedTime( filename ) : FILETIME();
-			Handler::Ptr handler = FindDecoderHandler( filename );
+			bool cached = false;
+			Handler::Ptr handler = SelectDecoderHandler( filename, true /*useCache*/, cached );
 			success = handler ? handler->SetTags( filename, tagsToWrite ) : false;
+			if ( !success ) {
+				if ( const Handler::Ptr sniffedHandler = ResniffDecoderHandler( filename, handler, cached ); sniffedHandler ) {
+					handler = sniffedHandler;
+					success = handler->SetTags( filename, tagsToWrite );
+				}
+			}
 			if ( !success && m_HandlerFFmpeg && ( handler != m_HandlerFFmpeg ) ) {
 				// Try the FFmpeg handler as a catch all.
 				m_HandlerFFmpeg->SetTags( filename, tagsToWrite );
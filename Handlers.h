@@ -3,6 +3,7 @@
 #include "Handler.h"
 
 #include <list>
+#include <map>
 #include <mutex>
 
 class Library;
@@ -23,6 +24,10 @@ public:
 	// Returns the decoder, or nullptr if the stream could not be opened.
 	Decoder::Ptr OpenDecoder( const MediaInfo& mediaInfo, const Decoder::Context context, const bool applyCues = true ) const;
 
+	// Returns the stream properties of the 'mediaInfo' file by parsing container headers only.
+	// Returns nullopt if the file could not be probed, in which case a decoder should be opened instead.
+	std::optional<StreamProbe::Info> Probe( const MediaInfo& mediaInfo ) const;
+
 	// Reads 'tags' from 'filename', returning true if the tags were read.
 	bool GetTags( const std::wstring& filename, Tags& tags ) const;
 
@@ -55,8 +60,22 @@ public:
 	void Init( Settings& settings );
 
 private:
-	// Returns a decoder handler supported by the 'filename' extension, or nullptr of there was no match.
-	Handler::Ptr FindDecoderHandler( const std::wstring& filename ) const;
+	// Maps a folder & file extension pair to the format (as a canonical file extension) of the files found in that folder.
+	using FormatCache = std::map<std::pair<std::wstring, std::wstring>, std::wstring>;
+
+	// Returns a decoder handler supported by the file 'extension', or nullptr of there was no match.
+	Handler::Ptr FindDecoderHandlerForExtension( const std::wstring& extension ) const;
+
+	// Returns the decoder handler for the format of 'filename', as identified from the file content.
+	// 'useCache' - whether to use the format previously identified for files with the same extension in the same folder, rather than reading the file content.
+	// 'cached' - out, whether the format was taken from the cache.
+	// Returns the handler, or nullptr if there was no match.
+	Handler::Ptr SelectDecoderHandler( const std::wstring& filename, const bool useCache, bool& cached ) const;
+
+	// Called when the 'handler' selected for 'filename' has failed, to identify the format from the file content if the handler was selected using the format cache.
+	// 'cached' - whether the handler was selected using the format cache.
+	// Returns the decoder handler for the identified format, or nullptr if the format was not taken from the cache, or the identified handler is the same as 'handler'.
+	Handler::Ptr ResniffDecoderHandler( const std::wstring& filename, const Handler::Ptr& handler, const bool cached ) const;
 
 	// BASS handler.
 	Handler::Ptr m_HandlerBASS;
@@ -84,4 +103,10 @@ private:
 
 	// Decoders mutex (used when swapping decoder order).
 	mutable std::mutex m_MutexDecoders;
+
+	// Formats identified from file content, per folder & file extension.
+	mutable FormatCache m_FormatCache;
+
+	// Format cache mutex.
+	mutable std::mutex m_MutexFormatCache;
 };
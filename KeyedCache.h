@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Bounded in-memory cache of per-file values, which can optionally be loaded from and saved to a store (such as the media library).
+// Each value applies to a particular file modification time & size, so that a value is discarded once its file changes.
+// 'Key' - cache key type.
+// 'Track' - identifies the file (with 'Filetime' & 'Filesize' members), and is passed to the store.
+// 'Value' - cached value type.
+template <typename Key, typename Track, typename Value>
+class KeyedCache
+{
+public:
+	// Loads the 'value' for a 'track', returning whether a value was loaded.
+	using LoadCallback = std::function<bool( const Track& /*track*/, Value& /*value*/ )>;
+
+	// Saves the 'value' for a 'track'.
+	using SaveCallback = std::function<void( const Track& /*track*/, const Value& /*value*/ )>;
+
+	// 'capacity' - maximum number of values to keep in memory.
+	// 'load' - initial load callback (can be nullptr).
+	// 'save' - initial save callback (can be nullptr).
+	KeyedCache( const size_t capacity, LoadCallback load = nullptr, SaveCallback save = nullptr ) :
+		m_Capacity( capacity ),
+		m_Load( load ),
+		m_Save( save )
+	{
+	}
+
+	KeyedCache( const KeyedCache& ) = delete;
+	KeyedCache& operator=( const KeyedCache& ) = delete;
+
+	// Returns the value for the 'key' & 'track', loading it from the store if it is not cached, or nullopt if there is no value.
+	std::optional<Value> Get( const Key& key, const Track& track )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_CacheMutex );
+			if ( const auto entry = m_Cache.find( key ); m_Cache.end() != entry ) {
+				if ( ( entry->second.TrackInfo.Filetime == track.Filetime ) && ( entry->second.TrackInfo.Filesize == track.Filesize ) ) {
+					return entry->second.TrackValue;
+				}
+				// The file has changed, so discard the stale value.
+				m_Cache.erase( entry );
+			}
+		}
+
+		// The store is queried without holding the cache mutex.
+		std::optional<Value> value;
+		if ( Value stored; Load( track, stored ) ) {
+			value = std::move( stored );
+		}
+		std::optional<Entry> evicted;
+		{
+			std::lock_guard<std::mutex> lock( m_CacheMutex );
+			if ( const auto entry = m_Cache.find( key ); m_Cache.end() != entry ) {
+				// Another thread has added the value in the meantime.
+				value = entry->second.TrackValue;
+			} else {
+				evicted = AddEntry( key, { track, value, false /*modified*/ } );
+			}
+		}
+		if ( evicted ) {
+			Save( *evicted );
+		}
+		return value;
+	}
+
+	// Sets the 'value' for the 'key' & 'track'.
+	void Set( const Key& key, const Track& track, const Value& value )
+	{
+		std::optional<Entry> evicted;
+		{
+			std::lock_guard<std::mutex> lock( m_CacheMutex );
+			if ( const auto entry = m_Cache.find( key ); m_Cache.end() != entry ) {
+				entry->second = { track, value, true /*modified*/ };
+			} else {
+				evicted = AddEntry( key, { track, value, true /*modified*/ } );
+			}
+		}
+		if ( evicted ) {
+			Save( *evicted );
+		}
+	}
+
+	// Marks the value for the 'key' as needing saving, for values which are shared objects that have been modified in place.
+	void SetModified( const Key& key )
+	{
+		std::lock_guard<std::mutex> lock( m_CacheMutex );
+		if ( const auto entry = m_Cache.find( key ); m_Cache.end() != entry ) {
+			entry->second.Modified = true;
+		}
+	}
+
+	// Sets the callbacks used to 'load' and 'save' values (either can be nullptr).
+	void SetStore( LoadCallback load, SaveCallback save )
+	{
+		std::lock_guard<std::mutex> lock( m_StoreMutex );
+		m_Load = load;
+		m_Save = save;
+	}
+
+	// Saves all modified values to the store.
+	void SaveAll()
+	{
+		std::vector<Entry> entries;
+		{
+			std::lock_guard<std::mutex> lock( m_CacheMutex );
+			for ( auto& [key, entry] : m_Cache ) {
+				if ( entry.Modified ) {
+					entries.push_back( entry );
+					entry.Modified = false;
+				}
+			}
+		}
+		for ( const auto& entry : entries ) {
+			Save( entry );
+		}
+	}
+
+private:
+	// Cached value for a track.
+	struct Entry {
+		Track TrackInfo;                    // Track information.
+		std::optional<Value> TrackValue;    // Cached value, or nullopt if there is none.
+		bool Modified = false;              // Whether the value has been modified since it was loaded or saved.
+	};
+
+	// Adds an 'entry' to the cache, evicting another entry if necessary (the cache mutex must be held by the caller).
+	// Returns the evicted entry, if it needs saving.
+	std::optional<Entry> AddEntry( const Key& key, Entry&& entry )
+	{
+		std::optional<Entry> evicted;
+		if ( m_Cache.size() >= m_Capacity ) {
+			// Evict an entry which does not need saving, or failing that an arbitrary one.
+			auto evictedEntry = std::find_if( m_Cache.begin(), m_Cache.end(), [] ( const auto& cached ) { return !cached.second.Modified; } );
+			if ( m_Cache.end() == evictedEntry ) {
+				evictedEntry = m_Cache.begin();
+				evicted = std::move( evictedEntry->second );
+			}
+			m_Cache.erase( evictedEntry );
+		}
+		m_Cache.insert( { key, std::move( entry ) } );
+		return evicted;
+	}
+
+	// Loads the 'value' for a 'track' from the store, returning whether a value was loaded.
+	bool Load( const Track& track, Value& value )
+	{
+		LoadCallback load;
+		{
+			std::lock_guard<std::mutex> lock( m_StoreMutex );
+			load = m_Load;
+		}
+		return load && load( track, value );
+	}
+
+	// Saves an 'entry' to the store.
+	void Save( const Entry& entry )
+	{
+		if ( entry.TrackValue ) {
+			SaveCallback save;
+			{
+				std::lock_guard<std::mutex> lock( m_StoreMutex );
+				save = m_Save;
+			}
+			if ( save ) {
+				save( entry.TrackInfo, *entry.TrackValue );
+			}
+		}
+	}
+
+	// Maximum number of values to keep in memory.
+	const size_t m_Capacity;
+
+	// Value cache.
+	std::map<Key, Entry> m_Cache;
+
+	// Value cache mutex.
+	std::mutex m_CacheMutex;
+
+	// Load callback.
+	LoadCallback m_Load;
+
+	// Save callback.
+	SaveCallback m_Save;
+
+	// Load & save callback mutex.
+	std::mutex m_StoreMutex;
+};
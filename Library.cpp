@@ -7,6 +7,13 @@
 #include <list>
 #include <sstream>
 
+// Returns the text value of the 'columnIndex' in the 'stmt', which SQLite decodes directly to UTF-16.
+static std::wstring GetColumnText( sqlite3_stmt* stmt, const int columnIndex )
+{
+	const wchar_t* text = static_cast<const wchar_t*>( sqlite3_column_text16( stmt, columnIndex ) );
+	return ( nullptr != text ) ? std::wstring( text, sqlite3_column_bytes16( stmt, columnIndex ) / sizeof( wchar_t ) ) : std::wstring();
+}
+
 Library::Library( Database& database, const Handlers& handlers ) :
 	m_Database( database ),
 	m_Handlers( handlers ),
@@ -14,6 +21,8 @@ Library::Library( Database& database, const Handlers& handlers ) :
 	m_LastTagWriteTime( 0 ),
 	m_TagsWritten(),
 	m_TagsWrittenMutex(),
+	m_ColumnBindings(),
+	m_ColumnBindingsMutex(),
 	m_MediaColumns( {
 		Columns::value_type( "Filename", Column::Filename ),
 		Columns::value_type( "Filetime", Column::Filetime ),
@@ -57,7 +66,8 @@ Library::Library( Database& database, const Handlers& handlers ) :
 		Columns::value_type( "Conductor", Column::Conductor ),
 		Columns::value_type( "Publisher", Column::Publisher ),
 		Columns::value_type( "PlayCount", Column::PlayCount )
-		} )
+		} ),
+	m_Writer( database )
 {
 	m_CueColumns = m_MediaColumns;
 	m_CueColumns.insert( { "CueStart", Column::CueStart } );
@@ -75,10 +85,50 @@ Library::Library( Database& database, const Handlers& handlers ) :
 	m_MediaFields.pop_back();
 
 	UpdateDatabase();
+
+	SeekIndex::SetStore(
+		[ this ] ( const std::wstring& filename, const long long filetime, const long long filesize, SeekIndex::Points& points )
+		{
+			return GetSeekIndex( filename, filetime, filesize, points );
+		},
+		[ this ] ( const std::wstring& filename, const long long filetime, const long long filesize, const SeekIndex::Points& points )
+		{
+			SetSeekIndex( filename, filetime, filesize, points );
+		}
+	);
+
+	SilenceOffsets::SetStore(
+		[ this ] ( const SilenceOffsets::Track& track, SilenceOffsets::Offsets& offsets )
+		{
+			return GetSilenceOffsets( track, offsets );
+		},
+		[ this ] ( const SilenceOffsets::Track& track, const SilenceOffsets::Offsets& offsets )
+		{
+			SetSilenceOffsets( track, offsets );
+		}
+	);
+
+	CrossfadeAnalysis::SetStore(
+		[ this ] ( const CrossfadeAnalysis::Track& track, CrossfadeAnalysis::Analysis& analysis )
+		{
+			return GetCrossfadeAnalysis( track, analysis );
+		},
+		[ this ] ( const CrossfadeAnalysis::Track& track, const CrossfadeAnalysis::Analysis& analysis )
+		{
+			SetCrossfadeAnalysis( track, analysis );
+		}
+	);
 }
 
 Library::~Library()
 {
+	SeekIndex::SaveAll();
+	SeekIndex::SetStore( nullptr, nullptr );
+	SilenceOffsets::SaveAll();
+	SilenceOffsets::SetStore( nullptr, nullptr );
+	CrossfadeAnalysis::SaveAll();
+	CrossfadeAnalysis::SetStore( nullptr, nullptr );
+
 	for ( const auto& filename : m_PendingTags ) {
 		if ( MediaInfo mediaInfo( filename ); GetMediaInfo( mediaInfo, false /*scanMedia*/, false /*sendNotification*/ ) ) {
 			if ( m_Handlers.SetTags( mediaInfo, *this ) ) {
@@ -96,6 +146,9 @@ void Library::UpdateDatabase()
 	UpdateMediaTable( true /*cuesTable*/ );
 	UpdateCDDATable();
 	UpdateArtworkTable();
+	UpdateSeekIndexTable();
+	UpdateSilenceTable();
+	UpdateCrossfadeTable();
 	CreateIndices();
 }
 
@@ -248,6 +301,36 @@ void Library::UpdateArtworkTable()
 	}
 }
 
+void Library::UpdateSeekIndexTable()
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		// Create the seek index table (if necessary).
+		const std::string seekIndexTableQuery = "CREATE TABLE IF NOT EXISTS SeekIndex(Filename,Filetime,Filesize,Points, PRIMARY KEY(Filename));";
+		sqlite3_exec( database, seekIndexTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	}
+}
+
+void Library::UpdateSilenceTable()
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		// Create the silence table (if necessary).
+		const std::string silenceTableQuery = "CREATE TABLE IF NOT EXISTS Silence(Filename,CueStart,CueEnd,Filetime,Filesize,Threshold,Leading,Trailing, PRIMARY KEY(Filename,CueStart,CueEnd));";
+		sqlite3_exec( database, silenceTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	}
+}
+
+void Library::UpdateCrossfadeTable()
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		// Create the crossfade table (if necessary).
+		const std::string crossfadeTableQuery = "CREATE TABLE IF NOT EXISTS Crossfade(Filename,CueStart,CueEnd,Filetime,Filesize,Threshold,Samplerate,WindowSize,StartFrame,EndFrame,Envelope, PRIMARY KEY(Filename,CueStart,CueEnd));";
+		sqlite3_exec( database, crossfadeTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	}
+}
+
 void Library::CreateIndices()
 {
 	sqlite3* database = m_Database.GetDatabase();
@@ -275,7 +358,7 @@ void Library::CreateIndices()
 	}
 }
 
-bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bool sendNotification, const bool removeMissing )
+bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bool sendNotification, const bool removeMissing, const std::optional<FileInfo>& fileInfo )
 {
 	bool success = false;
 	sqlite3* database = m_Database.GetDatabase();
@@ -292,7 +375,7 @@ bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bo
 			}
 		}
 		sqlite3_stmt* stmt = nullptr;
-		success = ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) );
+		success = ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) );
 		if ( success ) {
 			if ( MediaInfo::Source::CDDA == info.GetSource() ) {
 				success = ( SQLITE_OK == sqlite3_bind_int( stmt, 1 /*param*/, static_cast<int>( info.GetCDDB() ) ) ) && ( SQLITE_OK == sqlite3_bind_int( stmt, 2 /*param*/, static_cast<int>( info.GetTrack() ) ) );
@@ -309,7 +392,7 @@ bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bo
 				const int result = sqlite3_step( stmt );
 				success = ( SQLITE_ROW == result );
 				if ( success ) {
-					const bool missingData = !ExtractMediaInfo( stmt, info );
+					const bool missingData = !ExtractMediaInfo( stmt, GetColumnBindings( stmt ), info );
 					if ( scanMedia && ( MediaInfo::Source::File == info.GetSource() ) ) {
 						if ( missingData ) {
 							if ( GetDecoderInfo( info, true /*getTags*/ ) ) {
@@ -323,7 +406,12 @@ bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bo
 						} else {
 							long long filetime = 0;
 							long long filesize = 0;
-							GetFileInfo( info.GetFilename(), filetime, filesize );
+							if ( fileInfo ) {
+								filetime = fileInfo->Filetime;
+								filesize = fileInfo->Filesize;
+							} else {
+								GetFileInfo( info.GetFilename(), filetime, filesize );
+							}
 							success = ( info.GetFiletime() == filetime ) && ( info.GetFilesize() == filesize );
 							if ( !success ) {
 								info = mediaInfo;
@@ -350,7 +438,7 @@ bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia, const bo
 					mediaInfo = info;
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 	return success;
@@ -383,52 +471,63 @@ bool Library::GetFileInfo( const std::wstring& filename, long long& lastModified
 bool Library::GetDecoderInfo( MediaInfo& mediaInfo, const bool getTags )
 {
 	bool success = false;
-	if ( mediaInfo.GetCueStart() && m_LastCueFileInfo && ( mediaInfo.GetFilename() == m_LastCueFileInfo->GetFilename() ) ) {
+	std::optional<MediaInfo> lastCueFileInfo;
+	if ( mediaInfo.GetCueStart() ) {
+		std::lock_guard<std::mutex> lock( m_LastCueFileInfoMutex );
+		lastCueFileInfo = m_LastCueFileInfo;
+	}
+	if ( mediaInfo.GetCueStart() && lastCueFileInfo && ( mediaInfo.GetFilename() == lastCueFileInfo->GetFilename() ) ) {
 		// Use previously cached information for the CUE file entry, rather than scanning the backing file again.
-		mediaInfo.SetFiletime( m_LastCueFileInfo->GetFiletime() );
-		mediaInfo.SetFilesize( m_LastCueFileInfo->GetFilesize( false /*applyCues*/ ) );
-		mediaInfo.SetDuration( m_LastCueFileInfo->GetDuration( false /*applyCues*/ ) );
-		mediaInfo.SetSampleRate( m_LastCueFileInfo->GetSampleRate() );
-		mediaInfo.SetChannels( m_LastCueFileInfo->GetChannels() );
-		mediaInfo.SetBitsPerSample( m_LastCueFileInfo->GetBitsPerSample() );
-		mediaInfo.SetBitrate( m_LastCueFileInfo->GetBitrate( false /*calculate*/ ) );
-		mediaInfo.SetGainTrack( m_LastCueFileInfo->GetGainTrack() );
-		mediaInfo.SetGainAlbum( m_LastCueFileInfo->GetGainAlbum() );
-		mediaInfo.SetVersion( m_LastCueFileInfo->GetVersion() );
-		mediaInfo.SetArtworkID( m_LastCueFileInfo->GetArtworkID( false /*checkFolder*/ ) );
+		mediaInfo.SetFiletime( lastCueFileInfo->GetFiletime() );
+		mediaInfo.SetFilesize( lastCueFileInfo->GetFilesize( false /*applyCues*/ ) );
+		mediaInfo.SetDuration( lastCueFileInfo->GetDuration( false /*applyCues*/ ) );
+		mediaInfo.SetSampleRate( lastCueFileInfo->GetSampleRate() );
+		mediaInfo.SetChannels( lastCueFileInfo->GetChannels() );
+		mediaInfo.SetBitsPerSample( lastCueFileInfo->GetBitsPerSample() );
+		mediaInfo.SetBitrate( lastCueFileInfo->GetBitrate( false /*calculate*/ ) );
+		mediaInfo.SetGainTrack( lastCueFileInfo->GetGainTrack() );
+		mediaInfo.SetGainAlbum( lastCueFileInfo->GetGainAlbum() );
+		mediaInfo.SetVersion( lastCueFileInfo->GetVersion() );
+		mediaInfo.SetArtworkID( lastCueFileInfo->GetArtworkID( false /*checkFolder*/ ) );
 		if ( mediaInfo.GetYear() <= 0 )
-			mediaInfo.SetYear( m_LastCueFileInfo->GetYear() );
+			mediaInfo.SetYear( lastCueFileInfo->GetYear() );
 		if ( mediaInfo.GetTitle().empty() )
-			mediaInfo.SetTitle( m_LastCueFileInfo->GetTitle() );
+			mediaInfo.SetTitle( lastCueFileInfo->GetTitle() );
 		if ( mediaInfo.GetArtist().empty() )
-			mediaInfo.SetArtist( m_LastCueFileInfo->GetArtist() );
+			mediaInfo.SetArtist( lastCueFileInfo->GetArtist() );
 		if ( mediaInfo.GetAlbum().empty() )
-			mediaInfo.SetAlbum( m_LastCueFileInfo->GetAlbum() );
+			mediaInfo.SetAlbum( lastCueFileInfo->GetAlbum() );
 		if ( mediaInfo.GetGenre().empty() )
-			mediaInfo.SetGenre( m_LastCueFileInfo->GetGenre() );
+			mediaInfo.SetGenre( lastCueFileInfo->GetGenre() );
 		if ( mediaInfo.GetComposer().empty() )
-			mediaInfo.SetComposer( m_LastCueFileInfo->GetComposer() );
+			mediaInfo.SetComposer( lastCueFileInfo->GetComposer() );
 		if ( mediaInfo.GetConductor().empty() )
-			mediaInfo.SetConductor( m_LastCueFileInfo->GetConductor() );
+			mediaInfo.SetConductor( lastCueFileInfo->GetConductor() );
 		if ( mediaInfo.GetPublisher().empty() )
-			mediaInfo.SetPublisher( m_LastCueFileInfo->GetPublisher() );
+			mediaInfo.SetPublisher( lastCueFileInfo->GetPublisher() );
 		if ( mediaInfo.GetComment().empty() )
-			mediaInfo.SetComment( m_LastCueFileInfo->GetComment() );
+			mediaInfo.SetComment( lastCueFileInfo->GetComment() );
 		success = true;
 	} else {
-		Decoder::Ptr stream = m_Handlers.OpenDecoder( mediaInfo, Decoder::Context::Temporary, false /*applyCues*/ );
-		if ( stream ) {
+		// Probe the container headers where possible, which is much cheaper than opening a decoder.
+		std::optional<StreamProbe::Info> streamInfo = m_Handlers.Probe( mediaInfo );
+		if ( !streamInfo ) {
+			if ( Decoder::Ptr stream = m_Handlers.OpenDecoder( mediaInfo, Decoder::Context::Temporary, false /*applyCues*/ ); stream ) {
+				streamInfo = StreamProbe::Info{ stream->GetSampleRate(), stream->GetChannels(), stream->GetBPS(), stream->GetDuration(), stream->GetBitrate() };
+			}
+		}
+		if ( streamInfo ) {
 			long long filetime = 0;
 			long long filesize = 0;
 			GetFileInfo( mediaInfo.GetFilename(), filetime, filesize );
 			mediaInfo.SetFiletime( filetime );
 			mediaInfo.SetFilesize( filesize );
 
-			mediaInfo.SetBitsPerSample( stream->GetBPS() );
-			mediaInfo.SetChannels( stream->GetChannels() );
-			mediaInfo.SetDuration( stream->GetDuration() );
-			mediaInfo.SetSampleRate( stream->GetSampleRate() );
-			mediaInfo.SetBitrate( stream->GetBitrate() );
+			mediaInfo.SetBitsPerSample( streamInfo->BitsPerSample );
+			mediaInfo.SetChannels( streamInfo->Channels );
+			mediaInfo.SetDuration( streamInfo->Duration );
+			mediaInfo.SetSampleRate( streamInfo->SampleRate );
+			mediaInfo.SetBitrate( streamInfo->Bitrate );
 
 			if ( getTags ) {
 				std::optional<MediaInfo> cueInfo = mediaInfo.GetCueStart() ? std::make_optional( mediaInfo ) : std::nullopt;
@@ -463,7 +562,8 @@ bool Library::GetDecoderInfo( MediaInfo& mediaInfo, const bool getTags )
 			success = true;
 		}
 
-		if ( stream && mediaInfo.GetCueStart() ) {
+		std::lock_guard<std::mutex> lock( m_LastCueFileInfoMutex );
+		if ( streamInfo && mediaInfo.GetCueStart() ) {
 			m_LastCueFileInfo = mediaInfo;
 		} else {
 			m_LastCueFileInfo = std::nullopt;
@@ -472,179 +572,202 @@ bool Library::GetDecoderInfo( MediaInfo& mediaInfo, const bool getTags )
 	return success;
 }
 
-bool Library::ExtractMediaInfo( sqlite3_stmt* stmt, MediaInfo& mediaInfo )
+const Library::ColumnBindings& Library::GetColumnBindings( sqlite3_stmt* stmt )
 {
-	bool missingData = false;
-	if ( nullptr != stmt ) {
+	// The bindings depend only on the query, as the schema does not change once the library has been constructed.
+	static const ColumnBindings s_NoBindings;
+	const char* query = ( nullptr != stmt ) ? sqlite3_sql( stmt ) : nullptr;
+	if ( nullptr == query ) {
+		return s_NoBindings;
+	}
+	std::lock_guard<std::mutex> lock( m_ColumnBindingsMutex );
+	auto bindings = m_ColumnBindings.find( query );
+	if ( m_ColumnBindings.end() == bindings ) {
+		ColumnBindings columnBindings;
 		const int columnCount = sqlite3_column_count( stmt );
 		// Use cue columns (as a superset of media columns).
 		const Columns& columns = m_CueColumns;
 		for ( int columnIndex = 0; columnIndex < columnCount; columnIndex++ ) {
-			const auto columnIter = columns.find( sqlite3_column_name( stmt, columnIndex ) );
-			if ( columnIter != columns.end() ) {
-				const bool isNull = ( SQLITE_NULL == sqlite3_column_type( stmt, columnIndex ) );
-				const auto column = columnIter->second;
-				switch ( column ) {
-					case Column::Filename: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetFilename( UTF8ToWideString( text ) );
-						}
-						break;
-					}
-					case Column::Filetime: {
-						mediaInfo.SetFiletime( static_cast<long long>( sqlite3_column_int64( stmt, columnIndex ) ) );
-						break;
-					}
-					case Column::Filesize: {
-						mediaInfo.SetFilesize( static_cast<long long>( sqlite3_column_int64( stmt, columnIndex ) ) );
-						break;
-					}
-					case Column::Duration: {
-						mediaInfo.SetDuration( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
-						break;
-					}
-					case Column::SampleRate: {
-						mediaInfo.SetSampleRate( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
-						break;
-					}
-					case Column::BitsPerSample: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetBitsPerSample( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
-						}
-						break;
-					}
-					case Column::Channels: {
-						mediaInfo.SetChannels( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
-						break;
+			if ( const char* name = sqlite3_column_name( stmt, columnIndex ); nullptr != name ) {
+				if ( const auto column = columns.find( name ); columns.end() != column ) {
+					columnBindings.push_back( { columnIndex, column->second } );
+				}
+			}
+		}
+		bindings = m_ColumnBindings.insert( { query, columnBindings } ).first;
+	}
+	return bindings->second;
+}
+
+bool Library::ExtractMediaInfo( sqlite3_stmt* stmt, const ColumnBindings& bindings, MediaInfo& mediaInfo )
+{
+	bool missingData = false;
+	if ( nullptr != stmt ) {
+		for ( const auto& [columnIndex, column] : bindings ) {
+			const bool isNull = ( SQLITE_NULL == sqlite3_column_type( stmt, columnIndex ) );
+			switch ( column ) {
+				case Column::Filename: {
+					if ( !isNull ) {
+						mediaInfo.SetFilename( GetColumnText( stmt, columnIndex ) );
+					}
+					break;
+				}
+				case Column::Filetime: {
+					mediaInfo.SetFiletime( static_cast<long long>( sqlite3_column_int64( stmt, columnIndex ) ) );
+					break;
+				}
+				case Column::Filesize: {
+					mediaInfo.SetFilesize( static_cast<long long>( sqlite3_column_int64( stmt, columnIndex ) ) );
+					break;
+				}
+				case Column::Duration: {
+					mediaInfo.SetDuration( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
+					break;
+				}
+				case Column::SampleRate: {
+					mediaInfo.SetSampleRate( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
+					break;
+				}
+				case Column::BitsPerSample: {
+					if ( !isNull ) {
+						mediaInfo.SetBitsPerSample( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
 					}
-					case Column::Artist: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetArtist( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Channels: {
+					mediaInfo.SetChannels( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
+					break;
+				}
+				case Column::Artist: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetArtist( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Title: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetTitle( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Title: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetTitle( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Album: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetAlbum( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Album: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetAlbum( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Genre: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetGenre( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Genre: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetGenre( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Year: {
-						if ( isNull ) {
-							missingData = true;
-						} else {
-							mediaInfo.SetYear( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::Year: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetYear( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
 					}
-					case Column::Comment: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetComment( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Comment: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetComment( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Track: {
-						if ( isNull ) {
-							missingData = true;
-						} else {
-							mediaInfo.SetTrack( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::Track: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetTrack( static_cast<long>( sqlite3_column_int( stmt, columnIndex ) ) );
 					}
-					case Column::Version: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetVersion( UTF8ToWideString( text ) );
-						}
-						break;
+					break;
+				}
+				case Column::Version: {
+					if ( !isNull ) {
+						mediaInfo.SetVersion( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::GainTrack: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetGainTrack( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::GainTrack: {
+					if ( !isNull ) {
+						mediaInfo.SetGainTrack( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
 					}
-					case Column::GainAlbum: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetGainAlbum( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::GainAlbum: {
+					if ( !isNull ) {
+						mediaInfo.SetGainAlbum( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
 					}
-					case Column::Artwork: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetArtworkID( UTF8ToWideString( text ) );
-						}
-						break;
+					break;
+				}
+				case Column::Artwork: {
+					if ( !isNull ) {
+						mediaInfo.SetArtworkID( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Bitrate: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetBitrate( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::Bitrate: {
+					if ( !isNull ) {
+						mediaInfo.SetBitrate( static_cast<float>( sqlite3_column_double( stmt, columnIndex ) ) );
 					}
-					case Column::CueStart: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetCueStart( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::CueStart: {
+					if ( !isNull ) {
+						mediaInfo.SetCueStart( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
 					}
-					case Column::CueEnd: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetCueEnd( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::CueEnd: {
+					if ( !isNull ) {
+						mediaInfo.SetCueEnd( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
 					}
-					case Column::Composer: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetComposer( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Composer: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetComposer( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Conductor: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetConductor( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Conductor: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetConductor( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::Publisher: {
-						if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, columnIndex ) ); nullptr != text ) {
-							mediaInfo.SetPublisher( UTF8ToWideString( text ) );
-						} else if ( isNull ) {
-							missingData = true;
-						}
-						break;
+					break;
+				}
+				case Column::Publisher: {
+					if ( isNull ) {
+						missingData = true;
+					} else {
+						mediaInfo.SetPublisher( GetColumnText( stmt, columnIndex ) );
 					}
-					case Column::PlayCount: {
-						if ( SQLITE_NULL != sqlite3_column_type( stmt, columnIndex ) ) {
-							mediaInfo.SetPlayCount( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
-						}
-						break;
+					break;
+				}
+				case Column::PlayCount: {
+					if ( !isNull ) {
+						mediaInfo.SetPlayCount( static_cast<long>( sqlite3_column_int64( stmt, columnIndex ) ) );
 					}
+					break;
+				}
+				default: {
+					break;
 				}
 			}
 		}
@@ -654,6 +777,7 @@ bool Library::ExtractMediaInfo( sqlite3_stmt* stmt, MediaInfo& mediaInfo )
 
 bool Library::UpdateMediaLibrary( const MediaInfo& mediaInfo )
 {
+	const LibraryWriter::Scope scope( m_Writer );
 	bool success = false;
 
 	sqlite3* database = m_Database.GetDatabase();
@@ -673,7 +797,7 @@ bool Library::UpdateMediaLibrary( const MediaInfo& mediaInfo )
 		values.back() = ')';
 		const std::string query = "REPLACE INTO " + tableName + columns + values + ";";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			param = 0;
 			for ( const auto& iter : columnMap ) {
 				switch ( iter.second ) {
@@ -811,7 +935,7 @@ bool Library::UpdateMediaLibrary( const MediaInfo& mediaInfo )
 			}
 			const int result = sqlite3_step( stmt );
 			success = ( SQLITE_DONE == result );
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 	return success;
@@ -862,24 +986,193 @@ void Library::WriteFileTags( MediaInfo& mediaInfo )
 
 bool Library::AddArtwork( const std::wstring& id, const std::vector<BYTE>& image )
 {
+	const LibraryWriter::Scope scope( m_Writer );
 	bool success = false;
 	if ( !image.empty() ) {
 		sqlite3* database = m_Database.GetDatabase();
 		if ( nullptr != database ) {
 			sqlite3_stmt* stmt = nullptr;
 			const std::string insertQuery = "REPLACE INTO Artwork (ID,Size,Image) VALUES (?1,?2,?3);";
-			if ( SQLITE_OK == sqlite3_prepare_v2( database, insertQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_OK == m_Database.PrepareStatement( insertQuery, &stmt ) ) {
 				sqlite3_bind_text( stmt, 1, WideStringToUTF8( id ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
 				sqlite3_bind_int( stmt, 2, static_cast<int>( image.size() ) );
 				sqlite3_bind_blob( stmt, 3, &image[ 0 ], static_cast<int>( image.size() ), SQLITE_STATIC );
 				success = ( SQLITE_DONE == sqlite3_step( stmt ) );
-				sqlite3_finalize( stmt );
+				m_Database.ReleaseStatement( stmt );
+			}
+		}
+	}
+	return success;
+}
+
+bool Library::ReadFileRow( const std::string& table, const std::string& columns, const std::string& key, const std::function<void( sqlite3_stmt* )>& bind,
+	const long long filetime, const long long filesize, const std::function<bool( sqlite3_stmt* )>& read )
+{
+	bool success = false;
+	bool stale = false;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "SELECT Filetime,Filesize," + columns + " FROM " + table + " WHERE " + key + ";";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
+			bind( stmt );
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				stale = ( sqlite3_column_int64( stmt, 0 /*columnIndex*/ ) != filetime ) || ( sqlite3_column_int64( stmt, 1 /*columnIndex*/ ) != filesize );
+				if ( !stale ) {
+					success = read( stmt );
+				}
+			}
+			m_Database.ReleaseStatement( stmt );
+		}
+
+		if ( stale ) {
+			const LibraryWriter::Scope scope( m_Writer );
+			const std::string deleteQuery = "DELETE FROM " + table + " WHERE " + key + ";";
+			if ( SQLITE_OK == m_Database.PrepareStatement( deleteQuery, &stmt ) ) {
+				bind( stmt );
+				sqlite3_step( stmt );
+				m_Database.ReleaseStatement( stmt );
 			}
 		}
 	}
 	return success;
 }
 
+bool Library::GetSeekIndex( const std::wstring& filename, const long long filetime, const long long filesize, SeekIndex::Points& points )
+{
+	const std::string filenameUTF8 = WideStringToUTF8( filename );
+	return ReadFileRow( "SeekIndex", "Points", "Filename=?1",
+		[ &filenameUTF8 ] ( sqlite3_stmt* stmt )
+		{
+			sqlite3_bind_text( stmt, 1 /*param*/, filenameUTF8.c_str(), -1 /*strLen*/, SQLITE_STATIC );
+		},
+		filetime, filesize,
+		[ &points ] ( sqlite3_stmt* stmt )
+		{
+			const void* blob = sqlite3_column_blob( stmt, 2 /*columnIndex*/ );
+			const size_t size = static_cast<size_t>( sqlite3_column_bytes( stmt, 2 /*columnIndex*/ ) );
+			return SeekIndex::Deserialise( blob, size, points );
+		}
+	);
+}
+
+void Library::SetSeekIndex( const std::wstring& filename, const long long filetime, const long long filesize, const SeekIndex::Points& points )
+{
+	const LibraryWriter::Scope scope( m_Writer );
+	sqlite3* database = m_Database.GetDatabase();
+	if ( ( nullptr != database ) && !points.empty() ) {
+		const std::vector<uint8_t> blob = SeekIndex::Serialise( points );
+		const std::string query = "REPLACE INTO SeekIndex (Filename,Filetime,Filesize,Points) VALUES (?1,?2,?3,?4);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
+			sqlite3_bind_text( stmt, 1, WideStringToUTF8( filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+			sqlite3_bind_int64( stmt, 2, filetime );
+			sqlite3_bind_int64( stmt, 3, filesize );
+			sqlite3_bind_blob( stmt, 4, blob.data(), static_cast<int>( blob.size() ), SQLITE_STATIC );
+			sqlite3_step( stmt );
+			m_Database.ReleaseStatement( stmt );
+		}
+	}
+}
+
+bool Library::GetSilenceOffsets( const SilenceOffsets::Track& track, SilenceOffsets::Offsets& offsets )
+{
+	const std::string filenameUTF8 = WideStringToUTF8( track.Filename );
+	return ReadFileRow( "Silence", "Threshold,Leading,Trailing", "Filename=?1 AND CueStart=?2 AND CueEnd=?3",
+		[ &filenameUTF8, &track ] ( sqlite3_stmt* stmt )
+		{
+			sqlite3_bind_text( stmt, 1 /*param*/, filenameUTF8.c_str(), -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2 /*param*/, track.CueStart );
+			sqlite3_bind_int( stmt, 3 /*param*/, track.CueEnd );
+		},
+		track.Filetime, track.Filesize,
+		[ &offsets ] ( sqlite3_stmt* stmt )
+		{
+			offsets.Threshold = static_cast<float>( sqlite3_column_double( stmt, 2 /*columnIndex*/ ) );
+			offsets.Leading = sqlite3_column_int64( stmt, 3 /*columnIndex*/ );
+			offsets.Trailing = ( SQLITE_NULL == sqlite3_column_type( stmt, 4 /*columnIndex*/ ) ) ? std::nullopt : std::make_optional( sqlite3_column_int64( stmt, 4 /*columnIndex*/ ) );
+			return true;
+		}
+	);
+}
+
+void Library::SetSilenceOffsets( const SilenceOffsets::Track& track, const SilenceOffsets::Offsets& offsets )
+{
+	const LibraryWriter::Scope scope( m_Writer );
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Silence (Filename,CueStart,CueEnd,Filetime,Filesize,Threshold,Leading,Trailing) VALUES (?1,?2,?3,?4,?5,?6,?7,?8);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
+			sqlite3_bind_text( stmt, 1, WideStringToUTF8( track.Filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+			sqlite3_bind_int( stmt, 2, track.CueStart );
+			sqlite3_bind_int( stmt, 3, track.CueEnd );
+			sqlite3_bind_int64( stmt, 4, track.Filetime );
+			sqlite3_bind_int64( stmt, 5, track.Filesize );
+			sqlite3_bind_double( stmt, 6, offsets.Threshold );
+			sqlite3_bind_int64( stmt, 7, offsets.Leading );
+			if ( offsets.Trailing ) {
+				sqlite3_bind_int64( stmt, 8, *offsets.Trailing );
+			} else {
+				sqlite3_bind_null( stmt, 8 );
+			}
+			sqlite3_step( stmt );
+			m_Database.ReleaseStatement( stmt );
+		}
+	}
+}
+
+bool Library::GetCrossfadeAnalysis( const CrossfadeAnalysis::Track& track, CrossfadeAnalysis::Analysis& analysis )
+{
+	const std::string filenameUTF8 = WideStringToUTF8( track.Filename );
+	return ReadFileRow( "Crossfade", "Threshold,Samplerate,WindowSize,StartFrame,EndFrame,Envelope", "Filename=?1 AND CueStart=?2 AND CueEnd=?3",
+		[ &filenameUTF8, &track ] ( sqlite3_stmt* stmt )
+		{
+			sqlite3_bind_text( stmt, 1 /*param*/, filenameUTF8.c_str(), -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2 /*param*/, track.CueStart );
+			sqlite3_bind_int( stmt, 3 /*param*/, track.CueEnd );
+		},
+		track.Filetime, track.Filesize,
+		[ &analysis ] ( sqlite3_stmt* stmt )
+		{
+			analysis.Threshold = static_cast<float>( sqlite3_column_double( stmt, 2 /*columnIndex*/ ) );
+			analysis.SampleRate = sqlite3_column_int( stmt, 3 /*columnIndex*/ );
+			analysis.WindowSize = sqlite3_column_int( stmt, 4 /*columnIndex*/ );
+			analysis.StartFrame = sqlite3_column_int64( stmt, 5 /*columnIndex*/ );
+			analysis.EndFrame = sqlite3_column_int64( stmt, 6 /*columnIndex*/ );
+			const void* blob = sqlite3_column_blob( stmt, 7 /*columnIndex*/ );
+			const size_t size = static_cast<size_t>( sqlite3_column_bytes( stmt, 7 /*columnIndex*/ ) );
+			return CrossfadeAnalysis::Deserialise( blob, size, analysis.Envelope );
+		}
+	);
+}
+
+void Library::SetCrossfadeAnalysis( const CrossfadeAnalysis::Track& track, const CrossfadeAnalysis::Analysis& analysis )
+{
+	const LibraryWriter::Scope scope( m_Writer );
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::vector<uint8_t> blob = CrossfadeAnalysis::Serialise( analysis.Envelope );
+		const std::string query = "REPLACE INTO Crossfade (Filename,CueStart,CueEnd,Filetime,Filesize,Threshold,Samplerate,WindowSize,StartFrame,EndFrame,Envelope) VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,?11);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
+			sqlite3_bind_text( stmt, 1, WideStringToUTF8( track.Filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+			sqlite3_bind_int( stmt, 2, track.CueStart );
+			sqlite3_bind_int( stmt, 3, track.CueEnd );
+			sqlite3_bind_int64( stmt, 4, track.Filetime );
+			sqlite3_bind_int64( stmt, 5, track.Filesize );
+			sqlite3_bind_double( stmt, 6, analysis.Threshold );
+			sqlite3_bind_int( stmt, 7, analysis.SampleRate );
+			sqlite3_bind_int( stmt, 8, analysis.WindowSize );
+			sqlite3_bind_int64( stmt, 9, analysis.StartFrame );
+			sqlite3_bind_int64( stmt, 10, analysis.EndFrame );
+			sqlite3_bind_blob( stmt, 11, blob.data(), static_cast<int>( blob.size() ), SQLITE_STATIC );
+			sqlite3_step( stmt );
+			m_Database.ReleaseStatement( stmt );
+		}
+	}
+}
+
 std::wstring Library::FindArtwork( const std::vector<BYTE>& image )
 {
 	std::wstring result;
@@ -887,7 +1180,7 @@ std::wstring Library::FindArtwork( const std::vector<BYTE>& image )
 	if ( nullptr != database ) {
 		std::string query = "SELECT ID,Image FROM Artwork WHERE Size=?1;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			if ( SQLITE_OK == sqlite3_bind_int( stmt, 1 /*param*/, static_cast<int>( image.size() ) ) ) {
 				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					const size_t numBytes = static_cast<size_t>( sqlite3_column_bytes( stmt, 1 /*columnIndex*/ ) );
@@ -904,7 +1197,7 @@ std::wstring Library::FindArtwork( const std::vector<BYTE>& image )
 					}
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -920,7 +1213,7 @@ std::vector<BYTE> Library::GetMediaArtwork( const MediaInfo& mediaInfo )
 		if ( nullptr != database ) {
 			const std::string query = "SELECT Image FROM Artwork WHERE ID=?1;";
 			sqlite3_stmt* stmt = nullptr;
-			if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 				if ( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( artworkID ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) {
 					if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 						const size_t numBytes = static_cast<size_t>( sqlite3_column_bytes( stmt, 0 /*columnIndex*/ ) );
@@ -933,7 +1226,7 @@ std::vector<BYTE> Library::GetMediaArtwork( const MediaInfo& mediaInfo )
 						}
 					}
 				}
-				sqlite3_finalize( stmt );
+				m_Database.ReleaseStatement( stmt );
 				stmt = nullptr;
 			}
 		}
@@ -987,14 +1280,14 @@ std::set<long> Library::GetYears()
 	if ( nullptr != database ) {
 		const std::string query = "SELECT Year FROM Media UNION SELECT Year FROM Cues;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 			while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 				const long year = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
 				if ( ( year >= MINYEAR ) && ( year <= MAXYEAR ) ) {
 					years.insert( year );
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1059,15 +1352,16 @@ MediaInfo::List Library::GetMediaByYear( const long year )
 		if ( nullptr != database ) {
 			const std::string query = "SELECT " + m_MediaFields + " FROM Media WHERE Year=?1 UNION SELECT " + m_CueFields + " FROM Cues WHERE Year=?1 ORDER BY Filename,CueStart COLLATE NOCASE;";
 			sqlite3_stmt* stmt = nullptr;
-			if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 				if ( SQLITE_OK == sqlite3_bind_int( stmt, 1 /*param*/, static_cast<int>( year ) ) ) {
+					const ColumnBindings& bindings = GetColumnBindings( stmt );
 					while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 						MediaInfo mediaInfo;
-						ExtractMediaInfo( stmt, mediaInfo );
+						ExtractMediaInfo( stmt, bindings, mediaInfo );
 						mediaList.push_back( mediaInfo );
 					}
 				}
-				sqlite3_finalize( stmt );
+				m_Database.ReleaseStatement( stmt );
 				stmt = nullptr;
 			}
 		}
@@ -1112,13 +1406,14 @@ MediaInfo::List Library::GetAllMedia()
 	if ( nullptr != database ) {
 		const std::string query = "SELECT " + m_MediaFields + " FROM Media UNION SELECT " + m_CueFields + " FROM Cues ORDER BY Filename,CueStart COLLATE NOCASE;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
+			const ColumnBindings& bindings = GetColumnBindings( stmt );
 			while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 				MediaInfo mediaInfo;
-				ExtractMediaInfo( stmt, mediaInfo );
+				ExtractMediaInfo( stmt, bindings, mediaInfo );
 				mediaList.push_back( mediaInfo );
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1132,13 +1427,14 @@ MediaInfo::List Library::GetStreams()
 	if ( nullptr != database ) {
 		const std::string query = "SELECT * FROM Media WHERE Filename LIKE 'http:%' OR Filename LIKE 'https:%' OR Filename LIKE 'ftp:%' ORDER BY Filename COLLATE NOCASE;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
+			const ColumnBindings& bindings = GetColumnBindings( stmt );
 			while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 				MediaInfo mediaInfo;
-				ExtractMediaInfo( stmt, mediaInfo );
+				ExtractMediaInfo( stmt, bindings, mediaInfo );
 				mediaList.push_back( mediaInfo );
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1173,10 +1469,10 @@ bool Library::GetYearExists( const long year )
 		if ( nullptr != database ) {
 			const std::string query = "SELECT 1 FROM Media WHERE EXISTS(SELECT 1 FROM Media WHERE Year=?1) UNION SELECT 1 FROM Cues WHERE EXISTS(SELECT 1 FROM Cues WHERE Year=?1);";
 			sqlite3_stmt* stmt = nullptr;
-			exists = ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) &&
+			exists = ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) &&
 				( SQLITE_OK == sqlite3_bind_int( stmt, 1 /*param*/, static_cast<int>( year ) ) ) &&
 				( SQLITE_ROW == sqlite3_step( stmt ) );
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 	return exists;
@@ -1214,13 +1510,14 @@ bool Library::GetConductorAndAlbumExists( const std::wstring& conductor, const s
 
 bool Library::RemoveFromLibrary( const MediaInfo& mediaInfo )
 {
+	const LibraryWriter::Scope scope( m_Writer );
 	bool removed = false;
 	sqlite3* database = m_Database.GetDatabase();
 	const std::wstring& filename = mediaInfo.GetFilename();
 	if ( ( nullptr != database ) && !filename.empty() && ( MediaInfo::Source::File == mediaInfo.GetSource() ) ) {
 		const std::string query = mediaInfo.GetCueStart() ? "DELETE FROM Cues WHERE Filename=?1 AND CueStart=?2 AND CueEnd=?3;" : "DELETE FROM Media WHERE Filename=?1;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			bool ok = false;
 			if ( mediaInfo.GetCueStart() ) {
 				ok = ( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) &&
@@ -1232,7 +1529,7 @@ bool Library::RemoveFromLibrary( const MediaInfo& mediaInfo )
 				// Should be a maximum of one entry.
 				removed = ( SQLITE_DONE == sqlite3_step( stmt ) );
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 	return removed;
@@ -1359,6 +1656,8 @@ bool Library::UpdateTrackGain( const MediaInfo& previousInfo, const MediaInfo& u
 	if ( previousInfo.GetGainTrack() != updatedInfo.GetGainTrack() ) {
 		sqlite3* database = m_Database.GetDatabase();
 		if ( nullptr != database ) {
+			// Gain values are committed immediately, rather than as part of any batched library transaction.
+			const Database::WriteScope scope( m_Database );
 			std::string query;
 			if ( MediaInfo::Source::CDDA == updatedInfo.GetSource() ) {
 				query = "UPDATE CDDA SET GainTrack=?1 WHERE CDDB=?2 AND Track=?3;";
@@ -1370,7 +1669,7 @@ bool Library::UpdateTrackGain( const MediaInfo& previousInfo, const MediaInfo& u
 				}
 			}
 			sqlite3_stmt* stmt = nullptr;
-			updated = ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) );
+			updated = ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) );
 			if ( updated ) {
 				const auto gain = updatedInfo.GetGainTrack();
 				updated = gain.has_value() ? ( SQLITE_OK == sqlite3_bind_double( stmt, 1 /*param*/, gain.value() ) ) : ( SQLITE_OK == sqlite3_bind_null( stmt, 1 /*param*/ ) );
@@ -1390,7 +1689,7 @@ bool Library::UpdateTrackGain( const MediaInfo& previousInfo, const MediaInfo& u
 						updated = ( SQLITE_DONE == sqlite3_step( stmt ) );
 					}
 				}
-				sqlite3_finalize( stmt );
+				m_Database.ReleaseStatement( stmt );
 			}
 		}
 	}
@@ -1406,6 +1705,8 @@ bool Library::UpdateTrackGain( const MediaInfo& previousInfo, const MediaInfo& u
 void Library::UpdatePlayCount( const MediaInfo& previousInfo )
 {
 	if ( sqlite3* database = m_Database.GetDatabase(); nullptr != database ) {
+		// Play counts are committed immediately, rather than as part of any batched library transaction.
+		const Database::WriteScope scope( m_Database );
 		MediaInfo updatedInfo( previousInfo );
 		updatedInfo.IncrementPlayCount();
 		std::string query;
@@ -1419,7 +1720,7 @@ void Library::UpdatePlayCount( const MediaInfo& previousInfo )
 			}
 		}
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			const auto playCount = static_cast<int>( updatedInfo.GetPlayCount() );
 			bool ok = ( SQLITE_OK == sqlite3_bind_int( stmt, 1 /*param*/, playCount ) );
 			if ( ok ) {
@@ -1438,7 +1739,7 @@ void Library::UpdatePlayCount( const MediaInfo& previousInfo )
 					ok = ( SQLITE_DONE == sqlite3_step( stmt ) );
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			if ( ok ) {
 				VUPlayer* vuplayer = VUPlayer::Get();
 				if ( nullptr != vuplayer ) {
@@ -1504,6 +1805,16 @@ bool Library::HasRecentlyWrittenTag( const std::wstring& filename ) const
 	return recentTagWrite;
 }
 
+int Library::PrepareReadStatement( const std::string& query, sqlite3_stmt** statement )
+{
+	return m_Writer.IsTransactionOpen() ? m_Database.PrepareStatement( query, statement ) : m_Database.PrepareReadStatement( query, statement );
+}
+
+void Library::Flush()
+{
+	m_Writer.Flush();
+}
+
 std::set<std::wstring> Library::GetEntities( const std::string& entityColumn )
 {
 	std::set<std::wstring> entities;
@@ -1511,7 +1822,7 @@ std::set<std::wstring> Library::GetEntities( const std::string& entityColumn )
 	if ( nullptr != database ) {
 		const std::string query = "SELECT " + entityColumn + " FROM Media UNION SELECT " + entityColumn + " FROM Cues;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 			while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 				if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, 0 /*columnIndex*/ ) ); nullptr != text ) {
 					const std::wstring entity = UTF8ToWideString( text );
@@ -1520,7 +1831,7 @@ std::set<std::wstring> Library::GetEntities( const std::string& entityColumn )
 					}
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1534,7 +1845,7 @@ std::set<std::wstring> Library::GetAlbums( const std::wstring& entity, const std
 	if ( nullptr != database ) {
 		const std::string query = "SELECT Album FROM Media WHERE " + entityColumn + "=?1 UNION SELECT Album FROM Cues WHERE " + entityColumn + "=?1;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 			if ( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( entity ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) {
 				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					if ( const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, 0 /*columnIndex*/ ) ); nullptr != text ) {
@@ -1545,7 +1856,7 @@ std::set<std::wstring> Library::GetAlbums( const std::wstring& entity, const std
 					}
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1559,15 +1870,16 @@ MediaInfo::List Library::GetMediaByEntity( const std::wstring& entity, const std
 	if ( nullptr != database ) {
 		const std::string query = "SELECT " + m_MediaFields + " FROM Media WHERE " + entityColumn + "=?1 UNION SELECT " + m_CueFields + " FROM Cues WHERE " + entityColumn + "=?1 ORDER BY Filename,CueStart COLLATE NOCASE;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 			if ( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( entity ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) {
+				const ColumnBindings& bindings = GetColumnBindings( stmt );
 				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					MediaInfo mediaInfo;
-					ExtractMediaInfo( stmt, mediaInfo );
+					ExtractMediaInfo( stmt, bindings, mediaInfo );
 					mediaList.push_back( mediaInfo );
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1581,16 +1893,17 @@ MediaInfo::List Library::GetMediaByEntityAndAlbum( const std::wstring& entity, c
 	if ( nullptr != database ) {
 		const std::string query = "SELECT " + m_MediaFields + " FROM Media WHERE " + entityColumn + "=?1 AND Album=?2 UNION SELECT " + m_CueFields + " FROM Cues WHERE " + entityColumn + "=?1 AND Album=?2 ORDER BY Filename,CueStart COLLATE NOCASE;";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == PrepareReadStatement( query, &stmt ) ) {
 			if ( ( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( entity ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) &&
 				( SQLITE_OK == sqlite3_bind_text( stmt, 2 /*param*/, WideStringToUTF8( album ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) ) {
+				const ColumnBindings& bindings = GetColumnBindings( stmt );
 				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					MediaInfo mediaInfo;
-					ExtractMediaInfo( stmt, mediaInfo );
+					ExtractMediaInfo( stmt, bindings, mediaInfo );
 					mediaList.push_back( mediaInfo );
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 			stmt = nullptr;
 		}
 	}
@@ -1604,10 +1917,10 @@ bool Library::GetEntityExists( const std::wstring& entity, const std::string& en
 	if ( nullptr != database ) {
 		const std::string query = "SELECT 1 FROM Media WHERE EXISTS(SELECT 1 FROM Media WHERE " + entityColumn + "=?1) UNION SELECT 1 FROM Cues WHERE EXISTS(SELECT 1 FROM Cues WHERE " + entityColumn + "=?1);";
 		sqlite3_stmt* stmt = nullptr;
-		exists = ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) &&
+		exists = ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) &&
 			( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( entity ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) &&
 			( SQLITE_ROW == sqlite3_step( stmt ) );
-		sqlite3_finalize( stmt );
+		m_Database.ReleaseStatement( stmt );
 	}
 	return exists;
 }
@@ -1619,11 +1932,11 @@ bool Library::GetEntityAndAlbumExists( const std::wstring& entity, const std::ws
 	if ( nullptr != database ) {
 		const std::string query = "SELECT 1 FROM Media WHERE EXISTS(SELECT 1 FROM Media WHERE " + entityColumn + "=?1 AND Album=?2) UNION SELECT 1 FROM Cues WHERE EXISTS(SELECT 1 FROM Cues WHERE " + entityColumn + "=?1 AND Album=?2);";
 		sqlite3_stmt* stmt = nullptr;
-		exists = ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) &&
+		exists = ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) &&
 			( SQLITE_OK == sqlite3_bind_text( stmt, 1 /*param*/, WideStringToUTF8( entity ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) &&
 			( SQLITE_OK == sqlite3_bind_text( stmt, 2 /*param*/, WideStringToUTF8( album ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) &&
 			( SQLITE_ROW == sqlite3_step( stmt ) );
-		sqlite3_finalize( stmt );
+		m_Database.ReleaseStatement( stmt );
 	}
 	return exists;
 }
@@ -2,8 +2,13 @@
 
 #include "Database.h"
 #include "Handlers.h"
+#include "LibraryWriter.h"
 #include "MediaInfo.h"
+#include "CrossfadeAnalysis.h"
+#include "SeekIndex.h"
+#include "SilenceOffsets.h"
 
+#include <functional>
 #include <vector>
 
 // Media library
@@ -50,13 +55,20 @@ public:
 		_Undefined
 	};
 
+	// File modification time & size, as used to check whether media information is stale.
+	struct FileInfo {
+		long long Filetime = 0;
+		long long Filesize = 0;
+	};
+
 	// Gets media information.
 	// 'mediaInfo' - in/out, media information containing the filename (with optional cues) to query.
 	// 'scanMedia' - whether to scan the file specified in 'mediaInfo' if no matching database entry is found, or if the existing database entry is stale.
 	// 'sendNotification' - whether to notify the main app if 'mediaInfo' has changed.
 	// 'removeMissing' - whether to remove media information from the library if the file specified in 'mediaInfo' cannot be opened.
+	// 'fileInfo' - the file modification time & size, if already known (otherwise they are read from the file, when checking whether a database entry is stale).
 	// Returns true if media information was returned.
-	bool GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia = true, const bool sendNotification = true, const bool removeMissing = false );
+	bool GetMediaInfo( MediaInfo& mediaInfo, const bool scanMedia = true, const bool sendNotification = true, const bool removeMissing = false, const std::optional<FileInfo>& fileInfo = std::nullopt );
 
 	// Queries the available decoders for media information.
 	// 'mediaInfo' - in/out, media information containing the filename to query.
@@ -211,10 +223,16 @@ public:
 	// Updates the play count for a track.
 	void UpdatePlayCount( const MediaInfo& mediaInfo );
 
+	// Commits any pending media library writes.
+	void Flush();
+
 private:
 	// Media library columns.
 	using Columns = std::map<std::string, Column>;
 
+	// Result column bindings, pairing the index of each result column with the media library column it holds.
+	using ColumnBindings = std::vector<std::pair<int, Column>>;
+
 	// Updates the database to the current version if necessary.
 	void UpdateDatabase();
 
@@ -228,6 +246,15 @@ private:
 	// Updates the artwork table if necessary.
 	void UpdateArtworkTable();
 
+	// Updates the seek index table if necessary.
+	void UpdateSeekIndexTable();
+
+	// Updates the silence table if necessary.
+	void UpdateSilenceTable();
+
+	// Updates the crossfade table if necessary.
+	void UpdateCrossfadeTable();
+
 	// Creates indices if necessary.
 	void CreateIndices();
 
@@ -239,6 +266,12 @@ private:
 	// Returns true if the library was updated.
 	bool UpdateMediaLibrary( const MediaInfo& mediaInfo );
 
+	// Prepares a read only 'statement' for the 'query', using the reader pool unless the library writer has a transaction open.
+	// Reads are typically made in response to library change notifications, which are sent as soon as the change is written,
+	// so the main connection is used while there are writes which the reader pool connections would not yet see.
+	// Returns the SQLite result code.
+	int PrepareReadStatement( const std::string& query, sqlite3_stmt** statement );
+
 	// Writes out tag information to file.
 	// 'mediaInfo' - in/out, media information which will be modified if tags are successfully written.
 	void WriteFileTags( MediaInfo& mediaInfo );
@@ -248,13 +281,46 @@ private:
 	// 'artwork' - artwork image.
 	bool AddArtwork( const std::wstring& id, const std::vector<BYTE>& image );
 
+	// Reads the row identified by the 'key' clause from a per-file 'table' (such as the seek index, silence & crossfade tables).
+	// 'columns' - columns to read, which follow the Filetime & Filesize columns (so start at column index 2).
+	// 'bind' - binds the parameters of the 'key' clause.
+	// 'filetime' & 'filesize' - file modification time & size, a stale row which does not match these is deleted rather than read.
+	// 'read' - reads the columns from the row, returning whether successful.
+	// Returns whether the row was read.
+	bool ReadFileRow( const std::string& table, const std::string& columns, const std::string& key, const std::function<void( sqlite3_stmt* )>& bind,
+		const long long filetime, const long long filesize, const std::function<bool( sqlite3_stmt* )>& read );
+
+	// Gets the seek 'points' for 'filename', returning whether any points were found.
+	// Any stored seek index which does not match the 'filetime' & 'filesize' is removed.
+	bool GetSeekIndex( const std::wstring& filename, const long long filetime, const long long filesize, SeekIndex::Points& points );
+
+	// Sets the seek 'points' for 'filename', with the 'filetime' & 'filesize' to which they apply.
+	void SetSeekIndex( const std::wstring& filename, const long long filetime, const long long filesize, const SeekIndex::Points& points );
+
+	// Gets the silence 'offsets' for the 'track', returning whether any offsets were found.
+	// Any stored offsets which do not match the track file modification time & size are removed.
+	bool GetSilenceOffsets( const SilenceOffsets::Track& track, SilenceOffsets::Offsets& offsets );
+
+	// Sets the silence 'offsets' for the 'track'.
+	void SetSilenceOffsets( const SilenceOffsets::Track& track, const SilenceOffsets::Offsets& offsets );
+
+	// Gets the crossfade 'analysis' for the 'track', returning whether an analysis was found.
+	// Any stored analysis which does not match the track file modification time & size is removed.
+	bool GetCrossfadeAnalysis( const CrossfadeAnalysis::Track& track, CrossfadeAnalysis::Analysis& analysis );
+
+	// Sets the crossfade 'analysis' for the 'track'.
+	void SetCrossfadeAnalysis( const CrossfadeAnalysis::Track& track, const CrossfadeAnalysis::Analysis& analysis );
+
 	// Searches the artwork table for a matching 'image'.
 	// Returns the image ID if an image was found, or an empty string if there was no match.
 	std::wstring FindArtwork( const std::vector<BYTE>& image );
 
-	// Sets 'mediaInfo' from a SQLite 'stmt'.
+	// Returns the result column bindings for a SQLite 'stmt', which are resolved once for each query and then reused.
+	const ColumnBindings& GetColumnBindings( sqlite3_stmt* stmt );
+
+	// Sets 'mediaInfo' from the current row of a SQLite 'stmt', using the result column 'bindings'.
 	// Returns false if there was any missing media data in the table (from new columns added as part of a schema update).
-	bool ExtractMediaInfo( sqlite3_stmt* stmt, MediaInfo& mediaInfo );
+	bool ExtractMediaInfo( sqlite3_stmt* stmt, const ColumnBindings& bindings, MediaInfo& mediaInfo );
 
 	// Returns the library columns corresponding to 'mediaInfo'.
 	const Columns& GetColumns( const MediaInfo& mediaInfo ) const;
@@ -301,6 +367,12 @@ private:
 	// Mutex for the map of attempted tag writes.
 	mutable std::mutex m_TagsWrittenMutex;
 
+	// Result column bindings, mapped by query.
+	std::map<std::string, ColumnBindings> m_ColumnBindings;
+
+	// Mutex for the result column bindings.
+	std::mutex m_ColumnBindingsMutex;
+
 	// Media library columns.
 	Columns m_MediaColumns;
 
@@ -318,4 +390,10 @@ private:
 
 	// Media information for the last scanned CUE file entry (used for optimizing the opening of new CUE files).
 	std::optional<MediaInfo> m_LastCueFileInfo;
+
+	// Mutex for the last scanned CUE file entry.
+	std::mutex m_LastCueFileInfoMutex;
+
+	// Batches media library writes into transactions.
+	LibraryWriter m_Writer;
 };
@@ -0,0 +1,297 @@
+#include "LibraryBenchmark.h"
+
+#include "Database.h"
+#include "Handlers.h"
+#include "Library.h"
+#include "LibraryWriter.h"
+#include "Metrics.h"
+#include "Utility.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+// Results file format version.
+constexpr int kResultsVersion = 4;
+
+// Number of tracks in the synthetic library.
+constexpr size_t kTrackCount = 100000;
+
+// Number of times to get all media from the library (the fastest time is reported).
+constexpr size_t kExtractCount = 5;
+
+// Number of media information lookups to perform for each configuration.
+constexpr size_t kLookupCount = 100000;
+
+// Number of tracks written to the on-disk library for each scan configuration.
+constexpr size_t kScanCount = 1000;
+
+// Number of tracks written to the on-disk library by the scan thread for each concurrency configuration.
+constexpr size_t kConcurrentScanCount = 20000;
+
+// Returns the synthetic file name for the track with the 'index'.
+static std::wstring GetFilename( const size_t index )
+{
+	return L"C:\\Benchmark\\Artist " + std::to_wstring( index / 100 ) + L"\\Album " + std::to_wstring( index / 10 ) + L"\\Track " + std::to_wstring( index ) + L".flac";
+}
+
+// Query used to add a synthetic track to the Media table.
+static const std::string s_AddTrackQuery = "REPLACE INTO Media (Filename,Filetime,Filesize,Duration,SampleRate,BitsPerSample,Channels,Artist,Title,Album,Genre,Year,Track,GainTrack,GainAlbum,Bitrate) "
+	"VALUES (?1,?2,?3,240.0,44100,16,2,?4,?5,?6,'Genre',?7,?8,-6.5,-7.0,900.0);";
+
+// Binds the synthetic track with the 'index' and 'filename' to the add track 'stmt', and steps the statement.
+// Returns true if the track was added.
+static bool AddTrack( sqlite3_stmt* stmt, const size_t index, const std::wstring& filename )
+{
+	sqlite3_bind_text( stmt, 1, WideStringToUTF8( filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+	sqlite3_bind_int64( stmt, 2, 133000000000000000ll + static_cast<long long>( index ) );
+	sqlite3_bind_int64( stmt, 3, 30000000 + static_cast<long long>( index ) );
+	sqlite3_bind_text( stmt, 4, ( "Artist " + std::to_string( index / 100 ) ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+	sqlite3_bind_text( stmt, 5, ( "Track " + std::to_string( index ) ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+	sqlite3_bind_text( stmt, 6, ( "Album " + std::to_string( index / 10 ) ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+	sqlite3_bind_int( stmt, 7, 2000 + static_cast<int>( index % 25 ) );
+	sqlite3_bind_int( stmt, 8, 1 + static_cast<int>( index % 10 ) );
+	const bool added = ( SQLITE_DONE == sqlite3_step( stmt ) );
+	sqlite3_reset( stmt );
+	return added;
+}
+
+// Adds the synthetic tracks to the Media table of the 'database', returning their file names.
+static std::vector<std::wstring> AddTracks( sqlite3* database )
+{
+	std::vector<std::wstring> filenames;
+	sqlite3_exec( database, "BEGIN TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	sqlite3_stmt* stmt = nullptr;
+	if ( SQLITE_OK == sqlite3_prepare_v2( database, s_AddTrackQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		for ( size_t index = 0; index < kTrackCount; index++ ) {
+			const std::wstring filename = GetFilename( index );
+			if ( AddTrack( stmt, index, filename ) ) {
+				filenames.push_back( filename );
+			}
+		}
+		sqlite3_finalize( stmt );
+	}
+	sqlite3_exec( database, "COMMIT TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+	return filenames;
+}
+
+// Returns the number of seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Simulates a library scan of 'count' tracks into the on-disk 'database' (for which a 'library' has been created), using a writer with 'batched' writes.
+// Each track is looked up before it is written, as a library scan would.
+static LibraryBenchmark::ScanResult Scan( Database& database, Library& library, const size_t count, const bool batched )
+{
+	LibraryBenchmark::ScanResult result;
+	result.Batched = batched;
+	Metrics::Reset();
+	LibraryWriter writer( database );
+	writer.SetBatching( batched );
+	const auto start = std::chrono::steady_clock::now();
+	for ( size_t index = 0; index < count; index++ ) {
+		const std::wstring filename = GetFilename( index );
+		MediaInfo mediaInfo( filename );
+		library.GetMediaInfo( mediaInfo, false /*scanMedia*/, false /*sendNotification*/ );
+
+		const auto writeStart = std::chrono::steady_clock::now();
+		{
+			const LibraryWriter::Scope scope( writer );
+			sqlite3_stmt* stmt = nullptr;
+			if ( SQLITE_OK == database.PrepareStatement( s_AddTrackQuery, &stmt ) ) {
+				if ( AddTrack( stmt, index, filename ) ) {
+					++result.Writes;
+				}
+				database.ReleaseStatement( stmt );
+			}
+		}
+		result.MaxWriteMilliseconds = std::max( result.MaxWriteMilliseconds, 1000 * GetElapsedSeconds( writeStart ) );
+	}
+	writer.Flush();
+	result.Seconds = GetElapsedSeconds( start );
+	if ( result.Seconds > 0 ) {
+		result.WritesPerSecond = result.Writes / result.Seconds;
+	}
+	const Metrics::HistogramSnapshot commits = Metrics::GetSnapshot().Histograms[ static_cast<size_t>( Metrics::Histogram::LibraryCommit ) ];
+	result.Commits = static_cast<size_t>( commits.Count );
+	result.MaxCommitMilliseconds = commits.Max / 1000.0;
+	return result;
+}
+
+// Reads from the on-disk 'database' (for which a 'library' has been created) for as long as a library scan of 'count' tracks, using batched writes, runs on another thread.
+// 'readerPool' - whether reads use the reader pool, or share the main connection with the scan.
+static LibraryBenchmark::ConcurrencyResult ReadDuringScan( Database& database, Library& library, const size_t count, const bool readerPool )
+{
+	LibraryBenchmark::ConcurrencyResult result;
+	result.ReaderPool = readerPool;
+	database.SetReaderPoolEnabled( readerPool );
+	std::atomic<bool> scanning = true;
+	std::thread scanThread( [ &database, &library, &result, &scanning, count ] ()
+		{
+			result.Writes = Scan( database, library, count, true /*batched*/ ).Writes;
+			scanning = false;
+		} );
+	double totalSeconds = 0;
+	while ( scanning ) {
+		const auto start = std::chrono::steady_clock::now();
+		const MediaInfo::List mediaList = library.GetMediaByArtist( L"Artist " + std::to_wstring( result.Reads % 100 ) );
+		const double seconds = GetElapsedSeconds( start );
+		totalSeconds += seconds;
+		result.MaxReadMilliseconds = std::max( result.MaxReadMilliseconds, 1000 * seconds );
+		++result.Reads;
+	}
+	scanThread.join();
+	database.SetReaderPoolEnabled( true );
+	if ( result.Reads > 0 ) {
+		result.MeanReadMilliseconds = 1000 * totalSeconds / result.Reads;
+	}
+	return result;
+}
+
+// Removes the on-disk database 'filename', along with any WAL journaling files.
+static void RemoveDatabase( const std::filesystem::path& filename )
+{
+	std::error_code ec;
+	std::filesystem::remove( filename, ec );
+	std::filesystem::remove( filename.wstring() + L"-wal", ec );
+	std::filesystem::remove( filename.wstring() + L"-shm", ec );
+}
+
+LibraryBenchmark::Results LibraryBenchmark::Run()
+{
+	Database database( std::wstring(), Database::Mode::Memory );
+	const Handlers handlers;
+	Results results;
+	{
+		Library library( database, handlers );
+		const std::vector<std::wstring> filenames = AddTracks( database.GetDatabase() );
+		results.Tracks = filenames.size();
+		if ( filenames.empty() ) {
+			return results;
+		}
+
+		// Single row lookups.
+		for ( const bool statementCache : { false, true } ) {
+			database.SetStatementCacheEnabled( statementCache );
+			LookupResult result;
+			result.StatementCache = statementCache;
+			result.Lookups = kLookupCount;
+			const auto start = std::chrono::steady_clock::now();
+			for ( size_t lookup = 0; lookup < kLookupCount; lookup++ ) {
+				MediaInfo mediaInfo( filenames[ lookup % filenames.size() ] );
+				if ( library.GetMediaInfo( mediaInfo, false /*scanMedia*/, false /*sendNotification*/ ) ) {
+					++result.Found;
+				}
+			}
+			result.Seconds = GetElapsedSeconds( start );
+			if ( result.Seconds > 0 ) {
+				result.LookupsPerSecond = result.Lookups / result.Seconds;
+			}
+			results.Lookups.push_back( result );
+		}
+		database.SetStatementCacheEnabled( true );
+
+		// Bulk row extraction.
+		for ( size_t extract = 0; extract < kExtractCount; extract++ ) {
+			const auto start = std::chrono::steady_clock::now();
+			const MediaInfo::List mediaList = library.GetAllMedia();
+			const double seconds = GetElapsedSeconds( start );
+			if ( ( 0 == extract ) || ( seconds < results.ExtractSeconds ) ) {
+				results.ExtractSeconds = seconds;
+			}
+			results.ExtractedRows = mediaList.size();
+		}
+		if ( results.ExtractSeconds > 0 ) {
+			results.ExtractRowsPerSecond = results.ExtractedRows / results.ExtractSeconds;
+		}
+	}
+
+	// Library scans into an on-disk library, without & with batched writes.
+	// (Note that the in-memory database remains open, as it owns the database logging callback.)
+	const std::filesystem::path filename = std::filesystem::temp_directory_path() / L"VUPlayerBenchmark.db";
+	for ( const bool batched : { false, true } ) {
+		RemoveDatabase( filename );
+		{
+			Database diskDatabase( filename.wstring(), Database::Mode::Disk );
+			Library library( diskDatabase, handlers );
+			results.Scans.push_back( Scan( diskDatabase, library, kScanCount, batched ) );
+		}
+		RemoveDatabase( filename );
+	}
+
+	// Reads during a library scan into an on-disk library, without & with the reader pool.
+	for ( const bool readerPool : { false, true } ) {
+		RemoveDatabase( filename );
+		{
+			Database diskDatabase( filename.wstring(), Database::Mode::Disk );
+			Library library( diskDatabase, handlers );
+			results.Concurrency.push_back( ReadDuringScan( diskDatabase, library, kConcurrentScanCount, readerPool ) );
+		}
+		RemoveDatabase( filename );
+	}
+	return results;
+}
+
+bool LibraryBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "tracks" ] = results.Tracks;
+
+		nlohmann::json lookups = nlohmann::json::array();
+		for ( const auto& result : results.Lookups ) {
+			nlohmann::json lookup;
+			lookup[ "statementCache" ] = result.StatementCache;
+			lookup[ "lookups" ] = result.Lookups;
+			lookup[ "found" ] = result.Found;
+			lookup[ "seconds" ] = result.Seconds;
+			lookup[ "lookupsPerSecond" ] = result.LookupsPerSecond;
+			lookups.push_back( lookup );
+		}
+		doc[ "getMediaInfo" ] = lookups;
+
+		doc[ "getAllMedia" ] = {
+			{ "rows", results.ExtractedRows },
+			{ "seconds", results.ExtractSeconds },
+			{ "rowsPerSecond", results.ExtractRowsPerSecond }
+		};
+
+		nlohmann::json scans = nlohmann::json::array();
+		for ( const auto& result : results.Scans ) {
+			nlohmann::json scan;
+			scan[ "batched" ] = result.Batched;
+			scan[ "writes" ] = result.Writes;
+			scan[ "seconds" ] = result.Seconds;
+			scan[ "writesPerSecond" ] = result.WritesPerSecond;
+			scan[ "maxWriteMilliseconds" ] = result.MaxWriteMilliseconds;
+			scan[ "commits" ] = result.Commits;
+			scan[ "maxCommitMilliseconds" ] = result.MaxCommitMilliseconds;
+			scans.push_back( scan );
+		}
+		doc[ "scan" ] = scans;
+
+		nlohmann::json concurrency = nlohmann::json::array();
+		for ( const auto& result : results.Concurrency ) {
+			nlohmann::json entry;
+			entry[ "readerPool" ] = result.ReaderPool;
+			entry[ "writes" ] = result.Writes;
+			entry[ "reads" ] = result.Reads;
+			entry[ "meanReadMilliseconds" ] = result.MeanReadMilliseconds;
+			entry[ "maxReadMilliseconds" ] = result.MaxReadMilliseconds;
+			concurrency.push_back( entry );
+		}
+		doc[ "readDuringScan" ] = concurrency;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good();
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <vector>
+
+// Measures the performance of media library lookups, using a synthetic in-memory library, and of media library writes during a simulated scan,
+// and of reads concurrent with a simulated scan, using a temporary on-disk library.
+// The benchmark is run headless using the '-librarybenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class LibraryBenchmark
+{
+public:
+	// Media information lookup results for a single configuration.
+	struct LookupResult {
+		bool StatementCache = false;            // Whether the statement cache was enabled.
+		size_t Lookups = 0;                     // Number of media information lookups.
+		size_t Found = 0;                       // Number of lookups which found the media information.
+		double Seconds = 0;                     // Wall clock time for all lookups, in seconds.
+		double LookupsPerSecond = 0;            // Lookup throughput.
+	};
+
+	// Library scan results for a single configuration.
+	struct ScanResult {
+		bool Batched = false;                   // Whether writes were batched into transactions.
+		size_t Writes = 0;                      // Number of media library writes.
+		double Seconds = 0;                     // Wall clock time for the scan, in seconds.
+		double WritesPerSecond = 0;             // Write throughput.
+		double MaxWriteMilliseconds = 0;        // Worst case time for a single write (including any commit), in milliseconds.
+		size_t Commits = 0;                     // Number of batched commits.
+		double MaxCommitMilliseconds = 0;       // Worst case time for a batched commit, in milliseconds.
+	};
+
+	// Results of reads concurrent with a library scan, for a single configuration.
+	struct ConcurrencyResult {
+		bool ReaderPool = false;                // Whether reads used the reader pool.
+		size_t Writes = 0;                      // Number of media library writes by the scan.
+		size_t Reads = 0;                       // Number of reads (of all the tracks by an artist) completed during the scan.
+		double MeanReadMilliseconds = 0;        // Mean time for a read, in milliseconds.
+		double MaxReadMilliseconds = 0;         // Worst case time for a read, in milliseconds.
+	};
+
+	// Benchmark results.
+	struct Results {
+		size_t Tracks = 0;                      // Number of tracks in the synthetic library.
+		std::vector<LookupResult> Lookups;      // Media information lookup results, without & with the statement cache.
+		size_t ExtractedRows = 0;               // Number of rows extracted when getting all media.
+		double ExtractSeconds = 0;              // Wall clock time to get all media, in seconds.
+		double ExtractRowsPerSecond = 0;        // Row extraction throughput when getting all media.
+		std::vector<ScanResult> Scans;          // Library scan results, without & with batched writes.
+		std::vector<ConcurrencyResult> Concurrency; // Results of reads during a library scan, without & with the reader pool.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
@@ -3,6 +3,27 @@
 #include "Utility.h"
 #include "VUPlayer.h"
 
+#include <chrono>
+#include <thread>
+
+// Number of folder scanning threads for each local drive.
+constexpr size_t kLocalDriveThreads = 4;
+
+// Number of folder scanning threads for each network drive (where folder enumeration latency is higher).
+constexpr size_t kRemoteDriveThreads = 8;
+
+// Number of update threads.
+constexpr size_t kUpdateThreads = 4;
+
+// Maximum number of files waiting to be updated, before the folder scan waits for the update threads.
+constexpr size_t kMaxQueuedFiles = 4096;
+
+// Minimum interval between status updates.
+constexpr std::chrono::milliseconds kStatusInterval( 100 );
+
+// Interval at which waiting threads check the stop event.
+constexpr std::chrono::milliseconds kStopPollInterval( 100 );
+
 DWORD WINAPI LibraryMaintainer::MaintainerThreadProc( LPVOID lpParam )
 {
 	LibraryMaintainer* maintainer = static_cast<LibraryMaintainer*>( lpParam );
@@ -25,7 +46,21 @@ LibraryMaintainer::LibraryMaintainer( const HINSTANCE instance, Library& library
 	m_StatusUpdatingLibrary(),
 	m_ScanHiddenFolders( false ),
 	m_FileAddedCallback( nullptr ),
-	m_FinishedCallback( nullptr )
+	m_FinishedCallback( nullptr ),
+	m_QueueMutex(),
+	m_QueueNotEmpty(),
+	m_QueueNotFull(),
+	m_Queue(),
+	m_QueueClosed( false ),
+	m_FoundFilesMutex(),
+	m_FoundFiles(),
+	m_ExistingFiles(),
+	m_RemovedFilesMutex(),
+	m_RemovedFiles(),
+	m_ScanFinished( false ),
+	m_FilesQueued( 0 ),
+	m_FilesUpdated( 0 ),
+	m_LastStatusTime( 0 )
 {
 	const int bufSize = 64;
 	WCHAR buf[ bufSize ] = {};
@@ -90,65 +125,168 @@ void LibraryMaintainer::SetStatus( const std::wstring& status )
 	m_Status = status;
 }
 
-void LibraryMaintainer::Handler()
+bool LibraryMaintainer::IsStopped() const
 {
-	std::set<std::filesystem::path> allFiles;
+	return WAIT_OBJECT_0 == WaitForSingleObject( m_StopEvent, 0 );
+}
 
-	// Scan all drives for supported file types.
+void LibraryMaintainer::Handler()
+{
 	std::wstring initialStatus = m_StatusScanningComputer;
 	WideStringReplace( initialStatus, L"%", std::to_wstring( 0 ) );
 	SetStatus( initialStatus );
-	const auto drives = GetRootDrives();
-	for ( const auto& drive : drives ) {
-		ScanFolder( drive, allFiles );
-	}
-
-	if ( WAIT_OBJECT_0 != WaitForSingleObject( m_StopEvent, 0 ) ) {
-		// Make a note of existing library files (excluding streams), and merge in any that were not found in the folder scan.
-		std::set<std::filesystem::path> existingFiles;
-		const auto allMedia = m_Library.GetAllMedia();
-		for ( const auto& mediaInfo : allMedia ) {
-			if ( const auto& filename = mediaInfo.GetFilename(); !IsURL( filename ) ) {
-				existingFiles.insert( mediaInfo.GetFilename() );
-				allFiles.insert( filename );
-			}
+
+	m_Queue.clear();
+	m_QueueClosed = false;
+	m_FoundFiles.clear();
+	m_ExistingFiles.clear();
+	m_RemovedFiles.clear();
+	m_ScanFinished = false;
+	m_FilesQueued = 0;
+	m_FilesUpdated = 0;
+	m_LastStatusTime = 0;
+
+	// Make a note of existing library files (excluding streams).
+	const auto allMedia = m_Library.GetAllMedia();
+	for ( const auto& mediaInfo : allMedia ) {
+		if ( const auto& filename = mediaInfo.GetFilename(); !IsURL( filename ) ) {
+			m_ExistingFiles.insert( filename );
 		}
+	}
 
-		// Make a note of all files that are removed from the library.
-		MediaInfo::List removedFiles;
-
-		// Refresh library information for all the files.
-		if ( WAIT_OBJECT_0 != WaitForSingleObject( m_StopEvent, 0 ) ) {
-			size_t current = 0;
-			size_t total = allFiles.size();
-			for ( auto path = allFiles.begin(); ( WAIT_OBJECT_0 != WaitForSingleObject( m_StopEvent, 0 ) ) && ( allFiles.end() != path ); ++path ) {
-				std::wstring status = m_StatusUpdatingLibrary;
-				WideStringReplace( status, L"%1", std::to_wstring( ++current ) );
-				WideStringReplace( status, L"%2", std::to_wstring( total ) );
-				status += L" - " + TruncatePath( *path );
-				SetStatus( status );
-
-				MediaInfo mediaInfo( *path );
-				if ( m_Library.GetMediaInfo( mediaInfo, true /*scanMedia*/, true /*sendNotification*/, true /*removeMissing*/ ) ) {
-					if ( ( nullptr != m_FileAddedCallback ) && ( existingFiles.end() == existingFiles.find( *path ) ) ) {
-						m_FileAddedCallback( *path );
-					}
-				} else {
-					removedFiles.push_back( mediaInfo );
-				}
-			}
-			if ( nullptr != m_FinishedCallback ) {
-				m_FinishedCallback( removedFiles );
-			}
+	// Start the update threads, which refresh library information for files as they are found.
+	std::vector<std::thread> updateThreads;
+	for ( size_t index = 0; index < kUpdateThreads; index++ ) {
+		updateThreads.emplace_back( &LibraryMaintainer::UpdateHandler, this );
+	}
+
+	// Scan all drives for supported file types.
+	FolderScanner scanner(
+		[ this ] ( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<FolderScanner::File>& files ) {
+			EnumerateFolder( folder, folders, files );
+		},
+		[ this ] () {
+			return IsStopped();
+		} );
+	scanner.Scan( GetRootDrives(), [ this ] ( FolderScanner::File&& file ) { OnFileFound( std::move( file ) ); } );
+	m_ScanFinished = true;
+
+	// Queue any existing library files that were not found in the folder scan (which are removed from the library if they are no longer available).
+	for ( auto file = m_ExistingFiles.begin(); !IsStopped() && ( m_ExistingFiles.end() != file ); ++file ) {
+		if ( m_FoundFiles.end() == m_FoundFiles.find( *file ) ) {
+			QueueFile( { *file, std::nullopt } );
 		}
 	}
 
+	// Wait for the update threads to finish.
+	{
+		std::lock_guard<std::mutex> lock( m_QueueMutex );
+		m_QueueClosed = true;
+	}
+	m_QueueNotEmpty.notify_all();
+	for ( auto& thread : updateThreads ) {
+		thread.join();
+	}
+
+	m_Library.Flush();
+	if ( nullptr != m_FinishedCallback ) {
+		m_FinishedCallback( m_RemovedFiles );
+	}
+
 	SetStatus( {} );
 }
 
-std::set<std::wstring> LibraryMaintainer::GetRootDrives()
+void LibraryMaintainer::OnFileFound( FolderScanner::File&& file )
 {
-	std::set<std::wstring> drives;
+	{
+		std::lock_guard<std::mutex> lock( m_FoundFilesMutex );
+		if ( !m_FoundFiles.insert( file.Path ).second ) {
+			return;
+		}
+	}
+	UpdateProgress( file.Path );
+	QueueFile( { std::move( file.Path ), Library::FileInfo{ file.Filetime, file.Filesize } } );
+}
+
+void LibraryMaintainer::UpdateHandler()
+{
+	CoInitializeEx( NULL /*reserved*/, COINIT_APARTMENTTHREADED );
+	SetThreadPriority( GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN );
+
+	PendingFile file;
+	while ( TakeFile( file ) ) {
+		MediaInfo mediaInfo( file.Path );
+		if ( m_Library.GetMediaInfo( mediaInfo, true /*scanMedia*/, true /*sendNotification*/, true /*removeMissing*/, file.FileInfo ) ) {
+			if ( ( nullptr != m_FileAddedCallback ) && ( m_ExistingFiles.end() == m_ExistingFiles.find( file.Path ) ) ) {
+				m_FileAddedCallback( file.Path );
+			}
+		} else {
+			std::lock_guard<std::mutex> lock( m_RemovedFilesMutex );
+			m_RemovedFiles.push_back( mediaInfo );
+		}
+		++m_FilesUpdated;
+		UpdateProgress( file.Path );
+	}
+
+	SetThreadPriority( GetCurrentThread(), THREAD_MODE_BACKGROUND_END );
+	CoUninitialize();
+}
+
+bool LibraryMaintainer::QueueFile( PendingFile&& file )
+{
+	std::unique_lock<std::mutex> lock( m_QueueMutex );
+	while ( ( m_Queue.size() >= kMaxQueuedFiles ) && !IsStopped() ) {
+		m_QueueNotFull.wait_for( lock, kStopPollInterval );
+	}
+	if ( IsStopped() ) {
+		return false;
+	}
+	m_Queue.push_back( std::move( file ) );
+	++m_FilesQueued;
+	lock.unlock();
+	m_QueueNotEmpty.notify_one();
+	return true;
+}
+
+bool LibraryMaintainer::TakeFile( PendingFile& file )
+{
+	std::unique_lock<std::mutex> lock( m_QueueMutex );
+	while ( m_Queue.empty() && !m_QueueClosed && !IsStopped() ) {
+		m_QueueNotEmpty.wait_for( lock, kStopPollInterval );
+	}
+	if ( m_Queue.empty() || IsStopped() ) {
+		return false;
+	}
+	file = std::move( m_Queue.front() );
+	m_Queue.pop_front();
+	lock.unlock();
+	m_QueueNotFull.notify_one();
+	return true;
+}
+
+void LibraryMaintainer::UpdateProgress( const std::filesystem::path& path )
+{
+	const long long now = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	long long lastStatusTime = m_LastStatusTime;
+	if ( ( ( now - lastStatusTime ) >= kStatusInterval.count() ) && m_LastStatusTime.compare_exchange_strong( lastStatusTime, now ) ) {
+		std::wstring status;
+		if ( m_ScanFinished ) {
+			status = m_StatusUpdatingLibrary;
+			WideStringReplace( status, L"%1", std::to_wstring( m_FilesUpdated ) );
+			WideStringReplace( status, L"%2", std::to_wstring( m_FilesQueued ) );
+			status += L" - " + TruncatePath( path );
+		} else {
+			status = m_StatusScanningComputer;
+			WideStringReplace( status, L"%", std::to_wstring( m_FilesQueued ) );
+			status += L" " + TruncatePath( path );
+		}
+		SetStatus( status );
+	}
+}
+
+std::vector<FolderScanner::Volume> LibraryMaintainer::GetRootDrives()
+{
+	std::vector<FolderScanner::Volume> drives;
 	const DWORD bufferLength = GetLogicalDriveStrings( 0 /*bufferLength*/, nullptr /*buffer*/ );
 	if ( bufferLength > 0 ) {
 		std::vector<WCHAR> buffer( static_cast<size_t>( bufferLength ) );
@@ -157,8 +295,10 @@ std::set<std::wstring> LibraryMaintainer::GetRootDrives()
 			size_t stringLength = wcslen( driveString );
 			while ( stringLength > 0 ) {
 				const UINT driveType = GetDriveType( driveString );
-				if ( ( DRIVE_FIXED == driveType ) || ( DRIVE_REMOVABLE == driveType ) || ( DRIVE_REMOTE == driveType ) ) {
-					drives.insert( driveString );
+				if ( ( DRIVE_FIXED == driveType ) || ( DRIVE_REMOVABLE == driveType ) ) {
+					drives.push_back( { driveString, kLocalDriveThreads } );
+				} else if ( DRIVE_REMOTE == driveType ) {
+					drives.push_back( { driveString, kRemoteDriveThreads } );
 				}
 				driveString += stringLength + 1;
 				stringLength = wcslen( driveString );
@@ -168,33 +308,30 @@ std::set<std::wstring> LibraryMaintainer::GetRootDrives()
 	return drives;
 }
 
-void LibraryMaintainer::ScanFolder( const std::filesystem::path& folder, std::set<std::filesystem::path>& mediaFiles )
+void LibraryMaintainer::EnumerateFolder( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<FolderScanner::File>& files )
 {
 	const FINDEX_INFO_LEVELS levels = FindExInfoBasic;
 	const FINDEX_SEARCH_OPS searchOp = FindExSearchNameMatch;
 	const DWORD flags = FIND_FIRST_EX_LARGE_FETCH;
 	WIN32_FIND_DATA findData = {};
-	std::filesystem::path path = folder / L"*.*";
+	const std::filesystem::path path = folder / L"*.*";
 	const HANDLE handle = FindFirstFileEx( path.c_str(), levels, &findData, searchOp, nullptr /*filter*/, flags );
 	if ( INVALID_HANDLE_VALUE != handle ) {
 		BOOL found = TRUE;
-		while ( found && ( WAIT_OBJECT_0 != WaitForSingleObject( m_StopEvent, 0 ) ) ) {
+		while ( found && !IsStopped() ) {
 			if ( !( findData.dwFileAttributes & FILE_ATTRIBUTE_SYSTEM ) ) {
 				if ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) {
 					if ( !( findData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN ) || m_ScanHiddenFolders ) {
 						if ( ( findData.cFileName[ 0 ] != '.' ) ) {
-							path = folder / findData.cFileName;
-							ScanFolder( path, mediaFiles );
+							folders.push_back( folder / findData.cFileName );
 						}
 					}
 				} else if ( IsSupportedFileType( findData.cFileName ) ) {
-					path = folder / findData.cFileName;
-					mediaFiles.insert( path );
-
-					std::wstring status = m_StatusScanningComputer;
-					WideStringReplace( status, L"%", std::to_wstring( mediaFiles.size() ) );
-					status += L" " + TruncatePath( path );
-					SetStatus( status );
+					// Use the file modification time & size from the enumeration, rather than opening each file to check whether the library entry is stale.
+					FolderScanner::File& file = files.emplace_back();
+					file.Path = folder / findData.cFileName;
+					file.Filetime = ( static_cast<long long>( findData.ftLastWriteTime.dwHighDateTime ) << 32 ) + findData.ftLastWriteTime.dwLowDateTime;
+					file.Filesize = ( static_cast<long long>( findData.nFileSizeHigh ) << 32 ) + findData.nFileSizeLow;
 				}
 			}
 			found = FindNextFile( handle, &findData );
@@ -1,11 +1,19 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <set>
 
+#include "FolderScanner.h"
 #include "Library.h"
 
 // Library maintainer.
+// Folders are scanned in parallel (with a bounded number of threads for each drive), and files are queued as they are found for a pool of update threads.
+// The update threads refresh library information for each file, using the file modification time & size from the folder scan, and library writes are batched by the library writer.
 class LibraryMaintainer
 {
 public:
@@ -48,11 +56,37 @@ private:
 	// Maintenance thread handler.
 	void Handler();
 
-	// Returns the root drive names.
-	std::set<std::wstring> GetRootDrives();
+	// A file waiting to be updated.
+	struct PendingFile {
+		std::filesystem::path Path;                     // File path.
+		std::optional<Library::FileInfo> FileInfo;      // File modification time & size, if known from the folder scan.
+	};
 
-	// Recursively scans the 'folder' and adds any supported file types to 'mediaFiles'.
-	void ScanFolder( const std::filesystem::path& folder, std::set<std::filesystem::path>& mediaFiles );
+	// Returns the root drives to scan.
+	std::vector<FolderScanner::Volume> GetRootDrives();
+
+	// Enumerates a 'folder', adding any subfolders to scan to 'folders', and any supported file types to 'files'.
+	void EnumerateFolder( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<FolderScanner::File>& files );
+
+	// Called by the folder scanner for each 'file' found.
+	void OnFileFound( FolderScanner::File&& file );
+
+	// Update thread handler.
+	void UpdateHandler();
+
+	// Adds a 'file' to the update queue, waiting while the queue is full.
+	// Returns false if maintenance was stopped before the file could be queued.
+	bool QueueFile( PendingFile&& file );
+
+	// Takes the next 'file' from the update queue, waiting while the queue is empty.
+	// Returns false if maintenance was stopped, or if there are no more files to update.
+	bool TakeFile( PendingFile& file );
+
+	// Returns whether maintenance has been stopped.
+	bool IsStopped() const;
+
+	// Updates the current status, showing the 'path' of the file being processed (the status is updated at most once per status interval).
+	void UpdateProgress( const std::filesystem::path& path );
 
 	// Returns whether the 'filename' is a supported media file type.
 	bool IsSupportedFileType( const std::wstring& filename ) const;
@@ -92,4 +126,46 @@ private:
 
 	// A callback for when library maintenance has finished.
 	FinishedCallback m_FinishedCallback;
+
+	// Update queue mutex.
+	std::mutex m_QueueMutex;
+
+	// Signalled when a file is added to the update queue, or when no more files will be queued.
+	std::condition_variable m_QueueNotEmpty;
+
+	// Signalled when a file is taken from the update queue.
+	std::condition_variable m_QueueNotFull;
+
+	// Files waiting to be updated.
+	std::deque<PendingFile> m_Queue;
+
+	// Whether no more files will be added to the update queue.
+	bool m_QueueClosed;
+
+	// Found files mutex.
+	std::mutex m_FoundFilesMutex;
+
+	// All supported files found by the folder scan.
+	std::set<std::filesystem::path> m_FoundFiles;
+
+	// Existing library files (excluding streams), which are not modified once the folder scan has started.
+	std::set<std::filesystem::path> m_ExistingFiles;
+
+	// Removed files mutex.
+	std::mutex m_RemovedFilesMutex;
+
+	// All files that have been removed from the library.
+	MediaInfo::List m_RemovedFiles;
+
+	// Whether the folder scan has finished.
+	std::atomic<bool> m_ScanFinished;
+
+	// Number of files added to the update queue.
+	std::atomic<size_t> m_FilesQueued;
+
+	// Number of files updated.
+	std::atomic<size_t> m_FilesUpdated;
+
+	// The time at which the status was last updated, in milliseconds.
+	std::atomic<long long> m_LastStatusTime;
 };
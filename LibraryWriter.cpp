@@ -0,0 +1,119 @@
+#include "LibraryWriter.h"
+
+#include "Metrics.h"
+
+LibraryWriter::Scope::Scope( LibraryWriter& writer ) :
+	m_Writer( writer )
+{
+	m_Writer.BeginWrite();
+}
+
+LibraryWriter::Scope::~Scope()
+{
+	m_Writer.EndWrite();
+}
+
+LibraryWriter::LibraryWriter( Database& database ) :
+	m_Database( database ),
+	m_Mutex( database.GetWriteMutex() )
+{
+	m_Thread = std::thread( &LibraryWriter::Run, this );
+}
+
+LibraryWriter::~LibraryWriter()
+{
+	{
+		std::lock_guard<std::recursive_mutex> lock( m_Mutex );
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+	if ( m_Thread.joinable() ) {
+		m_Thread.join();
+	}
+	Flush();
+}
+
+void LibraryWriter::BeginWrite()
+{
+	m_Mutex.lock();
+	if ( ( 0 == m_Depth++ ) && m_Batched && !m_Database.IsWriteScopeActive() ) {
+		// If a transaction has been started elsewhere on the connection, the write just becomes part of that transaction.
+		// Conversely, a transaction opened by the writer might have been ended elsewhere on the connection.
+		if ( sqlite3* database = m_Database.GetDatabase(); ( nullptr != database ) && ( 0 != sqlite3_get_autocommit( database ) ) ) {
+			m_TransactionOpen = false;
+			if ( SQLITE_OK == sqlite3_exec( database, "BEGIN TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ ) ) {
+				m_TransactionOpen = true;
+				m_TransactionStart = std::chrono::steady_clock::now();
+				m_PendingWrites = 0;
+				m_Condition.notify_all();
+			}
+		}
+	}
+}
+
+void LibraryWriter::EndWrite()
+{
+	if ( ( 0 == --m_Depth ) && m_TransactionOpen ) {
+		if ( ++m_PendingWrites >= kMaxBatchWrites ) {
+			Commit();
+		}
+	}
+	m_Mutex.unlock();
+}
+
+void LibraryWriter::Flush()
+{
+	std::lock_guard<std::recursive_mutex> lock( m_Mutex );
+	if ( 0 == m_Depth ) {
+		Commit();
+	}
+}
+
+void LibraryWriter::SetBatching( const bool batched )
+{
+	std::lock_guard<std::recursive_mutex> lock( m_Mutex );
+	m_Batched = batched;
+	if ( !m_Batched && ( 0 == m_Depth ) ) {
+		Commit();
+	}
+}
+
+bool LibraryWriter::IsTransactionOpen() const
+{
+	return m_TransactionOpen;
+}
+
+void LibraryWriter::Commit()
+{
+	if ( m_TransactionOpen ) {
+		sqlite3* database = m_Database.GetDatabase();
+		if ( ( nullptr != database ) && ( 0 == sqlite3_get_autocommit( database ) ) ) {
+			const Metrics::Timer timer( Metrics::Histogram::LibraryCommit );
+			if ( SQLITE_BUSY == sqlite3_exec( database, "COMMIT TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ ) ) {
+				// Another statement on the connection is still writing, so try again later.
+				m_TransactionStart = std::chrono::steady_clock::now();
+				return;
+			}
+		}
+		// If the connection is already in autocommit mode, the transaction has been ended elsewhere on the connection.
+		m_TransactionOpen = false;
+		m_PendingWrites = 0;
+	}
+}
+
+void LibraryWriter::Run()
+{
+	std::unique_lock<std::recursive_mutex> lock( m_Mutex );
+	while ( !m_Stop ) {
+		if ( m_TransactionOpen ) {
+			const auto deadline = m_TransactionStart + kMaxBatchTime;
+			if ( std::chrono::steady_clock::now() >= deadline ) {
+				Commit();
+			} else {
+				m_Condition.wait_until( lock, deadline );
+			}
+		} else {
+			m_Condition.wait( lock );
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "Database.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Group commit writer for media library updates.
+// Writes are applied on the calling thread, so that they are immediately visible to all reads on the shared database connection,
+// but are grouped into transactions which are committed once they hold a maximum number of writes, or have been open for a maximum time.
+// This avoids a journal sync for every track when scanning a large collection.
+// Writes are serialised with other writes on the main connection using the database write mutex, and other writers use a Database::WriteScope
+// so that their writes (and transactions) are committed independently of the current batch.
+class LibraryWriter
+{
+public:
+	// Maximum number of writes in each transaction.
+	static constexpr size_t kMaxBatchWrites = 500;
+
+	// Maximum time for which a transaction is left open before it is committed.
+	static constexpr std::chrono::milliseconds kMaxBatchTime = std::chrono::milliseconds( 250 );
+
+	// A single write to the media library, which is added to the current transaction for as long as the scope exists.
+	// Scopes can be nested, in which case the outermost scope counts as the single write.
+	class Scope
+	{
+	public:
+		// 'writer' - library writer.
+		Scope( LibraryWriter& writer );
+
+		virtual ~Scope();
+
+	private:
+		// Library writer.
+		LibraryWriter& m_Writer;
+	};
+
+	// 'database' - media library database.
+	LibraryWriter( Database& database );
+
+	virtual ~LibraryWriter();
+
+	// Commits any pending writes, so that they are durable when this call returns.
+	void Flush();
+
+	// Sets whether writes are 'batched' (if not, each write is committed on its own).
+	void SetBatching( const bool batched );
+
+	// Returns whether the writer has a transaction open, the writes in which are not yet visible to other database connections.
+	bool IsTransactionOpen() const;
+
+private:
+	// Begins a write.
+	void BeginWrite();
+
+	// Ends a write.
+	void EndWrite();
+
+	// Commits the current transaction, if there is one (the mutex must be held).
+	void Commit();
+
+	// Commits transactions which have been open for the maximum time.
+	void Run();
+
+	// Media library database.
+	Database& m_Database;
+
+	// Protects the transaction state (this is the database write mutex, which is recursive to allow for nested scopes).
+	std::recursive_mutex& m_Mutex;
+
+	// Signalled when a transaction is opened, or the commit thread should stop.
+	std::condition_variable_any m_Condition;
+
+	// Commit thread.
+	std::thread m_Thread;
+
+	// Nesting depth of the current write scope.
+	size_t m_Depth = 0;
+
+	// Whether the writer has a transaction open (set before any write is made in a transaction, and cleared once it has been committed).
+	std::atomic_bool m_TransactionOpen = false;
+
+	// Time at which the current transaction was opened.
+	std::chrono::steady_clock::time_point m_TransactionStart;
+
+	// Number of writes in the current transaction.
+	size_t m_PendingWrites = 0;
+
+	// Whether writes are batched.
+	bool m_Batched = true;
+
+	// Indicates whether the commit thread should stop.
+	bool m_Stop = false;
+};
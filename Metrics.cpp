@@ -0,0 +1,224 @@
+#include "Metrics.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+
+// Metrics file format version.
+constexpr int kMetricsVersion = 1;
+
+// Counter names.
+static const std::array<const char*, Metrics::kCounterCount> s_CounterNames = {
+	"callbacks",
+	"lateCallbacks",
+	"shortCallbacks",
+	"preBufferUnderruns",
+	"sniffHits",
+	"sniffMisses",
+	"sniffCacheHits",
+	"sniffFallbacks"
+};
+
+// Histogram names.
+static const std::array<const char*, Metrics::kHistogramCount> s_HistogramNames = {
+	"callbackDuration",
+	"decoderOpen",
+	"crossfadeCalculation",
+	"gainCalculation",
+	"resamplerLatency",
+	"libraryCommit"
+};
+
+// Percentiles included when writing histograms.
+static const std::array<double, 3> s_Percentiles = { 50, 90, 99 };
+
+std::array<std::atomic<uint64_t>, Metrics::kCounterCount> Metrics::s_Counters = {};
+std::array<Metrics::HistogramValues, Metrics::kHistogramCount> Metrics::s_Histograms = {};
+std::atomic<std::chrono::steady_clock::rep> Metrics::s_StartTime = std::chrono::steady_clock::now().time_since_epoch().count();
+std::map<std::string, double> Metrics::s_Gauges;
+std::mutex Metrics::s_GaugeMutex;
+
+// Returns the histogram bucket for a 'value'.
+static size_t GetBucket( const uint64_t value )
+{
+	return std::min<size_t>( std::bit_width( value ), Metrics::kHistogramBuckets - 1 );
+}
+
+uint64_t Metrics::HistogramSnapshot::GetPercentile( const double percentile ) const
+{
+	if ( 0 == Count ) {
+		return 0;
+	}
+	const uint64_t target = std::clamp<uint64_t>( static_cast<uint64_t>( std::ceil( Count * percentile / 100 ) ), 1, Count );
+	uint64_t cumulative = 0;
+	for ( size_t bucket = 0; bucket < ( kHistogramBuckets - 1 ); bucket++ ) {
+		cumulative += Buckets[ bucket ];
+		if ( cumulative >= target ) {
+			return std::min( uint64_t( 1 ) << bucket, Max );
+		}
+	}
+	return Max;
+}
+
+void Metrics::Increment( const Counter counter, const uint64_t count )
+{
+	s_Counters[ static_cast<size_t>( counter ) ].fetch_add( count, std::memory_order_relaxed );
+}
+
+void Metrics::Record( const Histogram histogram, const uint64_t value )
+{
+	HistogramValues& values = s_Histograms[ static_cast<size_t>( histogram ) ];
+	values.Total.fetch_add( value, std::memory_order_relaxed );
+	values.Buckets[ GetBucket( value ) ].fetch_add( 1, std::memory_order_relaxed );
+	uint64_t max = values.Max.load( std::memory_order_relaxed );
+	while ( ( value > max ) && !values.Max.compare_exchange_weak( max, value, std::memory_order_relaxed ) ) {}
+}
+
+void Metrics::SetGauge( const std::string& name, const double value )
+{
+	std::lock_guard<std::mutex> lock( s_GaugeMutex );
+	s_Gauges[ name ] = value;
+}
+
+void Metrics::RemoveGauges( const std::string& prefix )
+{
+	std::lock_guard<std::mutex> lock( s_GaugeMutex );
+	auto gauge = s_Gauges.lower_bound( prefix );
+	while ( ( s_Gauges.end() != gauge ) && gauge->first.starts_with( prefix ) ) {
+		gauge = s_Gauges.erase( gauge );
+	}
+}
+
+Metrics::Snapshot Metrics::GetSnapshot()
+{
+	Snapshot snapshot;
+	const auto startTime = std::chrono::steady_clock::time_point( std::chrono::steady_clock::duration( s_StartTime.load() ) );
+	snapshot.UptimeSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+	for ( size_t counter = 0; counter < kCounterCount; counter++ ) {
+		snapshot.Counters[ counter ] = s_Counters[ counter ].load( std::memory_order_relaxed );
+	}
+	for ( size_t histogram = 0; histogram < kHistogramCount; histogram++ ) {
+		const HistogramValues& values = s_Histograms[ histogram ];
+		HistogramSnapshot& histogramSnapshot = snapshot.Histograms[ histogram ];
+		for ( size_t bucket = 0; bucket < kHistogramBuckets; bucket++ ) {
+			histogramSnapshot.Buckets[ bucket ] = values.Buckets[ bucket ].load( std::memory_order_relaxed );
+			histogramSnapshot.Count += histogramSnapshot.Buckets[ bucket ];
+		}
+		histogramSnapshot.Total = values.Total.load( std::memory_order_relaxed );
+		histogramSnapshot.Max = values.Max.load( std::memory_order_relaxed );
+	}
+	std::lock_guard<std::mutex> lock( s_GaugeMutex );
+	snapshot.Gauges = s_Gauges;
+	return snapshot;
+}
+
+void Metrics::Reset()
+{
+	for ( auto& counter : s_Counters ) {
+		counter.store( 0, std::memory_order_relaxed );
+	}
+	for ( auto& values : s_Histograms ) {
+		values.Total.store( 0, std::memory_order_relaxed );
+		values.Max.store( 0, std::memory_order_relaxed );
+		for ( auto& bucket : values.Buckets ) {
+			bucket.store( 0, std::memory_order_relaxed );
+		}
+	}
+	s_StartTime = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+const char* Metrics::GetName( const Counter counter )
+{
+	return s_CounterNames[ static_cast<size_t>( counter ) ];
+}
+
+const char* Metrics::GetName( const Histogram histogram )
+{
+	return s_HistogramNames[ static_cast<size_t>( histogram ) ];
+}
+
+bool Metrics::WriteJSON( const std::filesystem::path& filename )
+{
+	const Snapshot snapshot = GetSnapshot();
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kMetricsVersion;
+		doc[ "uptimeSeconds" ] = snapshot.UptimeSeconds;
+
+		nlohmann::json counters = nlohmann::json::object();
+		for ( size_t counter = 0; counter < kCounterCount; counter++ ) {
+			counters[ s_CounterNames[ counter ] ] = snapshot.Counters[ counter ];
+		}
+		doc[ "counters" ] = counters;
+
+		nlohmann::json histograms = nlohmann::json::object();
+		for ( size_t histogram = 0; histogram < kHistogramCount; histogram++ ) {
+			const HistogramSnapshot& values = snapshot.Histograms[ histogram ];
+			nlohmann::json entry;
+			entry[ "count" ] = values.Count;
+			entry[ "meanMicroseconds" ] = ( values.Count > 0 ) ? static_cast<double>( values.Total ) / values.Count : 0;
+			entry[ "maxMicroseconds" ] = values.Max;
+			for ( const auto percentile : s_Percentiles ) {
+				entry[ "p" + std::to_string( std::lround( percentile ) ) + "Microseconds" ] = values.GetPercentile( percentile );
+			}
+			nlohmann::json buckets = nlohmann::json::array();
+			for ( size_t bucket = 0; bucket < kHistogramBuckets; bucket++ ) {
+				if ( values.Buckets[ bucket ] > 0 ) {
+					buckets.push_back( { { "upperMicroseconds", uint64_t( 1 ) << bucket }, { "count", values.Buckets[ bucket ] } } );
+				}
+			}
+			entry[ "buckets" ] = buckets;
+			histograms[ s_HistogramNames[ histogram ] ] = entry;
+		}
+		doc[ "histograms" ] = histograms;
+
+		nlohmann::json gauges = nlohmann::json::object();
+		for ( const auto& [name, value] : snapshot.Gauges ) {
+			gauges[ name ] = value;
+		}
+		doc[ "gauges" ] = gauges;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good();
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
+
+bool Metrics::WriteCSV( const std::filesystem::path& filename )
+{
+	const Snapshot snapshot = GetSnapshot();
+	std::ofstream stream( filename );
+	stream << "type,name,count,value,mean,p50,p90,p99,max\n";
+	stream << "uptime,seconds,," << snapshot.UptimeSeconds << ",,,,,\n";
+	for ( size_t counter = 0; counter < kCounterCount; counter++ ) {
+		stream << "counter," << s_CounterNames[ counter ] << "," << snapshot.Counters[ counter ] << ",,,,,,\n";
+	}
+	for ( size_t histogram = 0; histogram < kHistogramCount; histogram++ ) {
+		const HistogramSnapshot& values = snapshot.Histograms[ histogram ];
+		stream << "histogram," << s_HistogramNames[ histogram ] << "," << values.Count << "," << values.Total << "," <<
+			( ( values.Count > 0 ) ? static_cast<double>( values.Total ) / values.Count : 0 );
+		for ( const auto percentile : s_Percentiles ) {
+			stream << "," << values.GetPercentile( percentile );
+		}
+		stream << "," << values.Max << "\n";
+	}
+	for ( const auto& [name, value] : snapshot.Gauges ) {
+		stream << "gauge," << name << ",," << value << ",,,,,\n";
+	}
+	return stream.good();
+}
+
+Metrics::Timer::Timer( const Histogram histogram ) :
+	m_Histogram( histogram ),
+	m_Start( std::chrono::steady_clock::now() )
+{
+}
+
+Metrics::Timer::~Timer()
+{
+	Record( m_Histogram, static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - m_Start ).count() ) );
+}
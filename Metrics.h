@@ -0,0 +1,140 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Process wide registry of playback pipeline metrics, so that glitches can be diagnosed without a debugger.
+// Counters and histograms are lock free, and can be updated from the audio output callbacks.
+// Gauges are held in a map, and must only be set from non-real-time threads.
+class Metrics
+{
+public:
+	// Event counters.
+	enum class Counter {
+		Callbacks,            // Output stream callbacks.
+		LateCallbacks,        // Output stream callbacks which took longer than the duration of the audio they produced.
+		ShortCallbacks,       // Output stream callbacks which produced less audio than requested (including the final callback for each stream).
+		PreBufferUnderruns,   // Output decoder reads which were padded with silence because the pre-buffer had not kept up.
+		SniffHits,            // Files for which the format was identified from the file content.
+		SniffMisses,          // Files for which the format could not be identified from the file content, so the file extension was used.
+		SniffCacheHits,       // Files for which the format was taken from the folder format cache, without reading the file content.
+		SniffFallbacks        // Decoder opens which failed with the selected handler, and fell back to another handler.
+	};
+
+	// Number of counters.
+	static constexpr size_t kCounterCount = 8;
+
+	// Duration histograms, in microseconds.
+	enum class Histogram {
+		CallbackDuration,       // Output stream callback duration.
+		DecoderOpen,            // Time taken to open a decoder.
+		CrossfadeCalculation,   // Time taken to analyse a track for its crossfade position.
+		GainCalculation,        // Time taken to calculate a track gain.
+		ResamplerLatency,       // Resampler delay, in microseconds of output audio.
+		LibraryCommit           // Time taken to commit a batch of media library writes.
+	};
+
+	// Number of histograms.
+	static constexpr size_t kHistogramCount = 6;
+
+	// Number of histogram buckets. Bucket N holds values in the range [2^(N-1), 2^N) microseconds, with the final bucket open ended.
+	static constexpr size_t kHistogramBuckets = 24;
+
+	// Histogram snapshot.
+	struct HistogramSnapshot {
+		uint64_t Count = 0;                                   // Number of recorded values.
+		uint64_t Total = 0;                                   // Sum of recorded values.
+		uint64_t Max = 0;                                     // Maximum recorded value.
+		std::array<uint64_t, kHistogramBuckets> Buckets = {}; // Number of values in each bucket.
+
+		// Returns an estimate of the 'percentile' (0 to 100), using the upper bound of the bucket in which it falls.
+		uint64_t GetPercentile( const double percentile ) const;
+	};
+
+	// Metrics snapshot.
+	struct Snapshot {
+		double UptimeSeconds = 0;                                       // Seconds elapsed since the metrics were last reset.
+		std::array<uint64_t, kCounterCount> Counters = {};              // Counter values.
+		std::array<HistogramSnapshot, kHistogramCount> Histograms = {}; // Histogram values.
+		std::map<std::string, double> Gauges;                           // Gauge values.
+	};
+
+	// Increments the 'counter' by 'count'.
+	static void Increment( const Counter counter, const uint64_t count = 1 );
+
+	// Records a 'value' (in microseconds) in the 'histogram'.
+	static void Record( const Histogram histogram, const uint64_t value );
+
+	// Sets the gauge with the 'name' to 'value'.
+	static void SetGauge( const std::string& name, const double value );
+
+	// Removes all gauges whose name starts with 'prefix'.
+	static void RemoveGauges( const std::string& prefix );
+
+	// Returns a snapshot of all metrics.
+	static Snapshot GetSnapshot();
+
+	// Resets all counters & histograms (gauges are retained).
+	static void Reset();
+
+	// Returns the name of the 'counter'.
+	static const char* GetName( const Counter counter );
+
+	// Returns the name of the 'histogram'.
+	static const char* GetName( const Histogram histogram );
+
+	// Writes a snapshot of all metrics to a JSON 'filename'.
+	// Returns true if the file was written.
+	static bool WriteJSON( const std::filesystem::path& filename );
+
+	// Writes a snapshot of all metrics to a CSV 'filename', with one row per metric (the value column holds the histogram totals).
+	// Returns true if the file was written.
+	static bool WriteCSV( const std::filesystem::path& filename );
+
+	// Records the time elapsed between construction and destruction in a histogram.
+	class Timer
+	{
+	public:
+		// 'histogram' - histogram in which to record the elapsed time.
+		Timer( const Histogram histogram );
+
+		virtual ~Timer();
+
+	private:
+		// Histogram in which to record the elapsed time.
+		const Histogram m_Histogram;
+
+		// Start time.
+		const std::chrono::steady_clock::time_point m_Start;
+	};
+
+private:
+	// Histogram values (the count is the sum of the buckets).
+	struct HistogramValues {
+		std::atomic<uint64_t> Total = 0;
+		std::atomic<uint64_t> Max = 0;
+		std::array<std::atomic<uint64_t>, kHistogramBuckets> Buckets = {};
+	};
+
+	// Counter values.
+	static std::array<std::atomic<uint64_t>, kCounterCount> s_Counters;
+
+	// Histogram values.
+	static std::array<HistogramValues, kHistogramCount> s_Histograms;
+
+	// The time at which the metrics were last reset.
+	static std::atomic<std::chrono::steady_clock::rep> s_StartTime;
+
+	// Gauge values.
+	static std::map<std::string, double> s_Gauges;
+
+	// Gauge mutex.
+	static std::mutex s_GaugeMutex;
+};
@@ -0,0 +1,118 @@
+#include "NullSink.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+// Number of sample frames to pull from the stream at a time.
+constexpr DWORD kBlockFrames = 1024;
+
+// Bits per sample to use when writing the output file.
+constexpr long kFileBitsPerSample = 24;
+
+NullSink::NullSink( const HSTREAM stream, const long sampleRate, const long channels, const Options& options ) :
+	m_Stream( stream ),
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_Realtime( options.Realtime ),
+	m_Encoder()
+{
+	if ( ( 0 == m_Stream ) || ( m_SampleRate <= 0 ) || ( m_Channels <= 0 ) ) {
+		throw std::runtime_error( "NullSink format not supported" );
+	}
+	if ( !options.Filename.empty() ) {
+		m_Encoder = std::make_unique<EncoderPCM>();
+		std::wstring filename = options.Filename;
+		if ( !m_Encoder->Open( filename, m_SampleRate, m_Channels, kFileBitsPerSample, 0 /*totalSamples*/, {} /*settings*/, {} /*tags*/ ) ) {
+			throw std::runtime_error( "NullSink could not create output file" );
+		}
+	}
+}
+
+NullSink::~NullSink()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+	if ( m_Thread.joinable() ) {
+		m_Thread.join();
+	}
+	if ( m_Encoder ) {
+		m_Encoder->Close();
+	}
+}
+
+void NullSink::Start()
+{
+	if ( !m_Thread.joinable() ) {
+		m_Thread = std::thread( &NullSink::Run, this );
+	}
+}
+
+void NullSink::SetPaused( const bool paused )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_Paused = paused;
+	}
+	m_Condition.notify_all();
+}
+
+bool NullSink::IsPaused() const
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	return m_Paused;
+}
+
+bool NullSink::IsFinished() const
+{
+	return m_Finished;
+}
+
+void NullSink::Run()
+{
+	std::vector<float> buffer( static_cast<size_t>( kBlockFrames ) * m_Channels );
+	const DWORD blockBytes = static_cast<DWORD>( buffer.size() * sizeof( float ) );
+
+	// When pacing in real time, the clock restarts after each pause.
+	auto clockStart = std::chrono::steady_clock::now();
+	uint64_t clockFrames = 0;
+
+	bool finished = false;
+	while ( !finished ) {
+		{
+			std::unique_lock<std::mutex> lock( m_Mutex );
+			if ( m_Paused ) {
+				m_Condition.wait( lock, [ this ] () { return !m_Paused || m_Stop; } );
+				clockStart = std::chrono::steady_clock::now();
+				clockFrames = 0;
+			}
+			if ( m_Stop ) {
+				break;
+			}
+		}
+
+		const DWORD bytesRead = BASS_ChannelGetData( m_Stream, buffer.data(), blockBytes );
+		if ( static_cast<DWORD>( -1 ) == bytesRead ) {
+			// The stream has ended.
+			finished = true;
+		} else if ( 0 == bytesRead ) {
+			// The stream has stalled, so try again shortly.
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		} else {
+			const long frames = static_cast<long>( bytesRead / sizeof( float ) / m_Channels );
+			if ( m_Encoder && !m_Encoder->Write( buffer.data(), frames ) ) {
+				finished = true;
+			}
+			if ( m_Realtime ) {
+				clockFrames += static_cast<uint64_t>( frames );
+				const auto due = clockStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( static_cast<double>( clockFrames ) / m_SampleRate ) );
+				std::unique_lock<std::mutex> lock( m_Mutex );
+				m_Condition.wait_until( lock, due, [ this ] () { return m_Stop; } );
+			}
+		}
+	}
+	m_Finished = true;
+}
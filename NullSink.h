@@ -0,0 +1,84 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "bass.h"
+#include "EncoderPCM.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Output sink which takes the place of an audio device, for headless playback.
+// Sample data is pulled from a decoding output stream on a dedicated thread, and is either discarded or written to a wave file.
+// Output can be pulled as fast as possible (to measure the maximum throughput of the playback pipeline) or paced in real time.
+class NullSink
+{
+public:
+	// Null sink options.
+	struct Options {
+		bool Realtime = false;    // Whether to pace the output in real time, rather than pulling sample data as fast as possible.
+		std::wstring Filename;    // Wave file to write (without the file extension), or empty to discard the output.
+	};
+
+	// 'stream' - decoding stream from which to pull sample data.
+	// 'sampleRate' - stream sample rate.
+	// 'channels' - stream channel count.
+	// 'options' - sink options.
+	// Throws a std::runtime_error exception if the output file could not be created.
+	NullSink( const HSTREAM stream, const long sampleRate, const long channels, const Options& options );
+
+	virtual ~NullSink();
+
+	// Starts pulling sample data from the stream.
+	void Start();
+
+	// Sets whether output is 'paused'.
+	void SetPaused( const bool paused );
+
+	// Returns whether output is paused.
+	bool IsPaused() const;
+
+	// Returns whether the stream has ended (or the output file could not be written).
+	bool IsFinished() const;
+
+private:
+	// Pulls sample data from the stream until it ends, or the sink is stopped.
+	void Run();
+
+	// Decoding stream.
+	const HSTREAM m_Stream;
+
+	// Stream sample rate.
+	const long m_SampleRate;
+
+	// Stream channel count.
+	const long m_Channels;
+
+	// Whether to pace the output in real time.
+	const bool m_Realtime;
+
+	// Wave file encoder, or nullptr to discard the output.
+	std::unique_ptr<EncoderPCM> m_Encoder;
+
+	// Output thread.
+	std::thread m_Thread;
+
+	// Protects the paused & stop flags.
+	mutable std::mutex m_Mutex;
+
+	// Signalled when the paused or stop flags change.
+	std::condition_variable m_Condition;
+
+	// Indicates whether output is paused.
+	bool m_Paused = false;
+
+	// Indicates whether the output thread should stop.
+	bool m_Stop = false;
+
+	// Indicates whether the stream has ended.
+	std::atomic<bool> m_Finished = false;
+};
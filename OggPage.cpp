@@ -11,36 +11,26 @@ static const uint32_t s_MaxCommentSize = 125829120;
 // Maximum page content size.
 uint32_t OggPage::MaximumContentSize = 255 * 255;
 
-OggPage::OggPage( std::fstream& stream ) :
+OggPage::OggPage( FileSource& source ) :
 	m_Header(),
 	m_Content()
 {
 	bool ok = false;
-	if ( stream.good() ) {
-		// Read the page header and do some basic checks.
-		m_Header.resize( 27 + 255 );
-		stream.read( reinterpret_cast<char*>( &m_Header[ 0 ] ), 27 );
-		if ( stream.good() && ( 0 == memcmp( &m_Header[ 0 ], "OggS", 4 ) ) && ( 0 == m_Header[ 4 ] ) ) {
-			const uint8_t segmentCount = m_Header[ 26 ];
-			if ( segmentCount > 0 ) {
-				stream.read( reinterpret_cast<char*>( &m_Header[ 27 ] ), segmentCount );
+	// Check the page header in place, before copying out the page.
+	const uint64_t pagePosition = source.GetPosition();
+	if ( const auto header = source.GetSpan( pagePosition, 27 ); ( 27 == header.size() ) && ( 0 == memcmp( header.data(), "OggS", 4 ) ) && ( 0 == header[ 4 ] ) ) {
+		const uint8_t segmentCount = header[ 26 ];
+		const auto page = source.GetSpan( pagePosition, 27 + segmentCount );
+		if ( page.size() == static_cast<size_t>( 27 + segmentCount ) ) {
+			uint32_t contentSize = 0;
+			for ( auto segment = page.begin() + 27; page.end() != segment; ++segment ) {
+				contentSize += *segment;
 			}
-			if ( stream.good() ) {
-				// Append the segment table to the header.
-				m_Header.resize( 27 + segmentCount );
-				uint32_t contentSize = 0;
-				auto segment = m_Header.begin() + 27;
-				while ( m_Header.end() != segment ) {
-					contentSize += *segment++;
-				}
-				if ( contentSize > 0 ) {
-					// Read the packet data.
-					m_Content.resize( contentSize );
-					stream.read( reinterpret_cast<char*>( &m_Content[ 0 ] ), contentSize );
-				}
-				if ( stream.good() ) {
-					ok = CheckCRC();
-				}
+			m_Header.assign( page.begin(), page.end() );
+			if ( const auto content = source.GetSpan( pagePosition + m_Header.size(), contentSize ); content.size() == contentSize ) {
+				m_Content.assign( content.begin(), content.end() );
+				source.SetPosition( pagePosition + m_Header.size() + contentSize );
+				ok = CheckCRC();
 			}
 		}
 	}
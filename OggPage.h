@@ -1,5 +1,7 @@
 #pragma once
 
+#include "FileSource.h"
+
 #include <fstream>
 #include <vector>
 
@@ -7,11 +9,11 @@
 class OggPage
 {
 public:
-	// 'stream' - binary mode input stream.
-	// Throws a std::runtime_error exception if a valid page could not be constructed from the stream.
-	// The stream, on input, is required to be positioned on a page boundary.
-	// On successful construction, the stream will be positioned at the next page boundary.
-	OggPage( std::fstream& stream );
+	// 'source' - input file source.
+	// Throws a std::runtime_error exception if a valid page could not be constructed from the source.
+	// The source, on input, is required to be positioned on a page boundary.
+	// On successful construction, the source will be positioned at the next page boundary.
+	OggPage( FileSource& source );
 
 	// 'isContinued' - indicates whether the page is continued from a previous page.
 	// 'serial' - serial number (should be non-zero).
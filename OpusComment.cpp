@@ -12,6 +12,7 @@ static const uint32_t s_MaxCommentSize = 125829120;
 OpusComment::OpusComment( const std::wstring& filename, const bool readonly ) :
 	m_Filename( filename ),
 	m_Stream( filename, ( readonly ? ( std::ios::in | std::ios::binary ) : ( std::ios::in | std::ios::out | std::ios::binary ) ), _SH_DENYWR ),
+	m_Source( FileSource::Open( filename ) ),
 	m_OriginalPages(),
 	m_Vendor(),
 	m_Comments(),
@@ -19,7 +20,10 @@ OpusComment::OpusComment( const std::wstring& filename, const bool readonly ) :
 {
 	bool readComments = false;
 	try {
-		const OggPage header( m_Stream );
+		if ( !m_Source ) {
+			throw std::runtime_error( "Could not open Opus file." );
+		}
+		const OggPage header( *m_Source );
 		if ( IsOpusHeader( header ) ) {
 			const uint32_t serial = header.GetSerialNumber();
 			const uint32_t sequence = header.GetSequenceNumber();
@@ -27,8 +31,8 @@ OpusComment::OpusComment( const std::wstring& filename, const bool readonly ) :
 			std::vector<uint8_t> vorbisComment;
 			bool valid = true;
 			while ( valid && !readComments ) {
-				const long long streamPos = m_Stream.tellg();
-				const OggPage page( m_Stream );
+				const long long streamPos = static_cast<long long>( m_Source->GetPosition() );
+				const OggPage page( *m_Source );
 				if ( page.GetSerialNumber() == serial ) {
 					if ( page.GetSequenceNumber() != ++nextSequence ) {
 						// Treat a gap in page sequence numbers as an error.
@@ -462,9 +466,8 @@ bool OpusComment::WriteComments()
 
 		if ( !wroteComments ) {
 			m_Stream.clear();
-			m_Stream.seekg( 0, std::ios::end );
-			const std::streampos sourceStreamSize = m_Stream.tellg();
-			m_Stream.seekg( 0 );
+			const uint64_t sourceStreamSize = m_Source->GetSize();
+			m_Source->SetPosition( 0 );
 			bool ok = m_Stream.good();
 			if ( ok ) {
 				// Attempt to copy the original stream to a temporary file with the modified comment header.
@@ -476,8 +479,8 @@ bool OpusComment::WriteComments()
 
 					std::ofstream outStream( tempFilename, std::ios::out | std::ios::binary, _SH_DENYRW );
 					ok = ( m_Stream.good() && outStream.good() );
-					while ( ok && ( m_Stream.tellg() < sourceStreamSize ) ) {
-						OggPage page( m_Stream );
+					while ( ok && ( m_Source->GetPosition() < sourceStreamSize ) ) {
+						OggPage page( *m_Source );
 						if ( page.GetSerialNumber() == serial ) {
 							const uint32_t sequence = page.GetSequenceNumber();
 							if ( sequence <= lastOriginalSequenceNumber ) {
@@ -520,6 +523,7 @@ bool OpusComment::WriteComments()
 
 				if ( ok ) {
 					// Replace the original file with the modified copy.
+					m_Source.reset();
 					m_Stream.close();
 					ok = ( 0 == _wunlink( m_Filename.c_str() ) );
 					if ( ok ) {
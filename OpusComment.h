@@ -84,9 +84,12 @@ private:
 	// Opus file name.
 	std::wstring m_Filename;
 
-	// Opus stream.
+	// Opus stream (used for writing).
 	std::fstream m_Stream;
 
+	// Opus file source (used for reading).
+	FileSource::Ptr m_Source;
+
 	// Original Opus comment page(s), keyed by the file offset to the start of the page.
 	std::map<long long, OggPage> m_OriginalPages;
 
@@ -1,6 +1,8 @@
 #include "Output.h"
 
 #include "GainCalculator.h"
+#include "Metrics.h"
+#include "SampleConversion.h"
 #include "Utility.h"
 #include "VUPlayer.h"
 
@@ -10,6 +12,7 @@
 #include "bassmix.h"
 #include "basswasapi.h"
 
+#include <chrono>
 #include <cmath>
 
 // Output buffer length, in seconds.
@@ -45,19 +48,20 @@ constexpr DWORD s_StopFadeDuration = 20;
 // Maximum number of playlist items to skip when trying to switch decoder streams.
 constexpr size_t s_MaxSkipItems = 20;
 
-// Define to output debug timing for testing.
-#undef DEBUG_TIMING
+// Maximum number of channels for which soft-clip state is allocated up front.
+constexpr size_t s_MaxSoftClipChannels = 32;
+
+// Interval at which the preload decoder thread checks that the next decoder stream is still the right one (as the playlist can change), in milliseconds.
+constexpr DWORD s_PreloadDecoderCheckInterval = 1000;
 
 DWORD CALLBACK Output::StreamProc( HSTREAM handle, void *buf, DWORD length, void *user )
 {
+	const RealtimeAudit::Scope auditScope;
 	DWORD bytesRead = 0;
 	Output* output = static_cast<Output*>( user );
 	if ( nullptr != output ) {
-#ifdef DEBUG_TIMING
-		LARGE_INTEGER perfFreq, perfCount1, perfCount2;
-		QueryPerformanceFrequency( &perfFreq );
-		QueryPerformanceCounter( &perfCount1 );
-#endif
+		const auto callbackStart = std::chrono::steady_clock::now();
+		const DWORD bytesRequested = length;
 
 		float* sampleBuffer = static_cast<float*>( buf );
 		bytesRead = output->ApplyLeadIn( sampleBuffer, length, handle );
@@ -66,25 +70,30 @@ DWORD CALLBACK Output::StreamProc( HSTREAM handle, void *buf, DWORD length, void
 			sampleBuffer += bytesRead / 4;
 			bytesRead += output->ReadSampleData( sampleBuffer, length, handle );
 		}
+		if ( const auto analysisTap = output->m_AnalysisTap.load(); ( bytesRead > 0 ) && analysisTap ) {
+			analysisTap->Process( static_cast<const float*>( buf ), bytesRead / ( sizeof( float ) * analysisTap->GetChannels() ) );
+		}
+		if ( bytesRead < bytesRequested ) {
+			Metrics::Increment( Metrics::Counter::ShortCallbacks );
+		}
 		if ( 0 == bytesRead ) {
 			bytesRead = BASS_STREAMPROC_END;
 			output->SetOutputStreamFinished( true );
 		}
 
-#ifdef DEBUG_TIMING
-		QueryPerformanceCounter( &perfCount2 );
-		const float msec = 1000 * static_cast<float>( perfCount2.QuadPart - perfCount1.QuadPart ) / perfFreq.QuadPart;
-		if ( msec >= 1.0f ) {
-			const std::wstring debugStr = L"VUPlayer::Output::StreamProc: " + std::to_wstring( msec ) + L"ms\r\n";
-			OutputDebugString( debugStr.c_str() );
+		const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - callbackStart ).count();
+		Metrics::Record( Metrics::Histogram::CallbackDuration, static_cast<uint64_t>( microseconds ) );
+		Metrics::Increment( Metrics::Counter::Callbacks );
+		if ( const double bytesPerSecond = output->m_OutputStreamBytesPerSecond; ( bytesPerSecond > 0 ) && ( microseconds > 1000000 * bytesRequested / bytesPerSecond ) ) {
+			Metrics::Increment( Metrics::Counter::LateCallbacks );
 		}
-#endif
 	}
 	return bytesRead;
 }
 
 DWORD CALLBACK Output::WasapiProc( void *buffer, DWORD length, void *user )
 {
+	const RealtimeAudit::Scope auditScope;
 	DWORD bytesRead = 0;
 	Output* output = static_cast<Output*>( user );
 	if ( nullptr != output ) {
@@ -177,13 +186,12 @@ DWORD WINAPI Output::PreloadDecoderProc( LPVOID lpParam )
 	return 0;
 }
 
-Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, Settings& settings ) :
+Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, Settings& settings, const std::optional<NullSink::Options>& nullOutput ) :
 	m_hInst( instance ),
 	m_Parent( hwnd ),
 	m_Handlers( handlers ),
 	m_Settings( settings ),
 	m_Playlist(),
-	m_CurrentItemDecoding( {} ),
 	m_SoftClipStateDecoding(),
 	m_DecoderStream(),
 	m_DecoderSampleRate( 0 ),
@@ -195,6 +203,8 @@ Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, S
 	m_Pitch( 1.0f ),
 	m_Balance( 0 ),
 	m_OutputQueue(),
+	m_OutputQueueEvents(),
+	m_RetiredDecoders(),
 	m_RestartItemID( 0 ),
 	m_RandomPlay( false ),
 	m_RepeatTrack( false ),
@@ -205,6 +215,7 @@ Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, S
 	m_LimitMode( Settings::LimitMode::None ),
 	m_GainPreamp( 0 ),
 	m_LoudnessNormalisation( m_Settings.GetLoudnessNormalisation() ),
+	m_SilenceThreshold( std::pow( 10.0f, m_Settings.GetSilenceThreshold() / 20 ) ),
 	m_RetainStopAtTrackEnd( m_Settings.GetRetainStopAtTrackEnd() ),
 	m_StopAtTrackEnd( m_RetainStopAtTrackEnd ? m_Settings.GetStopAtTrackEnd() : false ),
 	m_Muted( false ),
@@ -223,28 +234,39 @@ Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, S
 	m_PreloadDecoderStopEvent( CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
 	m_PreloadDecoderWakeEvent( CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
 	m_CrossfadingStream(),
-	m_CrossfadingStreamMutex(),
-	m_CurrentItemCrossfading( {} ),
+	m_CancelCrossfadingStream( false ),
+	m_CrossfadingBuffer(),
 	m_CrossfadingItemID( 0 ),
 	m_SoftClipStateCrossfading(),
 	m_CrossfadeSeekOffset( 0 ),
 	m_GainEstimateMap(),
+	m_GainEstimateMutex(),
 	m_CurrentEQ( m_Settings.GetEQSettings() ),
-	m_FX(),
+	m_Equaliser(),
+	m_AnalysisTap(),
 	m_EQEnabled( m_CurrentEQ.Enabled ),
 	m_EQPreamp( m_CurrentEQ.Preamp ),
 	m_OutputMode( Settings::OutputMode::Standard ),
 	m_OutputDevice(),
+	m_NullOutput( nullOutput ),
+	m_NullSink(),
+	m_NullSinkCount( 0 ),
 	m_WASAPIFailed( false ),
 	m_WASAPIPaused( false ),
 	m_ResetASIO( false ),
 	m_OutputStreamFinished( false ),
+	m_OutputStreamBytesPerSecond( 0 ),
 	m_MixerStreamHasEndSync( false ),
 	m_LeadInSeconds( 0 ),
 	m_PausedOnStartup( false ),
 	m_PreloadedDecoder( {} ),
 	m_PreloadedDecoderMutex(),
+	m_NextDecoderStream(),
+	m_NextDecoderStreamPending( false ),
+	m_StartingDecoderStream(),
 	m_StreamTitleQueue(),
+	m_StreamTitleEvents(),
+	m_LastStreamTitleSeconds(),
 	m_StreamTitleMutex(),
 	m_FollowTrackSelection( m_Settings.GetFollowTrackSelection() ),
 	m_FollowPlaylistInformation( {} ),
@@ -254,14 +276,20 @@ Output::Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, S
 	m_OnPreBufferFinishedCallback( [ this ] ( const long id )
 		{
 			if ( id != m_CrossfadingItemID ) {
-				std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-				if ( m_PreloadedDecoder.decoder ) {
-					m_PreloadedDecoder.decoder->PreBuffer( m_OnPreBufferFinishedCallback );
+				// Let the next decoder start pre-buffering, now that the current one has finished.
+				std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+				m_PreloadedDecoder.preBufferFinishedID = id;
+				if ( m_PreloadedDecoder.next && m_PreloadedDecoder.next->decoder ) {
+					m_PreloadedDecoder.next->decoder->ReleasePreBuffer();
 				}
 			}
 		}
 	)
 {
+	// Allocate the soft-clip state up front, so that it is not allocated by the output callback.
+	m_SoftClipStateDecoding.reserve( s_MaxSoftClipChannels );
+	m_SoftClipStateCrossfading.reserve( s_MaxSoftClipChannels );
+
 	InitialiseOutput();
 
 	SetVolume( m_Settings.GetVolume() );
@@ -312,8 +340,7 @@ void Output::Play( const long playlistID, const double seek )
 	}
 
 	if ( m_Playlist && m_Playlist->GetItem( item ) ) {
-		m_DecoderStream = OpenOutputDecoder( item );
-		if ( m_DecoderStream ) {
+		if ( const OutputDecoderPtr decoder = OpenOutputDecoder( item ); decoder ) {
 
 			const DWORD outputBufferSize = static_cast<DWORD>( 1000 * ( ( ( MediaInfo::Source::CDDA ) == item.Info.GetSource() ) ? ( 2 * s_BufferLength ) : s_BufferLength ) );
 			const DWORD previousOutputBufferSize = BASS_GetConfig( BASS_CONFIG_BUFFER );
@@ -323,7 +350,7 @@ void Output::Play( const long playlistID, const double seek )
 
 			EstimateGain( item );
 
-			m_DecoderSampleRate = m_DecoderStream->GetOutputSampleRate();
+			m_DecoderSampleRate = decoder->GetOutputSampleRate();
 			const DWORD freq = static_cast<DWORD>( m_DecoderSampleRate );
 			double seekPosition = seek;
 			if ( 0.0f != seekPosition ) {
@@ -333,17 +360,35 @@ void Output::Play( const long playlistID, const double seek )
 						seekPosition = 0;
 					}
 				}
-				seekPosition = m_DecoderStream->Seek( seekPosition );
+				seekPosition = decoder->Seek( seekPosition );
 			} else if ( GetCrossfade() ) {
-				m_DecoderStream->SkipSilence();
+				SkipSilence( decoder, item );
 			}
 
-			if ( !IsURL( item.Info.GetFilename() ) ) {
-				m_DecoderStream->PreBuffer( m_OnPreBufferFinishedCallback );
+			if ( UsePreBuffer( item ) ) {
+				// Not on the output thread, so wait for the pre-buffer to be primed, rather than starting playback with silence.
+				decoder->PreBuffer( m_OnPreBufferFinishedCallback );
+				decoder->WaitForPreBuffer();
 			}
 
+			m_DecoderStream = std::make_shared<DecoderStream>( DecoderStream{ decoder, item } );
+
 			if ( CreateOutputStream( item.Info ) ) {
-				m_CurrentItemDecoding = item;
+				// Allocate the crossfading buffer for the output buffer length up front, so that the output callback does not need to.
+				const size_t outputRate = m_Resample ? m_Resample->first : freq;
+				const size_t outputChannels = m_Resample ? m_Resample->second : decoder->GetOutputChannels();
+				m_CrossfadingBuffer.resize( outputRate * outputChannels * outputBufferSize / 1000 );
+
+				try {
+					m_Equaliser = std::make_unique<Equaliser>( static_cast<long>( outputRate ), static_cast<uint32_t>( outputChannels ) );
+				} catch ( const std::runtime_error& ) {
+				}
+
+				try {
+					m_AnalysisTap.store( std::make_shared<AnalysisTap>( static_cast<long>( outputRate ), static_cast<uint32_t>( outputChannels ) ) );
+				} catch ( const std::runtime_error& ) {
+				}
+
 				UpdateOutputVolume();
 				if ( 1.0f != m_Pitch ) {
 					BASS_ChannelSetAttribute( m_OutputStream, BASS_ATTRIB_FREQ, freq * m_Pitch );
@@ -353,6 +398,9 @@ void Output::Play( const long playlistID, const double seek )
 				}
 				UpdateEQ( m_CurrentEQ );
 
+				// Have the next decoder stream prepared before starting the output, in case the current one is very short.
+				ResetPreloadedDecoder( m_DecoderStream );
+
 				const State state = StartOutput();
 				if ( State::Playing == state ) {
 					Queue queue = GetOutputQueue();
@@ -362,7 +410,6 @@ void Output::Play( const long playlistID, const double seek )
 						StartCrossfadeCalculationThread( item, seekPosition );
 					}
 					StartLoudnessPrecalcThread();
-					PreloadNextDecoder( item );
 				} else {
 					Stop();
 				}
@@ -374,6 +421,8 @@ void Output::Play( const long playlistID, const double seek )
 void Output::Stop()
 {
 	if ( 0 != m_OutputStream ) {
+		m_NullSink.reset();
+
 		if ( Settings::OutputMode::Standard == m_OutputMode ) {
 			if ( BASS_ACTIVE_PLAYING == BASS_ChannelIsActive( m_OutputStream ) ) {
 				const HANDLE slideFinishedEvent = CreateEvent( nullptr /*attributes*/, FALSE /*manualReset*/, FALSE /*initial*/, L"" /*name*/ );
@@ -418,16 +467,22 @@ void Output::Stop()
 		}
 	}
 
-	m_FX.clear();
+	m_Equaliser.reset();
+	m_AnalysisTap.store( nullptr );
 	m_DecoderSampleRate = 0;
 	m_DecoderStream.reset();
 	m_CrossfadingStream.reset();
-	m_CurrentItemDecoding = {};
+	m_StartingDecoderStream.reset();
+	m_CancelCrossfadingStream = false;
 	m_SoftClipStateDecoding.clear();
-	m_CurrentItemCrossfading = {};
-	m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
+	m_CrossfadingItemID = 0;
 	m_SoftClipStateCrossfading.clear();
 	m_RestartItemID = 0;
+	FreeRetiredDecoders();
+	{
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_QueueMutex );
+		m_OutputQueueEvents.Clear();
+	}
 	SetOutputQueue( {} );
 	m_FadeOut = false;
 	m_FadeToNext = false;
@@ -441,9 +496,10 @@ void Output::Stop()
 	m_PausedOnStartup = false;
 	StopCrossfadeCalculationThread();
 	StopLoudnessPrecalcThread();
-	std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-	m_PreloadedDecoder = {};
+	ResetPreloadedDecoder();
 	SetStreamTitleQueue( {} );
+	m_LastStreamTitleSeconds.reset();
+	RealtimeAudit::Report();
 }
 
 void Output::Pause()
@@ -483,6 +539,12 @@ void Output::Pause()
 			}
 			break;
 		}
+		case Settings::OutputMode::Null: {
+			if ( m_NullSink && !m_NullSink->IsFinished() ) {
+				m_NullSink->SetPaused( !m_NullSink->IsPaused() );
+			}
+			break;
+		}
 	}
 }
 
@@ -504,9 +566,8 @@ void Output::Previous( const bool forcePrevious, const float seek )
 					}
 				} else {
 					if ( GetRandomPlay() ) {
-						std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-						if ( ( m_PreloadedDecoder.item.ID > 0 ) && ( m_PreloadedDecoder.item.ID != currentItem.ID ) && m_Playlist->ContainsItem( { m_PreloadedDecoder.item } ) ) {
-							previousItem = m_PreloadedDecoder.item;
+						if ( const Playlist::Item preloadedItem = GetPreloadedItem(); ( preloadedItem.ID > 0 ) && ( preloadedItem.ID != currentItem.ID ) && m_Playlist->ContainsItem( preloadedItem ) ) {
+							previousItem = preloadedItem;
 						} else {
 							previousItem = m_Playlist->GetRandomItem( currentItem );
 						}
@@ -541,9 +602,8 @@ void Output::Next()
 			}
 		} else {
 			if ( GetRandomPlay() ) {
-				std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-				if ( ( m_PreloadedDecoder.item.ID > 0 ) && ( m_PreloadedDecoder.item.ID != currentItem.ID ) && m_Playlist->ContainsItem( { m_PreloadedDecoder.item } ) ) {
-					nextItem = m_PreloadedDecoder.item;
+				if ( const Playlist::Item preloadedItem = GetPreloadedItem(); ( preloadedItem.ID > 0 ) && ( preloadedItem.ID != currentItem.ID ) && m_Playlist->ContainsItem( preloadedItem ) ) {
+					nextItem = preloadedItem;
 				} else {
 					nextItem = m_Playlist->GetRandomItem( currentItem );
 				}
@@ -640,6 +700,12 @@ Output::State Output::GetState()
 			}
 			break;
 		}
+		case Settings::OutputMode::Null: {
+			if ( m_NullSink && !m_NullSink->IsFinished() ) {
+				state = m_NullSink->IsPaused() ? State::Paused : State::Playing;
+			}
+			break;
+		}
 	}
 	return state;
 }
@@ -649,6 +715,9 @@ Output::Item Output::GetCurrentPlaying()
 	Item currentItem = {};
 	const State state = GetState();
 	if ( State::Stopped != state ) {
+		// Free any decoders which the output callback has finished with.
+		FreeRetiredDecoders();
+
 		const float seconds = GetOutputPosition();
 		const Queue queue = GetOutputQueue();
 		for ( auto iter = queue.rbegin(); iter != queue.rend(); iter++ ) {
@@ -673,68 +742,64 @@ Output::Item Output::GetCurrentPlaying()
 
 DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM handle )
 {
+	if ( m_CancelCrossfadingStream.exchange( false ) ) {
+		ResetCrossfadingStream();
+	}
+
 	// Read sample data into the output buffer.
 	DWORD bytesRead = 0;
 	if ( ( nullptr != buffer ) && ( byteCount > 0 ) && m_DecoderStream ) {
-		const long channels = m_DecoderStream->GetOutputChannels();
+		const OutputDecoderPtr& decoder = m_DecoderStream->decoder;
+		const long channels = decoder->GetOutputChannels();
 		if ( channels > 0 ) {
 			long samplesToRead = static_cast<long>( byteCount ) / ( channels * 4 );
 
 			if ( GetCrossfade() && !GetFadeOut() && !GetFadeToNext() && !GetStopAtTrackEnd() ) {
 				const double crossfadePosition = GetCrossfadePosition();
-				if ( crossfadePosition > 0 ) {
-					bool checkCrossFade = ( GetRandomPlay() || GetRepeatTrack() );
-					if ( !checkCrossFade ) {
-						if ( GetFollowTrackSelection() ) {
-							checkCrossFade = GetTrackToFollow( m_CurrentItemDecoding ).has_value();
-						} else {
-							std::lock_guard<std::mutex> lock( m_PlaylistMutex );
-							Playlist::Item nextItem = {};
-							checkCrossFade = m_Playlist->GetNextItem( m_CurrentItemDecoding, nextItem, GetRepeatPlaylist() /*wrap*/ );
-						}
-					}
-					if ( checkCrossFade ) {
+				const long sampleRate = decoder->GetOutputSampleRate();
+				if ( ( crossfadePosition > 0 ) && ( sampleRate > 0 ) ) {
+					const double trackPos = GetDecodePosition() - m_LastTransitionPosition - m_LeadInSeconds;
+					const double secondsTillCrossfade = crossfadePosition - trackPos;
+					const long samplesTillCrossfade = static_cast<long>( secondsTillCrossfade * sampleRate );
+					if ( ( samplesTillCrossfade < samplesToRead ) && m_NextDecoderStreamPending ) {
 						// Ensure we don't read past the crossfade point.
-						const long sampleRate = m_DecoderStream->GetOutputSampleRate();
-						if ( sampleRate > 0 ) {
-							const double trackPos = GetDecodePosition() - m_LastTransitionPosition - m_LeadInSeconds;
-							const double secondsTillCrossfade = crossfadePosition - trackPos;
-							const long samplesTillCrossfade = static_cast<long>( secondsTillCrossfade * sampleRate );
-							if ( samplesTillCrossfade < samplesToRead ) {
-								samplesToRead = samplesTillCrossfade;
-								if ( samplesToRead <= 0 ) {
-									samplesToRead = 0;
-									// Hold on the the decoder, and indicate its fade out position.
-									std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
-									m_CrossfadingStream = m_DecoderStream;
-									m_CurrentItemCrossfading = m_CurrentItemDecoding;
-									m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
-									m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
-								}
+						samplesToRead = std::max( 0l, samplesTillCrossfade );
+						if ( 0 == samplesToRead ) {
+							// Take the next decoder stream, hold on to the current one, and indicate its fade out position.
+							m_StartingDecoderStream = TakeNextDecoderStream();
+							if ( m_StartingDecoderStream ) {
+								RetireDecoderStream( m_CrossfadingStream );
+								m_CrossfadingStream = m_DecoderStream;
+								m_CrossfadingItemID = m_CrossfadingStream->item.ID;
+								m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
+							} else {
+								// The next decoder stream has yet to be prepared, so carry on with the current one for now.
+								samplesToRead = static_cast<long>( byteCount ) / ( channels * 4 );
 							}
 						}
 					}
 				}
 			} else if ( GetFadeToNext() && m_SwitchToNext ) {
-				ToggleFadeToNext();
-				samplesToRead = 0;
-				std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
-				m_CrossfadingStream = m_DecoderStream;
-				m_CurrentItemCrossfading = m_CurrentItemDecoding;
-				m_CurrentItemCrossfading.ID = s_ItemIsFadingToNext;
-				m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
-				m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
+				// Only switch once the next decoder stream has been prepared.
+				m_StartingDecoderStream = TakeNextDecoderStream();
+				if ( m_StartingDecoderStream ) {
+					m_FadeToNext = false;
+					m_SwitchToNext = false;
+					samplesToRead = 0;
+					RetireDecoderStream( m_CrossfadingStream );
+					m_CrossfadingStream = m_DecoderStream;
+					m_CrossfadingItemID = s_ItemIsFadingToNext;
+					m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
+				}
 			}
 
-			bytesRead = static_cast<DWORD>( m_DecoderStream->Read( buffer, samplesToRead ) * channels * 4 );
+			bytesRead = static_cast<DWORD>( decoder->Read( buffer, samplesToRead ) * channels * 4 );
 		}
 
-		if ( m_DecoderStream->SupportsStreamTitles() ) {
-			auto streamTitleQueue = GetStreamTitleQueue();
-			const auto [seconds, displayTitle] = m_DecoderStream->GetStreamTitle();
-			if ( m_StreamTitleQueue.empty() || ( seconds != m_StreamTitleQueue.back().first ) ) {
-				streamTitleQueue.push_back( { seconds, displayTitle } );
-				SetStreamTitleQueue( streamTitleQueue );
+		if ( decoder->SupportsStreamTitles() ) {
+			auto [seconds, displayTitle] = decoder->GetStreamTitle();
+			if ( !m_LastStreamTitleSeconds || ( seconds != *m_LastStreamTitleSeconds ) ) {
+				AddStreamTitle( seconds, std::move( displayTitle ) );
 			}
 		}
 	}
@@ -748,134 +813,116 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 			// Set a sync on the output stream, so that the states can be toggled when playback actually finishes.
 			m_RestartItemID = {};
 			SetEndSync( handle );
-		} else if ( m_DecoderStream && ( 0 != BASS_ChannelGetPosition( m_OutputStream, BASS_POS_DECODE ) ) && !IsURL( m_CurrentItemDecoding.Info.GetFilename() ) ) {
-			// Create a stream from the next playlist item, but not if there has been an error starting playback, or if the previous or next stream is a URL.
-			Playlist::Item nextItem = m_CurrentItemDecoding;
-			auto nextDecoder = GetNextDecoder( nextItem );
-			if ( nextDecoder && !IsURL( nextItem.Info.GetFilename() ) ) {
-				EstimateGain( nextItem );
-				const long channels = m_DecoderStream->GetOutputChannels();
-				const long sampleRate = m_DecoderStream->GetOutputSampleRate();
-				if ( ( nextDecoder->GetOutputChannels() == channels ) && ( nextDecoder->GetOutputSampleRate() == sampleRate ) ) {
-					if ( GetCrossfade() || GetFadeToNext() ) {
-						nextDecoder->SkipSilence();
-					}
-
-					const long sampleCount = static_cast<long>( byteCount ) / ( channels * 4 );
-					bytesRead = static_cast<DWORD>( nextDecoder->Read( buffer, sampleCount ) * channels * 4 );
-					if ( bytesRead > 0 ) {
-						m_LastTransitionPosition = GetDecodePosition() - m_LeadInSeconds;
-						Queue queue = GetOutputQueue();
-						queue.push_back( { nextItem, m_LastTransitionPosition } );
-						SetOutputQueue( queue );
-
-						if ( GetCrossfade() && ( 0 != bytesRead ) ) {
-							StartCrossfadeCalculationThread( nextItem );
+		} else if ( m_DecoderStream && ( 0 != BASS_ChannelGetPosition( m_OutputStream, BASS_POS_DECODE ) ) && !IsURL( m_DecoderStream->item.Info.GetFilename() ) ) {
+			// Switch to the next decoder stream (prepared by the preload decoder thread), but not if there has been an error starting playback, or if the previous stream is a URL.
+			DecoderStreamPtr nextStream = m_StartingDecoderStream ? std::move( m_StartingDecoderStream ) : TakeNextDecoderStream();
+			if ( !nextStream && m_NextDecoderStreamPending ) {
+				// The next decoder stream has yet to be prepared, so output silence and try again on the next read.
+				if ( const long channels = m_DecoderStream->decoder->GetOutputChannels(); channels > 0 ) {
+					bytesRead = ( byteCount / ( channels * 4 ) ) * channels * 4;
+					std::fill( buffer, buffer + bytesRead / 4, 0.0f );
+				}
+			} else {
+				// Streams (which are not preloaded) restart playback, rather than being switched to.
+				long restartItemID = nextStream ? nextStream->item.ID : 0;
+				if ( nextStream && nextStream->decoder ) {
+					const OutputDecoderPtr& nextDecoder = nextStream->decoder;
+					const long channels = m_DecoderStream->decoder->GetOutputChannels();
+					const long sampleRate = m_DecoderStream->decoder->GetOutputSampleRate();
+					if ( ( nextDecoder->GetOutputChannels() == channels ) && ( nextDecoder->GetOutputSampleRate() == sampleRate ) ) {
+						const long sampleCount = static_cast<long>( byteCount ) / ( channels * 4 );
+						bytesRead = static_cast<DWORD>( nextDecoder->Read( buffer, sampleCount ) * channels * 4 );
+						if ( bytesRead > 0 ) {
+							m_LastTransitionPosition = GetDecodePosition() - m_LeadInSeconds;
+							nextStream->queueItem.Position = m_LastTransitionPosition;
+							AddToOutputQueue( std::move( nextStream->queueItem ) );
+						} else {
+							restartItemID = 0;
 						}
-					} else {
-						nextItem = {};
-						nextDecoder.reset();
 					}
 				}
-			}
 
-			m_DecoderStream = nextDecoder;
-			m_CurrentItemDecoding = nextItem;
-
-			if ( ( 0 == bytesRead ) && ( nextItem.ID > 0 ) ) {
-				// Signal that playback should be restarted from the next playlist item.
-				m_RestartItemID = nextItem.ID;
-				SetEndSync( handle );
+				if ( bytesRead > 0 ) {
+					std::swap( m_DecoderStream, nextStream );
+				}
+				RetireDecoderStream( nextStream );
 
-				std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
-				if ( m_CrossfadingStream ) {
-					m_CrossfadingStream.reset();
-					m_CurrentItemCrossfading = {};
-					m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
-					m_SoftClipStateCrossfading.clear();
+				if ( 0 == bytesRead ) {
+					RetireDecoderStream( m_DecoderStream );
+					if ( restartItemID > 0 ) {
+						// Signal that playback should be restarted from the next playlist item.
+						m_RestartItemID = restartItemID;
+						SetEndSync( handle );
+						ResetCrossfadingStream();
+					}
 				}
 			}
 		}
 	}
 
+	// Gain, fade & crossfade to apply to the output buffer, which are mixed in a single pass.
+	SampleMixer::Gain decodingGain;
+	SampleMixer::Fade decodingFade;
+	SampleMixer::Gain crossfadingGain;
+	SampleMixer::Fade crossfadingFade;
+	const float* crossfadingBuffer = nullptr;
+	long crossfadingSamplesRead = 0;
+
 	if ( 0 != bytesRead ) {
-		const long currentDecodingChannels = OutputDecoder::GetOutputChannels( m_CurrentItemDecoding.Info );
+		const long currentDecodingChannels = m_DecoderStream ? OutputDecoder::GetOutputChannels( m_DecoderStream->item.Info ) : 0;
 		if ( currentDecodingChannels > 0 ) {
-			ApplyGain( buffer, static_cast<long>( bytesRead / ( currentDecodingChannels * 4 ) ), m_CurrentItemDecoding, m_SoftClipStateDecoding );
+			decodingGain = PrepareGain( buffer, static_cast<long>( bytesRead / ( currentDecodingChannels * 4 ) ), m_DecoderStream->item, m_SoftClipStateDecoding );
 		}
 
-		std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
 		if ( m_CrossfadingStream ) {
-			// Decode and fade out the crossfading stream and mix with the final output buffer.
-			const long channels = m_Resample ? m_Resample->second : OutputDecoder::GetOutputChannels( m_CurrentItemCrossfading.Info );
-			const long samplerate = m_Resample ? m_Resample->first : m_CurrentItemCrossfading.Info.GetSampleRate();
+			// Decode the crossfading stream, and determine its fade out.
+			const long channels = m_Resample ? m_Resample->second : OutputDecoder::GetOutputChannels( m_CrossfadingStream->item.Info );
+			const long samplerate = m_Resample ? m_Resample->first : m_CrossfadingStream->item.Info.GetSampleRate();
 			if ( ( channels > 0 ) && ( samplerate > 0 ) ) {
 				const long samplesToRead = static_cast<long>( bytesRead ) / ( channels * 4 );
-				std::vector<float> crossfadingBuffer( bytesRead / 4 );
-				const long crossfadingBytesRead = m_CrossfadingStream->Read( crossfadingBuffer.data(), samplesToRead ) * channels * 4;
-				ApplyGain( crossfadingBuffer.data(), crossfadingBytesRead / ( channels * 4 ), m_CurrentItemCrossfading, m_SoftClipStateCrossfading );
+				if ( m_CrossfadingBuffer.size() < ( bytesRead / 4 ) ) {
+					m_CrossfadingBuffer.resize( bytesRead / 4 );
+				}
+				const long crossfadingBytesRead = m_CrossfadingStream->decoder->Read( m_CrossfadingBuffer.data(), samplesToRead ) * channels * 4;
+				crossfadingGain = PrepareGain( m_CrossfadingBuffer.data(), crossfadingBytesRead / ( channels * 4 ), m_CrossfadingStream->item, m_SoftClipStateCrossfading );
+				crossfadingBuffer = m_CrossfadingBuffer.data();
 				if ( crossfadingBytesRead <= static_cast<long>( bytesRead ) ) {
-					long crossfadingSamplesRead = crossfadingBytesRead / ( channels * 4 );
+					crossfadingSamplesRead = crossfadingBytesRead / ( channels * 4 );
 
-					if ( s_ItemIsFadingToNext == m_CurrentItemCrossfading.ID ) {
+					if ( s_ItemIsFadingToNext == m_CrossfadingItemID ) {
 						// Fade to next track.
 						const float currentPos = GetDecodePosition();
-						if ( ( currentPos > m_FadeOutStartPosition ) && ( channels > 0 ) && ( samplerate > 0 ) ) {
+						if ( currentPos > m_FadeOutStartPosition ) {
 							if ( ( currentPos - m_FadeOutStartPosition ) > GetFadeOutDuration() ) {
 								crossfadingSamplesRead = 0;
 							} else {
 								const float fadeOutEndPosition = m_FadeOutStartPosition + GetFadeOutDuration();
-								for ( long sampleIndex = 0; sampleIndex < crossfadingSamplesRead; sampleIndex++ ) {
-									const float pos = static_cast<float>( sampleIndex ) / samplerate;
-									float scale = static_cast<float>( fadeOutEndPosition - currentPos - pos ) / GetFadeOutDuration();
-									if ( ( scale < 0 ) || ( scale > 1.0f ) ) {
-										scale = 0;
-									}
-									for ( long channel = 0; channel < channels; channel++ ) {
-										crossfadingBuffer[ sampleIndex * channels + channel ] *= scale;
-									}
-								}
+								crossfadingFade = SampleMixer::GetFadeOut( currentPos, fadeOutEndPosition, GetFadeOutDuration(), samplerate );
 							}
 						}
 					} else {
 						// Crossfade.
 						const float trackPos = GetDecodePosition() - m_LastTransitionPosition - m_LeadInSeconds;
 						if ( ( crossfadingBytesRead > 0 ) && ( trackPos < GetFadeOutDuration() ) ) {
-							for ( long sampleIndex = 0; sampleIndex < crossfadingSamplesRead; sampleIndex++ ) {
-								const float pos = static_cast<float>( sampleIndex ) / samplerate;
-								float scale = static_cast<float>( GetFadeOutDuration() - trackPos - pos ) / GetFadeOutDuration();
-								if ( ( scale < 0 ) || ( scale > 1.0f ) ) {
-									scale = 0;
-								}
-								for ( long channel = 0; channel < channels; channel++ ) {
-									crossfadingBuffer[ sampleIndex * channels + channel ] *= scale;
-								}
-							}
+							crossfadingFade = SampleMixer::GetFadeOut( trackPos, GetFadeOutDuration(), GetFadeOutDuration(), samplerate );
 						} else {
 							crossfadingSamplesRead = 0;
 						}
 					}
 
 					if ( 0 == crossfadingSamplesRead ) {
-						m_CrossfadingStream.reset();
-						m_CurrentItemCrossfading = {};
-						m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
-						m_SoftClipStateCrossfading.clear();
-					} else {
-						for ( long sample = 0; sample < crossfadingSamplesRead * channels; sample++ ) {
-							buffer[ sample ] += crossfadingBuffer[ sample ];
-						}
+						ResetCrossfadingStream();
 					}
 				}
 			}
 		}
 	}
 
-	// Apply fade out on the currently decoding track, if necessary.
+	// Determine the fade out on the currently decoding track, if necessary.
 	if ( ( GetFadeOut() || GetFadeToNext() ) && ( 0 != bytesRead ) && ( m_FadeOutStartPosition > 0 ) && m_DecoderStream ) {
 		const float currentPos = GetDecodePosition();
-		const long channels = m_DecoderStream->GetOutputChannels();
-		const long samplerate = m_DecoderStream->GetOutputSampleRate();
+		const long channels = m_DecoderStream->decoder->GetOutputChannels();
+		const long samplerate = m_DecoderStream->decoder->GetOutputSampleRate();
 		if ( ( currentPos > m_FadeOutStartPosition ) && ( channels > 0 ) && ( samplerate > 0 ) ) {
 			if ( ( currentPos - m_FadeOutStartPosition ) > GetFadeOutDuration() ) {
 				bytesRead = 0;
@@ -883,18 +930,8 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 				m_RestartItemID = {};
 				SetEndSync( handle );
 			} else {
-				const long sampleCount = static_cast<long>( bytesRead ) / ( channels * 4 );
 				const float fadeOutEndPosition = m_FadeOutStartPosition + GetFadeOutDuration();
-				for ( long sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++ ) {
-					const float pos = static_cast<float>( sampleIndex ) / samplerate;
-					float scale = static_cast<float>( fadeOutEndPosition - currentPos - pos ) / GetFadeOutDuration();
-					if ( ( scale < 0 ) || ( scale > 1.0f ) ) {
-						scale = 0;
-					}
-					for ( long channel = 0; channel < channels; channel++ ) {
-						buffer[ sampleIndex * channels + channel ] *= scale;
-					}
-				}
+				decodingFade = SampleMixer::GetFadeOut( currentPos, fadeOutEndPosition, GetFadeOutDuration(), samplerate );
 
 				if ( GetFadeToNext() && ( currentPos > ( m_FadeOutStartPosition + GetFadeToNextDuration() ) ) ) {
 					m_SwitchToNext = true;
@@ -903,6 +940,18 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 		}
 	}
 
+	// Apply the gain & fade to the output buffer, mixing in any crossfading stream.
+	if ( ( 0 != bytesRead ) && m_DecoderStream ) {
+		if ( const long channels = m_DecoderStream->decoder->GetOutputChannels(); channels > 0 ) {
+			const size_t frames = static_cast<size_t>( bytesRead ) / ( channels * 4 );
+			SampleMixer::Mix( buffer, frames, decodingGain, decodingFade,
+				crossfadingBuffer, static_cast<size_t>( crossfadingSamplesRead ), crossfadingGain, crossfadingFade, static_cast<uint32_t>( channels ) );
+			if ( m_Equaliser && ( m_Equaliser->GetChannels() == static_cast<uint32_t>( channels ) ) ) {
+				m_Equaliser->Process( buffer, frames );
+			}
+		}
+	}
+
 	return bytesRead;
 }
 
@@ -962,107 +1011,38 @@ void Output::SetBalance( const float balance )
 void Output::GetLevels( float& left, float& right )
 {
 	left = right = 0;
-	if ( 0 != m_OutputStream ) {
-		float levels[ 2 ] = {};
-		const float length = 0.05f;
-		switch ( m_OutputMode ) {
-			case Settings::OutputMode::Standard: {
-				if ( TRUE == BASS_ChannelGetLevelEx( m_OutputStream, levels, length, BASS_LEVEL_STEREO ) ) {
-					left = levels[ 0 ];
-					right = levels[ 1 ];
-				}
-				break;
-			}
-			case Settings::OutputMode::WASAPIExclusive: {
-				if ( TRUE == BASS_WASAPI_GetLevelEx( levels, length, BASS_LEVEL_STEREO ) ) {
-					left = levels[ 0 ];
-					right = levels[ 1 ];
-				}
-				break;
-			}
-			case Settings::OutputMode::ASIO: {
-				if ( TRUE == BASS_Mixer_ChannelGetLevelEx( m_OutputStream, levels, length, BASS_LEVEL_STEREO ) ) {
-					left = levels[ 0 ];
-					right = levels[ 1 ];
-				}
-				break;
-			}
+	if ( const auto analysisTap = GetAnalysisTap(); analysisTap ) {
+		if ( AnalysisTap::Levels levels; analysisTap->GetLevels( GetOutputStreamPosition(), levels ) ) {
+			left = levels.LeftPeak;
+			right = levels.RightPeak;
 		}
 	}
 }
 
 void Output::GetSampleData( const long sampleCount, std::vector<float>& samples, long& channels )
 {
-	if ( 0 != m_OutputStream ) {
-		switch ( m_OutputMode ) {
-			case Settings::OutputMode::Standard:
-			case Settings::OutputMode::ASIO: {
-				BASS_CHANNELINFO channelInfo = {};
-				if ( BASS_ChannelGetInfo( m_OutputStream, &channelInfo ) ) {
-					channels = static_cast<long>( channelInfo.chans );
-					const long sampleSize = channels * sampleCount;
-					if ( sampleSize > 0 ) {
-						samples.resize( sampleSize );
-						if ( Settings::OutputMode::Standard == m_OutputMode ) {
-							BASS_ChannelGetData( m_OutputStream, samples.data(), sampleSize * sizeof( float ) );
-						} else {
-							BASS_Mixer_ChannelGetData( m_OutputStream, samples.data(), sampleSize * sizeof( float ) );
-						}
-					}
-				}
-				break;
-			}
-			case Settings::OutputMode::WASAPIExclusive: {
-				if ( BASS_WASAPI_IsStarted() ) {
-					BASS_WASAPI_INFO wasapiInfo = {};
-					if ( TRUE == BASS_WASAPI_GetInfo( &wasapiInfo ) ) {
-						channels = static_cast<long>( wasapiInfo.chans );
-						const long sampleSize = channels * sampleCount;
-						if ( sampleSize > 0 ) {
-							samples.resize( sampleSize );
-							BASS_WASAPI_GetData( samples.data(), sampleSize * sizeof( float ) );
-						}
-					}
-				}
-				break;
-			}
+	samples.clear();
+	channels = 0;
+	if ( const auto analysisTap = GetAnalysisTap(); analysisTap && ( sampleCount > 0 ) ) {
+		if ( !analysisTap->GetSamples( GetOutputStreamPosition(), static_cast<size_t>( sampleCount ), samples, channels ) ) {
+			channels = 0;
 		}
 	}
 }
 
 void Output::GetFFTData( std::vector<float>& fft )
 {
-	constexpr std::pair fftSize{ BASS_DATA_FFT4096, 2048 };
-
-	if ( 0 != m_OutputStream ) {
-		switch ( m_OutputMode ) {
-			case Settings::OutputMode::Standard: {
-				fft.resize( fftSize.second );
-				if ( -1 == BASS_ChannelGetData( m_OutputStream, fft.data(), BASS_DATA_FLOAT | fftSize.first ) ) {
-					fft.clear();
-				}
-				break;
-			}
-			case Settings::OutputMode::WASAPIExclusive: {
-				if ( BASS_WASAPI_IsStarted() ) {
-					fft.resize( fftSize.second );
-					if ( -1 == BASS_WASAPI_GetData( fft.data(), BASS_DATA_FLOAT | fftSize.first ) ) {
-						fft.clear();
-					}
-				}
-				break;
-			}
-			case Settings::OutputMode::ASIO: {
-				fft.resize( fftSize.second );
-				if ( -1 == BASS_Mixer_ChannelGetData( m_OutputStream, fft.data(), BASS_DATA_FLOAT | fftSize.first ) ) {
-					fft.clear();
-				}
-				break;
-			}
-		}
+	fft.clear();
+	if ( const auto analysisTap = GetAnalysisTap(); analysisTap ) {
+		analysisTap->GetFFT( GetOutputStreamPosition(), fft );
 	}
 }
 
+std::shared_ptr<AnalysisTap> Output::GetAnalysisTap() const
+{
+	return m_AnalysisTap.load();
+}
+
 void Output::OnSyncEnd()
 {
 	if ( m_RestartItemID > 0 ) {
@@ -1091,8 +1071,10 @@ void Output::SetRandomPlay( const bool enabled )
 		if ( m_RandomPlay ) {
 			m_RepeatTrack = m_RepeatPlaylist = false;
 		}
-		std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-		m_PreloadedDecoder = {};
+		// Have the preload decoder thread choose the next item again.
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+		m_PreloadedDecoder.reselect = true;
+		SetEvent( m_PreloadDecoderWakeEvent );
 	}
 }
 
@@ -1153,7 +1135,15 @@ void Output::SetLoudnessNormalisation( const bool enabled )
 {
 	m_LoudnessNormalisation = enabled;
 	if ( m_LoudnessNormalisation ) {
-		EstimateGain( m_CurrentItemDecoding );
+		{
+			std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+			if ( m_PreloadedDecoder.current ) {
+				EstimateGain( m_PreloadedDecoder.current->item );
+			}
+			if ( m_PreloadedDecoder.next ) {
+				EstimateGain( m_PreloadedDecoder.next->item );
+			}
+		}
 		if ( State::Stopped != GetState() ) {
 			StartLoudnessPrecalcThread();
 		}
@@ -1162,7 +1152,7 @@ void Output::SetLoudnessNormalisation( const bool enabled )
 
 bool Output::OnUpdatedMedia( const MediaInfo& mediaInfo )
 {
-	std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_PlaylistMutex );
 
 	bool changed = false;
 	State state = GetState();
@@ -1251,6 +1241,10 @@ void Output::SettingsChanged()
 	std::wstring settingsDevice;
 	Settings::OutputMode settingsMode = Settings::OutputMode::Standard;
 	m_Settings.GetOutputSettings( settingsDevice, settingsMode );
+	if ( m_NullOutput ) {
+		settingsDevice.clear();
+		settingsMode = Settings::OutputMode::Null;
+	}
 
 	uint32_t resamplerRate = 0;
 	uint32_t resamplerChannels = 0;
@@ -1286,6 +1280,7 @@ void Output::SettingsChanged()
 	}
 
 	m_RetainStopAtTrackEnd = m_Settings.GetRetainStopAtTrackEnd();
+	m_SilenceThreshold = std::pow( 10.0f, m_Settings.GetSilenceThreshold() / 20 );
 
 	m_Handlers.SettingsChanged( m_Settings );
 }
@@ -1294,6 +1289,10 @@ void Output::InitialiseOutput()
 {
 	int deviceNum = -1;
 	m_Settings.GetOutputSettings( m_OutputDevice, m_OutputMode );
+	if ( m_NullOutput ) {
+		m_OutputDevice.clear();
+		m_OutputMode = Settings::OutputMode::Null;
+	}
 
 	if ( ( Settings::OutputMode::ASIO == m_OutputMode ) && !InitASIO() ) {
 		m_OutputDevice.clear();
@@ -1381,14 +1380,21 @@ void Output::EstimateGain( Playlist::Item& item )
 			}
 		}
 		if ( !gain.has_value() ) {
-			const auto estimateIter = m_GainEstimateMap.find( item.ID );
-			if ( m_GainEstimateMap.end() != estimateIter ) {
-				item.Info.SetGainTrack( estimateIter->second );
+			std::optional<std::optional<float>> estimate;
+			{
+				std::lock_guard<RealtimeAudit::Mutex> lock( m_GainEstimateMutex );
+				if ( const auto estimateIter = m_GainEstimateMap.find( item.ID ); m_GainEstimateMap.end() != estimateIter ) {
+					estimate = estimateIter->second;
+				}
+			}
+			if ( estimate ) {
+				item.Info.SetGainTrack( *estimate );
 			} else {
 				const auto tempDecoder = OpenDecoder( item, Decoder::Context::Temporary );
 				if ( tempDecoder ) {
 					const auto trackGain = tempDecoder->CalculateTrackGain( [] () { return true; }, s_GainPrecalcTime );
 					item.Info.SetGainTrack( trackGain );
+					std::lock_guard<RealtimeAudit::Mutex> lock( m_GainEstimateMutex );
 					m_GainEstimateMap.insert( GainEstimateMap::value_type( item.ID, trackGain ) );
 				}
 			}
@@ -1411,40 +1417,32 @@ void Output::CalculateCrossfadeHandler()
 		return;
 	}
 
-	const auto decoder = IsURL( m_CrossfadeItem.Info.GetFilename() ) ? nullptr : OpenDecoder( m_CrossfadeItem, Decoder::Context::Input );
-	if ( decoder ) {
-		const float duration = decoder->GetDuration();
-		const long channels = decoder->GetChannels();
-		const long samplerate = decoder->GetSampleRate();
-		if ( ( duration > 0 ) && ( channels > 0 ) && ( samplerate > 0 ) ) {
-			const double crossfadePosition = CalculateCrossfadePosition( decoder, m_CrossfadeSeekOffset, [ this ] () {
-				return WAIT_OBJECT_0 != WaitForSingleObject( m_CrossfadeStopEvent, 0 );
-				} );
-			if ( WAIT_OBJECT_0 != WaitForSingleObject( m_CrossfadeStopEvent, 0 ) ) {
-				SetCrossfadePosition( crossfadePosition - m_CrossfadeSeekOffset );
-
-				Playlist::Item nextItem = {};
-				{
-					std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-					nextItem = m_PreloadedDecoder.item;
-				}
-				if ( MediaInfo::Source::CDDA == nextItem.Info.GetSource() ) {
-					// Pre-cache some CD audio data for the next track, to prevent glitches when crossfading.
-					if ( const auto nextDecoder = OpenDecoder( nextItem, Decoder::Context::Output ); nextDecoder ) {
-						const long bufferSize = nextDecoder->GetSampleRate() / 10;
-						std::vector<float> buffer( bufferSize * channels );
-						const long kSamplesToRead = 10 * nextDecoder->GetSampleRate();
-						long totalSamplesRead = 0;
-						while ( WAIT_OBJECT_0 != WaitForSingleObject( m_CrossfadeStopEvent, 0 ) ) {
-							const long samplesRead = nextDecoder->ReadSamples( buffer.data(), bufferSize );
-							totalSamplesRead += samplesRead;
-							if ( ( totalSamplesRead >= kSamplesToRead ) || ( samplesRead <= 0 ) ) {
-								break;
-							}
-						}
+	const auto canContinue = [ this ] () {
+		return WAIT_OBJECT_0 != WaitForSingleObject( m_CrossfadeStopEvent, 0 );
+	};
+
+	if ( const auto analysis = GetCrossfadeAnalysis( m_CrossfadeItem, canContinue ); analysis && canContinue() ) {
+		SetCrossfadePosition( CrossfadeAnalysis::GetCrossfadePosition( *analysis, m_CrossfadeSeekOffset, s_CrossfadeVolume ) );
+
+		Playlist::Item nextItem = GetPreloadedItem();
+		if ( MediaInfo::Source::CDDA == nextItem.Info.GetSource() ) {
+			// Pre-cache some CD audio data for the next track, to prevent glitches when crossfading.
+			if ( const auto nextDecoder = OpenDecoder( nextItem, Decoder::Context::Output ); nextDecoder ) {
+				const long bufferSize = nextDecoder->GetSampleRate() / 10;
+				std::vector<float> buffer( bufferSize * nextDecoder->GetChannels() );
+				const long kSamplesToRead = 10 * nextDecoder->GetSampleRate();
+				long totalSamplesRead = 0;
+				while ( canContinue() ) {
+					const long samplesRead = nextDecoder->ReadSamples( buffer.data(), bufferSize );
+					totalSamplesRead += samplesRead;
+					if ( ( totalSamplesRead >= kSamplesToRead ) || ( samplesRead <= 0 ) ) {
+						break;
 					}
 				}
 			}
+		} else if ( ( nextItem.ID > 0 ) && !IsURL( nextItem.Info.GetFilename() ) ) {
+			// Analyse the next track in advance, so that its crossfade position is available as soon as it starts.
+			GetCrossfadeAnalysis( nextItem, canContinue );
 		}
 	}
 }
@@ -1462,58 +1460,110 @@ void Output::StopCrossfadeCalculationThread()
 	m_CrossfadeItem = {};
 }
 
-double Output::CalculateCrossfadePosition( Decoder::Ptr decoder, const double seekOffset, Decoder::CanContinue canContinue ) const
+std::optional<CrossfadeAnalysis::Analysis> Output::GetCrossfadeAnalysis( Playlist::Item& item, Decoder::CanContinue canContinue )
 {
-	if ( !decoder )
-		return 0;
+	if ( IsURL( item.Info.GetFilename() ) ) {
+		return std::nullopt;
+	}
+	auto analysis = CrossfadeAnalysis::Get( item.Info, m_SilenceThreshold );
+	if ( !analysis ) {
+		if ( const auto decoder = OpenDecoder( item, Decoder::Context::Input ); decoder && ( decoder->GetDuration() > 0 ) ) {
+			const Metrics::Timer timer( Metrics::Histogram::CrossfadeCalculation );
+			analysis = AnalyseCrossfade( decoder, item.Info, canContinue );
+			if ( analysis ) {
+				CrossfadeAnalysis::Set( item.Info, *analysis );
+			}
+		}
+	}
+	return analysis;
+}
 
-	if ( 0.0f == seekOffset ) {
-		decoder->SkipSilence();
+std::optional<CrossfadeAnalysis::Analysis> Output::AnalyseCrossfade( Decoder::Ptr decoder, const MediaInfo& mediaInfo, Decoder::CanContinue canContinue ) const
+{
+	const long sampleRate = decoder ? decoder->GetSampleRate() : 0;
+	const long channels = decoder ? decoder->GetChannels() : 0;
+	if ( ( sampleRate <= 0 ) || ( channels <= 0 ) ) {
+		return std::nullopt;
 	}
 
-	double position = 0;
-	if ( seekOffset > 0 ) {
-		position = decoder->SetPosition( seekOffset );
+	const auto knownSilence = SilenceOffsets::Get( mediaInfo, m_SilenceThreshold );
+	SilenceOffsets::Offsets silence = knownSilence.value_or( SilenceOffsets::Offsets{ m_SilenceThreshold } );
+	if ( knownSilence ) {
+		if ( silence.Leading > 0 ) {
+			decoder->SetPosition( static_cast<double>( silence.Leading ) / sampleRate );
+		}
+	} else {
+		silence.Leading = decoder->SkipSilence( m_SilenceThreshold );
 	}
-	double crossfadePosition = 0;
 
-	int64_t cumulativeCount = 0;
-	double cumulativeTotal = 0;
-	double cumulativeRMS = 0;
+	CrossfadeAnalysis::Analysis analysis;
+	analysis.Threshold = m_SilenceThreshold;
+	analysis.SampleRate = sampleRate;
+	analysis.WindowSize = std::max<long>( 1, sampleRate / 10 );
+	analysis.StartFrame = silence.Leading;
 
-	const double crossfadeRMSRatio = s_CrossfadeVolume;
-	const long windowSize = decoder->GetSampleRate() / 10;
-	std::vector<float> buffer( windowSize * decoder->GetChannels() );
+	// Trailing silence does not affect the crossfade position, so there is no need to read past it when it is known.
+	const std::optional<int64_t> endFrame = silence.Trailing;
+	std::optional<int64_t> lastNonSilentFrame;
+	int64_t frame = silence.Leading;
 
+	std::vector<float> buffer( analysis.WindowSize * channels );
+	bool completed = false;
 	while ( ( nullptr == canContinue ) || canContinue() ) {
-		long sampleCount = decoder->ReadSamples( buffer.data(), windowSize );
-		if ( sampleCount > 0 ) {
+		const long samplesToRead = endFrame ? static_cast<long>( std::clamp<int64_t>( *endFrame - frame, 0, analysis.WindowSize ) ) : analysis.WindowSize;
+		long sampleCount = 0;
+		while ( sampleCount < samplesToRead ) {
+			const long samplesRead = decoder->ReadSamples( buffer.data() + sampleCount * channels, samplesToRead - sampleCount );
+			if ( samplesRead <= 0 ) {
+				break;
+			}
+			sampleCount += samplesRead;
+		}
 
-			auto sampleIter = buffer.begin();
+		if ( sampleCount > 0 ) {
+			const size_t totalSamples = static_cast<size_t>( sampleCount ) * channels;
 			double windowTotal = 0;
-			for ( long sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++ ) {
-				for ( long channel = 0; channel < decoder->GetChannels(); channel++, sampleIter++, cumulativeCount++ ) {
-					const double value = *sampleIter * *sampleIter;
-					windowTotal += value;
-					cumulativeTotal += value;
-				}
+			for ( size_t sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
+				windowTotal += static_cast<double>( buffer[ sampleIndex ] ) * buffer[ sampleIndex ];
 			}
+			analysis.Envelope.push_back( static_cast<float>( windowTotal / totalSamples ) );
 
-			const double windowRMS = sqrt( windowTotal / ( sampleCount * decoder->GetChannels() ) );
-			cumulativeRMS = sqrt( cumulativeTotal / cumulativeCount );
-			position += static_cast<double>( sampleCount ) / decoder->GetSampleRate();
-
-			if ( windowRMS > cumulativeRMS ) {
-				crossfadePosition = position;
-			} else if ( ( cumulativeRMS > 0 ) && ( ( windowRMS / cumulativeRMS ) > crossfadeRMSRatio ) ) {
-				crossfadePosition = position;
+			if ( const size_t lastSample = SampleConversion::FindLastAboveThreshold( buffer.data(), totalSamples, m_SilenceThreshold ); lastSample > 0 ) {
+				lastNonSilentFrame = frame + static_cast<int64_t>( ( lastSample + channels - 1 ) / channels );
 			}
+			frame += sampleCount;
+		}
 
-		} else {
+		if ( ( sampleCount < samplesToRead ) || ( 0 == samplesToRead ) ) {
+			completed = true;
 			break;
 		}
 	}
-	return crossfadePosition;
+
+	if ( !completed ) {
+		return std::nullopt;
+	}
+
+	analysis.EndFrame = frame;
+	if ( !silence.Trailing ) {
+		silence.Trailing = lastNonSilentFrame.value_or( silence.Leading );
+		SilenceOffsets::Set( mediaInfo, silence );
+	}
+	return analysis;
+}
+
+void Output::SkipSilence( const OutputDecoderPtr& decoder, const Playlist::Item& item )
+{
+	if ( decoder ) {
+		if ( const auto silence = SilenceOffsets::Get( item.Info, m_SilenceThreshold ); silence ) {
+			if ( silence->Leading > 0 ) {
+				decoder->SkipSilence( m_SilenceThreshold, silence->Leading );
+			}
+		} else {
+			const int64_t leading = decoder->SkipSilence( m_SilenceThreshold );
+			SilenceOffsets::Set( item.Info, SilenceOffsets::Offsets{ m_SilenceThreshold, leading } );
+		}
+	}
 }
 
 double Output::GetCrossfadePosition() const
@@ -1579,12 +1629,11 @@ void Output::ToggleFadeToNext()
 		m_FadeOutStartPosition = GetDecodePosition();
 	} else {
 		m_SwitchToNext = false;
-		std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
-		if ( m_CrossfadingStream ) {
-			m_CrossfadingStream.reset();
-			m_CurrentItemCrossfading = {};
-			m_CrossfadingItemID = m_CurrentItemCrossfading.ID;
-			m_SoftClipStateCrossfading.clear();
+		if ( 0 != m_OutputStream ) {
+			// The crossfading stream is owned by the output callback, so request that it stops the stream.
+			m_CancelCrossfadingStream = true;
+		} else {
+			ResetCrossfadingStream();
 		}
 	}
 }
@@ -1594,53 +1643,50 @@ bool Output::GetFadeToNext() const
 	return m_FadeToNext;
 }
 
-void Output::ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState )
+SampleMixer::Gain Output::PrepareGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState )
 {
+	SampleMixer::Gain gain;
 	const bool eqEnabled = m_EQEnabled;
 	const long channels = OutputDecoder::GetOutputChannels( item.Info );
 	if ( ( 0 != sampleCount ) && ( channels > 0 ) && ( m_LoudnessNormalisation || eqEnabled ) ) {
 		float preamp = eqEnabled ? m_EQPreamp : 0;
 
 		if ( m_LoudnessNormalisation ) {
-			auto gain = item.Info.GetGainAlbum();
-			if ( !gain.has_value() || ( Settings::GainMode::Album != m_GainMode ) ) {
+			auto itemGain = item.Info.GetGainAlbum();
+			if ( !itemGain.has_value() || ( Settings::GainMode::Album != m_GainMode ) ) {
 				if ( const auto trackGain = item.Info.GetGainTrack(); trackGain.has_value() ) {
-					gain = trackGain;
+					itemGain = trackGain;
 				}
 			}
-			if ( gain.has_value() ) {
-				if ( gain.value() < s_GainMin ) {
-					gain = s_GainMin;
-				} else if ( gain.value() > s_GainMax ) {
-					gain = s_GainMax;
+			if ( itemGain.has_value() ) {
+				if ( itemGain.value() < s_GainMin ) {
+					itemGain = s_GainMin;
+				} else if ( itemGain.value() > s_GainMax ) {
+					itemGain = s_GainMax;
 				}
 				preamp += m_GainPreamp;
-				preamp += gain.value();
+				preamp += itemGain.value();
 			}
 		}
 
 		if ( 0 != preamp ) {
-			const float scale = powf( 10.0f, preamp / 20.0f );
-			const long totalSamples = sampleCount * channels;
-			for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
-				buffer[ sampleIndex ] *= scale;
-			}
+			gain.Scale = powf( 10.0f, preamp / 20.0f );
 			switch ( m_LimitMode ) {
 				case Settings::LimitMode::Hard: {
-					for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
-						if ( buffer[ sampleIndex ] < -1.0f ) {
-							buffer[ sampleIndex ] = -1.0f;
-						} else if ( buffer[ sampleIndex ] > 1.0f ) {
-							buffer[ sampleIndex ] = 1.0f;
-						}
-					}
+					gain.Limit = true;
 					break;
 				}
 				case Settings::LimitMode::Soft: {
+					// Apply the gain & soft limit to the buffer now, rather than in the output mix.
+					const long totalSamples = sampleCount * channels;
+					for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
+						buffer[ sampleIndex ] *= gain.Scale;
+					}
 					if ( softClipState.size() != static_cast<size_t>( channels ) ) {
 						softClipState.resize( channels, 0 );
 					}
 					opus_pcm_soft_clip( buffer, sampleCount, channels, softClipState.data() );
+					gain = {};
 					break;
 				}
 				default: {
@@ -1649,20 +1695,63 @@ void Output::ApplyGain( float* buffer, const long sampleCount, const Playlist::I
 			}
 		}
 	}
+	return gain;
 }
 
 Output::Queue Output::GetOutputQueue()
 {
-	std::lock_guard<std::mutex> lock( m_QueueMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_QueueMutex );
+	UpdateOutputQueue();
 	return m_OutputQueue;
 }
 
 void Output::SetOutputQueue( const Queue& queue )
 {
-	std::lock_guard<std::mutex> lock( m_QueueMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_QueueMutex );
 	m_OutputQueue = queue;
 }
 
+void Output::AddToOutputQueue( Item&& item )
+{
+	if ( !m_OutputQueueEvents.Push( std::move( item ) ) ) {
+		// The pending item queue is full, so add the item directly.
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_QueueMutex );
+		UpdateOutputQueue();
+		m_OutputQueue.push_back( std::move( item ) );
+	}
+}
+
+void Output::UpdateOutputQueue()
+{
+	Item item;
+	while ( m_OutputQueueEvents.Pop( item ) ) {
+		m_OutputQueue.push_back( std::move( item ) );
+	}
+}
+
+void Output::RetireDecoderStream( DecoderStreamPtr& stream )
+{
+	if ( stream && !m_RetiredDecoders.Push( std::move( stream ) ) ) {
+		// The retired decoder queue is full, so the stream has to be freed here.
+		stream.reset();
+	}
+}
+
+void Output::FreeRetiredDecoders()
+{
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_QueueMutex );
+	m_RetiredDecoders.Clear();
+}
+
+void Output::ResetCrossfadingStream()
+{
+	if ( m_CrossfadingStream ) {
+		RetireDecoderStream( m_CrossfadingStream );
+		m_CrossfadingItemID = 0;
+		m_SoftClipStateCrossfading.clear();
+	}
+}
+
 float Output::GetPitchRange() const
 {
 	const float range = m_Settings.GetPitchRangeOptions()[ m_Settings.GetPitchRange() ];
@@ -1675,58 +1764,14 @@ void Output::UpdateEQ( const Settings::EQ& eq )
 	m_EQPreamp = eq.Preamp;
 
 	m_CurrentEQ = eq;
-	if ( 0 != m_OutputStream ) {
-		if ( eq.Enabled ) {
-			if ( m_FX.empty() ) {
-				// Add FX to current output stream.
-				BASS_DX8_PARAMEQ params = {};
-				params.fBandwidth = eq.Bandwidth;
-				for ( const auto& setting : eq.Gains ) {
-					const int freq = setting.first;
-					const HFX fx = BASS_ChannelSetFX( m_OutputStream, BASS_FX_DX8_PARAMEQ, 100 /*priority*/ );
-					if ( 0 != fx ) {
-						params.fCenter = static_cast<float>( freq );
-						params.fGain = setting.second;
-						BASS_FXSetParameters( fx, &params );
-
-						BASS_FXGetParameters( fx, &params );
-						if ( static_cast<int>( params.fCenter ) != freq ) {
-							// The centre frequency was too high for the stream, so remove the FX.
-							BASS_ChannelRemoveFX( m_OutputStream, fx );
-						} else {
-							m_FX.push_back( fx );
-						}
-					}
-				}
-			} else {
-				// Modify FX on the current output stream.
-				for ( const auto& fx : m_FX ) {
-					BASS_DX8_PARAMEQ params = {};
-					if ( BASS_FXGetParameters( fx, &params ) ) {
-						const int freq = static_cast<int>( params.fCenter );
-						const auto setting = eq.Gains.find( freq );
-						if ( eq.Gains.end() != setting ) {
-							const float gain = setting->second;
-							if ( gain != params.fGain ) {
-								params.fGain = gain;
-								BASS_FXSetParameters( fx, &params );
-							}
-						}
-					}
-				}
-			}
-		} else {
-			// Disable EQ.
-			for ( const auto& fx : m_FX ) {
-				BASS_ChannelRemoveFX( m_OutputStream, fx );
-			}
-			m_FX.clear();
-		}
+	if ( m_Equaliser ) {
+		m_Equaliser->SetSettings( eq );
 	}
 }
 
 Decoder::Ptr Output::OpenDecoder( Playlist::Item& item, const Decoder::Context context )
 {
+	const Metrics::Timer timer( Metrics::Histogram::DecoderOpen );
 	constexpr bool applyCues = true;
 	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info, context, applyCues );
 	if ( !decoder ) {
@@ -1744,32 +1789,22 @@ Decoder::Ptr Output::OpenDecoder( Playlist::Item& item, const Decoder::Context c
 	return decoder;
 }
 
-Output::OutputDecoderPtr Output::OpenOutputDecoder( Playlist::Item& item, const bool usePreloadedDecoder )
+bool Output::UsePreBuffer( const Playlist::Item& item ) const
+{
+	return !IsURL( item.Info.GetFilename() ) && !m_NullOutput;
+}
+
+Output::OutputDecoderPtr Output::OpenOutputDecoder( Playlist::Item& item )
 {
 	OutputDecoderPtr outputDecoder;
-	if ( usePreloadedDecoder ) {
-		std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-		const auto& info = m_PreloadedDecoder.item.Info;
-		if ( m_PreloadedDecoder.decoder && ( std::tie( info.GetFilename(), info.GetCueStart(), info.GetCueEnd() ) == std::tie( item.Info.GetFilename(), item.Info.GetCueStart(), item.Info.GetCueEnd() ) ) && ( info.GetFiletime() == item.Info.GetFiletime() ) ) {
-			outputDecoder = m_PreloadedDecoder.decoder;
-			m_PreloadedDecoder.decoder.reset();
-			m_PreloadedDecoder.item = {};
-			if ( !IsURL( item.Info.GetFilename() ) ) {
-				// Ensure pre-buffering has started (in case the pre-buffer finished callback was not received for the previous decoder).
-				outputDecoder->PreBuffer( m_OnPreBufferFinishedCallback );
-			}
-		}
-	}
-	if ( !outputDecoder ) {
-		try {
-			std::optional<uint32_t> resamplerRate = m_Resample ? std::make_optional( m_Resample->first ) : std::nullopt;
-			std::optional<uint32_t> resamplerChannels = m_Resample ? std::make_optional( m_Resample->second ) : std::nullopt;
-			if ( resamplerRate && resamplerChannels )
-				outputDecoder = std::make_shared<Resampler>( OpenDecoder( item, Decoder::Context::Output ), item.ID, *resamplerRate, *resamplerChannels );
-			else
-				outputDecoder = std::make_shared<OutputDecoder>( OpenDecoder( item, Decoder::Context::Output ), item.ID );
-		} catch ( const std::runtime_error& ) {
-		}
+	try {
+		std::optional<uint32_t> resamplerRate = m_Resample ? std::make_optional( m_Resample->first ) : std::nullopt;
+		std::optional<uint32_t> resamplerChannels = m_Resample ? std::make_optional( m_Resample->second ) : std::nullopt;
+		if ( resamplerRate && resamplerChannels )
+			outputDecoder = std::make_shared<Resampler>( OpenDecoder( item, Decoder::Context::Output ), item.ID, *resamplerRate, *resamplerChannels, Resampler::GetQuality( Decoder::Context::Output ) );
+		else
+			outputDecoder = std::make_shared<OutputDecoder>( OpenDecoder( item, Decoder::Context::Output ), item.ID );
+	} catch ( const std::runtime_error& ) {
 	}
 	return outputDecoder;
 }
@@ -1810,6 +1845,13 @@ Output::State Output::StartOutput()
 			}
 			break;
 		}
+		case Settings::OutputMode::Null: {
+			if ( m_NullSink ) {
+				m_NullSink->Start();
+				state = State::Playing;
+			}
+			break;
+		}
 	}
 	return state;
 }
@@ -1826,24 +1868,34 @@ float Output::GetOutputPosition() const
 	if ( m_PausedOnStartup )
 		return 0;
 
-	float seconds = 0;
+	float seconds = static_cast<float>( GetOutputStreamPosition() );
+	if ( ( Settings::OutputMode::WASAPIExclusive == m_OutputMode ) || ( Settings::OutputMode::ASIO == m_OutputMode ) ) {
+		seconds -= m_LeadInSeconds;
+		if ( seconds < 0 ) {
+			seconds = 0;
+		}
+	}
+	return seconds;
+}
+
+double Output::GetOutputStreamPosition() const
+{
+	double seconds = 0;
 	switch ( m_OutputMode ) {
-		case Settings::OutputMode::Standard: {
+		case Settings::OutputMode::Standard:
+		case Settings::OutputMode::Null: {
 			const QWORD bytePos = BASS_ChannelGetPosition( m_OutputStream, BASS_POS_BYTE );
-			seconds = static_cast<float>( BASS_ChannelBytes2Seconds( m_OutputStream, bytePos ) );
+			seconds = BASS_ChannelBytes2Seconds( m_OutputStream, bytePos );
 			break;
 		}
 		case Settings::OutputMode::WASAPIExclusive:
 		case Settings::OutputMode::ASIO: {
 			const QWORD bytePos = BASS_Mixer_ChannelGetPosition( m_OutputStream, BASS_POS_BYTE );
-			seconds = static_cast<float>( BASS_ChannelBytes2Seconds( m_OutputStream, bytePos ) ) - m_LeadInSeconds;
-			if ( seconds < 0 ) {
-				seconds = 0;
-			}
+			seconds = BASS_ChannelBytes2Seconds( m_OutputStream, bytePos );
 			break;
 		}
 	}
-	return seconds;
+	return ( seconds > 0 ) ? seconds : 0;
 }
 
 LONGLONG Output::GetTick()
@@ -1866,6 +1918,7 @@ bool Output::CreateOutputStream( const MediaInfo& mediaInfo )
 	const DWORD samplerate = static_cast<DWORD>( m_Resample ? m_Resample->first : mediaInfo.GetSampleRate() );
 	const DWORD channels = static_cast<DWORD>( m_Resample ? m_Resample->second : OutputDecoder::GetOutputChannels( mediaInfo ) );
 	if ( ( samplerate > 0 ) && ( channels > 0 ) ) {
+		m_OutputStreamBytesPerSecond = static_cast<double>( samplerate ) * channels * sizeof( float );
 		switch ( m_OutputMode ) {
 			case Settings::OutputMode::Standard: {
 				m_LeadInSeconds = 0;
@@ -2037,6 +2090,29 @@ bool Output::CreateOutputStream( const MediaInfo& mediaInfo )
 				}
 				break;
 			}
+
+			case Settings::OutputMode::Null: {
+				m_LeadInSeconds = 0;
+				const DWORD flags = BASS_SAMPLE_FLOAT | BASS_STREAM_DECODE;
+				m_OutputStream = BASS_StreamCreate( samplerate, channels, flags, StreamProc, this );
+				success = ( 0 != m_OutputStream );
+				if ( success && m_NullOutput ) {
+					NullSink::Options options = *m_NullOutput;
+					if ( !options.Filename.empty() && ( ++m_NullSinkCount > 1 ) ) {
+						options.Filename += L"-" + std::to_wstring( m_NullSinkCount );
+					}
+					try {
+						m_NullSink = std::make_unique<NullSink>( m_OutputStream, static_cast<long>( samplerate ), static_cast<long>( channels ), options );
+					} catch ( const std::runtime_error& ) {
+						success = false;
+					}
+				}
+				if ( !success && ( 0 != m_OutputStream ) ) {
+					BASS_StreamFree( m_OutputStream );
+					m_OutputStream = 0;
+				}
+				break;
+			}
 		}
 	}
 	return success;
@@ -2125,7 +2201,7 @@ void Output::LoudnessPrecalcHandler()
 	do {
 		Playlist::Items items;
 		{
-			std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+			std::lock_guard<RealtimeAudit::Mutex> lock( m_PlaylistMutex );
 			items = m_Playlist->GetItems();
 		}
 		auto item = items.begin();
@@ -2148,7 +2224,7 @@ void Output::LoudnessPrecalcHandler()
 						if ( gain.has_value() ) {
 							const MediaInfo previousMediaInfo( item->Info );
 							item->Info.SetGainTrack( gain );
-							std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+							std::lock_guard<RealtimeAudit::Mutex> lock( m_PlaylistMutex );
 							m_Playlist->GetLibrary().UpdateTrackGain( previousMediaInfo, item->Info );
 						}
 					}
@@ -2194,66 +2270,103 @@ void Output::SetOutputStreamFinished( const bool finished )
 	m_OutputStreamFinished = finished;
 }
 
-Output::OutputDecoderPtr Output::GetNextDecoder( Playlist::Item& item )
+Output::DecoderStreamPtr Output::GetNextDecoderStream( const Playlist::Item& currentItem, const DecoderStreamPtr& preparedStream )
 {
-	OutputDecoderPtr nextDecoder;
-	Playlist::Item nextItem = item;
-	item = {};
+	// Returns whether the 'item' is the one for which the next decoder stream has already been prepared.
+	const auto isPrepared = [ &preparedStream ] ( const Playlist::Item& item ) {
+		if ( preparedStream && ( preparedStream->item.ID == item.ID ) ) {
+			const auto& info = preparedStream->item.Info;
+			return ( std::tie( info.GetFilename(), info.GetCueStart(), info.GetCueEnd() ) == std::tie( item.Info.GetFilename(), item.Info.GetCueStart(), item.Info.GetCueEnd() ) ) && ( info.GetFiletime() == item.Info.GetFiletime() );
+		}
+		return false;
+	};
 
 	if ( GetFollowTrackSelection() ) {
+		Playlist::Item nextItem = {};
+		Playlist::Ptr playlist;
 		bool selectNextItem = false;
 		if ( GetRepeatTrack() ) {
-			nextItem = m_CurrentItemDecoding;
-		} else if ( const auto nextTrackToFollow = GetTrackToFollow( nextItem ) ) {
-			auto [playlist, nextTrack, selectTrack] = *nextTrackToFollow;
-			ChangePlaylist( playlist );
-			nextItem = nextTrack;
-			selectNextItem = selectTrack;
-		} else {
-			nextItem = {};
+			nextItem = currentItem;
+		} else if ( const auto nextTrackToFollow = GetTrackToFollow( currentItem ) ) {
+			std::tie( playlist, nextItem, selectNextItem ) = *nextTrackToFollow;
+			if ( GetRandomPlay() && selectNextItem && playlist && preparedStream && playlist->ContainsItem( preparedStream->item ) ) {
+				// Keep the random item that has already been chosen.
+				return preparedStream;
+			}
 		}
 		if ( nextItem.ID > 0 ) {
-			nextDecoder = OpenOutputDecoder( nextItem, true /*usePreloadedDecoder*/ );
-			if ( nextDecoder ) {
-				item = nextItem;
-				PreloadNextDecoder( item );
-				if ( m_OnSelectFollowedTrackCallback && selectNextItem ) {
-					m_OnSelectFollowedTrackCallback( nextItem.ID );
-				}
+			if ( isPrepared( nextItem ) ) {
+				return preparedStream;
+			}
+			if ( DecoderStreamPtr nextStream = PrepareDecoderStream( nextItem ); nextStream ) {
+				nextStream->followPlaylist = playlist;
+				nextStream->selectFollowedItem = selectNextItem;
+				return nextStream;
 			}
 		}
-		return nextDecoder;
+		return nullptr;
 	}
 
-	std::lock_guard<std::mutex> playlistLock( m_PlaylistMutex );
-	if ( m_Playlist ) {
+	Playlist::Ptr playlist;
+	{
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_PlaylistMutex );
+		playlist = m_Playlist;
+	}
+	if ( playlist ) {
+		if ( GetRandomPlay() && preparedStream && playlist->ContainsItem( preparedStream->item ) ) {
+			// Keep the random item that has already been chosen.
+			return preparedStream;
+		}
+		Playlist::Item nextItem = currentItem;
 		size_t skip = 0;
-		while ( !nextDecoder && ( nextItem.ID > 0 ) && ( skip++ < s_MaxSkipItems ) ) {
+		while ( ( nextItem.ID > 0 ) && ( skip++ < s_MaxSkipItems ) ) {
 			if ( GetRandomPlay() ) {
-				std::lock_guard<std::mutex> preloadLock( m_PreloadedDecoderMutex );
-				if ( ( m_PreloadedDecoder.item.ID > 0 ) && ( m_Playlist->ContainsItem( m_PreloadedDecoder.item ) ) ) {
-					nextItem = m_PreloadedDecoder.item;
-				} else {
-					nextItem = m_Playlist->GetRandomItem( nextItem );
-				}
+				nextItem = playlist->GetRandomItem( nextItem );
 			} else if ( GetRepeatTrack() ) {
-				nextItem = m_CurrentItemDecoding;
+				nextItem = currentItem;
 			} else {
-				Playlist::Item currentItem = nextItem;
+				const Playlist::Item item = nextItem;
 				nextItem = {};
-				m_Playlist->GetNextItem( currentItem, nextItem, GetRepeatPlaylist() /*wrap*/ );
+				playlist->GetNextItem( item, nextItem, GetRepeatPlaylist() /*wrap*/ );
 			}
 			if ( nextItem.ID > 0 ) {
-				nextDecoder = OpenOutputDecoder( nextItem, true /*usePreloadedDecoder*/ );
-				if ( nextDecoder ) {
-					item = nextItem;
-					PreloadNextDecoder( item );
+				if ( isPrepared( nextItem ) ) {
+					return preparedStream;
+				}
+				if ( DecoderStreamPtr nextStream = PrepareDecoderStream( nextItem ); nextStream ) {
+					return nextStream;
 				}
 			}
 		}
 	}
+	return nullptr;
+}
+
+Output::DecoderStreamPtr Output::PrepareDecoderStream( Playlist::Item item )
+{
+	DecoderStreamPtr stream;
+	if ( IsURL( item.Info.GetFilename() ) ) {
+		// Streams are not preloaded, so the output callback restarts playback from the item instead.
+		stream = std::make_shared<DecoderStream>( DecoderStream{ nullptr, item } );
+	} else if ( const OutputDecoderPtr decoder = OpenOutputDecoder( item ); decoder ) {
+		EstimateGain( item );
+		if ( GetCrossfade() || GetFadeToNext() ) {
+			// Skip any leading silence now, so that the decoder is positioned after it by the time the output callback starts the next track.
+			SkipSilence( decoder, item );
+		}
+		stream = std::make_shared<DecoderStream>( DecoderStream{ decoder, item, { item } } );
+	}
+	return stream;
+}
 
-	return nextDecoder;
+Output::DecoderStreamPtr Output::TakeNextDecoderStream()
+{
+	DecoderStreamPtr nextStream = m_NextDecoderStream.exchange( nullptr );
+	if ( nextStream ) {
+		// Have the preload decoder thread prepare the stream which follows on.
+		SetEvent( m_PreloadDecoderWakeEvent );
+	}
+	return nextStream;
 }
 
 void Output::StartPreloadDecoderThread()
@@ -2277,50 +2390,159 @@ void Output::StopPreloadDecoderThread()
 void Output::PreloadDecoderHandler()
 {
 	const HANDLE handles[ 2 ] = { m_PreloadDecoderStopEvent, m_PreloadDecoderWakeEvent };
-	while ( WaitForMultipleObjects( 2, handles, FALSE /*waitAll*/, INFINITE ) != WAIT_OBJECT_0 ) {
-		std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-		const std::wstring& filename = m_PreloadedDecoder.itemToPreload.Info.GetFilename();
-		m_PreloadedDecoder.decoder = IsURL( filename ) ? nullptr : OpenOutputDecoder( m_PreloadedDecoder.itemToPreload );
-		if ( m_PreloadedDecoder.decoder ) {
-			m_PreloadedDecoder.item = m_PreloadedDecoder.itemToPreload;
-		} else {
-			m_PreloadedDecoder.item = {};
-		}
-		m_PreloadedDecoder.itemToPreload = {};
+	while ( WaitForMultipleObjects( 2, handles, FALSE /*waitAll*/, s_PreloadDecoderCheckInterval ) != WAIT_OBJECT_0 ) {
 		ResetEvent( m_PreloadDecoderWakeEvent );
+		UpdateNextDecoderStream();
 	}
 }
 
-void Output::PreloadNextDecoder( const Playlist::Item& item )
+void Output::UpdateNextDecoderStream()
 {
-	if ( m_Playlist ) {
-		Playlist::Item preloadItem;
-		if ( GetRandomPlay() ) {
-			preloadItem = m_Playlist->GetRandomItem( item );
-		} else if ( GetRepeatTrack() ) {
-			preloadItem = item;
-		} else {
-			m_Playlist->GetNextItem( item, preloadItem, GetRepeatPlaylist() /*wrap*/ );
+	// Streams are only released once the preloaded decoder mutex has been unlocked, as freeing an output decoder waits for its pre-buffer thread (which can be waiting on the mutex in the pre-buffer finished callback).
+	std::vector<DecoderStreamPtr> releasedStreams;
+
+	DecoderStreamPtr startedStream;
+	DecoderStreamPtr preparedStream;
+	Playlist::Item currentItem;
+	uint64_t generation = 0;
+	{
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+		if ( m_PreloadedDecoder.published && ( m_NextDecoderStream.load() != m_PreloadedDecoder.next ) ) {
+			// The output callback has taken the next decoder stream, so it is now the current one.
+			releasedStreams.push_back( std::move( m_PreloadedDecoder.current ) );
+			m_PreloadedDecoder.current = std::move( m_PreloadedDecoder.next );
+			m_PreloadedDecoder.published = false;
+			startedStream = m_PreloadedDecoder.current;
 		}
+		if ( !m_PreloadedDecoder.current ) {
+			m_NextDecoderStreamPending = false;
+			return;
+		}
+		currentItem = m_PreloadedDecoder.current->item;
+		if ( !m_PreloadedDecoder.reselect ) {
+			preparedStream = m_PreloadedDecoder.next;
+		}
+		m_PreloadedDecoder.reselect = false;
+		generation = m_PreloadedDecoder.generation;
+	}
+
+	if ( startedStream ) {
+		if ( startedStream->followPlaylist ) {
+			ChangePlaylist( startedStream->followPlaylist );
+		}
+		if ( m_OnSelectFollowedTrackCallback && startedStream->selectFollowedItem ) {
+			m_OnSelectFollowedTrackCallback( startedStream->item.ID );
+		}
+		if ( GetCrossfade() ) {
+			StartCrossfadeCalculationThread( startedStream->item );
+		}
+	}
+
+	// Determine the next decoder stream (the playlist might have changed since it was last prepared), without holding the mutex.
+	DecoderStreamPtr nextStream = GetNextDecoderStream( currentItem, preparedStream );
 
-		std::lock_guard<std::mutex> lock( m_PreloadedDecoderMutex );
-		m_PreloadedDecoder.itemToPreload = preloadItem;
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+	if ( generation != m_PreloadedDecoder.generation ) {
+		// Playback has been stopped or restarted in the meantime.
+		releasedStreams.push_back( std::move( nextStream ) );
+		return;
+	}
+	if ( nextStream != m_PreloadedDecoder.next ) {
+		if ( m_PreloadedDecoder.published ) {
+			// Withdraw the previously published stream, unless the output callback has taken it in the meantime (in which case, start over).
+			DecoderStreamPtr expected = m_PreloadedDecoder.next;
+			if ( !m_NextDecoderStream.compare_exchange_strong( expected, DecoderStreamPtr() ) ) {
+				releasedStreams.push_back( std::move( nextStream ) );
+				SetEvent( m_PreloadDecoderWakeEvent );
+				return;
+			}
+			m_PreloadedDecoder.published = false;
+		}
+		releasedStreams.push_back( std::move( m_PreloadedDecoder.next ) );
+		m_PreloadedDecoder.next = std::move( nextStream );
+	}
+
+	if ( m_PreloadedDecoder.next ) {
+		if ( !m_PreloadedDecoder.published ) {
+			if ( const OutputDecoderPtr& decoder = m_PreloadedDecoder.next->decoder; decoder && UsePreBuffer( m_PreloadedDecoder.next->item ) ) {
+				// Hold off pre-buffering until the current decoder has finished pre-buffering (or the output callback starts reading from the next decoder).
+				const bool hold = ( m_PreloadedDecoder.preBufferFinishedID != m_PreloadedDecoder.current->item.ID );
+				decoder->PreBuffer( m_OnPreBufferFinishedCallback, hold );
+			}
+			m_NextDecoderStream.store( m_PreloadedDecoder.next );
+			m_PreloadedDecoder.published = true;
+		}
+		m_NextDecoderStreamPending = true;
+	} else {
+		m_NextDecoderStreamPending = false;
+	}
+}
+
+void Output::ResetPreloadedDecoder( const DecoderStreamPtr& currentStream )
+{
+	// Streams are released once the mutex has been unlocked (see UpdateNextDecoderStream).
+	DecoderStreamPtr previousStream;
+	DecoderStreamPtr previousNextStream;
+	{
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+		previousStream = std::move( m_PreloadedDecoder.current );
+		previousNextStream = std::move( m_PreloadedDecoder.next );
+		m_PreloadedDecoder.current = currentStream;
+		m_PreloadedDecoder.next.reset();
+		m_PreloadedDecoder.published = false;
+		m_PreloadedDecoder.reselect = false;
+		if ( !currentStream ) {
+			m_PreloadedDecoder.preBufferFinishedID = 0;
+		}
+		++m_PreloadedDecoder.generation;
+		m_NextDecoderStream.store( nullptr );
+		m_NextDecoderStreamPending = static_cast<bool>( currentStream );
+	}
+	if ( currentStream ) {
 		SetEvent( m_PreloadDecoderWakeEvent );
 	}
 }
 
+Playlist::Item Output::GetPreloadedItem()
+{
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_PreloadedDecoderMutex );
+	return m_PreloadedDecoder.next ? m_PreloadedDecoder.next->item : Playlist::Item{};
+}
+
 std::vector<std::pair<float /*seconds*/, std::wstring /*title*/>> Output::GetStreamTitleQueue()
 {
-	std::lock_guard<std::mutex> lock( m_StreamTitleMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_StreamTitleMutex );
+	UpdateStreamTitleQueue();
 	return m_StreamTitleQueue;
 }
 
 void Output::SetStreamTitleQueue( const std::vector<std::pair<float /*seconds*/, std::wstring /*title*/>>& queue )
 {
-	std::lock_guard<std::mutex> lock( m_StreamTitleMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_StreamTitleMutex );
+	m_StreamTitleEvents.Clear();
 	m_StreamTitleQueue = queue;
 }
 
+void Output::AddStreamTitle( const float seconds, std::wstring&& title )
+{
+	m_LastStreamTitleSeconds = seconds;
+	std::pair<float /*seconds*/, std::wstring /*title*/> streamTitle( seconds, std::move( title ) );
+	if ( !m_StreamTitleEvents.Push( std::move( streamTitle ) ) ) {
+		// The pending title queue is full, so add the title directly.
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_StreamTitleMutex );
+		UpdateStreamTitleQueue();
+		m_StreamTitleQueue.push_back( std::move( streamTitle ) );
+	}
+}
+
+void Output::UpdateStreamTitleQueue()
+{
+	std::pair<float /*seconds*/, std::wstring /*title*/> streamTitle;
+	while ( m_StreamTitleEvents.Pop( streamTitle ) ) {
+		m_StreamTitleQueue.push_back( std::move( streamTitle ) );
+	}
+}
+
 void Output::SetPlaylistChangeCallback( PlaylistChangeCallback callback )
 {
 	m_OnPlaylistChangeCallback = callback;
@@ -2349,13 +2571,13 @@ bool Output::CanBackgroundThreadProceed( const HANDLE stopEvent )
 
 void Output::SetPlaylistInformationToFollow( Playlist::Ptr playlist, const Playlist::Items& selectedItems )
 {
-	std::lock_guard<std::mutex> lock( m_FollowPlaylistInformationMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_FollowPlaylistInformationMutex );
 	m_FollowPlaylistInformation = std::make_pair( playlist, selectedItems );
 }
 
 std::pair<Playlist::Ptr, Playlist::Items> Output::GetPlaylistInformationToFollow()
 {
-	std::lock_guard<std::mutex> lock( m_FollowPlaylistInformationMutex );
+	std::lock_guard<RealtimeAudit::Mutex> lock( m_FollowPlaylistInformationMutex );
 	return m_FollowPlaylistInformation;
 }
 
@@ -2363,7 +2585,7 @@ std::optional<std::tuple<Playlist::Ptr, Playlist::Item, bool>> Output::GetTrackT
 {
 	auto [playlist, selectedItems] = GetPlaylistInformationToFollow();
 	if ( !playlist || selectedItems.empty() ) {
-		std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+		std::lock_guard<RealtimeAudit::Mutex> lock( m_PlaylistMutex );
 		playlist = m_Playlist;
 		if ( !playlist )
 			return std::nullopt;
@@ -2412,7 +2634,7 @@ std::optional<std::tuple<Playlist::Ptr, Playlist::Item, bool>> Output::GetTrackT
 
 bool Output::ChangePlaylist( const Playlist::Ptr& playlist )
 {
-	std::lock_guard<std::mutex> playlistLock( m_PlaylistMutex );
+	std::lock_guard<RealtimeAudit::Mutex> playlistLock( m_PlaylistMutex );
 	if ( m_Playlist != playlist ) {
 		m_Playlist = playlist;
 		if ( nullptr != m_OnPlaylistChangeCallback ) {
@@ -3,13 +3,22 @@
 #include "stdafx.h"
 
 #include "bass.h"
+#include "AnalysisTap.h"
 #include "Handlers.h"
+#include "NullSink.h"
 #include "Resampler.h"
 #include "Playlist.h"
+#include "RealtimeAudit.h"
+#include "RealtimeQueue.h"
+#include "CrossfadeAnalysis.h"
+#include "Equaliser.h"
+#include "SampleMixer.h"
 #include "Settings.h"
+#include "SilenceOffsets.h"
 
 #include <atomic>
 #include <functional>
+#include <mutex>
 #include <optional>
 
 // Message ID for signalling that playback needs to be restarted from a playlist item ID (wParam).
@@ -23,7 +32,8 @@ public:
 	// 'hwnd' - main window handle.
 	// 'handlers' - the available handlers.
 	// 'settings' - application settings.
-	Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, Settings& settings );
+	// 'nullOutput' - null sink options, to use the null output mode instead of the output mode in the application settings.
+	Output( const HINSTANCE instance, const HWND hwnd, Handlers& handlers, Settings& settings, const std::optional<NullSink::Options>& nullOutput );
 
 	virtual ~Output();
 
@@ -228,20 +238,38 @@ private:
 	// Output queue.
 	using Queue = std::vector<Item>;
 
+	// Output queue items added by the output callback, which have yet to be added to the output queue.
+	using QueueEvents = RealtimeQueue<Item, 16>;
+
+	// Stream titles, associated with their start times, added by the output callback.
+	using StreamTitleEvents = RealtimeQueue<std::pair<float /*seconds*/, std::wstring /*title*/>, 16>;
+
 	// Maps a playlist item ID to a gain estimate.
 	using GainEstimateMap = std::map<long, std::optional<float>>;
 
-	// A list of FX.
-	using FXList = std::list<HFX>;
-
 	// Buffered output decoder shared pointer.
 	using OutputDecoderPtr = std::shared_ptr<OutputDecoder>;
 
-	// Preloaded decoder information.
+	// An output decoder, together with the playlist item it decodes.
+	struct DecoderStream {
+		OutputDecoderPtr decoder = {};      // Output decoder (which is empty for streams, as these are not preloaded).
+		Playlist::Item item = {};           // Playlist item.
+		Item queueItem = {};                // Output queue item, moved to the output queue by the output callback when it switches to the stream.
+		Playlist::Ptr followPlaylist = {};  // Playlist to change to when the stream starts (when using 'follow track selection' mode).
+		bool selectFollowedItem = false;    // Whether to select the item when the stream starts (when using 'follow track selection' mode).
+	};
+
+	// Decoder stream shared pointer.
+	using DecoderStreamPtr = std::shared_ptr<DecoderStream>;
+
+	// Preloaded decoder information, which is owned by the preload decoder thread.
 	struct PreloadedDecoder {
-		Playlist::Item itemToPreload = {};  // Item to preload.
-		Playlist::Item item = {};           // Preloaded item.
-		OutputDecoderPtr decoder = {};      // Preloaded decoder.
+		DecoderStreamPtr current = {};   // The decoder stream most recently started by the output callback.
+		DecoderStreamPtr next = {};      // The decoder stream to follow on from the current one.
+		bool published = false;          // Whether the next decoder stream has been published to the output callback.
+		bool reselect = false;           // Whether to choose the next item again (rather than keep a random item that has already been chosen).
+		long preBufferFinishedID = 0;    // The playlist item ID of the decoder that most recently finished pre-buffering.
+		uint64_t generation = 0;         // Incremented whenever playback is stopped or restarted.
 	};
 
 	// BASS stream callback.
@@ -313,8 +341,22 @@ private:
 	// Terminates the crossfade calculation thread.
 	void StopCrossfadeCalculationThread();
 
-	// Calculates the crossfade position.
-	double CalculateCrossfadePosition( Decoder::Ptr decoder, const double seekPosition, Decoder::CanContinue canContinue ) const;
+	// Returns the crossfade analysis for the 'item', analysing the track if the analysis is not already known.
+	// 'canContinue' - callback which returns whether the analysis can continue.
+	// Returns the analysis, or nullopt if the track could not be analysed.
+	std::optional<CrossfadeAnalysis::Analysis> GetCrossfadeAnalysis( Playlist::Item& item, Decoder::CanContinue canContinue );
+
+	// Analyses a track by decoding it in full, using any known silence offsets for the track to skip leading & trailing silence.
+	// 'decoder' - decoder for the track.
+	// 'mediaInfo' - track information (any silence offsets detected during the analysis are stored for the track).
+	// 'canContinue' - callback which returns whether the analysis can continue.
+	// Returns the analysis, or nullopt if the analysis did not complete.
+	std::optional<CrossfadeAnalysis::Analysis> AnalyseCrossfade( Decoder::Ptr decoder, const MediaInfo& mediaInfo, Decoder::CanContinue canContinue ) const;
+
+	// Skips any leading silence for the 'item' using the output 'decoder', leaving the decoder positioned after the silence.
+	// Silence is skipped by seeking when the silence offsets are known, otherwise it is detected by decoding, and the silence offsets stored.
+	// This accesses the silence offsets store, so must be called before the decoder is handed over to the output thread (and before pre-buffering starts).
+	void SkipSilence( const OutputDecoderPtr& decoder, const Playlist::Item& item );
 
 	// Returns the crossfade position for the current track, in seconds.
 	double GetCrossfadePosition() const;
@@ -322,8 +364,11 @@ private:
 	// Sets the crossfade 'position' for the current track, in seconds.
 	void SetCrossfadePosition( const double position );
 
-	// Applies gain (and EQ preamp) to an output 'buffer' containing 'sampleCount' samples, using 'item' information and 'softClipState'.
-	void ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState );
+	// Prepares the gain (and EQ preamp) for an output 'buffer' containing 'sampleCount' samples, using 'item' information.
+	// Note that this modifies the 'buffer' in soft limit mode: soft limiting is stateful, so it cannot be fused into the output mix,
+	// and instead the gain & soft limit are applied to the 'buffer' in a separate pass using the 'softClipState'.
+	// Returns the gain to apply when mixing the 'buffer', which is unity gain if it has already been applied.
+	SampleMixer::Gain PrepareGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState );
 
 	// Gets the output queue.
 	Queue GetOutputQueue();
@@ -331,12 +376,30 @@ private:
 	// Sets the output 'queue'.
 	void SetOutputQueue( const Queue& queue );
 
+	// Adds an 'item' to the output queue from the output callback, without blocking (unless the pending item queue is full).
+	void AddToOutputQueue( Item&& item );
+
+	// Moves any items added by the output callback to the output queue (the queue mutex must be held by the caller).
+	void UpdateOutputQueue();
+
+	// Hands a decoder 'stream' that is no longer needed by the output callback to another thread to be freed, so that it is not freed on the audio thread.
+	void RetireDecoderStream( DecoderStreamPtr& stream );
+
+	// Frees any decoder streams retired by the output callback.
+	void FreeRetiredDecoders();
+
+	// Stops the crossfading stream (called from the output callback, or when the output stream is not playing).
+	void ResetCrossfadingStream();
+
 	// Returns a decoder for the 'item' in the specified 'context' (and updates the item if necessary), or nullptr if a decoder could not be opened.
 	Decoder::Ptr OpenDecoder( Playlist::Item& item, const Decoder::Context context );
 
+	// Returns whether to pre-buffer the output decoder for the 'item'.
+	// Streams are not pre-buffered, and neither is null output (which pulls sample data as fast as it can, so must be given decoded data rather than silence when the pre-buffer falls behind).
+	bool UsePreBuffer( const Playlist::Item& item ) const;
+
 	// Returns an output decoder for the 'item'.
-	// 'usePreloadedDecoder' - whether to use the preloaded decoder (when available).
-	OutputDecoderPtr OpenOutputDecoder( Playlist::Item& item, const bool usePreloadedDecoder = false );
+	OutputDecoderPtr OpenOutputDecoder( Playlist::Item& item );
 
 	// Starts the output and returns the output state.
 	State StartOutput();
@@ -347,6 +410,12 @@ private:
 	// Gets the current output position, in seconds.
 	float GetOutputPosition() const;
 
+	// Gets the current output stream position (including any lead-in), in seconds.
+	double GetOutputStreamPosition() const;
+
+	// Returns the analysis stage for the current output stream, or nullptr if there is no output stream.
+	std::shared_ptr<AnalysisTap> GetAnalysisTap() const;
+
 	// Creates the BASS output stream (and mixer stream, if necessary) based on the 'mediaInfo' and the current output mode/device.
 	// Returns whether the stream(s) were created successfully.
 	bool CreateOutputStream( const MediaInfo& mediaInfo );
@@ -379,9 +448,21 @@ private:
 	// Sets whether the output stream has finished.
 	void SetOutputStreamFinished( const bool finished );
 
-	// Returns the next decoder on from the 'item', or nullptr if a decoder could not be opened.
-	// Updates 'item' with the next playlist item on success, resets 'item' on failure.
-	OutputDecoderPtr GetNextDecoder( Playlist::Item& item );
+	// Returns the decoder stream to follow on from the 'currentItem', or nullptr if there is no next item (or no decoder could be opened).
+	// 'preparedStream' - the previously prepared next decoder stream, which is returned if it is still for the next item.
+	// Called by the preload decoder thread.
+	DecoderStreamPtr GetNextDecoderStream( const Playlist::Item& currentItem, const DecoderStreamPtr& preparedStream );
+
+	// Returns a decoder stream for the 'item', with any leading silence skipped, or nullptr if a decoder could not be opened.
+	DecoderStreamPtr PrepareDecoderStream( Playlist::Item item );
+
+	// Takes the next decoder stream published by the preload decoder thread (called from the output callback).
+	// Returns nullptr if the next decoder stream has yet to be prepared, or if there is no next item.
+	DecoderStreamPtr TakeNextDecoderStream();
+
+	// Prepares (and publishes) the next decoder stream, after first checking whether the output callback has started the previous one.
+	// Called by the preload decoder thread.
+	void UpdateNextDecoderStream();
 
 	// Starts the preload decoder thread.
 	void StartPreloadDecoderThread();
@@ -389,8 +470,11 @@ private:
 	// Stops the preload decoder thread.
 	void StopPreloadDecoderThread();
 
-	// Preloads the next decoder on from the current 'item'.
-	void PreloadNextDecoder( const Playlist::Item& item );
+	// Resets the preloaded decoder, and has the preload decoder thread prepare the stream to follow on from the 'currentStream' (if there is one).
+	void ResetPreloadedDecoder( const DecoderStreamPtr& currentStream = {} );
+
+	// Returns the playlist item of the next decoder stream (which is empty if it has yet to be prepared).
+	Playlist::Item GetPreloadedItem();
 
 	// Gets the stream title queue.
 	std::vector<std::pair<float /*seconds*/, std::wstring /*title*/>> GetStreamTitleQueue();
@@ -398,6 +482,12 @@ private:
 	// Sets the stream title 'queue'.
 	void SetStreamTitleQueue( const std::vector<std::pair<float /*seconds*/, std::wstring /*title*/>>& queue );
 
+	// Adds a stream 'title', starting at 'seconds', from the output callback.
+	void AddStreamTitle( const float seconds, std::wstring&& title );
+
+	// Moves any stream titles added by the output callback to the stream title queue (the stream title mutex must be held by the caller).
+	void UpdateStreamTitleQueue();
+
 	// Sets the synchronizer which is called when the current output 'stream' ends.
 	void SetEndSync( const HSTREAM stream );
 
@@ -437,14 +527,11 @@ private:
 	// The current playlist.
 	Playlist::Ptr m_Playlist;
 
-	// The currently decoding playlist item.
-	Playlist::Item m_CurrentItemDecoding;
-
 	// The soft-clip state for the currently decoding item.
 	std::vector<float> m_SoftClipStateDecoding;
 
-	// The currently decoding stream.
-	OutputDecoderPtr m_DecoderStream;
+	// The currently decoding stream (only accessed by the output callback while the output stream is playing).
+	DecoderStreamPtr m_DecoderStream;
 
 	// The sample rate of the currently decoding stream.
 	long m_DecoderSampleRate;
@@ -456,10 +543,10 @@ private:
 	HSTREAM m_MixerStream;
 
 	// Playlist mutex.
-	std::mutex m_PlaylistMutex;
+	RealtimeAudit::Mutex m_PlaylistMutex;
 
 	// Output queue mutex.
-	std::mutex m_QueueMutex;
+	RealtimeAudit::Mutex m_QueueMutex;
 
 	// Volume level in the range 0.0 (silent) to 1.0 (full volume).
 	float m_Volume;
@@ -473,6 +560,12 @@ private:
 	// The queue of output items, with their start times, in the output stream.
 	Queue m_OutputQueue;
 
+	// Output queue items added by the output callback.
+	QueueEvents m_OutputQueueEvents;
+
+	// Decoder streams no longer needed by the output callback, which are waiting to be freed.
+	RealtimeQueue<DecoderStreamPtr, 16> m_RetiredDecoders;
+
 	// Playlist item ID to restart playback from, if stream playback has ended.
 	long m_RestartItemID;
 
@@ -503,6 +596,9 @@ private:
 	// Indicates whether loudness normalisation is enabled.
 	bool m_LoudnessNormalisation;
 
+	// Sample magnitude at or below which a sample is considered to be silent, when skipping leading silence.
+	float m_SilenceThreshold;
+
 	// Indicates whether the 'stop at track end' setting should be reset when playback ends.
 	bool m_RetainStopAtTrackEnd;
 
@@ -554,16 +650,16 @@ private:
 	// Event handle for waking the preload decoder thread.
 	HANDLE m_PreloadDecoderWakeEvent;
 
-	// The decoding stream that is being faded out during a crossfade.
-	OutputDecoderPtr m_CrossfadingStream;
+	// The decoding stream that is being faded out during a crossfade (only accessed by the output callback while the output stream is playing).
+	DecoderStreamPtr m_CrossfadingStream;
 
-	// Crossfading stream mutex.
-	std::mutex m_CrossfadingStreamMutex;
+	// Indicates that the output callback should stop the crossfading stream.
+	std::atomic<bool> m_CancelCrossfadingStream;
 
-	// The item that is being faded out during a crossfade.
-	Playlist::Item m_CurrentItemCrossfading;
+	// Sample buffer for the crossfading stream, allocated up front so that the output callback does not need to.
+	std::vector<float> m_CrossfadingBuffer;
 
-	// The ID of the playlist item that is being faded out during a crossfade.
+	// The ID of the playlist item that is being faded out during a crossfade (or an indicator when fading to the next track).
 	std::atomic<long> m_CrossfadingItemID;
 
 	// The soft-clip state for the currently crossfading item.
@@ -575,11 +671,18 @@ private:
 	// Gain estimates.
 	GainEstimateMap m_GainEstimateMap;
 
+	// Gain estimates mutex.
+	RealtimeAudit::Mutex m_GainEstimateMutex;
+
 	// Current EQ settings.
 	Settings::EQ m_CurrentEQ;
 
-	// EQ FX handles.
-	FXList m_FX;
+	// Equaliser for the current output stream.
+	std::unique_ptr<Equaliser> m_Equaliser;
+
+	// Analysis stage for the current output stream, which feeds the visuals.
+	// Accessed atomically, as it is used by the output callback and by the visuals (which run on their own threads).
+	std::atomic<std::shared_ptr<AnalysisTap>> m_AnalysisTap;
 
 	// Indicates whether EQ is enabled.
 	bool m_EQEnabled;
@@ -593,6 +696,15 @@ private:
 	// Current output device.
 	std::wstring m_OutputDevice;
 
+	// Null sink options, when the null output mode has been selected from the command line.
+	const std::optional<NullSink::Options> m_NullOutput;
+
+	// Null sink for the current output stream, when using the null output mode.
+	std::unique_ptr<NullSink> m_NullSink;
+
+	// Number of null sinks created, used to give each null sink output file a unique name.
+	int m_NullSinkCount;
+
 	// Indicates whether the current WASAPI device has failed or been disabled.
 	std::atomic<bool> m_WASAPIFailed;
 
@@ -605,6 +717,9 @@ private:
 	// Indicates whether the output stream has finished.
 	std::atomic<bool> m_OutputStreamFinished;
 
+	// Output stream data rate, in bytes per second, used to detect late stream callbacks.
+	std::atomic<double> m_OutputStreamBytesPerSecond;
+
 	// Indicates whether an end synchronizer has been set on a mixer stream.
 	std::atomic<bool> m_MixerStreamHasEndSync;
 
@@ -625,7 +740,7 @@ private:
 	std::pair<Playlist::Ptr, Playlist::Items> m_FollowPlaylistInformation;
 
 	// Mutex for the current playlist with selected items to follow (used for 'follow track selection' mode).
-	std::mutex m_FollowPlaylistInformationMutex;
+	RealtimeAudit::Mutex m_FollowPlaylistInformationMutex;
 
 	// When starting playback in non-standard output mode, the lead-in length before passing through actual sample data.
 	float m_LeadInSeconds;
@@ -637,13 +752,28 @@ private:
 	PreloadedDecoder m_PreloadedDecoder;
 
 	// A mutex for the preloaded decoder.
-	std::mutex m_PreloadedDecoderMutex;
+	RealtimeAudit::Mutex m_PreloadedDecoderMutex;
+
+	// The next decoder stream, published by the preload decoder thread, and taken by the output callback when it switches streams.
+	std::atomic<DecoderStreamPtr> m_NextDecoderStream;
+
+	// Indicates whether there is a next decoder stream to switch to (even if the preload decoder thread has yet to publish it).
+	std::atomic<bool> m_NextDecoderStreamPending;
+
+	// The next decoder stream, taken by the output callback at the crossfade point (only accessed by the output callback).
+	DecoderStreamPtr m_StartingDecoderStream;
 
 	// The queue of stream titles, associated with their start times.
 	std::vector<std::pair<float /*seconds*/, std::wstring /*title*/>> m_StreamTitleQueue;
 
+	// Stream titles added by the output callback.
+	StreamTitleEvents m_StreamTitleEvents;
+
+	// Start time of the last stream title added by the output callback.
+	std::optional<float> m_LastStreamTitleSeconds;
+
 	// Stream title queue mutex.
-	std::mutex m_StreamTitleMutex;
+	RealtimeAudit::Mutex m_StreamTitleMutex;
 
 	// Callback function for when the output playlist changes.
 	PlaylistChangeCallback m_OnPlaylistChangeCallback;
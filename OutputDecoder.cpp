@@ -1,59 +1,100 @@
 #include "OutputDecoder.h"
 
-// Pre-buffer read queue size.
-constexpr size_t kQueueSize = 5;
+#include "Metrics.h"
 
-// The (maximum) number of seconds stored in each pre-buffer slot.
-constexpr float kSecondsPerSlot = 0.5f;
+#include <algorithm>
+#include <chrono>
+
+// Define to output pre-buffer statistics for each track, for testing.
+#undef DEBUG_PREBUFFER
+
+// Initial pre-buffer duration, in seconds.
+constexpr float kPreBufferSeconds = 2.5f;
+
+// Minimum pre-buffer duration, in seconds.
+constexpr float kMinimumPreBufferSeconds = 1.0f;
+
+// Maximum pre-buffer duration, in seconds.
+constexpr float kMaximumPreBufferSeconds = 10.0f;
+
+// Minimum pre-buffer size, in bytes (regardless of duration).
+constexpr size_t kMinimumPreBufferBytes = 512 * 1024;
+
+// Maximum pre-buffer size, in bytes (regardless of duration).
+constexpr size_t kMaximumPreBufferBytes = 32 * 1024 * 1024;
+
+// The decode speed, in decoded seconds per wall clock second, at which the initial pre-buffer duration is used.
+// Slower decoders get a proportionally deeper pre-buffer, faster decoders a shallower one.
+constexpr float kReferenceRealtimeFactor = 10.0f;
+
+// The factor by which the pre-buffer duration is increased for each underrun.
+constexpr float kUnderrunDepthScale = 1.5f;
+
+// The factor by which the pre-buffer capacity is grown when the pre-buffer depth exceeds it.
+constexpr size_t kPreBufferGrowthFactor = 2;
+
+// The (maximum) number of seconds decoded by the pre-buffer thread in one go.
+constexpr float kSecondsPerChunk = 0.25f;
+
+// Serial number for each output decoder instance, used to name its metrics gauges (the same playlist item can have more than one output decoder).
+static std::atomic<uint64_t> s_MetricsSerial = 0;
 
 OutputDecoder::OutputDecoder( Decoder::Ptr decoder, const long id ) :
 	m_Decoder( decoder ),
 	m_ID( id ),
-	m_DecoderChannels( GetDecoderChannels( decoder ) )
+	m_DecoderChannels( GetDecoderChannels( decoder ) ),
+	m_MetricsPrefix( "prebuffer." + std::to_string( ++s_MetricsSerial ) + "." )
 {
 	if ( m_DecoderChannels <= 0 ) {
 		throw std::runtime_error( "Unable to create output decoder" );
 	}
+	if ( const long channels = m_Decoder->GetChannels(); channels != m_DecoderChannels ) {
+		m_ChannelMixer = std::make_unique<ChannelMixer>( static_cast<uint32_t>( channels ), static_cast<uint32_t>( m_DecoderChannels ) );
+	}
 }
 
 OutputDecoder::~OutputDecoder()
 {
 	StopPreBufferThread();
-	if ( nullptr != m_SemaphoreInput ) {
-		CloseHandle( m_SemaphoreInput );
-	}
-	if ( nullptr != m_SemaphoreOutput ) {
-		CloseHandle( m_SemaphoreOutput );
+	Metrics::RemoveGauges( m_MetricsPrefix );
+
+#ifdef DEBUG_PREBUFFER
+	if ( m_UsePreBuffer ) {
+		const PreBufferStatistics statistics = GetPreBufferStatistics();
+		const std::wstring debugStr = L"VUPlayer::OutputDecoder(" + std::to_wstring( m_ID ) + L"): depth " + std::to_wstring( statistics.DepthSeconds ) + L"s (" +
+			std::to_wstring( statistics.DepthBytes ) + L"/" + std::to_wstring( statistics.CapacityBytes ) + L" bytes), " +
+			std::to_wstring( statistics.RealtimeFactor ) + L"x realtime, " + std::to_wstring( statistics.Underruns ) + L" underruns\r\n";
+		OutputDebugString( debugStr.c_str() );
 	}
+#endif
 }
 
 long OutputDecoder::Read( float* buffer, const long sampleCount )
 {
 	long samplesRead = 0;
 	if ( m_UsePreBuffer ) {
-		while ( ( samplesRead < sampleCount ) && !m_DecoderFinished ) {
-			const long readBufferSize = ( nullptr != m_ReadBuffer ) ? static_cast<long>( m_ReadBuffer->size() ) : 0;
-			if ( m_ReadBufferOffset < readBufferSize ) {
-				const long samplesToRead = std::min<long>( sampleCount - samplesRead, ( readBufferSize - m_ReadBufferOffset ) / m_DecoderChannels );
-				const auto first = m_ReadBuffer->begin() + m_ReadBufferOffset;
-				const auto last = first + samplesToRead * m_DecoderChannels;
-				const auto dest = buffer + samplesRead * m_DecoderChannels;
-				std::copy( first, last, dest );
-				m_ReadBufferOffset += samplesToRead * m_DecoderChannels;
-				samplesRead += samplesToRead;
+		if ( m_PreBufferHeld ) {
+			m_PreBufferHeld = false;
+		}
+		const size_t samplesRequested = static_cast<size_t>( sampleCount ) * m_DecoderChannels;
+		size_t samplesAvailable = m_PreBuffer.Read( buffer, samplesRequested );
+		if ( samplesAvailable < samplesRequested ) {
+			if ( m_DecoderFinished ) {
+				// Pick up anything that was written between the first read and the decoder finishing.
+				samplesAvailable += m_PreBuffer.Read( buffer + samplesAvailable, samplesRequested - samplesAvailable );
 			} else {
-				WaitForSingleObject( m_SemaphoreOutput, INFINITE );
-				std::lock_guard<std::mutex> lock( m_BufferMutex );
-				if ( m_ReadQueue.empty() ) {
-					m_DecoderFinished = true;
-				} else {
-					m_ReadBuffer = m_ReadQueue.front();
-					m_ReadBufferOffset = 0;
-					m_ReadQueue.pop();
+				// The pre-buffer thread has not kept up, so fill the shortfall with silence rather than waiting.
+				// A shortfall while the pre-buffer is still being primed is expected, so it is not counted as an underrun.
+				if ( m_PreBufferPrimed ) {
+					m_PreBuffer.AddUnderrun();
+					Metrics::Increment( Metrics::Counter::PreBufferUnderruns );
 				}
-				ReleaseSemaphore( m_SemaphoreInput, 1, nullptr );
+				std::fill( buffer + samplesAvailable, buffer + samplesRequested, 0.0f );
+				samplesAvailable = samplesRequested;
 			}
 		}
+		SignalPreBufferThread();
+		samplesRead = static_cast<long>( samplesAvailable / m_DecoderChannels );
 	} else {
 		samplesRead = Decode( buffer, sampleCount );
 	}
@@ -92,16 +133,25 @@ std::optional<float> OutputDecoder::GetBitrate() const
 	return m_Decoder->GetBitrate();
 }
 
-void OutputDecoder::SkipSilence()
+int64_t OutputDecoder::SkipSilence( const float threshold, const std::optional<int64_t> leadingSilence )
 {
 	if ( m_UsePreBuffer ) {
 		StopPreBufferThread();
 		m_Decoder->SetPosition( 0 );
 	}
-	m_Decoder->SkipSilence();
+	int64_t skippedFrames = 0;
+	if ( leadingSilence ) {
+		skippedFrames = *leadingSilence;
+		if ( ( skippedFrames > 0 ) && ( m_Decoder->GetSampleRate() > 0 ) ) {
+			m_Decoder->SetPosition( static_cast<double>( skippedFrames ) / m_Decoder->GetSampleRate() );
+		}
+	} else {
+		skippedFrames = m_Decoder->SkipSilence( threshold );
+	}
 	if ( m_UsePreBuffer ) {
 		StartPreBufferThread();
 	}
+	return skippedFrames;
 }
 
 bool OutputDecoder::SupportsStreamTitles() const
@@ -114,61 +164,143 @@ std::pair<float /*seconds*/, std::wstring /*title*/> OutputDecoder::GetStreamTit
 	return m_Decoder->GetStreamTitle();
 }
 
-void OutputDecoder::PreBuffer( PreBufferFinishedCallback callback )
+void OutputDecoder::PreBuffer( PreBufferFinishedCallback callback, const bool hold )
 {
 	if ( !m_UsePreBuffer ) {
-		m_SemaphoreOutput = CreateSemaphore( nullptr /*attributes*/, 0 /*initial*/, kQueueSize /*maximum*/, L"" );
-		m_SemaphoreInput = CreateSemaphore( nullptr /*attributes*/, kQueueSize /*initial*/, kQueueSize /*maximum*/, L"" );
-		m_UsePreBuffer = ( nullptr != m_SemaphoreOutput ) && ( nullptr != m_SemaphoreInput );
+		// The pre-buffer is allocated for its initial depth, and the pre-buffering thread grows it (up to its maximum depth, within the byte budget) as the depth adapts.
+		const long sampleRate = m_Decoder->GetSampleRate();
+		m_UsePreBuffer = ( sampleRate > 0 ) && ( GetPreBufferSamples( kMaximumPreBufferSeconds ) > 0 );
 		if ( m_UsePreBuffer ) {
+			m_PreBuffer.Resize( GetPreBufferSamples( kPreBufferSeconds ) );
+			UpdatePreBufferDepth();
 			m_PreBufferFinishedCallback = callback;
+			m_PreBufferHeld = hold;
 			StartPreBufferThread();
 		}
 	}
 }
 
+SampleRingBuffer::Levels OutputDecoder::GetPreBufferLevels() const
+{
+	return m_UsePreBuffer ? m_PreBuffer.GetLevels() : SampleRingBuffer::Levels();
+}
+
+OutputDecoder::PreBufferStatistics OutputDecoder::GetPreBufferStatistics() const
+{
+	PreBufferStatistics statistics;
+	if ( m_UsePreBuffer ) {
+		const long sampleRate = m_Decoder->GetSampleRate();
+		const size_t depth = m_PreBufferDepth;
+		statistics.DepthBytes = depth * sizeof( float );
+		statistics.DepthSeconds = ( sampleRate > 0 ) ? static_cast<float>( depth / m_DecoderChannels ) / sampleRate : 0;
+		statistics.CapacityBytes = m_PreBuffer.GetCapacity() * sizeof( float );
+		statistics.RealtimeFactor = m_RealtimeFactor;
+		statistics.Underruns = m_PreBuffer.GetLevels().Underruns;
+	}
+	return statistics;
+}
+
+void OutputDecoder::UpdatePreBufferDepth()
+{
+	const float realtimeFactor = m_RealtimeFactor;
+	float seconds = ( realtimeFactor > 0 ) ? ( kPreBufferSeconds * kReferenceRealtimeFactor / realtimeFactor ) : kPreBufferSeconds;
+	const uint64_t underruns = m_PreBuffer.GetLevels().Underruns;
+	for ( uint64_t underrun = 0; ( underrun < underruns ) && ( seconds < kMaximumPreBufferSeconds ); underrun++ ) {
+		seconds *= kUnderrunDepthScale;
+	}
+	seconds = std::clamp( seconds, kMinimumPreBufferSeconds, kMaximumPreBufferSeconds );
+
+	const size_t depth = GetPreBufferSamples( seconds );
+	if ( const size_t capacity = m_PreBuffer.GetCapacity(); depth > capacity ) {
+		// Grow geometrically, so that a gradually increasing depth does not cause repeated allocations (if the pre-buffer cannot be grown yet, this is retried on the next update).
+		m_PreBuffer.Grow( std::clamp( capacity * kPreBufferGrowthFactor, depth, GetPreBufferSamples( kMaximumPreBufferSeconds ) ) );
+	}
+	m_PreBufferDepth = std::min( depth, m_PreBuffer.GetCapacity() );
+	UpdatePreBufferMetrics();
+}
+
+size_t OutputDecoder::GetPreBufferSamples( const float seconds ) const
+{
+	const long sampleRate = m_Decoder->GetSampleRate();
+	const size_t frameBytes = m_DecoderChannels * sizeof( float );
+	const size_t bytes = std::clamp( static_cast<size_t>( std::max( 0l, sampleRate ) * seconds * GetPreBufferSizeFactor() ) * frameBytes, kMinimumPreBufferBytes, kMaximumPreBufferBytes );
+	return ( bytes / frameBytes ) * m_DecoderChannels;
+}
+
+void OutputDecoder::UpdatePreBufferMetrics() const
+{
+	const PreBufferStatistics statistics = GetPreBufferStatistics();
+	Metrics::SetGauge( m_MetricsPrefix + "itemID", m_ID );
+	Metrics::SetGauge( m_MetricsPrefix + "depthSeconds", statistics.DepthSeconds );
+	Metrics::SetGauge( m_MetricsPrefix + "depthBytes", static_cast<double>( statistics.DepthBytes ) );
+	Metrics::SetGauge( m_MetricsPrefix + "filledBytes", static_cast<double>( m_PreBuffer.GetReadAvailable() * sizeof( float ) ) );
+	Metrics::SetGauge( m_MetricsPrefix + "capacityBytes", static_cast<double>( statistics.CapacityBytes ) );
+	Metrics::SetGauge( m_MetricsPrefix + "realtimeFactor", statistics.RealtimeFactor );
+	Metrics::SetGauge( m_MetricsPrefix + "underruns", static_cast<double>( statistics.Underruns ) );
+}
+
 void OutputDecoder::StartPreBufferThread()
 {
 	m_StopPreBuffering = false;
+	m_PreBufferPrimed = false;
 	m_DecoderFinished = false;
-	m_ReadQueue = {};
-	m_ReadBuffer = nullptr;
-	m_ReadBufferOffset = 0;
+	m_PreBuffer.Reset();
 
 	m_BufferThread = std::thread( [ this ] ()
 		{
-			// Create a 'circular' buffer containing a fixed number of write slots, which the read queue will point to.
-			// This buffer needs to be two slots wider than the read queue because:
-			// 1. When the writer wraps around, it will (re)acquire the initial read slot, before being held.
-			// 2. When the writer is then released, it will immediately acquire the next read slot, before being held.
-			constexpr size_t kSlotCount = 2 + kQueueSize;
-			m_BufferSlots.resize( kSlotCount );
-			size_t slotIndex = 0;
-
-			const long bufferSamples = static_cast<long>( m_Decoder->GetSampleRate() * kSecondsPerSlot * GetPreBufferSizeFactor() );
-			bool finished = false;
-			while ( !finished ) {
-				auto& buffer = m_BufferSlots[ slotIndex ];
-				slotIndex = ( 1 + slotIndex ) % kSlotCount;
-
-				buffer.resize( bufferSamples * m_DecoderChannels );
-				const long samplesRead = Decode( buffer.data(), bufferSamples );
-				buffer.resize( samplesRead * m_DecoderChannels );
-
-				WaitForSingleObject( m_SemaphoreInput, INFINITE );
-				std::lock_guard<std::mutex> lock( m_BufferMutex );
+			const long sampleRate = m_Decoder->GetSampleRate();
+			const long chunkSamples = std::max( 1l, static_cast<long>( sampleRate * kSecondsPerChunk * GetPreBufferSizeFactor() ) );
+			while ( true ) {
+				// Take the consumer signal before checking the stop flag & the free space, so that a signal in between is not missed.
+				const uint32_t signal = m_PreBufferSignal;
 				if ( m_StopPreBuffering ) {
-					finished = true;
-					m_ReadQueue = {};
-				} else if ( buffer.empty() ) {
-					finished = true;
-					if ( m_PreBufferFinishedCallback ) {
-						m_PreBufferFinishedCallback( m_ID );
+					break;
+				}
+				if ( m_PreBufferHeld ) {
+					m_PreBufferSignal.wait( signal );
+					continue;
+				}
+
+				// Decode directly into the free space of the pre-buffer (which is always a whole number of frames), up to the current depth.
+				const auto [region, regionSize] = m_PreBuffer.GetWriteRegion();
+				const size_t filled = m_PreBuffer.GetReadAvailable();
+				const size_t depth = m_PreBufferDepth;
+				const size_t writable = ( depth > filled ) ? std::min( regionSize, depth - filled ) : 0;
+				const long samplesToDecode = std::min( chunkSamples, static_cast<long>( writable / m_DecoderChannels ) );
+				if ( samplesToDecode > 0 ) {
+					const auto decodeStart = std::chrono::steady_clock::now();
+					const long samplesRead = Decode( region, samplesToDecode );
+					const std::chrono::duration<double> decodeTime = std::chrono::steady_clock::now() - decodeStart;
+					if ( samplesRead > 0 ) {
+						m_PreBuffer.CommitWrite( static_cast<size_t>( samplesRead ) * m_DecoderChannels );
+
+						m_DecodedSeconds += static_cast<double>( samplesRead ) / sampleRate;
+						m_DecodingSeconds += decodeTime.count();
+						if ( m_DecodingSeconds > 0 ) {
+							m_RealtimeFactor = static_cast<float>( m_DecodedSeconds / m_DecodingSeconds );
+						}
+						UpdatePreBufferDepth();
+					} else {
+						m_DecoderFinished = true;
+					}
+					if ( !m_PreBufferPrimed ) {
+						m_PreBufferPrimed = true;
+						m_PreBufferPrimed.notify_all();
+					}
+					if ( m_DecoderFinished ) {
+						if ( m_PreBufferFinishedCallback ) {
+							m_PreBufferFinishedCallback( m_ID );
+						}
+						break;
 					}
 				} else {
-					m_ReadQueue.push( &buffer );
+					// The pre-buffer is full, so wait until the consumer has read from it (or the thread is stopped).
+					m_PreBufferSignal.wait( signal );
 				}
-				ReleaseSemaphore( m_SemaphoreOutput, 1, nullptr );
+			}
+			if ( !m_PreBufferPrimed ) {
+				m_PreBufferPrimed = true;
+				m_PreBufferPrimed.notify_all();
 			}
 		}
 	);
@@ -178,12 +310,30 @@ void OutputDecoder::StopPreBufferThread()
 {
 	if ( m_BufferThread.joinable() ) {
 		m_StopPreBuffering = true;
-		ReleaseSemaphore( m_SemaphoreInput, 1, nullptr );
+		SignalPreBufferThread();
 		m_BufferThread.join();
+		m_PreBuffer.Reset();
+	}
+}
+
+void OutputDecoder::SignalPreBufferThread()
+{
+	++m_PreBufferSignal;
+	m_PreBufferSignal.notify_one();
+}
 
-		while ( WAIT_OBJECT_0 == WaitForSingleObject( m_SemaphoreOutput, 0 ) ) {}
-		while ( WAIT_OBJECT_0 == WaitForSingleObject( m_SemaphoreInput, 0 ) ) {}
-		ReleaseSemaphore( m_SemaphoreInput, kQueueSize, nullptr );
+void OutputDecoder::ReleasePreBuffer()
+{
+	if ( m_PreBufferHeld ) {
+		m_PreBufferHeld = false;
+		SignalPreBufferThread();
+	}
+}
+
+void OutputDecoder::WaitForPreBuffer()
+{
+	if ( m_UsePreBuffer && m_BufferThread.joinable() ) {
+		m_PreBufferPrimed.wait( false );
 	}
 }
 
@@ -204,20 +354,9 @@ long OutputDecoder::GetOutputChannels( const MediaInfo& mediaInfo )
 long OutputDecoder::Decode( float* buffer, const long sampleCount )
 {
 	long samplesRead = m_Decoder->ReadSamples( buffer, sampleCount );
-	if ( ( 7 == m_Decoder->GetChannels() ) && ( 8 == m_DecoderChannels ) ) {
-		// Copy the back centre channel to the back left & back right channels.
-		for ( long sample = sampleCount - 1; sample >= 0; sample-- ) {
-			const long srcOffset = sample * 7;
-			const long destOffset = sample * 8;
-			buffer[ destOffset + 7 ] = buffer[ srcOffset + 6 ];
-			buffer[ destOffset + 6 ] = buffer[ srcOffset + 5 ];
-			buffer[ destOffset + 5 ] = buffer[ srcOffset + 4 ];
-			buffer[ destOffset + 4 ] = buffer[ srcOffset + 4 ];
-			buffer[ destOffset + 3 ] = buffer[ srcOffset + 3 ];
-			buffer[ destOffset + 2 ] = buffer[ srcOffset + 2 ];
-			buffer[ destOffset + 1 ] = buffer[ srcOffset + 1 ];
-			buffer[ destOffset + 0 ] = buffer[ srcOffset + 0 ];
-		}
+	if ( m_ChannelMixer && ( samplesRead > 0 ) ) {
+		// The buffer is large enough for the decoder channels, so remix in place.
+		m_ChannelMixer->Process( buffer, buffer, static_cast<size_t>( samplesRead ) );
 	}
 	return samplesRead;
 }
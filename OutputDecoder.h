@@ -2,13 +2,16 @@
 
 #include "stdafx.h"
 
+#include "ChannelMixer.h"
 #include "Decoder.h"
 #include "Playlist.h"
+#include "SampleRingBuffer.h"
 
 #include <array>
+#include <atomic>
 #include <functional>
-#include <mutex>
-#include <queue>
+#include <memory>
+#include <string>
 #include <thread>
 
 // Buffered output decoder wrapper.
@@ -24,6 +27,15 @@ public:
 	// Callback function for when the output decoder has finished pre-buffering the playlist item ID.
 	using PreBufferFinishedCallback = std::function<void( const long /*ID*/ )>;
 
+	// Pre-buffer statistics.
+	struct PreBufferStatistics {
+		float DepthSeconds = 0;    // Current pre-buffer depth, in seconds.
+		size_t DepthBytes = 0;     // Current pre-buffer depth, in bytes.
+		size_t CapacityBytes = 0;  // Current pre-buffer capacity, in bytes (which grows as the depth adapts).
+		float RealtimeFactor = 0;  // Measured decode speed, in decoded seconds per wall clock second (or zero if not yet measured).
+		uint64_t Underruns = 0;    // Number of pre-buffer underruns.
+	};
+
 	// Returns the number of channels to output for the 'mediaInfo'.
 	static long GetOutputChannels( const MediaInfo& mediaInfo );
 
@@ -31,6 +43,7 @@ public:
 	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
 	// 'sampleCount' - number of samples to read.
 	// Returns the number of samples read, or zero if the stream has ended.
+	// When pre-buffering, this never blocks - if the pre-buffer has underrun, the shortfall is filled with silence.
 	virtual long Read( float* buffer, const long sampleCount );
 
 	// Seeks to a 'position' in the stream, in seconds.
@@ -49,8 +62,11 @@ public:
 	// Returns the bitrate in kbps (if relevant).
 	std::optional<float> GetBitrate() const;
 
-	// Skips any leading silence.
-	void SkipSilence();
+	// Skips any leading silence, returning the number of sample frames (at the decoder sample rate) which were skipped.
+	// 'threshold' - sample magnitude at or below which a sample is considered to be silent.
+	// 'leadingSilence' - the number of leading silent frames, if known, in which case the silence is skipped by seeking rather than decoding.
+	// This should be called before pre-buffering starts, as otherwise the pre-buffer has to be restarted.
+	int64_t SkipSilence( const float threshold, const std::optional<int64_t> leadingSilence = std::nullopt );
 
 	// Returns whether stream titles are supported.
 	bool SupportsStreamTitles() const;
@@ -60,18 +76,45 @@ public:
 
 	// Starts pre-buffering sample data - all subsequent reads will be pre-buffered.
 	// 'callback' - called when the output decoder has finished pre-buffering.
-	void PreBuffer( PreBufferFinishedCallback callback );
+	// 'hold' - whether to hold off decoding into the pre-buffer until ReleasePreBuffer is called (or the first read).
+	// This does not wait for the pre-buffer to be primed (reads fill any shortfall with silence until it is).
+	void PreBuffer( PreBufferFinishedCallback callback, const bool hold = false );
+
+	// Lets a held pre-buffer start decoding.
+	void ReleasePreBuffer();
+
+	// Waits until the pre-buffer contains some initial sample data (or decoding has finished), if pre-buffering.
+	// This must not be called from the output thread, nor for a held pre-buffer.
+	void WaitForPreBuffer();
+
+	// Returns the pre-buffer fill level information (which will be empty if not pre-buffering).
+	SampleRingBuffer::Levels GetPreBufferLevels() const;
+
+	// Returns the pre-buffer depth & decode speed statistics (which will be empty if not pre-buffering).
+	PreBufferStatistics GetPreBufferStatistics() const;
 
 protected:
-	// Starts the pre-buffering thread.
+	// Starts the pre-buffering thread, without waiting for the pre-buffer to be primed.
 	void StartPreBufferThread();
 
 	// Stops the pre-buffering thread.
 	void StopPreBufferThread();
 
+	// Wakes the pre-buffering thread if it is waiting for the pre-buffer to have free space.
+	void SignalPreBufferThread();
+
 	// Returns an additional factor by which to scale the buffer size when pre-buffering.
 	virtual float GetPreBufferSizeFactor() const { return 1.0f; }
 
+	// Adapts the pre-buffer depth to the measured decode speed and the number of underruns, growing the pre-buffer as necessary (called by the pre-buffering thread).
+	void UpdatePreBufferDepth();
+
+	// Returns the number of samples needed to pre-buffer a number of 'seconds', within the pre-buffer byte budget.
+	size_t GetPreBufferSamples( const float seconds ) const;
+
+	// Publishes the pre-buffer statistics as metrics gauges.
+	void UpdatePreBufferMetrics() const;
+
 	// Decodes sample data.
 	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
 	// 'sampleCount' - number of samples to read.
@@ -87,42 +130,51 @@ protected:
 	// Decoder channels.
 	const long m_DecoderChannels;
 
+	// Channel mixer, used when the decoder channels differ from the underlying decoder output.
+	std::unique_ptr<ChannelMixer> m_ChannelMixer;
+
 	// Playlist item ID.
 	const long m_ID;
 
 	// Indicates whether to use pre-buffering.
 	bool m_UsePreBuffer = false;
 
-	// Pre-buffer output semaphore.
-	HANDLE m_SemaphoreOutput = nullptr;
-
-	// Pre-buffer input semaphore.
-	HANDLE m_SemaphoreInput = nullptr;
+	// Pre-buffered sample data, written by the pre-buffer thread and read by the output thread.
+	SampleRingBuffer m_PreBuffer;
 
 	// Pre-buffer thread.
 	std::thread m_BufferThread;
 
-	// Pre-buffer mutex.
-	std::mutex m_BufferMutex;
-
 	// Indicates whether the pre-buffering thread should stop.
 	std::atomic_bool m_StopPreBuffering = false;
 
+	// Indicates whether the pre-buffering thread has written some initial sample data (or has finished).
+	std::atomic_bool m_PreBufferPrimed = false;
+
+	// Indicates whether the pre-buffering thread is being held off from decoding.
+	std::atomic_bool m_PreBufferHeld = false;
+
+	// Incremented (and notified) whenever the consumer reads from the pre-buffer, the pre-buffer is released, or the pre-buffering thread is stopped.
+	std::atomic<uint32_t> m_PreBufferSignal = 0;
+
 	// Indicates whether decoding has finished.
-	bool m_DecoderFinished = false;
+	std::atomic_bool m_DecoderFinished = false;
 
-	// Callback function for when the output decoder has finished pre-buffering.
-	PreBufferFinishedCallback m_PreBufferFinishedCallback = nullptr;
+	// The number of samples to which the pre-buffering thread fills the pre-buffer.
+	std::atomic<size_t> m_PreBufferDepth = 0;
+
+	// Measured decode speed, in decoded seconds per wall clock second.
+	std::atomic<float> m_RealtimeFactor = 0;
 
-	// Pre-buffered sample data.
-	std::vector<std::vector<float>> m_BufferSlots;
+	// Total number of seconds decoded by the pre-buffering thread.
+	double m_DecodedSeconds = 0;
 
-	// Read buffer queue.
-	std::queue<std::vector<float>*> m_ReadQueue;
+	// Total wall clock time spent decoding by the pre-buffering thread, in seconds.
+	double m_DecodingSeconds = 0;
 
-	// Current read buffer.
-	std::vector<float>* m_ReadBuffer = nullptr;
+	// Callback function for when the output decoder has finished pre-buffering.
+	PreBufferFinishedCallback m_PreBufferFinishedCallback = nullptr;
 
-	// Current read buffer offset.
-	long m_ReadBufferOffset = 0;
+	// Prefix for the names of the metrics gauges published by this output decoder.
+	const std::string m_MetricsPrefix;
 };
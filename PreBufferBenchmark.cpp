@@ -0,0 +1,348 @@
+#include "PreBufferBenchmark.h"
+
+#include "OutputDecoder.h"
+#include "SampleRingBuffer.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <thread>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Random seed, so that each run uses the same chunk sizes & seek positions.
+constexpr uint32_t kSeed = 1974;
+
+// Ring buffer capacity at the start of each stream, in samples (a prime number, so that reads & writes wrap around the end of the buffer at every offset).
+constexpr size_t kRingBufferCapacity = 4099;
+
+// Maximum ring buffer capacity to which the producer grows the buffer, in samples.
+constexpr size_t kRingBufferMaximumCapacity = 1 << 20;
+
+// Number of ring buffer streams.
+constexpr size_t kRingBufferStreams = 16;
+
+// Number of samples in each ring buffer stream.
+constexpr uint64_t kRingBufferStreamSamples = 1 << 22;
+
+// Maximum number of samples written or read in one go.
+constexpr size_t kRingBufferMaximumChunk = 8192;
+
+// The producer attempts to grow the buffer, on average, once in this many writes.
+constexpr uint32_t kRingBufferGrowInterval = 256;
+
+// Streamed sample values repeat after this many samples (so that each value is exactly representable).
+constexpr uint64_t kSequenceLength = 1 << 24;
+
+// Value of the samples which are left in the ring buffer when it is flushed.
+constexpr float kStaleSample = -1.0f;
+
+// Synthetic decoder sample rate.
+constexpr long kSyntheticSampleRate = 48000;
+
+// Synthetic decoder channels.
+constexpr long kSyntheticChannels = 2;
+
+// Synthetic decoder stream length, in frames.
+constexpr int64_t kSyntheticFrames = 60 * kSyntheticSampleRate;
+
+// Number of output decoder seeks.
+constexpr size_t kOutputDecoderSeeks = 200;
+
+// Every so many seeks, the output decoder seeks close to the end of the stream, and is read through to the end.
+constexpr size_t kEndOfStreamInterval = 10;
+
+// Number of frames before the end of the stream to seek to, when reading through to the end.
+constexpr int64_t kEndOfStreamFrames = 2 * kSyntheticSampleRate;
+
+// Maximum number of decoded frames to read after each seek (if the end of the stream is not reached first).
+constexpr int64_t kMaximumFramesPerSeek = 5 * kSyntheticSampleRate;
+
+// Maximum number of frames read from the output decoder in one go.
+constexpr long kMaximumReadFrames = 4096;
+
+// Returns the number of seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Returns the streamed sample value at the 'position'.
+static float GetSequenceValue( const uint64_t position )
+{
+	return static_cast<float>( position % kSequenceLength );
+}
+
+// Returns the synthetic decoder sample value for the 'frame' & 'channel' (which is never zero, so that it can be told apart from the silence written on underrun).
+static float GetFrameValue( const int64_t frame, const long channel )
+{
+	const float value = static_cast<float>( frame + 1 );
+	return ( 0 == ( channel % 2 ) ) ? value : -value;
+}
+
+// Synthetic decoder, whose sample values identify the frame from which they were decoded.
+class SyntheticDecoder : public Decoder
+{
+public:
+	SyntheticDecoder() :
+		Decoder( Context::Output )
+	{
+		SetSampleRate( kSyntheticSampleRate );
+		SetChannels( kSyntheticChannels );
+		SetDuration( static_cast<float>( kSyntheticFrames ) / kSyntheticSampleRate );
+	}
+
+	~SyntheticDecoder() override
+	{
+	}
+
+protected:
+	long Read( float* buffer, const long sampleCount ) override
+	{
+		const long frames = static_cast<long>( std::clamp<int64_t>( kSyntheticFrames - m_Position, 0, sampleCount ) );
+		for ( long frame = 0; frame < frames; frame++ ) {
+			for ( long channel = 0; channel < kSyntheticChannels; channel++ ) {
+				*buffer++ = GetFrameValue( m_Position + frame, channel );
+			}
+		}
+		m_Position += frames;
+		return frames;
+	}
+
+	double Seek( const double position ) override
+	{
+		m_Position = std::clamp<int64_t>( std::llround( position * kSyntheticSampleRate ), 0, kSyntheticFrames );
+		return static_cast<double>( m_Position ) / kSyntheticSampleRate;
+	}
+
+private:
+	// Current position, in frames.
+	int64_t m_Position = 0;
+};
+
+// Streams 'sampleCount' samples through the 'buffer', from a producer thread (which randomly grows the buffer, adding to 'grows') to the calling thread.
+// Returns the number of samples which were read out of sequence.
+static uint64_t StreamRingBuffer( SampleRingBuffer& buffer, const uint64_t sampleCount, std::mt19937& engine, size_t& grows )
+{
+	// The producer alternates between writing directly to the free space, and copying from a chunk buffer.
+	std::thread producer( [ &buffer, sampleCount, seed = engine(), &grows ] ()
+		{
+			std::mt19937 producerEngine( seed );
+			std::uniform_int_distribution<size_t> chunkDistribution( 1, kRingBufferMaximumChunk );
+			std::uniform_int_distribution<uint32_t> growDistribution( 1, kRingBufferGrowInterval );
+			std::vector<float> chunk( kRingBufferMaximumChunk );
+			bool writeRegion = false;
+			uint64_t position = 0;
+			while ( position < sampleCount ) {
+				if ( const size_t capacity = buffer.GetCapacity(); ( 1 == growDistribution( producerEngine ) ) && ( capacity < kRingBufferMaximumCapacity ) && buffer.Grow( capacity * 2 ) ) {
+					++grows;
+				}
+				const size_t chunkSize = static_cast<size_t>( std::min<uint64_t>( chunkDistribution( producerEngine ), sampleCount - position ) );
+				size_t samplesWritten = 0;
+				if ( writeRegion ) {
+					const auto [region, regionSize] = buffer.GetWriteRegion();
+					samplesWritten = std::min( chunkSize, regionSize );
+					for ( size_t sample = 0; sample < samplesWritten; sample++ ) {
+						region[ sample ] = GetSequenceValue( position + sample );
+					}
+					buffer.CommitWrite( samplesWritten );
+				} else {
+					for ( size_t sample = 0; sample < chunkSize; sample++ ) {
+						chunk[ sample ] = GetSequenceValue( position + sample );
+					}
+					samplesWritten = buffer.Write( chunk.data(), chunkSize );
+				}
+				writeRegion = !writeRegion;
+				position += samplesWritten;
+				if ( 0 == samplesWritten ) {
+					std::this_thread::yield();
+				}
+			}
+		}
+	);
+
+	uint64_t errors = 0;
+	std::uniform_int_distribution<size_t> chunkDistribution( 1, kRingBufferMaximumChunk );
+	std::vector<float> chunk( kRingBufferMaximumChunk );
+	uint64_t position = 0;
+	while ( position < sampleCount ) {
+		const size_t samplesRead = buffer.Read( chunk.data(), chunkDistribution( engine ) );
+		for ( size_t sample = 0; sample < samplesRead; sample++ ) {
+			if ( GetSequenceValue( position + sample ) != chunk[ sample ] ) {
+				++errors;
+			}
+		}
+		position += samplesRead;
+		if ( 0 == samplesRead ) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	return errors;
+}
+
+// Streams through a ring buffer, flushing the buffer between streams.
+static PreBufferBenchmark::RingBufferResult RunRingBuffer()
+{
+	PreBufferBenchmark::RingBufferResult result;
+	result.InitialCapacity = kRingBufferCapacity;
+	std::mt19937 engine( kSeed );
+	SampleRingBuffer buffer( kRingBufferCapacity );
+	const std::vector<float> staleSamples( kRingBufferCapacity / 2, kStaleSample );
+	const auto start = std::chrono::steady_clock::now();
+	for ( size_t stream = 0; stream < kRingBufferStreams; stream++ ) {
+		result.Errors += StreamRingBuffer( buffer, kRingBufferStreamSamples, engine, result.Grows );
+		result.Samples += kRingBufferStreamSamples;
+		result.FinalCapacity = buffer.GetCapacity();
+
+		// Leave unread samples in both the current & previous storage, which the flush (as on seek) must discard.
+		buffer.Write( staleSamples.data(), staleSamples.size() );
+		if ( const size_t capacity = buffer.GetCapacity(); ( capacity < kRingBufferMaximumCapacity ) && buffer.Grow( capacity * 2 ) ) {
+			++result.Grows;
+		}
+		buffer.Write( staleSamples.data(), staleSamples.size() );
+		buffer.Resize( kRingBufferCapacity );
+		const SampleRingBuffer::Levels levels = buffer.GetLevels();
+		result.Errors += buffer.GetReadAvailable() + levels.TotalRead + levels.TotalWritten;
+		++result.Streams;
+	}
+	result.Seconds = GetElapsedSeconds( start );
+	result.MegasamplesPerSecond = ( result.Seconds > 0 ) ? ( result.Samples / result.Seconds / 1e6 ) : 0;
+	return result;
+}
+
+// Checks 'frameCount' frames read from the output decoder into the 'buffer', against the 'nextFrame' expected (which is advanced past each decoded frame).
+// Silent frames are counted in 'silentFrames', and are otherwise ignored.
+// Returns the number of frames which were read out of sequence.
+static uint64_t CheckFrames( const float* buffer, const long frameCount, int64_t& nextFrame, uint64_t& silentFrames )
+{
+	uint64_t errors = 0;
+	for ( long frame = 0; frame < frameCount; frame++, buffer += kSyntheticChannels ) {
+		if ( std::all_of( buffer, buffer + kSyntheticChannels, [] ( const float sample ) { return 0 == sample; } ) ) {
+			++silentFrames;
+		} else {
+			bool inSequence = true;
+			for ( long channel = 0; inSequence && ( channel < kSyntheticChannels ); channel++ ) {
+				inSequence = ( GetFrameValue( nextFrame, channel ) == buffer[ channel ] );
+			}
+			if ( inSequence ) {
+				++nextFrame;
+			} else {
+				// Resynchronise to the frame that was read, so that a single error is only counted once.
+				++errors;
+				nextFrame = static_cast<int64_t>( std::fabs( buffer[ 0 ] ) );
+			}
+		}
+	}
+	return errors;
+}
+
+// Reads from a pre-buffered output decoder, with random seeks and reads through to the end of the stream.
+static PreBufferBenchmark::OutputDecoderResult RunOutputDecoder()
+{
+	PreBufferBenchmark::OutputDecoderResult result;
+	std::mt19937 engine( kSeed );
+	std::uniform_int_distribution<int64_t> positionDistribution( 0, kSyntheticFrames - 1 );
+	std::uniform_int_distribution<int64_t> framesDistribution( 1, kMaximumFramesPerSeek );
+	std::uniform_int_distribution<long> readDistribution( 1, kMaximumReadFrames );
+	std::vector<float> buffer( kMaximumReadFrames * kSyntheticChannels );
+
+	const auto start = std::chrono::steady_clock::now();
+	OutputDecoder outputDecoder( std::make_shared<SyntheticDecoder>(), 0 /*id*/ );
+	outputDecoder.PreBuffer( nullptr /*callback*/ );
+	int64_t nextFrame = 0;
+	for ( size_t seek = 0; seek <= kOutputDecoderSeeks; seek++ ) {
+		const bool readToEnd = ( seek > 0 ) && ( 0 == ( seek % kEndOfStreamInterval ) );
+		if ( seek > 0 ) {
+			const int64_t frame = readToEnd ? ( kSyntheticFrames - kEndOfStreamFrames ) : positionDistribution( engine );
+			const double position = outputDecoder.Seek( static_cast<double>( frame ) / kSyntheticSampleRate );
+			nextFrame = std::llround( position * kSyntheticSampleRate );
+			if ( frame != nextFrame ) {
+				++result.Errors;
+			}
+			++result.Seeks;
+		}
+
+		// Read until enough decoded frames have been read, or until the end of the stream.
+		const int64_t framesToRead = readToEnd ? kSyntheticFrames : framesDistribution( engine );
+		const int64_t firstFrame = nextFrame;
+		while ( ( nextFrame - firstFrame ) < framesToRead ) {
+			const long frames = outputDecoder.Read( buffer.data(), readDistribution( engine ) );
+			if ( 0 == frames ) {
+				// The stream must end at the end of the stream, and stay ended.
+				if ( ( kSyntheticFrames != nextFrame ) || ( 0 != outputDecoder.Read( buffer.data(), kMaximumReadFrames ) ) ) {
+					++result.Errors;
+				}
+				++result.EndOfStreams;
+				break;
+			}
+			const uint64_t silentFrames = result.SilentFrames;
+			result.Errors += CheckFrames( buffer.data(), frames, nextFrame, result.SilentFrames );
+			result.Frames += static_cast<uint64_t>( frames );
+			if ( silentFrames != result.SilentFrames ) {
+				// Give the pre-buffering thread a chance to catch up.
+				std::this_thread::yield();
+			}
+		}
+	}
+	const OutputDecoder::PreBufferStatistics statistics = outputDecoder.GetPreBufferStatistics();
+	result.Underruns = statistics.Underruns;
+	result.CapacityBytes = statistics.CapacityBytes;
+	result.Seconds = GetElapsedSeconds( start );
+	return result;
+}
+
+PreBufferBenchmark::Results PreBufferBenchmark::Run()
+{
+	Results results;
+	results.RingBuffer = RunRingBuffer();
+	results.OutputDecoder = RunOutputDecoder();
+	return results;
+}
+
+bool PreBufferBenchmark::Passed( const Results& results )
+{
+	return ( 0 == results.RingBuffer.Errors ) && ( 0 == results.OutputDecoder.Errors ) && ( results.OutputDecoder.EndOfStreams > 0 );
+}
+
+bool PreBufferBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+
+		doc[ "ringBuffer" ] = {
+			{ "streams", results.RingBuffer.Streams },
+			{ "samples", results.RingBuffer.Samples },
+			{ "initialCapacity", results.RingBuffer.InitialCapacity },
+			{ "finalCapacity", results.RingBuffer.FinalCapacity },
+			{ "grows", results.RingBuffer.Grows },
+			{ "errors", results.RingBuffer.Errors },
+			{ "seconds", results.RingBuffer.Seconds },
+			{ "megasamplesPerSecond", results.RingBuffer.MegasamplesPerSecond }
+		};
+
+		doc[ "outputDecoder" ] = {
+			{ "seeks", results.OutputDecoder.Seeks },
+			{ "endOfStreams", results.OutputDecoder.EndOfStreams },
+			{ "frames", results.OutputDecoder.Frames },
+			{ "silentFrames", results.OutputDecoder.SilentFrames },
+			{ "underruns", results.OutputDecoder.Underruns },
+			{ "capacityBytes", results.OutputDecoder.CapacityBytes },
+			{ "errors", results.OutputDecoder.Errors },
+			{ "seconds", results.OutputDecoder.Seconds }
+		};
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
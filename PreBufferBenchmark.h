@@ -0,0 +1,53 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+
+// Stress tests the output decoder pre-buffer, checking that no sample data is lost, duplicated or reordered, and measures its throughput.
+// The ring buffer is streamed through by a producer & consumer thread pair, with a capacity that wraps at every offset, while the producer grows the buffer, and is flushed between streams.
+// An output decoder is then pre-buffered from a synthetic decoder, and read as fast as possible (so that it underruns and grows the pre-buffer), with random seeks and reads through to the end of the stream.
+// The benchmark is run headless using the '-prebufferbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class PreBufferBenchmark
+{
+public:
+	// Ring buffer results.
+	struct RingBufferResult {
+		size_t Streams = 0;                     // Number of streams (with the buffer flushed before each stream).
+		uint64_t Samples = 0;                   // Total number of samples streamed.
+		size_t InitialCapacity = 0;             // Buffer capacity at the start of each stream, in samples.
+		size_t FinalCapacity = 0;               // Buffer capacity at the end of the last stream, in samples.
+		size_t Grows = 0;                       // Number of times the buffer was grown.
+		uint64_t Errors = 0;                    // Number of samples which were read out of sequence, or found after a flush.
+		double Seconds = 0;                     // Wall clock time for all streams, in seconds.
+		double MegasamplesPerSecond = 0;        // Throughput, in millions of samples per second.
+	};
+
+	// Output decoder results.
+	struct OutputDecoderResult {
+		size_t Seeks = 0;                       // Number of seeks (each of which flushes the pre-buffer).
+		size_t EndOfStreams = 0;                // Number of times the stream was read through to the end.
+		uint64_t Frames = 0;                    // Number of decoded frames read.
+		uint64_t SilentFrames = 0;              // Number of silent frames read, which fill the shortfall when the pre-buffer underruns.
+		uint64_t Underruns = 0;                 // Number of pre-buffer underruns.
+		size_t CapacityBytes = 0;               // Pre-buffer capacity at the end of the test, in bytes.
+		uint64_t Errors = 0;                    // Number of frames read out of sequence, seeks to the wrong position, and streams which did not end at the end of the stream.
+		double Seconds = 0;                     // Wall clock time for the test, in seconds.
+	};
+
+	// Benchmark results.
+	struct Results {
+		RingBufferResult RingBuffer;            // Ring buffer results.
+		OutputDecoderResult OutputDecoder;      // Output decoder results.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are free of errors.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are free of errors.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
@@ -0,0 +1,202 @@
+#include "ProbeBenchmark.h"
+
+#include "Handlers.h"
+#include "MediaInfo.h"
+#include "Utility.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Maximum allowed difference between the probed & decoder durations, in seconds (which is less than the encoder delay of an AAC stream).
+constexpr double kMaxDurationError = 0.01;
+
+// Synthetic track format.
+constexpr long kSampleRate = 44100;
+constexpr long kChannels = 2;
+constexpr long kBitsPerSample = 16;
+
+// Synthetic track duration, in seconds.
+constexpr long kTrackSeconds = 30;
+
+// Number of frames encoded in one go.
+constexpr long kBlockFrames = 4096;
+
+// Number of copies of the synthetic track in each format.
+constexpr size_t kTrackCount = 100;
+
+// Returns the number of seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Encodes a synthetic track to the 'filename' (without file extension) using the 'encoder'.
+// Returns the file name with file extension, or an empty string if the track could not be encoded.
+static std::wstring EncodeTrack( Encoder& encoder, const std::filesystem::path& filename )
+{
+	std::wstring encodedFilename = filename.wstring();
+	constexpr long long totalFrames = static_cast<long long>( kSampleRate ) * kTrackSeconds;
+	if ( !encoder.Open( encodedFilename, kSampleRate, kChannels, kBitsPerSample, totalFrames, std::string() /*settings*/, Tags() ) ) {
+		return std::wstring();
+	}
+	std::vector<float> buffer( kBlockFrames * kChannels );
+	bool success = true;
+	for ( long long frame = 0; success && ( frame < totalFrames ); frame += kBlockFrames ) {
+		const long frames = static_cast<long>( std::min<long long>( kBlockFrames, totalFrames - frame ) );
+		for ( long offset = 0; offset < frames; offset++ ) {
+			const float sample = 0.5f * static_cast<float>( std::sin( 2 * std::numbers::pi * 440 * ( frame + offset ) / kSampleRate ) );
+			std::fill_n( buffer.begin() + offset * kChannels, kChannels, sample );
+		}
+		success = encoder.Write( buffer.data(), frames );
+	}
+	encoder.Close();
+	return success ? encodedFilename : std::wstring();
+}
+
+// Copies the encoded track 'filename' to form a folder of tracks at the 'root', returning the copied file names.
+static std::vector<std::wstring> CopyTrack( const std::filesystem::path& filename, const std::filesystem::path& root )
+{
+	std::vector<std::wstring> files;
+	std::error_code ec;
+	std::filesystem::create_directories( root, ec );
+	for ( size_t track = 0; !ec && ( track < kTrackCount ); track++ ) {
+		const std::filesystem::path copy = root / ( L"Track " + std::to_wstring( track ) + filename.extension().wstring() );
+		if ( std::filesystem::copy_file( filename, copy, std::filesystem::copy_options::overwrite_existing, ec ) ) {
+			files.push_back( copy.wstring() );
+		}
+	}
+	return files;
+}
+
+// Returns the stream properties of the 'filename' from a decoder, or nullopt if a decoder could not be opened.
+static std::optional<StreamProbe::Info> GetDecoderInfo( const Handlers& handlers, const std::wstring& filename )
+{
+	if ( const Decoder::Ptr stream = handlers.OpenDecoder( MediaInfo( filename ), Decoder::Context::Temporary, false /*applyCues*/ ); stream ) {
+		return StreamProbe::Info{ stream->GetSampleRate(), stream->GetChannels(), stream->GetBPS(), stream->GetDuration(), stream->GetBitrate() };
+	}
+	return std::nullopt;
+}
+
+// Returns the stream properties of the 'filename' by probing the container headers, falling back to a decoder if necessary (as the library does).
+static std::optional<StreamProbe::Info> GetProbeInfo( const Handlers& handlers, const std::wstring& filename )
+{
+	const std::optional<StreamProbe::Info> info = handlers.Probe( MediaInfo( filename ) );
+	return info ? info : GetDecoderInfo( handlers, filename );
+}
+
+// Scans the 'files' using the 'getInfo' function, returning the throughput in files per second (or zero if any file could not be scanned).
+template <typename GetInfo>
+static double ScanFiles( const Handlers& handlers, const std::vector<std::wstring>& files, const GetInfo& getInfo )
+{
+	const auto start = std::chrono::steady_clock::now();
+	for ( const auto& file : files ) {
+		if ( !getInfo( handlers, file ) ) {
+			return 0;
+		}
+	}
+	const double seconds = GetElapsedSeconds( start );
+	return ( seconds > 0 ) ? ( files.size() / seconds ) : 0;
+}
+
+// Runs the benchmark for the encoder 'handler', using the 'folder' for the synthetic tracks.
+// Returns the result, or nullopt if the synthetic tracks could not be created.
+static std::optional<ProbeBenchmark::Result> RunFormat( const Handlers& handlers, const Handler& handler, const std::filesystem::path& folder )
+{
+	const Encoder::Ptr encoder = handler.OpenEncoder();
+	const std::wstring filename = encoder ? EncodeTrack( *encoder, folder / L"Source" ) : std::wstring();
+	const std::vector<std::wstring> files = filename.empty() ? std::vector<std::wstring>() : CopyTrack( filename, folder / L"Tracks" );
+	const auto decoderInfo = files.empty() ? std::nullopt : GetDecoderInfo( handlers, files.front() );
+	if ( !decoderInfo ) {
+		return std::nullopt;
+	}
+
+	ProbeBenchmark::Result result;
+	result.Format = WideStringToUTF8( handler.GetDescription() );
+	result.Extension = WideStringToUTF8( GetFileExtension( filename ) );
+	result.Files = files.size();
+	result.DecoderDuration = decoderInfo->Duration;
+	if ( const auto probeInfo = handlers.Probe( MediaInfo( files.front() ) ); probeInfo ) {
+		result.Probed = true;
+		result.ProbeDuration = probeInfo->Duration;
+		result.Matches = ( probeInfo->SampleRate == decoderInfo->SampleRate ) && ( probeInfo->Channels == decoderInfo->Channels ) &&
+			( std::fabs( result.ProbeDuration - result.DecoderDuration ) <= kMaxDurationError );
+	} else {
+		result.ProbeDuration = result.DecoderDuration;
+		result.Matches = true;
+	}
+
+	result.DecoderFilesPerSecond = ScanFiles( handlers, files, GetDecoderInfo );
+	result.ProbeFilesPerSecond = ScanFiles( handlers, files, GetProbeInfo );
+	return result;
+}
+
+ProbeBenchmark::Results ProbeBenchmark::Run()
+{
+	Results results;
+	const std::filesystem::path root = std::filesystem::temp_directory_path() / L"VUPlayerProbeBenchmark";
+	std::error_code ec;
+	std::filesystem::remove_all( root, ec );
+
+	const Handlers handlers;
+	size_t index = 0;
+	for ( const auto& handler : handlers.GetEncoders() ) {
+		const std::filesystem::path folder = root / ( L"Format " + std::to_wstring( index++ ) );
+		if ( std::filesystem::create_directories( folder, ec ) ) {
+			if ( const auto result = RunFormat( handlers, *handler, folder ); result ) {
+				results.Formats.push_back( *result );
+			}
+		}
+	}
+
+	std::filesystem::remove_all( root, ec );
+	return results;
+}
+
+bool ProbeBenchmark::Passed( const Results& results )
+{
+	return !results.Formats.empty() && std::all_of( results.Formats.begin(), results.Formats.end(), [] ( const Result& result )
+		{
+			return result.Matches && ( result.ProbeFilesPerSecond > 0 ) && ( result.DecoderFilesPerSecond > 0 );
+		} );
+}
+
+bool ProbeBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+		doc[ "trackSeconds" ] = kTrackSeconds;
+		doc[ "maxAllowedDurationError" ] = kMaxDurationError;
+
+		nlohmann::json formats = nlohmann::json::array();
+		for ( const auto& result : results.Formats ) {
+			nlohmann::json format;
+			format[ "format" ] = result.Format;
+			format[ "extension" ] = result.Extension;
+			format[ "files" ] = result.Files;
+			format[ "probed" ] = result.Probed;
+			format[ "matches" ] = result.Matches;
+			format[ "probeDuration" ] = result.ProbeDuration;
+			format[ "decoderDuration" ] = result.DecoderDuration;
+			format[ "probeFilesPerSecond" ] = result.ProbeFilesPerSecond;
+			format[ "decoderFilesPerSecond" ] = result.DecoderFilesPerSecond;
+			formats.push_back( format );
+		}
+		doc[ "formats" ] = formats;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
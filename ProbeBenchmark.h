@@ -0,0 +1,44 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Checks the correctness, and measures the scan throughput, of the lightweight stream probes used when adding files to the media library.
+// A synthetic track is encoded in each format for which an encoder is available, and copied to form a folder of tracks in the temporary folder.
+// The stream properties of each track are then read by probing the container headers, and by opening a decoder (as the library did before probing),
+// and the probed properties are checked against those reported by the decoder.
+// The benchmark is run headless using the '-probebenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class ProbeBenchmark
+{
+public:
+	// Benchmark results for a single format.
+	struct Result {
+		std::string Format;                     // Format description.
+		std::string Extension;                  // File extension.
+		size_t Files = 0;                       // Number of files scanned.
+		bool Probed = false;                    // Whether the stream properties could be probed (otherwise a decoder is needed).
+		bool Matches = false;                   // Whether the probed stream properties match the decoder (or true, if the format could not be probed).
+		double ProbeDuration = 0;               // Duration reported by the probe, in seconds.
+		double DecoderDuration = 0;             // Duration reported by the decoder, in seconds.
+		double ProbeFilesPerSecond = 0;         // Scan throughput when probing (falling back to a decoder, if necessary).
+		double DecoderFilesPerSecond = 0;       // Scan throughput when opening a decoder.
+	};
+
+	// Benchmark results.
+	struct Results {
+		std::vector<Result> Formats;            // Results for each format.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are correct.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are correct.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
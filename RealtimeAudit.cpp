@@ -0,0 +1,110 @@
+#include "RealtimeAudit.h"
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <string>
+
+#if defined( REALTIME_AUDIT ) && defined( _DEBUG )
+// Heap allocations are counted using the debug CRT allocation hook.
+#define REALTIME_AUDIT_ALLOCATIONS
+#include <crtdbg.h>
+#endif
+
+#ifdef REALTIME_AUDIT
+
+// Audio callback nesting depth for the current thread.
+static thread_local int s_CallbackDepth = 0;
+
+// Number of audio callbacks.
+static std::atomic<uint64_t> s_Callbacks = 0;
+
+// Number of heap allocations made during audio callbacks.
+static std::atomic<uint64_t> s_Allocations = 0;
+
+// Number of blocking locks taken during audio callbacks.
+static std::atomic<uint64_t> s_Locks = 0;
+
+// Number of heap allocations at the time of the last report.
+static std::atomic<uint64_t> s_ReportedAllocations = 0;
+
+// Number of blocking locks at the time of the last report.
+static std::atomic<uint64_t> s_ReportedLocks = 0;
+
+#ifdef REALTIME_AUDIT_ALLOCATIONS
+
+// Previous allocation hook.
+static _CRT_ALLOC_HOOK s_PreviousAllocHook = nullptr;
+
+// Debug CRT allocation hook, which counts allocations made during audio callbacks.
+static int __cdecl AllocHook( int allocType, void* userData, size_t size, int blockType, long requestNumber, const unsigned char* filename, int lineNumber )
+{
+	if ( ( s_CallbackDepth > 0 ) && ( ( _HOOK_ALLOC == allocType ) || ( _HOOK_REALLOC == allocType ) ) ) {
+		++s_Allocations;
+	}
+	return ( nullptr != s_PreviousAllocHook ) ? s_PreviousAllocHook( allocType, userData, size, blockType, requestNumber, filename, lineNumber ) : TRUE;
+}
+
+// Installs the allocation hook.
+static bool InstallAllocHook()
+{
+	s_PreviousAllocHook = _CrtSetAllocHook( AllocHook );
+	return true;
+}
+
+#endif
+
+#endif
+
+RealtimeAudit::Scope::Scope()
+{
+#ifdef REALTIME_AUDIT
+#ifdef REALTIME_AUDIT_ALLOCATIONS
+	[[maybe_unused]] static const bool s_AllocHookInstalled = InstallAllocHook();
+#endif
+	if ( 0 == s_CallbackDepth++ ) {
+		++s_Callbacks;
+	}
+#endif
+}
+
+RealtimeAudit::Scope::~Scope()
+{
+#ifdef REALTIME_AUDIT
+	--s_CallbackDepth;
+#endif
+}
+
+void RealtimeAudit::OnLock()
+{
+#ifdef REALTIME_AUDIT
+	if ( s_CallbackDepth > 0 ) {
+		++s_Locks;
+	}
+#endif
+}
+
+RealtimeAudit::Counts RealtimeAudit::GetCounts()
+{
+	Counts counts;
+#ifdef REALTIME_AUDIT
+	counts.Callbacks = s_Callbacks;
+	counts.Allocations = s_Allocations;
+	counts.Locks = s_Locks;
+#endif
+	return counts;
+}
+
+void RealtimeAudit::Report()
+{
+#ifdef REALTIME_AUDIT
+	const Counts counts = GetCounts();
+	const uint64_t allocations = counts.Allocations - s_ReportedAllocations.exchange( counts.Allocations );
+	const uint64_t locks = counts.Locks - s_ReportedLocks.exchange( counts.Locks );
+	if ( ( allocations > 0 ) || ( locks > 0 ) ) {
+		const std::wstring debugStr = L"VUPlayer::RealtimeAudit: " + std::to_wstring( allocations ) + L" allocations, " + std::to_wstring( locks ) + L" blocking locks on the audio thread (" +
+			std::to_wstring( counts.Callbacks ) + L" callbacks in total)\r\n";
+		OutputDebugString( debugStr.c_str() );
+	}
+#endif
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#ifdef _DEBUG
+// Define to audit audio threads for operations which are not real-time safe.
+#define REALTIME_AUDIT
+#endif
+
+// Audits audio threads, by counting the heap allocations & blocking locks made while running an audio callback.
+// Auditing is only performed when REALTIME_AUDIT is defined (by default, in debug builds), and has no effect otherwise.
+class RealtimeAudit
+{
+public:
+	// Audit counts.
+	struct Counts {
+		uint64_t Callbacks = 0;       // Number of audio callbacks.
+		uint64_t Allocations = 0;     // Number of heap allocations made during audio callbacks.
+		uint64_t Locks = 0;           // Number of blocking locks taken during audio callbacks.
+	};
+
+	// Marks the current thread as running an audio callback, for the lifetime of the scope (scopes can be nested).
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+	};
+
+	// Mutex which records a blocking lock when locked during an audio callback.
+	// Non-blocking attempts to lock the mutex are not recorded.
+	class Mutex
+	{
+	public:
+		void lock()
+		{
+#ifdef REALTIME_AUDIT
+			OnLock();
+#endif
+			m_Mutex.lock();
+		}
+
+		bool try_lock()
+		{
+			return m_Mutex.try_lock();
+		}
+
+		void unlock()
+		{
+			m_Mutex.unlock();
+		}
+
+	private:
+		std::mutex m_Mutex;
+	};
+
+	// Returns the audit counts.
+	static Counts GetCounts();
+
+	// Outputs the audit counts to the debugger, if any allocations or blocking locks have been recorded since the last report.
+	static void Report();
+
+private:
+	// Called when a mutex is locked.
+	static void OnLock();
+};
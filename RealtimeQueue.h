@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Fixed capacity, lock-free single producer/single consumer queue, for passing events from an audio thread.
+// All elements are constructed up front, so pushing an element only moves it into an existing slot, and the consumer resets each slot as it is popped.
+// Consequently, neither pushing nor popping allocates or frees memory on the producer thread (provided moving an element does not).
+template <typename T, size_t Capacity>
+class RealtimeQueue
+{
+public:
+	RealtimeQueue() = default;
+
+	RealtimeQueue( const RealtimeQueue& ) = delete;
+	RealtimeQueue& operator=( const RealtimeQueue& ) = delete;
+
+	// Producer side.
+
+	// Moves the 'value' into the queue, returning false if the queue is full (in which case the 'value' is left unchanged).
+	bool Push( T&& value )
+	{
+		const uint64_t writePosition = m_WritePosition.load( std::memory_order_relaxed );
+		if ( ( writePosition - m_ReadPosition.load( std::memory_order_acquire ) ) >= Capacity ) {
+			return false;
+		}
+		m_Slots[ writePosition % Capacity ] = std::move( value );
+		m_WritePosition.store( writePosition + 1, std::memory_order_release );
+		return true;
+	}
+
+	// Consumer side.
+
+	// Moves the oldest element from the queue into the 'value', returning false if the queue is empty.
+	bool Pop( T& value )
+	{
+		const uint64_t readPosition = m_ReadPosition.load( std::memory_order_relaxed );
+		if ( readPosition == m_WritePosition.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+		T& slot = m_Slots[ readPosition % Capacity ];
+		value = std::move( slot );
+		slot = T();
+		m_ReadPosition.store( readPosition + 1, std::memory_order_release );
+		return true;
+	}
+
+	// Discards all elements in the queue.
+	void Clear()
+	{
+		T value;
+		while ( Pop( value ) ) {
+		}
+	}
+
+private:
+	// Element slots.
+	std::array<T, Capacity> m_Slots = {};
+
+	// Total number of elements pushed (only modified by the producer).
+	alignas( 64 ) std::atomic<uint64_t> m_WritePosition = 0;
+
+	// Total number of elements popped (only modified by the consumer).
+	alignas( 64 ) std::atomic<uint64_t> m_ReadPosition = 0;
+};
@@ -1,11 +1,15 @@
 #include "Resampler.h"
 
+#include "Metrics.h"
+
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 
 extern "C"
 {
 #include <libswresample/swresample.h>
+#include <libavutil/mathematics.h>
 #include <libavutil/opt.h>
 }
 
@@ -27,53 +31,169 @@ static AVChannelLayout GetChannelLayout( const uint32_t channels )
 	};
 	if ( const auto layout = kChannelLayouts.find( channels ); kChannelLayouts.end() != layout )
 		return layout->second;
-	return {};
+	AVChannelLayout layout = {};
+	av_channel_layout_default( &layout, static_cast<int>( channels ) );
+	return layout;
+}
+
+// Maximum number of idle resampler contexts to keep for reuse.
+constexpr size_t kMaxIdleContexts = 4;
+
+// Minimum number of input samples to feed the resampler, so that reads always make progress while the resampler fills its filter.
+constexpr long kMinimumInputSamples = 64;
+
+// Resampler filter options for each quality.
+struct QualityOptions {
+	int FilterSize;               // Length of each filter, in input samples.
+	int PhaseShift;               // Log2 of the number of filter phases.
+	bool LinearInterpolation;     // Whether to interpolate between filter phases.
+	double Cutoff;                // Filter cutoff, relative to the Nyquist frequency.
+};
+
+static QualityOptions GetQualityOptions( const Resampler::Quality quality )
+{
+	switch ( quality ) {
+		case Resampler::Quality::Fast: {
+			return { 8, 6, true, 0.9 };
+		}
+		case Resampler::Quality::Best: {
+			return { 64, 12, true, 0.97 };
+		}
+		default: {
+			return { 32, 10, true, 0.97 };
+		}
+	}
+}
+
+Resampler::ContextPool Resampler::s_ContextPool;
+
+std::mutex Resampler::s_ContextPoolMutex;
+
+void Resampler::ContextDeleter::operator()( SwrContext* context ) const
+{
+	swr_free( &context );
 }
 
-Resampler::Resampler( Decoder::Ptr decoder, const long id, const uint32_t outputRate, const uint32_t outputChannels ) :
+Resampler::Resampler( Decoder::Ptr decoder, const long id, const uint32_t outputRate, const uint32_t outputChannels, const Quality quality ) :
 	OutputDecoder( decoder, id ),
+	m_ContextKey( static_cast<uint32_t>( decoder->GetSampleRate() ), outputRate, outputChannels, quality ),
+	m_Context( AcquireContext( m_ContextKey ) ),
 	m_InputSampleRate( static_cast<uint32_t>( decoder->GetSampleRate() ) ),
 	m_InputChannels( GetDecoderChannels( decoder ) ),
 	m_OutputSampleRate( outputRate ),
 	m_OutputChannels( outputChannels )
 {
-	const AVChannelLayout srcLayout = GetChannelLayout( m_InputChannels );
-	const AVChannelLayout dstLayout = GetChannelLayout( m_OutputChannels );
+	// Remix before resampling, so that the FFmpeg resampler only needs to handle the output channels.
+	if ( m_InputChannels != m_OutputChannels ) {
+		m_ChannelMixer = std::make_unique<ChannelMixer>( m_InputChannels, m_OutputChannels );
+	}
+}
+
+Resampler::~Resampler()
+{
+	ReleaseContext( m_ContextKey, std::move( m_Context ) );
+}
+
+Resampler::Quality Resampler::GetQuality( const Decoder::Context context )
+{
+	switch ( context ) {
+		case Decoder::Context::Output: {
+			return Quality::Balanced;
+		}
+		case Decoder::Context::Input: {
+			return Quality::Best;
+		}
+		default: {
+			return Quality::Fast;
+		}
+	}
+}
+
+Resampler::ContextPtr Resampler::CreateContext( const ContextKey& key )
+{
+	const auto& [inputRate, outputRate, channels, quality] = key;
+	const AVChannelLayout layout = GetChannelLayout( channels );
 	constexpr AVSampleFormat kSampleFormat = AV_SAMPLE_FMT_FLT;
-	int result = swr_alloc_set_opts2( &m_Context, &dstLayout, kSampleFormat, static_cast<int>( m_OutputSampleRate ), &srcLayout, kSampleFormat, static_cast<int>( m_InputSampleRate ), 0, nullptr );
-	if ( 0 == result ) {
-		result = av_opt_set( m_Context, "filter_type", "kaiser", 0 );
-		result = swr_init( m_Context );
-		if ( result < 0 )
-			swr_free( &m_Context );
+	SwrContext* context = nullptr;
+	if ( 0 == swr_alloc_set_opts2( &context, &layout, kSampleFormat, static_cast<int>( outputRate ), &layout, kSampleFormat, static_cast<int>( inputRate ), 0, nullptr ) ) {
+		const QualityOptions options = GetQualityOptions( quality );
+		av_opt_set( context, "filter_type", "kaiser", 0 );
+		av_opt_set_int( context, "filter_size", options.FilterSize, 0 );
+		av_opt_set_int( context, "phase_shift", options.PhaseShift, 0 );
+		av_opt_set_int( context, "linear_interp", options.LinearInterpolation ? 1 : 0, 0 );
+		av_opt_set_double( context, "cutoff", options.Cutoff, 0 );
+		if ( swr_init( context ) < 0 ) {
+			swr_free( &context );
+		}
+	}
+	return ContextPtr( context );
+}
+
+Resampler::ContextPtr Resampler::AcquireContext( const ContextKey& key )
+{
+	ContextPtr context;
+	{
+		std::lock_guard<std::mutex> lock( s_ContextPoolMutex );
+		const auto idle = std::find_if( s_ContextPool.begin(), s_ContextPool.end(), [ &key ] ( const auto& entry ) { return key == entry.first; } );
+		if ( s_ContextPool.end() != idle ) {
+			context = std::move( idle->second );
+			s_ContextPool.erase( idle );
+		}
 	}
-	if ( nullptr == m_Context ) {
+
+	// Reinitialising an idle context clears its buffered samples, but keeps the filter bank (which is the expensive part to calculate).
+	if ( context && ( swr_init( context.get() ) < 0 ) ) {
+		context.reset();
+	}
+	if ( !context ) {
+		context = CreateContext( key );
+	}
+	if ( !context ) {
 		throw std::runtime_error( "Resampler could not be initialised" );
 	}
+	return context;
 }
 
-Resampler::~Resampler()
+void Resampler::ReleaseContext( const ContextKey& key, ContextPtr context )
 {
-	if ( nullptr != m_Context ) {
-		swr_free( &m_Context );
+	if ( context ) {
+		std::lock_guard<std::mutex> lock( s_ContextPoolMutex );
+		s_ContextPool.emplace_front( key, std::move( context ) );
+		if ( s_ContextPool.size() > kMaxIdleContexts ) {
+			s_ContextPool.pop_back();
+		}
 	}
 }
 
 long Resampler::Read( float* outputBuffer, const long outputSampleCount )
 {
-	long inputSampleCount = std::max( 1l, static_cast<long>( outputSampleCount * static_cast<float>( m_InputSampleRate ) / m_OutputSampleRate ) );
-	m_InputBuffer.resize( inputSampleCount * m_InputChannels );
+	long samplesConverted = 0;
+	while ( ( samplesConverted < outputSampleCount ) && !m_Flushed ) {
+		const long samplesRemaining = outputSampleCount - samplesConverted;
+		float* output = outputBuffer + static_cast<size_t>( samplesConverted ) * m_OutputChannels;
 
-	long samplesDecoded = OutputDecoder::Read( m_InputBuffer.data(), inputSampleCount );
-	long samplesConverted = static_cast<long>( Convert( m_InputBuffer.data(), static_cast<uint32_t>( samplesDecoded ), outputBuffer, static_cast<uint32_t>( outputSampleCount ) ) );
+		long samplesDecoded = 0;
+		if ( !m_InputFinished ) {
+			// Only decode the input needed for the remaining output, allowing for the input already buffered by the resampler.
+			const int64_t inputRequired = av_rescale_rnd( samplesRemaining, m_InputSampleRate, m_OutputSampleRate, AV_ROUND_UP ) - swr_get_delay( m_Context.get(), m_InputSampleRate );
+			const long inputSampleCount = static_cast<long>( std::max<int64_t>( kMinimumInputSamples, inputRequired ) );
+			const size_t inputBufferSize = static_cast<size_t>( inputSampleCount ) * std::max( m_InputChannels, m_OutputChannels );
+			if ( m_InputBuffer.size() < inputBufferSize ) {
+				m_InputBuffer.resize( inputBufferSize );
+			}
+			samplesDecoded = Remix( OutputDecoder::Read( m_InputBuffer.data(), inputSampleCount ) );
+			m_InputFinished = ( samplesDecoded <= 0 );
+		}
 
-	// The resampler has an internal buffer, so keep feeding it data until it provides some output.
-	constexpr long kBufferSizeLimit = 65536;
-	while ( ( samplesConverted <= 0 ) && ( samplesDecoded > 0 ) && ( inputSampleCount <= kBufferSizeLimit ) ) {
-		inputSampleCount *= 2;
-		m_InputBuffer.resize( inputSampleCount * m_InputChannels );
-		samplesDecoded = OutputDecoder::Read( m_InputBuffer.data(), inputSampleCount );
-		samplesConverted = static_cast<long>( Convert( m_InputBuffer.data(), static_cast<uint32_t>( samplesDecoded ), outputBuffer, static_cast<uint32_t>( outputSampleCount ) ) );
+		// Once the input has finished, flush the samples still buffered by the resampler.
+		const long samples = static_cast<long>( Convert( m_InputFinished ? nullptr : m_InputBuffer.data(), static_cast<uint32_t>( std::max( 0l, samplesDecoded ) ), output, static_cast<uint32_t>( samplesRemaining ) ) );
+		if ( m_InputFinished && ( 0 == samples ) ) {
+			m_Flushed = true;
+		}
+		samplesConverted += samples;
+	}
+	if ( !m_Flushed ) {
+		Metrics::Record( Metrics::Histogram::ResamplerLatency, static_cast<uint64_t>( std::max<int64_t>( 0, swr_get_delay( m_Context.get(), 1000000 ) ) ) );
 	}
 	return samplesConverted;
 }
@@ -93,10 +213,18 @@ float Resampler::GetPreBufferSizeFactor() const
 	return std::clamp( static_cast<float>( m_InputSampleRate ) / m_OutputSampleRate, 1.0f, 8.0f );
 }
 
+long Resampler::Remix( const long samples )
+{
+	if ( m_ChannelMixer && ( samples > 0 ) ) {
+		m_ChannelMixer->Process( m_InputBuffer.data(), m_InputBuffer.data(), static_cast<size_t>( samples ) );
+	}
+	return samples;
+}
+
 uint32_t Resampler::Convert( const float* const inputBuffer, const uint32_t inputSamples, float* outputBuffer, const uint32_t outputSamples )
 {
 	const uint8_t* const inBuffer = reinterpret_cast<const uint8_t* const>( inputBuffer );
 	uint8_t* const outBuffer = reinterpret_cast<uint8_t* const>( outputBuffer );
-	const int samplesConverted = swr_convert( m_Context, &outBuffer, static_cast<int>( outputSamples ), &inBuffer, static_cast<int>( inputSamples ) );
+	const int samplesConverted = swr_convert( m_Context.get(), &outBuffer, static_cast<int>( outputSamples ), ( nullptr != inputBuffer ) ? &inBuffer : nullptr, static_cast<int>( inputSamples ) );
 	return ( samplesConverted < 0 ) ? 0 : static_cast<uint32_t>( samplesConverted );
 }
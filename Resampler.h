@@ -1,24 +1,41 @@
 #pragma once
 
+#include "ChannelMixer.h"
 #include "OutputDecoder.h"
 
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 struct SwrContext;
 
 // An output decoder that provides resampled data.
 class Resampler : public OutputDecoder
 {
 public:
+	// Resampling quality.
+	enum class Quality {
+		Fast,       // Short interpolating filter, for the lowest CPU usage.
+		Balanced,   // Medium length filter, suitable for playback.
+		Best        // Long interpolating filter, suitable for conversion.
+	};
+
 	// 'decoder' - underlying decoder.
 	// 'id' - playlist item ID.
 	// 'outputRate' - output sample rate.
 	// 'outputChannels' - output channels.
-	Resampler( Decoder::Ptr decoder, const long id, const uint32_t outputRate, const uint32_t outputChannels );
+	// 'quality' - resampling quality.
+	Resampler( Decoder::Ptr decoder, const long id, const uint32_t outputRate, const uint32_t outputChannels, const Quality quality );
 	virtual ~Resampler();
 
+	// Returns the resampling quality to use for a decoding 'context'.
+	static Quality GetQuality( const Decoder::Context context );
+
 	// Reads sample data.
 	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
 	// 'sampleCount' - number of samples to read.
-	// Returns the number of samples read, or zero if the stream has ended.
+	// Returns the number of samples read, which is always the number requested until the stream ends, or zero if the stream has ended.
 	long Read( float* buffer, const long sampleCount ) override;
 
 	// Returns the output sample rate.
@@ -28,23 +45,70 @@ public:
 	long GetOutputChannels() const override;
 
 private:
+	// Frees an FFmpeg resampler context.
+	struct ContextDeleter {
+		void operator()( SwrContext* context ) const;
+	};
+
+	// FFmpeg resampler context pointer.
+	using ContextPtr = std::unique_ptr<SwrContext, ContextDeleter>;
+
+	// Identifies a resampler context configuration (input rate, output rate, channels, quality).
+	using ContextKey = std::tuple<uint32_t, uint32_t, uint32_t, Quality>;
+
+	// Idle resampler contexts, most recently released first.
+	using ContextPool = std::list<std::pair<ContextKey, ContextPtr>>;
+
+	// Returns an initialised resampler context for the 'key', reusing an idle context where possible.
+	// Throws a std::runtime_error exception if the context could not be initialised.
+	static ContextPtr AcquireContext( const ContextKey& key );
+
+	// Returns a resampler 'context' for the 'key' to the idle pool, so that it can be reused by the next resampler with the same configuration.
+	static void ReleaseContext( const ContextKey& key, ContextPtr context );
+
+	// Creates a resampler context for the 'key', or returns nullptr if the context could not be created.
+	static ContextPtr CreateContext( const ContextKey& key );
+
 	// Converts sample data using the FFmpeg resampler.
-	// 'inputBuffer' - input samples from the decoder.
+	// 'inputBuffer' - input samples from the decoder, or nullptr to flush the samples buffered by the resampler.
 	// 'inputSamples' - input sample count.
 	// 'outputBuffer' - output samples from the resampler.
 	// 'outputSamples' - output sample count.
 	// Returns the number of samples converted.
 	uint32_t Convert( const float* const inputBuffer, const uint32_t inputSamples, float* outputBuffer, const uint32_t outputSamples );
 
+	// Remixes decoded sample data in the input buffer from the input channels to the output channels.
+	// 'samples' - input sample count.
+	// Returns the input sample count.
+	long Remix( const long samples );
+
 	// Returns an additional factor by which to scale the buffer size when pre-buffering.
 	float GetPreBufferSizeFactor() const;
 
+	// Idle resampler contexts.
+	static ContextPool s_ContextPool;
+
+	// Idle resampler context mutex.
+	static std::mutex s_ContextPoolMutex;
+
+	// Resampler context configuration.
+	const ContextKey m_ContextKey;
+
 	// FFmpeg resampler context.
-	SwrContext* m_Context = nullptr;
+	ContextPtr m_Context;
 
-	// Decoded sample data to feed the FFmpeg resampler.
+	// Decoded sample data to feed the FFmpeg resampler (only ever grows, so that reads do not normally allocate).
 	std::vector<float> m_InputBuffer;
 
+	// Indicates whether the decoder has no more input samples.
+	bool m_InputFinished = false;
+
+	// Indicates whether the samples buffered by the FFmpeg resampler have been flushed.
+	bool m_Flushed = false;
+
+	// Channel mixer, used when the input & output channels differ.
+	std::unique_ptr<ChannelMixer> m_ChannelMixer;
+
 	const uint32_t m_InputSampleRate;
 	const uint32_t m_InputChannels;
 	const uint32_t m_OutputSampleRate;
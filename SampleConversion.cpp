@@ -0,0 +1,862 @@
+#include "SampleConversion.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#define SAMPLE_CONVERSION_X86
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// Kernel function types.
+using Signed32ToFloatKernel = void ( * )( const int32_t*, float*, const size_t, const uint32_t );
+using Signed16ToFloatKernel = void ( * )( const int16_t*, float*, const size_t );
+using Unsigned8ToFloatKernel = void ( * )( const uint8_t*, float*, const size_t );
+using FloatToSigned32Kernel = void ( * )( const float*, int32_t*, const size_t, const uint32_t );
+using FloatToSigned16Kernel = void ( * )( const float*, int16_t*, const size_t );
+using FloatToUnsigned8Kernel = void ( * )( const float*, uint8_t*, const size_t );
+using PlanarStereoToFloatKernel = void ( * )( const int32_t*, const int32_t*, float*, const size_t, const uint32_t );
+using FindAboveThresholdKernel = size_t ( * )( const float*, const size_t, const float );
+
+// A set of conversion kernels for an instruction set.
+struct Kernels {
+	Signed32ToFloatKernel Signed32ToFloat;
+	Signed16ToFloatKernel Signed16ToFloat;
+	Unsigned8ToFloatKernel Unsigned8ToFloat;
+	FloatToSigned32Kernel FloatToSigned32;
+	FloatToSigned16Kernel FloatToSigned16;
+	FloatToUnsigned8Kernel FloatToUnsigned8;
+	PlanarStereoToFloatKernel PlanarStereoToFloat;
+	FindAboveThresholdKernel FindFirstAboveThreshold;
+	FindAboveThresholdKernel FindLastAboveThreshold;
+};
+
+// Number of samples converted at a time, when a conversion is performed via an intermediate buffer.
+constexpr size_t kBlockSize = 1024;
+
+// Returns the scale factor for converting signed integer samples of 'bits' resolution to floating point.
+static float GetIntegerToFloatScale( const uint32_t bits )
+{
+	return 1.0f / static_cast<float>( 1ull << ( std::clamp( bits, 1u, 32u ) - 1 ) );
+}
+
+// Returns the scale factor, and the minimum & maximum (scaled) values, for converting floating point samples to signed integer samples of 'bits' resolution.
+static std::array<float, 3> GetFloatToIntegerLimits( const uint32_t bits )
+{
+	const uint32_t clampedBits = std::clamp( bits, 8u, 32u );
+	const float scale = static_cast<float>( 1ull << ( clampedBits - 1 ) );
+	// For 32-bit output, the maximum is the largest float value which is less than 2^31.
+	const float maximum = ( 32 == clampedBits ) ? 2147483520.0f : ( scale - 1 );
+	return { scale, -scale, maximum };
+}
+
+// Scalar kernels.
+
+static void Signed32ToFloatScalar( const int32_t* input, float* output, const size_t count, const uint32_t bits )
+{
+	const float scale = GetIntegerToFloatScale( bits );
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<float>( input[ index ] ) * scale;
+	}
+}
+
+static void Signed16ToFloatScalar( const int16_t* input, float* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<float>( input[ index ] ) / 0x8000;
+	}
+}
+
+static void Unsigned8ToFloatScalar( const uint8_t* input, float* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<float>( static_cast<int>( input[ index ] ) - 0x80 ) / 0x80;
+	}
+}
+
+static void FloatToSigned32Scalar( const float* input, int32_t* output, const size_t count, const uint32_t bits )
+{
+	const auto [scale, minimum, maximum] = GetFloatToIntegerLimits( bits );
+	for ( size_t index = 0; index < count; index++ ) {
+		const float scaledValue = input[ index ] * scale;
+		output[ index ] = ( scaledValue > maximum ) ? static_cast<int32_t>( maximum ) : ( ( scaledValue < minimum ) ? static_cast<int32_t>( minimum ) : static_cast<int32_t>( scaledValue ) );
+	}
+}
+
+static void FloatToSigned16Scalar( const float* input, int16_t* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		const float scaledValue = input[ index ] * 32768;
+		output[ index ] = ( scaledValue > 32767.0f ) ? 32767 : ( ( scaledValue < -32768.0f ) ? -32768 : static_cast<int16_t>( scaledValue ) );
+	}
+}
+
+static void FloatToUnsigned8Scalar( const float* input, uint8_t* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		const float scaledValue = ( input[ index ] + 1.0f ) * 128;
+		output[ index ] = ( scaledValue > 255.0f ) ? 255 : ( ( scaledValue < 0.0f ) ? 0 : static_cast<uint8_t>( scaledValue ) );
+	}
+}
+
+static void PlanarStereoToFloatScalar( const int32_t* left, const int32_t* right, float* output, const size_t frames, const uint32_t bits )
+{
+	const float scale = GetIntegerToFloatScale( bits );
+	for ( size_t frame = 0; frame < frames; frame++ ) {
+		*output++ = static_cast<float>( left[ frame ] ) * scale;
+		*output++ = static_cast<float>( right[ frame ] ) * scale;
+	}
+}
+
+static size_t FindFirstAboveThresholdScalar( const float* input, const size_t count, const float threshold )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		if ( std::fabs( input[ index ] ) > threshold ) {
+			return index;
+		}
+	}
+	return count;
+}
+
+static size_t FindLastAboveThresholdScalar( const float* input, const size_t count, const float threshold )
+{
+	for ( size_t index = count; index > 0; index-- ) {
+		if ( std::fabs( input[ index - 1 ] ) > threshold ) {
+			return index;
+		}
+	}
+	return 0;
+}
+
+constexpr Kernels kScalarKernels = {
+	Signed32ToFloatScalar,
+	Signed16ToFloatScalar,
+	Unsigned8ToFloatScalar,
+	FloatToSigned32Scalar,
+	FloatToSigned16Scalar,
+	FloatToUnsigned8Scalar,
+	PlanarStereoToFloatScalar,
+	FindFirstAboveThresholdScalar,
+	FindLastAboveThresholdScalar
+};
+
+#ifdef SAMPLE_CONVERSION_X86
+
+// SSE2 kernels.
+
+static void Signed32ToFloatSSE2( const int32_t* input, float* output, const size_t count, const uint32_t bits )
+{
+	const float scale = GetIntegerToFloatScale( bits );
+	const __m128 scaleVector = _mm_set1_ps( scale );
+	size_t index = 0;
+	for ( ; ( index + 4 ) <= count; index += 4 ) {
+		const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) );
+		_mm_storeu_ps( output + index, _mm_mul_ps( _mm_cvtepi32_ps( value ), scaleVector ) );
+	}
+	Signed32ToFloatScalar( input + index, output + index, count - index, bits );
+}
+
+static void Signed16ToFloatSSE2( const int16_t* input, float* output, const size_t count )
+{
+	const __m128 scaleVector = _mm_set1_ps( 1.0f / 0x8000 );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) );
+		// Sign extend to 32-bit, by unpacking into the upper half of each element and shifting down.
+		const __m128i low = _mm_srai_epi32( _mm_unpacklo_epi16( value, value ), 16 );
+		const __m128i high = _mm_srai_epi32( _mm_unpackhi_epi16( value, value ), 16 );
+		_mm_storeu_ps( output + index, _mm_mul_ps( _mm_cvtepi32_ps( low ), scaleVector ) );
+		_mm_storeu_ps( output + index + 4, _mm_mul_ps( _mm_cvtepi32_ps( high ), scaleVector ) );
+	}
+	Signed16ToFloatScalar( input + index, output + index, count - index );
+}
+
+static void Unsigned8ToFloatSSE2( const uint8_t* input, float* output, const size_t count )
+{
+	const __m128 scaleVector = _mm_set1_ps( 1.0f / 0x80 );
+	const __m128i offset = _mm_set1_epi32( 0x80 );
+	const __m128i zero = _mm_setzero_si128();
+	size_t index = 0;
+	for ( ; ( index + 16 ) <= count; index += 16 ) {
+		const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) );
+		const __m128i low = _mm_unpacklo_epi8( value, zero );
+		const __m128i high = _mm_unpackhi_epi8( value, zero );
+		const __m128i values[ 4 ] = {
+			_mm_unpacklo_epi16( low, zero ), _mm_unpackhi_epi16( low, zero ), _mm_unpacklo_epi16( high, zero ), _mm_unpackhi_epi16( high, zero ) };
+		for ( size_t part = 0; part < 4; part++ ) {
+			_mm_storeu_ps( output + index + 4 * part, _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( values[ part ], offset ) ), scaleVector ) );
+		}
+	}
+	Unsigned8ToFloatScalar( input + index, output + index, count - index );
+}
+
+static void FloatToSigned32SSE2( const float* input, int32_t* output, const size_t count, const uint32_t bits )
+{
+	const auto [scale, minimum, maximum] = GetFloatToIntegerLimits( bits );
+	const __m128 scaleVector = _mm_set1_ps( scale );
+	const __m128 minimumVector = _mm_set1_ps( minimum );
+	const __m128 maximumVector = _mm_set1_ps( maximum );
+	size_t index = 0;
+	for ( ; ( index + 4 ) <= count; index += 4 ) {
+		const __m128 scaledValue = _mm_mul_ps( _mm_loadu_ps( input + index ), scaleVector );
+		const __m128 clampedValue = _mm_max_ps( _mm_min_ps( scaledValue, maximumVector ), minimumVector );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( output + index ), _mm_cvttps_epi32( clampedValue ) );
+	}
+	FloatToSigned32Scalar( input + index, output + index, count - index, bits );
+}
+
+static void FloatToSigned16SSE2( const float* input, int16_t* output, const size_t count )
+{
+	const __m128 scaleVector = _mm_set1_ps( 32768.0f );
+	const __m128 minimumVector = _mm_set1_ps( -32768.0f );
+	const __m128 maximumVector = _mm_set1_ps( 32767.0f );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m128 low = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_loadu_ps( input + index ), scaleVector ), maximumVector ), minimumVector );
+		const __m128 high = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_loadu_ps( input + index + 4 ), scaleVector ), maximumVector ), minimumVector );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( output + index ), _mm_packs_epi32( _mm_cvttps_epi32( low ), _mm_cvttps_epi32( high ) ) );
+	}
+	FloatToSigned16Scalar( input + index, output + index, count - index );
+}
+
+static void FloatToUnsigned8SSE2( const float* input, uint8_t* output, const size_t count )
+{
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 scaleVector = _mm_set1_ps( 128.0f );
+	const __m128 minimumVector = _mm_setzero_ps();
+	const __m128 maximumVector = _mm_set1_ps( 255.0f );
+	size_t index = 0;
+	for ( ; ( index + 16 ) <= count; index += 16 ) {
+		__m128i values[ 4 ];
+		for ( size_t part = 0; part < 4; part++ ) {
+			const __m128 scaledValue = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( input + index + 4 * part ), one ), scaleVector );
+			values[ part ] = _mm_cvttps_epi32( _mm_max_ps( _mm_min_ps( scaledValue, maximumVector ), minimumVector ) );
+		}
+		// Values are already clamped to 0-255, so signed saturation to 16-bit followed by unsigned saturation to 8-bit is exact.
+		const __m128i low = _mm_packs_epi32( values[ 0 ], values[ 1 ] );
+		const __m128i high = _mm_packs_epi32( values[ 2 ], values[ 3 ] );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( output + index ), _mm_packus_epi16( low, high ) );
+	}
+	FloatToUnsigned8Scalar( input + index, output + index, count - index );
+}
+
+static void PlanarStereoToFloatSSE2( const int32_t* left, const int32_t* right, float* output, const size_t frames, const uint32_t bits )
+{
+	const __m128 scaleVector = _mm_set1_ps( GetIntegerToFloatScale( bits ) );
+	size_t frame = 0;
+	for ( ; ( frame + 4 ) <= frames; frame += 4, output += 8 ) {
+		const __m128 leftValue = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( left + frame ) ) ), scaleVector );
+		const __m128 rightValue = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( right + frame ) ) ), scaleVector );
+		_mm_storeu_ps( output, _mm_unpacklo_ps( leftValue, rightValue ) );
+		_mm_storeu_ps( output + 4, _mm_unpackhi_ps( leftValue, rightValue ) );
+	}
+	PlanarStereoToFloatScalar( left + frame, right + frame, output, frames - frame, bits );
+}
+
+// Returns whether any of the 16 samples at 'input' has a magnitude which exceeds the threshold.
+static bool AnyAboveThresholdSSE2( const float* input, const __m128 absMask, const __m128 thresholdVector )
+{
+	const __m128 first = _mm_cmpgt_ps( _mm_and_ps( _mm_loadu_ps( input ), absMask ), thresholdVector );
+	const __m128 second = _mm_cmpgt_ps( _mm_and_ps( _mm_loadu_ps( input + 4 ), absMask ), thresholdVector );
+	const __m128 third = _mm_cmpgt_ps( _mm_and_ps( _mm_loadu_ps( input + 8 ), absMask ), thresholdVector );
+	const __m128 fourth = _mm_cmpgt_ps( _mm_and_ps( _mm_loadu_ps( input + 12 ), absMask ), thresholdVector );
+	return 0 != _mm_movemask_ps( _mm_or_ps( _mm_or_ps( first, second ), _mm_or_ps( third, fourth ) ) );
+}
+
+static size_t FindFirstAboveThresholdSSE2( const float* input, const size_t count, const float threshold )
+{
+	// Skip whole blocks of silent samples, then locate the exact sample within the block.
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+	const __m128 thresholdVector = _mm_set1_ps( threshold );
+	size_t index = 0;
+	while ( ( ( index + 16 ) <= count ) && !AnyAboveThresholdSSE2( input + index, absMask, thresholdVector ) ) {
+		index += 16;
+	}
+	return index + FindFirstAboveThresholdScalar( input + index, count - index, threshold );
+}
+
+static size_t FindLastAboveThresholdSSE2( const float* input, const size_t count, const float threshold )
+{
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+	const __m128 thresholdVector = _mm_set1_ps( threshold );
+	size_t index = count;
+	while ( ( index >= 16 ) && !AnyAboveThresholdSSE2( input + index - 16, absMask, thresholdVector ) ) {
+		index -= 16;
+	}
+	return FindLastAboveThresholdScalar( input, index, threshold );
+}
+
+constexpr Kernels kSSE2Kernels = {
+	Signed32ToFloatSSE2,
+	Signed16ToFloatSSE2,
+	Unsigned8ToFloatSSE2,
+	FloatToSigned32SSE2,
+	FloatToSigned16SSE2,
+	FloatToUnsigned8SSE2,
+	PlanarStereoToFloatSSE2,
+	FindFirstAboveThresholdSSE2,
+	FindLastAboveThresholdSSE2
+};
+
+// AVX2 kernels (where AVX2 offers no benefit over SSE2, the SSE2 kernel is used).
+
+static void Signed32ToFloatAVX2( const int32_t* input, float* output, const size_t count, const uint32_t bits )
+{
+	const __m256 scaleVector = _mm256_set1_ps( GetIntegerToFloatScale( bits ) );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256i value = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + index ) );
+		_mm256_storeu_ps( output + index, _mm256_mul_ps( _mm256_cvtepi32_ps( value ), scaleVector ) );
+	}
+	Signed32ToFloatSSE2( input + index, output + index, count - index, bits );
+}
+
+static void Signed16ToFloatAVX2( const int16_t* input, float* output, const size_t count )
+{
+	const __m256 scaleVector = _mm256_set1_ps( 1.0f / 0x8000 );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256i value = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) ) );
+		_mm256_storeu_ps( output + index, _mm256_mul_ps( _mm256_cvtepi32_ps( value ), scaleVector ) );
+	}
+	Signed16ToFloatScalar( input + index, output + index, count - index );
+}
+
+static void Unsigned8ToFloatAVX2( const uint8_t* input, float* output, const size_t count )
+{
+	const __m256 scaleVector = _mm256_set1_ps( 1.0f / 0x80 );
+	const __m256i offset = _mm256_set1_epi32( 0x80 );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256i value = _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( input + index ) ) );
+		_mm256_storeu_ps( output + index, _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_sub_epi32( value, offset ) ), scaleVector ) );
+	}
+	Unsigned8ToFloatScalar( input + index, output + index, count - index );
+}
+
+static void FloatToSigned32AVX2( const float* input, int32_t* output, const size_t count, const uint32_t bits )
+{
+	const auto [scale, minimum, maximum] = GetFloatToIntegerLimits( bits );
+	const __m256 scaleVector = _mm256_set1_ps( scale );
+	const __m256 minimumVector = _mm256_set1_ps( minimum );
+	const __m256 maximumVector = _mm256_set1_ps( maximum );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256 scaledValue = _mm256_mul_ps( _mm256_loadu_ps( input + index ), scaleVector );
+		const __m256 clampedValue = _mm256_max_ps( _mm256_min_ps( scaledValue, maximumVector ), minimumVector );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( output + index ), _mm256_cvttps_epi32( clampedValue ) );
+	}
+	FloatToSigned32SSE2( input + index, output + index, count - index, bits );
+}
+
+static void FloatToSigned16AVX2( const float* input, int16_t* output, const size_t count )
+{
+	const __m256 scaleVector = _mm256_set1_ps( 32768.0f );
+	const __m256 minimumVector = _mm256_set1_ps( -32768.0f );
+	const __m256 maximumVector = _mm256_set1_ps( 32767.0f );
+	size_t index = 0;
+	for ( ; ( index + 16 ) <= count; index += 16 ) {
+		const __m256 low = _mm256_max_ps( _mm256_min_ps( _mm256_mul_ps( _mm256_loadu_ps( input + index ), scaleVector ), maximumVector ), minimumVector );
+		const __m256 high = _mm256_max_ps( _mm256_min_ps( _mm256_mul_ps( _mm256_loadu_ps( input + index + 8 ), scaleVector ), maximumVector ), minimumVector );
+		// Packing operates within each 128-bit lane, so reorder the 64-bit blocks afterwards.
+		const __m256i packed = _mm256_packs_epi32( _mm256_cvttps_epi32( low ), _mm256_cvttps_epi32( high ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( output + index ), _mm256_permute4x64_epi64( packed, 0xd8 ) );
+	}
+	FloatToSigned16SSE2( input + index, output + index, count - index );
+}
+
+static void PlanarStereoToFloatAVX2( const int32_t* left, const int32_t* right, float* output, const size_t frames, const uint32_t bits )
+{
+	const __m256 scaleVector = _mm256_set1_ps( GetIntegerToFloatScale( bits ) );
+	size_t frame = 0;
+	for ( ; ( frame + 8 ) <= frames; frame += 8, output += 16 ) {
+		const __m256 leftValue = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( left + frame ) ) ), scaleVector );
+		const __m256 rightValue = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( right + frame ) ) ), scaleVector );
+		// Unpacking operates within each 128-bit lane, so recombine the lanes afterwards.
+		const __m256 low = _mm256_unpacklo_ps( leftValue, rightValue );
+		const __m256 high = _mm256_unpackhi_ps( leftValue, rightValue );
+		_mm256_storeu_ps( output, _mm256_permute2f128_ps( low, high, 0x20 ) );
+		_mm256_storeu_ps( output + 8, _mm256_permute2f128_ps( low, high, 0x31 ) );
+	}
+	PlanarStereoToFloatSSE2( left + frame, right + frame, output, frames - frame, bits );
+}
+
+// Returns whether any of the 32 samples at 'input' has a magnitude which exceeds the threshold.
+static bool AnyAboveThresholdAVX2( const float* input, const __m256 absMask, const __m256 thresholdVector )
+{
+	const __m256 first = _mm256_cmp_ps( _mm256_and_ps( _mm256_loadu_ps( input ), absMask ), thresholdVector, _CMP_GT_OQ );
+	const __m256 second = _mm256_cmp_ps( _mm256_and_ps( _mm256_loadu_ps( input + 8 ), absMask ), thresholdVector, _CMP_GT_OQ );
+	const __m256 third = _mm256_cmp_ps( _mm256_and_ps( _mm256_loadu_ps( input + 16 ), absMask ), thresholdVector, _CMP_GT_OQ );
+	const __m256 fourth = _mm256_cmp_ps( _mm256_and_ps( _mm256_loadu_ps( input + 24 ), absMask ), thresholdVector, _CMP_GT_OQ );
+	return 0 != _mm256_movemask_ps( _mm256_or_ps( _mm256_or_ps( first, second ), _mm256_or_ps( third, fourth ) ) );
+}
+
+static size_t FindFirstAboveThresholdAVX2( const float* input, const size_t count, const float threshold )
+{
+	const __m256 absMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+	const __m256 thresholdVector = _mm256_set1_ps( threshold );
+	size_t index = 0;
+	while ( ( ( index + 32 ) <= count ) && !AnyAboveThresholdAVX2( input + index, absMask, thresholdVector ) ) {
+		index += 32;
+	}
+	return index + FindFirstAboveThresholdSSE2( input + index, count - index, threshold );
+}
+
+static size_t FindLastAboveThresholdAVX2( const float* input, const size_t count, const float threshold )
+{
+	const __m256 absMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+	const __m256 thresholdVector = _mm256_set1_ps( threshold );
+	size_t index = count;
+	while ( ( index >= 32 ) && !AnyAboveThresholdAVX2( input + index - 32, absMask, thresholdVector ) ) {
+		index -= 32;
+	}
+	return FindLastAboveThresholdSSE2( input, index, threshold );
+}
+
+constexpr Kernels kAVX2Kernels = {
+	Signed32ToFloatAVX2,
+	Signed16ToFloatAVX2,
+	Unsigned8ToFloatAVX2,
+	FloatToSigned32AVX2,
+	FloatToSigned16AVX2,
+	FloatToUnsigned8SSE2,
+	PlanarStereoToFloatAVX2,
+	FindFirstAboveThresholdAVX2,
+	FindLastAboveThresholdAVX2
+};
+
+// Returns whether the processor (and operating system) supports the 'instructionSet'.
+static bool IsSupported( const SampleConversion::InstructionSet instructionSet )
+{
+	std::array<int, 4> info = {};
+	__cpuid( info.data(), 0 );
+	const int maximumFunction = info[ 0 ];
+	__cpuid( info.data(), 1 );
+	const bool sse2 = ( info[ 3 ] & ( 1 << 26 ) );
+	if ( SampleConversion::InstructionSet::SSE2 == instructionSet ) {
+		return sse2;
+	}
+	if ( SampleConversion::InstructionSet::AVX2 == instructionSet ) {
+		// AVX requires OS support for saving the YMM registers.
+		const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) );
+		const bool avx = ( info[ 2 ] & ( 1 << 28 ) );
+		if ( !sse2 || !osxsave || !avx || ( maximumFunction < 7 ) || ( 0x6 != ( _xgetbv( 0 ) & 0x6 ) ) ) {
+			return false;
+		}
+		__cpuidex( info.data(), 7, 0 );
+		return ( info[ 1 ] & ( 1 << 5 ) );
+	}
+	return true;
+}
+
+#else
+
+static bool IsSupported( const SampleConversion::InstructionSet instructionSet )
+{
+	return SampleConversion::InstructionSet::Scalar == instructionSet;
+}
+
+#endif
+
+// Returns the best instruction set supported by the processor.
+static SampleConversion::InstructionSet GetBestInstructionSet()
+{
+	for ( const auto instructionSet : { SampleConversion::InstructionSet::AVX2, SampleConversion::InstructionSet::SSE2 } ) {
+		if ( IsSupported( instructionSet ) ) {
+			return instructionSet;
+		}
+	}
+	return SampleConversion::InstructionSet::Scalar;
+}
+
+// Returns the kernels for the 'instructionSet'.
+static const Kernels* GetKernelsFor( const SampleConversion::InstructionSet instructionSet )
+{
+#ifdef SAMPLE_CONVERSION_X86
+	switch ( instructionSet ) {
+		case SampleConversion::InstructionSet::AVX2:
+			return &kAVX2Kernels;
+		case SampleConversion::InstructionSet::SSE2:
+			return &kSSE2Kernels;
+		default:
+			break;
+	}
+#endif
+	return &kScalarKernels;
+}
+
+// Current instruction set.
+static std::atomic<SampleConversion::InstructionSet> s_InstructionSet = GetBestInstructionSet();
+
+// Current kernels.
+static std::atomic<const Kernels*> s_Kernels = GetKernelsFor( s_InstructionSet );
+
+// Returns the current kernels.
+static const Kernels& GetKernels()
+{
+	// Fall back to the scalar kernels, should a conversion be requested during static initialisation.
+	const Kernels* kernels = s_Kernels.load( std::memory_order_relaxed );
+	return ( nullptr != kernels ) ? *kernels : kScalarKernels;
+}
+
+#ifdef SAMPLE_CONVERSION_X86
+
+// Interleaves 4 frames at a time, from the planar vectors returned by 'load' for each channel & first frame, returning the number of frames interleaved.
+// The channel count is known at compile time, and must be an even number of at least 4 (groups of 4 channels are transposed, followed by any remaining pair).
+template <uint32_t Channels, typename Load>
+static size_t InterleaveFramesSSE2( const Load& load, float* output, const size_t frames )
+{
+	static_assert( ( Channels >= 4 ) && ( 0 == ( Channels % 2 ) ) );
+	size_t frame = 0;
+	for ( ; ( frame + 4 ) <= frames; frame += 4, output += 4 * Channels ) {
+		uint32_t channel = 0;
+		for ( ; ( channel + 4 ) <= Channels; channel += 4 ) {
+			__m128 first = load( channel, frame );
+			__m128 second = load( channel + 1, frame );
+			__m128 third = load( channel + 2, frame );
+			__m128 fourth = load( channel + 3, frame );
+			_MM_TRANSPOSE4_PS( first, second, third, fourth );
+			_mm_storeu_ps( output + channel, first );
+			_mm_storeu_ps( output + Channels + channel, second );
+			_mm_storeu_ps( output + 2 * Channels + channel, third );
+			_mm_storeu_ps( output + 3 * Channels + channel, fourth );
+		}
+		if constexpr ( 0 != ( Channels % 4 ) ) {
+			const __m128 first = load( channel, frame );
+			const __m128 second = load( channel + 1, frame );
+			const __m128d low = _mm_castps_pd( _mm_unpacklo_ps( first, second ) );
+			const __m128d high = _mm_castps_pd( _mm_unpackhi_ps( first, second ) );
+			_mm_storel_pd( reinterpret_cast<double*>( output + channel ), low );
+			_mm_storeh_pd( reinterpret_cast<double*>( output + Channels + channel ), low );
+			_mm_storel_pd( reinterpret_cast<double*>( output + 2 * Channels + channel ), high );
+			_mm_storeh_pd( reinterpret_cast<double*>( output + 3 * Channels + channel ), high );
+		}
+	}
+	return frame;
+}
+
+// Deinterleaves 4 frames at a time into planar buffers, returning the number of frames deinterleaved.
+// The channel count is known at compile time, and must be an even number of at least 4 (groups of 4 channels are transposed, followed by any remaining pair).
+template <uint32_t Channels>
+static size_t DeinterleaveFramesSSE2( const float* input, float* const* output, const size_t frames )
+{
+	static_assert( ( Channels >= 4 ) && ( 0 == ( Channels % 2 ) ) );
+	size_t frame = 0;
+	for ( ; ( frame + 4 ) <= frames; frame += 4, input += 4 * Channels ) {
+		uint32_t channel = 0;
+		for ( ; ( channel + 4 ) <= Channels; channel += 4 ) {
+			__m128 first = _mm_loadu_ps( input + channel );
+			__m128 second = _mm_loadu_ps( input + Channels + channel );
+			__m128 third = _mm_loadu_ps( input + 2 * Channels + channel );
+			__m128 fourth = _mm_loadu_ps( input + 3 * Channels + channel );
+			_MM_TRANSPOSE4_PS( first, second, third, fourth );
+			_mm_storeu_ps( output[ channel ] + frame, first );
+			_mm_storeu_ps( output[ channel + 1 ] + frame, second );
+			_mm_storeu_ps( output[ channel + 2 ] + frame, third );
+			_mm_storeu_ps( output[ channel + 3 ] + frame, fourth );
+		}
+		if constexpr ( 0 != ( Channels % 4 ) ) {
+			const __m128 low = _mm_castpd_ps( _mm_loadh_pd( _mm_load_sd( reinterpret_cast<const double*>( input + channel ) ), reinterpret_cast<const double*>( input + Channels + channel ) ) );
+			const __m128 high = _mm_castpd_ps( _mm_loadh_pd( _mm_load_sd( reinterpret_cast<const double*>( input + 2 * Channels + channel ) ), reinterpret_cast<const double*>( input + 3 * Channels + channel ) ) );
+			_mm_storeu_ps( output[ channel ] + frame, _mm_shuffle_ps( low, high, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+			_mm_storeu_ps( output[ channel + 1 ] + frame, _mm_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+		}
+	}
+	return frame;
+}
+
+#endif
+
+// Converts planar signed integer samples to interleaved floating point, for a channel count known at compile time.
+template <uint32_t Channels>
+static void PlanarSigned32ToFloatFrames( const int32_t* const* input, float* output, const size_t frames, const uint32_t bits )
+{
+	const float scale = GetIntegerToFloatScale( bits );
+	size_t frame = 0;
+#ifdef SAMPLE_CONVERSION_X86
+	if ( SampleConversion::InstructionSet::Scalar != s_InstructionSet.load( std::memory_order_relaxed ) ) {
+		const __m128 scaleVector = _mm_set1_ps( scale );
+		const auto load = [ input, scaleVector ] ( const uint32_t channel, const size_t first )
+		{
+			return _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( input[ channel ] + first ) ) ), scaleVector );
+		};
+		frame = InterleaveFramesSSE2<Channels>( load, output, frames );
+		output += frame * Channels;
+	}
+#endif
+	for ( ; frame < frames; frame++ ) {
+		for ( uint32_t channel = 0; channel < Channels; channel++ ) {
+			*output++ = static_cast<float>( input[ channel ][ frame ] ) * scale;
+		}
+	}
+}
+
+// Interleaves planar samples, for a channel count known at compile time.
+template <uint32_t Channels>
+static void InterleaveFrames( const float* const* input, float* output, const size_t frames )
+{
+	size_t frame = 0;
+#ifdef SAMPLE_CONVERSION_X86
+	if ( SampleConversion::InstructionSet::Scalar != s_InstructionSet.load( std::memory_order_relaxed ) ) {
+		const auto load = [ input ] ( const uint32_t channel, const size_t first )
+		{
+			return _mm_loadu_ps( input[ channel ] + first );
+		};
+		frame = InterleaveFramesSSE2<Channels>( load, output, frames );
+		output += frame * Channels;
+	}
+#endif
+	for ( ; frame < frames; frame++ ) {
+		for ( uint32_t channel = 0; channel < Channels; channel++ ) {
+			*output++ = input[ channel ][ frame ];
+		}
+	}
+}
+
+template <>
+void InterleaveFrames<1>( const float* const* input, float* output, const size_t frames )
+{
+	std::copy( input[ 0 ], input[ 0 ] + frames, output );
+}
+
+template <>
+void InterleaveFrames<2>( const float* const* input, float* output, const size_t frames )
+{
+	size_t frame = 0;
+#ifdef SAMPLE_CONVERSION_X86
+	if ( SampleConversion::InstructionSet::Scalar != s_InstructionSet.load( std::memory_order_relaxed ) ) {
+		for ( ; ( frame + 4 ) <= frames; frame += 4, output += 8 ) {
+			const __m128 left = _mm_loadu_ps( input[ 0 ] + frame );
+			const __m128 right = _mm_loadu_ps( input[ 1 ] + frame );
+			_mm_storeu_ps( output, _mm_unpacklo_ps( left, right ) );
+			_mm_storeu_ps( output + 4, _mm_unpackhi_ps( left, right ) );
+		}
+	}
+#endif
+	for ( ; frame < frames; frame++ ) {
+		*output++ = input[ 0 ][ frame ];
+		*output++ = input[ 1 ][ frame ];
+	}
+}
+
+// Deinterleaves samples into planar buffers, for a channel count known at compile time.
+template <uint32_t Channels>
+static void DeinterleaveFrames( const float* input, float* const* output, const size_t frames )
+{
+	size_t frame = 0;
+#ifdef SAMPLE_CONVERSION_X86
+	if ( SampleConversion::InstructionSet::Scalar != s_InstructionSet.load( std::memory_order_relaxed ) ) {
+		frame = DeinterleaveFramesSSE2<Channels>( input, output, frames );
+		input += frame * Channels;
+	}
+#endif
+	for ( ; frame < frames; frame++ ) {
+		for ( uint32_t channel = 0; channel < Channels; channel++ ) {
+			output[ channel ][ frame ] = *input++;
+		}
+	}
+}
+
+template <>
+void DeinterleaveFrames<1>( const float* input, float* const* output, const size_t frames )
+{
+	std::copy( input, input + frames, output[ 0 ] );
+}
+
+template <>
+void DeinterleaveFrames<2>( const float* input, float* const* output, const size_t frames )
+{
+	size_t frame = 0;
+#ifdef SAMPLE_CONVERSION_X86
+	if ( SampleConversion::InstructionSet::Scalar != s_InstructionSet.load( std::memory_order_relaxed ) ) {
+		for ( ; ( frame + 4 ) <= frames; frame += 4, input += 8 ) {
+			const __m128 first = _mm_loadu_ps( input );
+			const __m128 second = _mm_loadu_ps( input + 4 );
+			_mm_storeu_ps( output[ 0 ] + frame, _mm_shuffle_ps( first, second, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+			_mm_storeu_ps( output[ 1 ] + frame, _mm_shuffle_ps( first, second, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+		}
+	}
+#endif
+	for ( ; frame < frames; frame++ ) {
+		output[ 0 ][ frame ] = *input++;
+		output[ 1 ][ frame ] = *input++;
+	}
+}
+
+SampleConversion::InstructionSet SampleConversion::GetInstructionSet()
+{
+	return s_InstructionSet.load( std::memory_order_relaxed );
+}
+
+bool SampleConversion::SetInstructionSet( const InstructionSet instructionSet )
+{
+	if ( !IsSupported( instructionSet ) ) {
+		return false;
+	}
+	s_InstructionSet.store( instructionSet, std::memory_order_relaxed );
+	s_Kernels.store( GetKernelsFor( instructionSet ), std::memory_order_relaxed );
+	return true;
+}
+
+void SampleConversion::Signed32ToFloat( const int32_t* input, float* output, const size_t count, const uint32_t bits )
+{
+	GetKernels().Signed32ToFloat( input, output, count, bits );
+}
+
+void SampleConversion::Signed16ToFloat( const int16_t* input, float* output, const size_t count )
+{
+	GetKernels().Signed16ToFloat( input, output, count );
+}
+
+void SampleConversion::Signed24ToFloat( const uint8_t* input, float* output, const size_t count )
+{
+	// Unpack to 32-bit containers (in the upper 24 bits, so that the sign is preserved), then convert as 32-bit samples.
+	std::array<int32_t, kBlockSize> block;
+	for ( size_t index = 0; index < count; index += kBlockSize ) {
+		const size_t blockCount = std::min( kBlockSize, count - index );
+		for ( size_t blockIndex = 0; blockIndex < blockCount; blockIndex++, input += 3 ) {
+			block[ blockIndex ] = static_cast<int32_t>( ( static_cast<uint32_t>( input[ 0 ] ) << 8 ) | ( static_cast<uint32_t>( input[ 1 ] ) << 16 ) | ( static_cast<uint32_t>( input[ 2 ] ) << 24 ) );
+		}
+		GetKernels().Signed32ToFloat( block.data(), output + index, blockCount, 32 );
+	}
+}
+
+void SampleConversion::Unsigned8ToFloat( const uint8_t* input, float* output, const size_t count )
+{
+	GetKernels().Unsigned8ToFloat( input, output, count );
+}
+
+void SampleConversion::FloatToSigned32( const float* input, int32_t* output, const size_t count, const uint32_t bits )
+{
+	GetKernels().FloatToSigned32( input, output, count, bits );
+}
+
+void SampleConversion::FloatToSigned16( const float* input, int16_t* output, const size_t count )
+{
+	GetKernels().FloatToSigned16( input, output, count );
+}
+
+void SampleConversion::FloatToSigned24( const float* input, uint8_t* output, const size_t count )
+{
+	// Convert to 32-bit containers, then pack.
+	std::array<int32_t, kBlockSize> block;
+	for ( size_t index = 0; index < count; index += kBlockSize ) {
+		const size_t blockCount = std::min( kBlockSize, count - index );
+		GetKernels().FloatToSigned32( input + index, block.data(), blockCount, 24 );
+		for ( size_t blockIndex = 0; blockIndex < blockCount; blockIndex++, output += 3 ) {
+			const int32_t value = block[ blockIndex ];
+			output[ 0 ] = value & 0xff;
+			output[ 1 ] = ( value >> 8 ) & 0xff;
+			output[ 2 ] = ( value >> 16 ) & 0xff;
+		}
+	}
+}
+
+void SampleConversion::FloatToUnsigned8( const float* input, uint8_t* output, const size_t count )
+{
+	GetKernels().FloatToUnsigned8( input, output, count );
+}
+
+void SampleConversion::PlanarSigned32ToFloat( const int32_t* const* input, float* output, const size_t frames, const uint32_t channels, const uint32_t bits )
+{
+	switch ( channels ) {
+		case 1: {
+			GetKernels().Signed32ToFloat( input[ 0 ], output, frames, bits );
+			break;
+		}
+		case 2: {
+			GetKernels().PlanarStereoToFloat( input[ 0 ], input[ 1 ], output, frames, bits );
+			break;
+		}
+		case 6: {
+			PlanarSigned32ToFloatFrames<6>( input, output, frames, bits );
+			break;
+		}
+		case 8: {
+			PlanarSigned32ToFloatFrames<8>( input, output, frames, bits );
+			break;
+		}
+		default: {
+			const float scale = GetIntegerToFloatScale( bits );
+			for ( size_t frame = 0; frame < frames; frame++ ) {
+				for ( uint32_t channel = 0; channel < channels; channel++ ) {
+					*output++ = static_cast<float>( input[ channel ][ frame ] ) * scale;
+				}
+			}
+			break;
+		}
+	}
+}
+
+void SampleConversion::Interleave( const float* const* input, float* output, const size_t frames, const uint32_t channels )
+{
+	switch ( channels ) {
+		case 1: {
+			InterleaveFrames<1>( input, output, frames );
+			break;
+		}
+		case 2: {
+			InterleaveFrames<2>( input, output, frames );
+			break;
+		}
+		case 6: {
+			InterleaveFrames<6>( input, output, frames );
+			break;
+		}
+		case 8: {
+			InterleaveFrames<8>( input, output, frames );
+			break;
+		}
+		default: {
+			for ( size_t frame = 0; frame < frames; frame++ ) {
+				for ( uint32_t channel = 0; channel < channels; channel++ ) {
+					*output++ = input[ channel ][ frame ];
+				}
+			}
+			break;
+		}
+	}
+}
+
+void SampleConversion::Deinterleave( const float* input, float* const* output, const size_t frames, const uint32_t channels )
+{
+	switch ( channels ) {
+		case 1: {
+			DeinterleaveFrames<1>( input, output, frames );
+			break;
+		}
+		case 2: {
+			DeinterleaveFrames<2>( input, output, frames );
+			break;
+		}
+		case 6: {
+			DeinterleaveFrames<6>( input, output, frames );
+			break;
+		}
+		case 8: {
+			DeinterleaveFrames<8>( input, output, frames );
+			break;
+		}
+		default: {
+			for ( size_t frame = 0; frame < frames; frame++ ) {
+				for ( uint32_t channel = 0; channel < channels; channel++ ) {
+					output[ channel ][ frame ] = *input++;
+				}
+			}
+			break;
+		}
+	}
+}
+
+size_t SampleConversion::FindFirstAboveThreshold( const float* input, const size_t count, const float threshold )
+{
+	return GetKernels().FindFirstAboveThreshold( input, count, threshold );
+}
+
+size_t SampleConversion::FindLastAboveThreshold( const float* input, const size_t count, const float threshold )
+{
+	return GetKernels().FindLastAboveThreshold( input, count, threshold );
+}
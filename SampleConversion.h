@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// PCM sample conversion kernels, shared by decoders and encoders.
+// Each conversion has scalar, SSE2 & AVX2 implementations, with the best one for the processor being chosen at runtime.
+// Floating point samples are scaled to +/-1.0f, and conversions to integer formats clamp any value outside that range.
+// Unless stated otherwise, 'count' is the total number of samples (i.e. frames multiplied by channels).
+class SampleConversion
+{
+public:
+	// Instruction set used by the conversion kernels.
+	enum class InstructionSet {
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// Returns the instruction set used by the conversion kernels.
+	static InstructionSet GetInstructionSet();
+
+	// Selects the instruction set to use, returning whether it is supported by the processor (intended for benchmarking).
+	static bool SetInstructionSet( const InstructionSet instructionSet );
+
+	// Converts signed integer samples of 'bits' resolution, stored in 32-bit containers, to floating point.
+	// The 'input' and 'output' can be the same buffer, for in-place conversion.
+	static void Signed32ToFloat( const int32_t* input, float* output, const size_t count, const uint32_t bits );
+
+	// Converts signed 16-bit samples to floating point.
+	static void Signed16ToFloat( const int16_t* input, float* output, const size_t count );
+
+	// Converts packed (little-endian) signed 24-bit samples to floating point.
+	static void Signed24ToFloat( const uint8_t* input, float* output, const size_t count );
+
+	// Converts unsigned 8-bit samples to floating point.
+	static void Unsigned8ToFloat( const uint8_t* input, float* output, const size_t count );
+
+	// Converts floating point samples to signed integer samples of 'bits' resolution (from 8 to 32), stored in 32-bit containers.
+	static void FloatToSigned32( const float* input, int32_t* output, const size_t count, const uint32_t bits );
+
+	// Converts floating point samples to signed 16-bit.
+	static void FloatToSigned16( const float* input, int16_t* output, const size_t count );
+
+	// Converts floating point samples to packed (little-endian) signed 24-bit.
+	static void FloatToSigned24( const float* input, uint8_t* output, const size_t count );
+
+	// Converts floating point samples to unsigned 8-bit.
+	static void FloatToUnsigned8( const float* input, uint8_t* output, const size_t count );
+
+	// Converts planar signed integer samples of 'bits' resolution, stored in 32-bit containers, to interleaved floating point.
+	// 'input' - one buffer per channel, each containing 'frames' samples.
+	static void PlanarSigned32ToFloat( const int32_t* const* input, float* output, const size_t frames, const uint32_t channels, const uint32_t bits );
+
+	// Interleaves planar floating point samples.
+	// 'input' - one buffer per channel, each containing 'frames' samples.
+	static void Interleave( const float* const* input, float* output, const size_t frames, const uint32_t channels );
+
+	// Deinterleaves floating point samples into planar buffers.
+	// 'output' - one buffer per channel, each to receive 'frames' samples.
+	static void Deinterleave( const float* input, float* const* output, const size_t frames, const uint32_t channels );
+
+	// Returns the index of the first sample in 'input' with a magnitude greater than the 'threshold', or 'count' if there is none.
+	static size_t FindFirstAboveThreshold( const float* input, const size_t count, const float threshold );
+
+	// Returns one past the index of the last sample in 'input' with a magnitude greater than the 'threshold', or zero if there is none.
+	static size_t FindLastAboveThreshold( const float* input, const size_t count, const float threshold );
+};
@@ -0,0 +1,238 @@
+#include "SampleConversionBenchmark.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <random>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Number of samples converted by each conversion.
+constexpr size_t kSamples = 1 << 18;
+
+// Number of samples converted when timing each conversion.
+constexpr size_t kTimingSamples = 1 << 26;
+
+// Random seed for the input data, so that each run uses the same input.
+constexpr uint32_t kSeed = 1974;
+
+// Threshold used by the threshold searches.
+constexpr float kThreshold = 0.001f;
+
+// Instruction sets, and their names in the results file.
+static const std::vector<std::pair<SampleConversion::InstructionSet, const char*>> s_InstructionSets = {
+	{ SampleConversion::InstructionSet::Scalar, "scalar" },
+	{ SampleConversion::InstructionSet::SSE2, "sse2" },
+	{ SampleConversion::InstructionSet::AVX2, "avx2" }
+};
+
+// Benchmark input data, in each sample format.
+struct InputData {
+	std::vector<int32_t> Signed32;      // Signed 24-bit samples, in 32-bit containers.
+	std::vector<int16_t> Signed16;      // Signed 16-bit samples.
+	std::vector<uint8_t> Signed24;      // Packed signed 24-bit samples.
+	std::vector<uint8_t> Unsigned8;     // Unsigned 8-bit samples.
+	std::vector<float> Float;           // Floating point samples, including values beyond +/-1.0f (to check clamping).
+	std::vector<float> Quiet;           // Floating point samples below the threshold, apart from a single sample in the middle.
+};
+
+// A conversion of the input data, which writes its output as bytes (so that the output for each instruction set can be compared).
+struct Conversion {
+	const char* Name;                                                              // Conversion name.
+	uint32_t Channels;                                                             // Channel count (for planar & interleaving conversions, otherwise zero).
+	std::function<void( const InputData& input, std::vector<uint8_t>& output )> Convert; // Conversion function.
+};
+
+// Resizes the 'output' to hold 'count' values of type T, returning a pointer to the first value.
+template <typename T>
+static T* GetOutput( std::vector<uint8_t>& output, const size_t count )
+{
+	output.resize( count * sizeof( T ) );
+	return reinterpret_cast<T*>( output.data() );
+}
+
+// Returns the number of frames for a 'channels' count (or the number of samples, if zero).
+static size_t GetFrames( const uint32_t channels )
+{
+	return ( channels > 0 ) ? ( kSamples / channels ) : kSamples;
+}
+
+// Returns pointers to the planes of a planar 'buffer', for a 'channels' count.
+template <typename T>
+static std::vector<T*> GetPlanes( T* buffer, const uint32_t channels )
+{
+	std::vector<T*> planes( channels );
+	for ( uint32_t channel = 0; channel < channels; channel++ ) {
+		planes[ channel ] = buffer + channel * GetFrames( channels );
+	}
+	return planes;
+}
+
+// Returns a planar to interleaved floating point conversion, for a 'channels' count.
+static Conversion GetPlanarConversion( const uint32_t channels )
+{
+	return { "planarSigned32ToFloat", channels, [ channels ] ( const InputData& input, std::vector<uint8_t>& output )
+		{
+			const std::vector<const int32_t*> planes = GetPlanes( input.Signed32.data(), channels );
+			SampleConversion::PlanarSigned32ToFloat( planes.data(), GetOutput<float>( output, GetFrames( channels ) * channels ), GetFrames( channels ), channels, 24 );
+		} };
+}
+
+// Returns an interleaving conversion, for a 'channels' count.
+static Conversion GetInterleaveConversion( const uint32_t channels )
+{
+	return { "interleave", channels, [ channels ] ( const InputData& input, std::vector<uint8_t>& output )
+		{
+			const std::vector<const float*> planes = GetPlanes( input.Float.data(), channels );
+			SampleConversion::Interleave( planes.data(), GetOutput<float>( output, GetFrames( channels ) * channels ), GetFrames( channels ), channels );
+		} };
+}
+
+// Returns a deinterleaving conversion, for a 'channels' count.
+static Conversion GetDeinterleaveConversion( const uint32_t channels )
+{
+	return { "deinterleave", channels, [ channels ] ( const InputData& input, std::vector<uint8_t>& output )
+		{
+			const std::vector<float*> planes = GetPlanes( GetOutput<float>( output, GetFrames( channels ) * channels ), channels );
+			SampleConversion::Deinterleave( input.Float.data(), planes.data(), GetFrames( channels ), channels );
+		} };
+}
+
+// Returns the conversions to check & time.
+static std::vector<Conversion> GetConversions()
+{
+	std::vector<Conversion> conversions = {
+		{ "signed32ToFloat", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::Signed32ToFloat( input.Signed32.data(), GetOutput<float>( output, kSamples ), kSamples, 24 ); } },
+		{ "signed16ToFloat", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::Signed16ToFloat( input.Signed16.data(), GetOutput<float>( output, kSamples ), kSamples ); } },
+		{ "signed24ToFloat", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::Signed24ToFloat( input.Signed24.data(), GetOutput<float>( output, kSamples ), kSamples ); } },
+		{ "unsigned8ToFloat", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::Unsigned8ToFloat( input.Unsigned8.data(), GetOutput<float>( output, kSamples ), kSamples ); } },
+		{ "floatToSigned32", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::FloatToSigned32( input.Float.data(), GetOutput<int32_t>( output, kSamples ), kSamples, 32 ); } },
+		{ "floatToSigned16", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::FloatToSigned16( input.Float.data(), GetOutput<int16_t>( output, kSamples ), kSamples ); } },
+		{ "floatToSigned24", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::FloatToSigned24( input.Float.data(), GetOutput<uint8_t>( output, kSamples * 3 ), kSamples ); } },
+		{ "floatToUnsigned8", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { SampleConversion::FloatToUnsigned8( input.Float.data(), GetOutput<uint8_t>( output, kSamples ), kSamples ); } },
+		{ "findFirstAboveThreshold", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { *GetOutput<size_t>( output, 1 ) = SampleConversion::FindFirstAboveThreshold( input.Quiet.data(), kSamples, kThreshold ); } },
+		{ "findLastAboveThreshold", 0, [] ( const InputData& input, std::vector<uint8_t>& output ) { *GetOutput<size_t>( output, 1 ) = SampleConversion::FindLastAboveThreshold( input.Quiet.data(), kSamples, kThreshold ); } }
+	};
+	for ( const uint32_t channels : { 1, 2, 6, 8 } ) {
+		conversions.push_back( GetPlanarConversion( channels ) );
+	}
+	for ( const uint32_t channels : { 2, 6, 8 } ) {
+		conversions.push_back( GetInterleaveConversion( channels ) );
+		conversions.push_back( GetDeinterleaveConversion( channels ) );
+	}
+	return conversions;
+}
+
+// Returns the benchmark input data.
+static InputData GetInputData()
+{
+	InputData input;
+	std::mt19937 engine( kSeed );
+	std::uniform_int_distribution<int32_t> signed24Distribution( -( 1 << 23 ), ( 1 << 23 ) - 1 );
+	std::uniform_real_distribution<float> floatDistribution( -1.25f, 1.25f );
+	std::uniform_real_distribution<float> quietDistribution( -kThreshold, kThreshold );
+	for ( size_t sample = 0; sample < kSamples; sample++ ) {
+		const int32_t value = signed24Distribution( engine );
+		input.Signed32.push_back( value );
+		input.Signed16.push_back( static_cast<int16_t>( value >> 8 ) );
+		input.Signed24.push_back( static_cast<uint8_t>( value & 0xff ) );
+		input.Signed24.push_back( static_cast<uint8_t>( ( value >> 8 ) & 0xff ) );
+		input.Signed24.push_back( static_cast<uint8_t>( ( value >> 16 ) & 0xff ) );
+		input.Unsigned8.push_back( static_cast<uint8_t>( ( value >> 16 ) + 128 ) );
+		input.Float.push_back( floatDistribution( engine ) );
+		input.Quiet.push_back( quietDistribution( engine ) );
+	}
+
+	// Include the extremes of the floating point range, and place the loud sample in the middle of the quiet samples (so that the searches from either end cover half the data).
+	input.Float[ 0 ] = 1.0f;
+	input.Float[ 1 ] = -1.0f;
+	input.Quiet[ kSamples / 2 + 1 ] = 0.5f;
+	return input;
+}
+
+// Returns the time taken by the 'conversion' of the 'input', in nanoseconds per sample.
+static double TimeConversion( const Conversion& conversion, const InputData& input, std::vector<uint8_t>& output )
+{
+	const size_t samples = GetFrames( conversion.Channels ) * std::max( 1u, conversion.Channels );
+	const size_t iterations = std::max<size_t>( 1, kTimingSamples / samples );
+	const auto start = std::chrono::steady_clock::now();
+	for ( size_t iteration = 0; iteration < iterations; iteration++ ) {
+		conversion.Convert( input, output );
+	}
+	return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / ( iterations * samples );
+}
+
+SampleConversionBenchmark::Results SampleConversionBenchmark::Run()
+{
+	Results results;
+	results.DefaultInstructionSet = SampleConversion::GetInstructionSet();
+	const InputData input = GetInputData();
+	std::vector<uint8_t> reference;
+	std::vector<uint8_t> output;
+	for ( const auto& conversion : GetConversions() ) {
+		SampleConversion::SetInstructionSet( SampleConversion::InstructionSet::Scalar );
+		conversion.Convert( input, reference );
+		for ( const auto& [instructionSet, name] : s_InstructionSets ) {
+			if ( SampleConversion::SetInstructionSet( instructionSet ) ) {
+				Result result;
+				result.Conversion = conversion.Name;
+				result.Channels = conversion.Channels;
+				result.InstructionSet = instructionSet;
+				output.assign( reference.size(), 0 );
+				conversion.Convert( input, output );
+				result.Matches = ( output == reference );
+				result.NanosecondsPerSample = TimeConversion( conversion, input, output );
+				results.Conversions.push_back( result );
+			}
+		}
+	}
+	SampleConversion::SetInstructionSet( results.DefaultInstructionSet );
+	return results;
+}
+
+bool SampleConversionBenchmark::Passed( const Results& results )
+{
+	return std::all_of( results.Conversions.begin(), results.Conversions.end(), [] ( const Result& result )
+		{
+			return result.Matches;
+		} );
+}
+
+bool SampleConversionBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	const auto getName = [] ( const SampleConversion::InstructionSet instructionSet )
+	{
+		const auto entry = std::find_if( s_InstructionSets.begin(), s_InstructionSets.end(), [ instructionSet ] ( const auto& entry ) { return entry.first == instructionSet; } );
+		return ( s_InstructionSets.end() != entry ) ? entry->second : "";
+	};
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+		doc[ "defaultInstructionSet" ] = getName( results.DefaultInstructionSet );
+
+		nlohmann::json conversions = nlohmann::json::array();
+		for ( const auto& result : results.Conversions ) {
+			nlohmann::json conversion;
+			conversion[ "conversion" ] = result.Conversion;
+			if ( result.Channels > 0 ) {
+				conversion[ "channels" ] = result.Channels;
+			}
+			conversion[ "instructionSet" ] = getName( result.InstructionSet );
+			conversion[ "matches" ] = result.Matches;
+			conversion[ "nanosecondsPerSample" ] = result.NanosecondsPerSample;
+			conversions.push_back( conversion );
+		}
+		doc[ "conversions" ] = conversions;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
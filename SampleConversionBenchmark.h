@@ -0,0 +1,41 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "SampleConversion.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Checks the correctness, and measures the performance, of the PCM sample conversion kernels.
+// Each conversion is run with each instruction set supported by the processor, and its output is checked against the scalar kernels (which should be bit-identical).
+// The benchmark is run headless using the '-conversionbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class SampleConversionBenchmark
+{
+public:
+	// Benchmark results for a single conversion & instruction set.
+	struct Result {
+		std::string Conversion;                                                       // Conversion name.
+		uint32_t Channels = 0;                                                        // Channel count (for planar & interleaving conversions, otherwise zero).
+		SampleConversion::InstructionSet InstructionSet = SampleConversion::InstructionSet::Scalar; // Instruction set.
+		bool Matches = false;                                                         // Whether the output matches the scalar kernels.
+		double NanosecondsPerSample = 0;                                              // Time taken, in nanoseconds per sample.
+	};
+
+	// Benchmark results.
+	struct Results {
+		SampleConversion::InstructionSet DefaultInstructionSet = SampleConversion::InstructionSet::Scalar; // Instruction set chosen for the processor.
+		std::vector<Result> Conversions;                                              // Results for each conversion & instruction set.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are correct.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are correct.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
@@ -0,0 +1,141 @@
+#include "SampleMixer.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#define SAMPLE_MIXER_SSE
+#include <immintrin.h>
+#endif
+
+// Maximum channel count for which the vectorised kernel is used.
+constexpr uint32_t kMaxVectorChannels = 32;
+
+// Mixing parameters.
+struct MixParameters {
+	float* Output;
+	const float* Input;
+	size_t InputSamples;
+	SampleMixer::Gain OutputGain;
+	SampleMixer::Fade OutputFade;
+	SampleMixer::Gain InputGain;
+	SampleMixer::Fade InputFade;
+	uint32_t Channels;
+};
+
+// Returns the 'fade' scale factor for a sample 'frame'.
+static float GetScale( const SampleMixer::Fade& fade, const float frame )
+{
+	const float scale = fade.Start + fade.Step * frame;
+	return ( ( scale < 0 ) || ( scale > 1.0f ) ) ? 0 : scale;
+}
+
+// Returns a 'sample' with the 'gain' applied.
+static float ApplyGain( const float sample, const SampleMixer::Gain& gain )
+{
+	const float value = sample * gain.Scale;
+	return gain.Limit ? std::clamp( value, -1.0f, 1.0f ) : value;
+}
+
+// Mixes the samples from the 'first' index up to (but not including) the 'last' index, one sample at a time.
+static void MixScalar( const MixParameters& params, const size_t first, const size_t last )
+{
+	for ( size_t index = first; index < last; index++ ) {
+		const float frame = static_cast<float>( index / params.Channels );
+		float value = ApplyGain( params.Output[ index ], params.OutputGain );
+		if ( index < params.InputSamples ) {
+			value += ApplyGain( params.Input[ index ], params.InputGain ) * GetScale( params.InputFade, frame );
+		}
+		params.Output[ index ] = value * GetScale( params.OutputFade, frame );
+	}
+}
+
+#ifdef SAMPLE_MIXER_SSE
+
+// Returns the fade scale factors for the sample 'frames', from the fade 'start' & 'step'.
+static __m128 GetScaleSSE( const __m128 start, const __m128 step, const __m128 frames )
+{
+	const __m128 scale = _mm_add_ps( start, _mm_mul_ps( step, frames ) );
+	const __m128 inRange = _mm_and_ps( _mm_cmpge_ps( scale, _mm_setzero_ps() ), _mm_cmple_ps( scale, _mm_set1_ps( 1.0f ) ) );
+	return _mm_and_ps( scale, inRange );
+}
+
+// Mixes vectors of samples from the 'first' index, while a whole vector precedes the 'last' index.
+// 'laneFrames' - the frame offset of each vector lane, for each channel position of the first lane.
+// Returns the index following the last sample mixed.
+template <bool mixInput>
+static size_t MixSSE( const MixParameters& params, const __m128* laneFrames, const size_t first, const size_t last )
+{
+	constexpr float kInfinity = std::numeric_limits<float>::infinity();
+	const __m128 outputScale = _mm_set1_ps( params.OutputGain.Scale );
+	const __m128 outputMin = _mm_set1_ps( params.OutputGain.Limit ? -1.0f : -kInfinity );
+	const __m128 outputMax = _mm_set1_ps( params.OutputGain.Limit ? 1.0f : kInfinity );
+	const __m128 outputStart = _mm_set1_ps( params.OutputFade.Start );
+	const __m128 outputStep = _mm_set1_ps( params.OutputFade.Step );
+	const __m128 inputScale = _mm_set1_ps( params.InputGain.Scale );
+	const __m128 inputMin = _mm_set1_ps( params.InputGain.Limit ? -1.0f : -kInfinity );
+	const __m128 inputMax = _mm_set1_ps( params.InputGain.Limit ? 1.0f : kInfinity );
+	const __m128 inputStart = _mm_set1_ps( params.InputFade.Start );
+	const __m128 inputStep = _mm_set1_ps( params.InputFade.Step );
+
+	size_t frame = first / params.Channels;
+	uint32_t channel = static_cast<uint32_t>( first % params.Channels );
+	size_t index = first;
+	for ( ; ( index + 4 ) <= last; index += 4 ) {
+		const __m128 frames = _mm_add_ps( _mm_set1_ps( static_cast<float>( frame ) ), laneFrames[ channel ] );
+		__m128 value = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( params.Output + index ), outputScale ), outputMin ), outputMax );
+		if constexpr ( mixInput ) {
+			const __m128 input = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( params.Input + index ), inputScale ), inputMin ), inputMax );
+			value = _mm_add_ps( value, _mm_mul_ps( input, GetScaleSSE( inputStart, inputStep, frames ) ) );
+		}
+		_mm_storeu_ps( params.Output + index, _mm_mul_ps( value, GetScaleSSE( outputStart, outputStep, frames ) ) );
+
+		channel += 4;
+		while ( channel >= params.Channels ) {
+			channel -= params.Channels;
+			++frame;
+		}
+	}
+	return index;
+}
+
+#endif
+
+SampleMixer::Fade SampleMixer::GetFadeOut( const float position, const float endPosition, const float duration, const long sampleRate )
+{
+	if ( ( duration <= 0 ) || ( sampleRate <= 0 ) ) {
+		return { 0, 0 };
+	}
+	return { ( endPosition - position ) / duration, -1.0f / ( duration * sampleRate ) };
+}
+
+void SampleMixer::Mix( float* output, const size_t outputFrames, const Gain& outputGain, const Fade& outputFade,
+	const float* input, const size_t inputFrames, const Gain& inputGain, const Fade& inputFade, const uint32_t channels )
+{
+	if ( ( nullptr == output ) || ( 0 == channels ) ) {
+		return;
+	}
+
+	const size_t samples = outputFrames * channels;
+	const size_t inputSamples = ( nullptr != input ) ? ( std::min( inputFrames, outputFrames ) * channels ) : 0;
+	const MixParameters params = { output, input, inputSamples, outputGain, outputFade, inputGain, inputFade, channels };
+
+#ifdef SAMPLE_MIXER_SSE
+	if ( channels <= kMaxVectorChannels ) {
+		__m128 laneFrames[ kMaxVectorChannels ];
+		for ( uint32_t channel = 0; channel < channels; channel++ ) {
+			laneFrames[ channel ] = _mm_set_ps( static_cast<float>( ( channel + 3 ) / channels ), static_cast<float>( ( channel + 2 ) / channels ),
+				static_cast<float>( ( channel + 1 ) / channels ), static_cast<float>( channel / channels ) );
+		}
+
+		// Mix both streams, then apply the remaining output stream gain & fade.
+		size_t index = MixSSE<true>( params, laneFrames, 0, inputSamples );
+		MixScalar( params, index, inputSamples );
+		index = MixSSE<false>( params, laneFrames, inputSamples, samples );
+		MixScalar( params, index, samples );
+		return;
+	}
+#endif
+
+	MixScalar( params, 0, samples );
+}
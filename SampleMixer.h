@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Fused gain, fade, mix & limit kernel for interleaved floating point output samples.
+// All stages are applied in a single pass over the output buffer, using SIMD instructions where available.
+class SampleMixer
+{
+public:
+	// Gain applied to a stream.
+	struct Gain {
+		float Scale = 1.0f;     // Linear gain scale.
+		bool Limit = false;     // Whether to hard limit the scaled samples to +/-1.0f.
+	};
+
+	// Linear fade applied to a stream, as a scale factor for each sample frame.
+	// A scale factor outside the range [0,1] silences the frame.
+	struct Fade {
+		float Start = 1.0f;     // Scale factor for the first frame.
+		float Step = 0;         // Change in scale factor for each subsequent frame.
+	};
+
+	// Returns the fade for a stream fading out from 'position' seconds, ending at 'endPosition' seconds, over a 'duration' in seconds, at a 'sampleRate'.
+	static Fade GetFadeOut( const float position, const float endPosition, const float duration, const long sampleRate );
+
+	// Mixes an 'input' stream into an 'output' stream, in place.
+	// 'output' - output samples, to which the 'outputGain' is applied before mixing, and the 'outputFade' after mixing.
+	// 'outputFrames' - number of sample frames in the output.
+	// 'input' - input samples, to which the 'inputGain' & 'inputFade' are applied before mixing (can be nullptr).
+	// 'inputFrames' - number of sample frames in the input, which must not be more than the output.
+	// 'channels' - number of channels in both streams.
+	static void Mix( float* output, const size_t outputFrames, const Gain& outputGain, const Fade& outputFade,
+		const float* input, const size_t inputFrames, const Gain& inputGain, const Fade& inputFade, const uint32_t channels );
+};
@@ -0,0 +1,249 @@
+#include "SampleMixerBenchmark.h"
+
+#include "SampleMixer.h"
+
+#include "json.hpp"
+#include "opus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Maximum allowed difference between the fused & multi-pass output samples.
+constexpr double kMaxDifference = 1e-5;
+
+// Duration of audio produced by each callback, in seconds.
+constexpr float kCallbackSeconds = 0.02f;
+
+// Number of callbacks timed for each scenario & format.
+constexpr size_t kCallbacks = 1000;
+
+// Fade out duration, in seconds (as used by the output).
+constexpr float kFadeSeconds = 5.0f;
+
+// Track position at which the fade out starts, in seconds.
+constexpr float kFadeStartPosition = 180.0f;
+
+// Offset of the first callback into the fade out, in seconds.
+// Callback positions cycle through the middle of the fade out, so that they never fall on the point at which the fade starts or ends (where rounding can decide whether a frame is silenced).
+constexpr float kFadeOffset = 0.5f;
+
+// Number of callbacks after which callback positions return to the fade offset.
+constexpr size_t kFadeCallbacks = 100;
+
+// Gain applied to the crossfading stream.
+constexpr SampleMixer::Gain kCrossfadeGain = { 0.8f, false };
+
+// Random seed for the sample data, so that each run uses the same input.
+constexpr uint32_t kSeed = 1974;
+
+// Mixing scenario.
+struct Scenario {
+	const char* Name;               // Scenario name.
+	SampleMixer::Gain Gain;         // Gain applied to the output stream.
+	bool FadeOut;                   // Whether the output stream is faded out.
+	bool Crossfade;                 // Whether a crossfading stream, which is faded out, is mixed into the output stream.
+	bool SoftLimit;                 // Whether the output stream is soft limited (in place of any hard limit).
+};
+
+// Mixing scenarios.
+static const std::vector<Scenario> s_Scenarios = {
+	{ "gain", { 0.7f, false }, false, false, false },
+	{ "limitedGain", { 2.5f, true }, false, false, false },
+	{ "softLimitedGain", { 2.5f, false }, false, false, true },
+	{ "fadeOut", { 0.7f, false }, true, false, false },
+	{ "crossfade", { 0.7f, false }, false, true, false }
+};
+
+// Sample formats.
+static const std::vector<std::pair<long /*sampleRate*/, uint32_t /*channels*/>> s_Formats = {
+	{ 44100, 2 },
+	{ 192000, 8 }
+};
+
+// Applies the 'gain' to the 'samples' in the 'buffer', as a separate pass.
+static void ApplyGain( float* buffer, const size_t samples, const SampleMixer::Gain& gain )
+{
+	for ( size_t sample = 0; sample < samples; sample++ ) {
+		buffer[ sample ] *= gain.Scale;
+	}
+	if ( gain.Limit ) {
+		for ( size_t sample = 0; sample < samples; sample++ ) {
+			if ( buffer[ sample ] < -1.0f ) {
+				buffer[ sample ] = -1.0f;
+			} else if ( buffer[ sample ] > 1.0f ) {
+				buffer[ sample ] = 1.0f;
+			}
+		}
+	}
+}
+
+// Applies the 'gain' & a soft limit to the 'frames' in the 'buffer', as a separate pass, using the 'softClipState' carried over from the previous callback.
+static void ApplySoftLimit( float* buffer, const size_t frames, const uint32_t channels, const SampleMixer::Gain& gain, std::vector<float>& softClipState )
+{
+	ApplyGain( buffer, frames * channels, gain );
+	opus_pcm_soft_clip( buffer, static_cast<int>( frames ), static_cast<int>( channels ), softClipState.data() );
+}
+
+// Applies a fade out from the 'position' in seconds, ending at 'endPosition' seconds, to the 'frames' in the 'buffer', as a separate pass.
+static void ApplyFadeOut( float* buffer, const size_t frames, const uint32_t channels, const float position, const float endPosition, const long sampleRate )
+{
+	for ( size_t frame = 0; frame < frames; frame++ ) {
+		const float pos = static_cast<float>( frame ) / sampleRate;
+		float scale = ( endPosition - position - pos ) / kFadeSeconds;
+		if ( ( scale < 0 ) || ( scale > 1.0f ) ) {
+			scale = 0;
+		}
+		for ( uint32_t channel = 0; channel < channels; channel++ ) {
+			buffer[ frame * channels + channel ] *= scale;
+		}
+	}
+}
+
+// Mixes the 'input' into the 'output' for the 'scenario' at the fade 'position' in seconds, as separate passes (as the output did before the passes were fused).
+// 'softClipState' - soft limit state for the output stream.
+static void MixMultiPass( const Scenario& scenario, float* output, float* input, const size_t frames, const uint32_t channels, const long sampleRate, const float position,
+	std::vector<float>& softClipState )
+{
+	const size_t samples = frames * channels;
+	const float endPosition = kFadeStartPosition + kFadeSeconds;
+	if ( scenario.SoftLimit ) {
+		ApplySoftLimit( output, frames, channels, scenario.Gain, softClipState );
+	} else {
+		ApplyGain( output, samples, scenario.Gain );
+	}
+	if ( scenario.Crossfade ) {
+		ApplyGain( input, samples, kCrossfadeGain );
+		ApplyFadeOut( input, frames, channels, position, endPosition, sampleRate );
+		for ( size_t sample = 0; sample < samples; sample++ ) {
+			output[ sample ] += input[ sample ];
+		}
+	}
+	if ( scenario.FadeOut ) {
+		ApplyFadeOut( output, frames, channels, position, endPosition, sampleRate );
+	}
+}
+
+// Mixes the 'input' into the 'output' for the 'scenario' at the fade 'position' in seconds, in a single pass (preceded by the soft limit pass, if the scenario is soft limited).
+// 'softClipState' - soft limit state for the output stream.
+static void MixFused( const Scenario& scenario, float* output, const float* input, const size_t frames, const uint32_t channels, const long sampleRate, const float position,
+	std::vector<float>& softClipState )
+{
+	SampleMixer::Gain gain = scenario.Gain;
+	if ( scenario.SoftLimit ) {
+		// As with the output, the gain is applied by the soft limit pass, so the mix uses unity gain.
+		ApplySoftLimit( output, frames, channels, gain, softClipState );
+		gain = {};
+	}
+	const SampleMixer::Fade fade = SampleMixer::GetFadeOut( position, kFadeStartPosition + kFadeSeconds, kFadeSeconds, sampleRate );
+	SampleMixer::Mix( output, frames, gain, scenario.FadeOut ? fade : SampleMixer::Fade(),
+		scenario.Crossfade ? input : nullptr, frames, kCrossfadeGain, fade, channels );
+}
+
+// Returns the number of microseconds elapsed since 'start'.
+static double GetElapsedMicroseconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Runs the 'scenario' for a 'sampleRate' & 'channels', using the 'engine' to generate the sample data.
+static SampleMixerBenchmark::Result RunScenario( const Scenario& scenario, const long sampleRate, const uint32_t channels, std::mt19937& engine )
+{
+	SampleMixerBenchmark::Result result;
+	result.Scenario = scenario.Name;
+	result.SampleRate = sampleRate;
+	result.Channels = channels;
+	result.CallbackFrames = static_cast<size_t>( kCallbackSeconds * sampleRate );
+
+	// Both streams are decoded into fresh buffers for each callback, so each mix starts from a copy of the sample data (the fused mix does not modify the input).
+	const size_t samples = result.CallbackFrames * channels;
+	std::uniform_real_distribution<float> distribution( -1.0f, 1.0f );
+	std::vector<float> outputData( samples );
+	std::vector<float> inputData( samples );
+	for ( size_t sample = 0; sample < samples; sample++ ) {
+		outputData[ sample ] = distribution( engine );
+		inputData[ sample ] = distribution( engine );
+	}
+	std::vector<float> multiPassOutput( samples );
+	std::vector<float> multiPassInput( samples );
+	std::vector<float> fusedOutput( samples );
+	std::vector<float> multiPassSoftClipState( channels, 0 );
+	std::vector<float> fusedSoftClipState( channels, 0 );
+
+	for ( size_t callback = 0; callback < kCallbacks; callback++ ) {
+		const float position = kFadeStartPosition + kFadeOffset + ( callback % kFadeCallbacks ) * kCallbackSeconds;
+
+		multiPassOutput = outputData;
+		multiPassInput = inputData;
+		auto start = std::chrono::steady_clock::now();
+		MixMultiPass( scenario, multiPassOutput.data(), multiPassInput.data(), result.CallbackFrames, channels, sampleRate, position, multiPassSoftClipState );
+		result.MultiPassMicroseconds += GetElapsedMicroseconds( start );
+
+		fusedOutput = outputData;
+		start = std::chrono::steady_clock::now();
+		MixFused( scenario, fusedOutput.data(), inputData.data(), result.CallbackFrames, channels, sampleRate, position, fusedSoftClipState );
+		result.FusedMicroseconds += GetElapsedMicroseconds( start );
+
+		for ( size_t sample = 0; sample < samples; sample++ ) {
+			result.MaxDifference = std::max( result.MaxDifference, static_cast<double>( std::fabs( fusedOutput[ sample ] - multiPassOutput[ sample ] ) ) );
+		}
+	}
+	result.MultiPassMicroseconds /= kCallbacks;
+	result.FusedMicroseconds /= kCallbacks;
+	return result;
+}
+
+SampleMixerBenchmark::Results SampleMixerBenchmark::Run()
+{
+	Results results;
+	std::mt19937 engine( kSeed );
+	for ( const auto& [sampleRate, channels] : s_Formats ) {
+		for ( const auto& scenario : s_Scenarios ) {
+			results.Mixes.push_back( RunScenario( scenario, sampleRate, channels, engine ) );
+		}
+	}
+	return results;
+}
+
+bool SampleMixerBenchmark::Passed( const Results& results )
+{
+	return std::all_of( results.Mixes.begin(), results.Mixes.end(), [] ( const Result& result )
+		{
+			return result.MaxDifference <= kMaxDifference;
+		} );
+}
+
+bool SampleMixerBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	const bool passed = Passed( results );
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "passed" ] = passed;
+		doc[ "maxAllowedDifference" ] = kMaxDifference;
+
+		nlohmann::json mixes = nlohmann::json::array();
+		for ( const auto& result : results.Mixes ) {
+			nlohmann::json mix;
+			mix[ "scenario" ] = result.Scenario;
+			mix[ "sampleRate" ] = result.SampleRate;
+			mix[ "channels" ] = result.Channels;
+			mix[ "callbackFrames" ] = result.CallbackFrames;
+			mix[ "maxDifference" ] = result.MaxDifference;
+			mix[ "multiPassMicroseconds" ] = result.MultiPassMicroseconds;
+			mix[ "fusedMicroseconds" ] = result.FusedMicroseconds;
+			mixes.push_back( mix );
+		}
+		doc[ "mixes" ] = mixes;
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good() && passed;
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Checks the correctness, and measures the performance, of the fused gain, fade, mix & limit kernel used by the output callback.
+// For each scenario (gain, limited gain, soft limited gain, fade out & crossfade), the output is compared against the separate passes previously made over the output buffer, and both are timed per callback.
+// Soft limiting is stateful, so it is still applied in a separate pass before the fused mix (as the output does), and that scenario measures the cost of the extra pass.
+// The benchmark is run headless using the '-mixerbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class SampleMixerBenchmark
+{
+public:
+	// Benchmark results for a single scenario & format.
+	struct Result {
+		std::string Scenario;                   // Scenario name.
+		long SampleRate = 0;                    // Sample rate.
+		uint32_t Channels = 0;                  // Channel count.
+		size_t CallbackFrames = 0;              // Number of sample frames in each callback.
+		double MaxDifference = 0;               // Maximum difference between the fused & multi-pass output samples.
+		double MultiPassMicroseconds = 0;       // Time taken by the multi-pass mix, in microseconds per callback.
+		double FusedMicroseconds = 0;           // Time taken by the fused mix, in microseconds per callback.
+	};
+
+	// Benchmark results.
+	struct Results {
+		std::vector<Result> Mixes;              // Results for each scenario & format.
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Returns whether the 'results' are within tolerance.
+	static bool Passed( const Results& results );
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written and are within tolerance.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
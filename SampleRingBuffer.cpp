@@ -0,0 +1,158 @@
+#include "SampleRingBuffer.h"
+
+#include <algorithm>
+
+SampleRingBuffer::SampleRingBuffer( const size_t capacity ) :
+	m_Storage( std::make_unique<Storage>() )
+{
+	m_Storage->Samples.resize( capacity );
+	m_Capacity = capacity;
+	m_ReadStorage = m_Storage.get();
+}
+
+size_t SampleRingBuffer::GetCapacity() const
+{
+	return m_Capacity.load( std::memory_order_relaxed );
+}
+
+void SampleRingBuffer::Resize( const size_t capacity )
+{
+	if ( capacity != m_Storage->Samples.size() ) {
+		m_Storage->Samples.resize( capacity );
+		m_Storage->Samples.shrink_to_fit();
+		m_Capacity.store( capacity, std::memory_order_relaxed );
+	}
+	Reset();
+}
+
+void SampleRingBuffer::Reset()
+{
+	m_PreviousStorage.reset();
+	m_Storage->StartPosition = 0;
+	m_Storage->Previous = nullptr;
+	m_ReadStorage.store( m_Storage.get(), std::memory_order_relaxed );
+	m_WritePosition.store( 0, std::memory_order_relaxed );
+	m_ReadPosition.store( 0, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+}
+
+bool SampleRingBuffer::Grow( const size_t capacity )
+{
+	ReleasePreviousStorage();
+	if ( m_PreviousStorage || ( capacity <= m_Storage->Samples.size() ) ) {
+		return false;
+	}
+
+	// Samples are written to the new storage from the current write position onwards, while the consumer continues to read any earlier samples from the current storage.
+	auto storage = std::make_unique<Storage>();
+	storage->Samples.resize( capacity );
+	storage->StartPosition = m_WritePosition.load( std::memory_order_relaxed );
+	storage->Previous = m_Storage.get();
+	m_PreviousStorage = std::move( m_Storage );
+	m_Storage = std::move( storage );
+	m_Capacity.store( capacity, std::memory_order_relaxed );
+	m_ReadStorage.store( m_Storage.get(), std::memory_order_release );
+	return true;
+}
+
+void SampleRingBuffer::ReleasePreviousStorage()
+{
+	if ( m_PreviousStorage && ( m_ReadPosition.load( std::memory_order_acquire ) >= m_Storage->StartPosition ) ) {
+		m_PreviousStorage.reset();
+	}
+}
+
+size_t SampleRingBuffer::GetWriteAvailable() const
+{
+	const uint64_t writePosition = m_WritePosition.load( std::memory_order_relaxed );
+	const uint64_t readPosition = m_ReadPosition.load( std::memory_order_acquire );
+	const uint64_t firstPosition = std::max( readPosition, m_Storage->StartPosition );
+	return m_Storage->Samples.size() - static_cast<size_t>( writePosition - firstPosition );
+}
+
+std::pair<float*, size_t> SampleRingBuffer::GetWriteRegion()
+{
+	ReleasePreviousStorage();
+	const size_t capacity = m_Storage->Samples.size();
+	if ( 0 == capacity ) {
+		return { nullptr, 0 };
+	}
+	const size_t offset = static_cast<size_t>( ( m_WritePosition.load( std::memory_order_relaxed ) - m_Storage->StartPosition ) % capacity );
+	const size_t available = GetWriteAvailable();
+	return { m_Storage->Samples.data() + offset, std::min( available, capacity - offset ) };
+}
+
+void SampleRingBuffer::CommitWrite( const size_t sampleCount )
+{
+	m_WritePosition.store( m_WritePosition.load( std::memory_order_relaxed ) + sampleCount, std::memory_order_release );
+}
+
+size_t SampleRingBuffer::Write( const float* buffer, const size_t sampleCount )
+{
+	size_t samplesWritten = 0;
+	while ( samplesWritten < sampleCount ) {
+		const auto [region, regionSize] = GetWriteRegion();
+		if ( 0 == regionSize ) {
+			break;
+		}
+		const size_t samplesToWrite = std::min( regionSize, sampleCount - samplesWritten );
+		std::copy( buffer + samplesWritten, buffer + samplesWritten + samplesToWrite, region );
+		CommitWrite( samplesToWrite );
+		samplesWritten += samplesToWrite;
+	}
+	return samplesWritten;
+}
+
+size_t SampleRingBuffer::GetReadAvailable() const
+{
+	const uint64_t readPosition = m_ReadPosition.load( std::memory_order_relaxed );
+	const uint64_t writePosition = m_WritePosition.load( std::memory_order_acquire );
+	return static_cast<size_t>( writePosition - readPosition );
+}
+
+size_t SampleRingBuffer::Read( float* buffer, const size_t sampleCount )
+{
+	// The write position is loaded before the storage, so that the storage is at least as recent as any samples which are available to read.
+	const size_t samplesToRead = std::min( sampleCount, GetReadAvailable() );
+	if ( samplesToRead > 0 ) {
+		const Storage* storage = m_ReadStorage.load( std::memory_order_acquire );
+		const uint64_t readPosition = m_ReadPosition.load( std::memory_order_relaxed );
+		size_t samplesRead = 0;
+		if ( ( readPosition < storage->StartPosition ) && ( nullptr != storage->Previous ) ) {
+			samplesRead = static_cast<size_t>( std::min<uint64_t>( samplesToRead, storage->StartPosition - readPosition ) );
+			CopyFromStorage( *storage->Previous, readPosition, samplesRead, buffer );
+		}
+		CopyFromStorage( *storage, readPosition + samplesRead, samplesToRead - samplesRead, buffer + samplesRead );
+		m_ReadPosition.store( readPosition + samplesToRead, std::memory_order_release );
+	}
+	return samplesToRead;
+}
+
+void SampleRingBuffer::CopyFromStorage( const Storage& storage, const uint64_t position, const size_t sampleCount, float* buffer )
+{
+	const size_t capacity = storage.Samples.size();
+	if ( ( sampleCount > 0 ) && ( capacity > 0 ) ) {
+		const size_t offset = static_cast<size_t>( ( position - storage.StartPosition ) % capacity );
+		const size_t firstPart = std::min( sampleCount, capacity - offset );
+		std::copy( storage.Samples.data() + offset, storage.Samples.data() + offset + firstPart, buffer );
+		if ( firstPart < sampleCount ) {
+			std::copy( storage.Samples.data(), storage.Samples.data() + sampleCount - firstPart, buffer + firstPart );
+		}
+	}
+}
+
+void SampleRingBuffer::AddUnderrun()
+{
+	m_Underruns.store( m_Underruns.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+}
+
+SampleRingBuffer::Levels SampleRingBuffer::GetLevels() const
+{
+	Levels levels;
+	levels.Capacity = GetCapacity();
+	levels.TotalRead = m_ReadPosition.load( std::memory_order_acquire );
+	levels.TotalWritten = m_WritePosition.load( std::memory_order_acquire );
+	levels.Filled = ( levels.TotalWritten > levels.TotalRead ) ? static_cast<size_t>( levels.TotalWritten - levels.TotalRead ) : 0;
+	levels.Underruns = m_Underruns.load( std::memory_order_relaxed );
+	return levels;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Wait-free single producer/single consumer ring buffer of floating point sample data.
+// One thread may write to the buffer while another thread reads from it, without either thread taking a lock.
+// The capacity, and all read & write counts, are in samples (i.e. individual floats, not frames).
+// The producer can grow the buffer while the consumer is active (the consumer never allocates or frees memory).
+class SampleRingBuffer
+{
+public:
+	// Fill level information.
+	struct Levels {
+		size_t Capacity = 0;        // Capacity of the buffer.
+		size_t Filled = 0;          // Number of samples currently available to read.
+		uint64_t TotalWritten = 0;  // Total number of samples written since the buffer was last reset.
+		uint64_t TotalRead = 0;     // Total number of samples read since the buffer was last reset.
+		uint64_t Underruns = 0;     // Total number of reads which could not be fully satisfied.
+	};
+
+	// 'capacity' - buffer capacity, in samples.
+	SampleRingBuffer( const size_t capacity = 0 );
+
+	SampleRingBuffer( const SampleRingBuffer& ) = delete;
+	SampleRingBuffer& operator=( const SampleRingBuffer& ) = delete;
+
+	// Returns the buffer capacity, in samples.
+	size_t GetCapacity() const;
+
+	// Resizes the buffer to the 'capacity', in samples, and discards any buffered data.
+	// Must not be called while either the producer or the consumer is active.
+	void Resize( const size_t capacity );
+
+	// Discards any buffered data and resets the read & write counters.
+	// Must not be called while either the producer or the consumer is active.
+	void Reset();
+
+	// Producer side.
+
+	// Grows the buffer to the 'capacity', in samples, keeping any buffered data.
+	// Returns whether the buffer was grown, which is not possible until the consumer has read all the data buffered before any previous growth.
+	bool Grow( const size_t capacity );
+
+	// Returns the number of samples that can currently be written.
+	size_t GetWriteAvailable() const;
+
+	// Returns a pointer to the contiguous region that can currently be written to, and the size of that region in samples.
+	// The region size will be less than the write available count when the free space wraps around the end of the buffer.
+	std::pair<float*, size_t> GetWriteRegion();
+
+	// Makes 'sampleCount' samples, previously written to the region returned by GetWriteRegion, available to the consumer.
+	void CommitWrite( const size_t sampleCount );
+
+	// Writes up to 'sampleCount' samples from the 'buffer', returning the number of samples written.
+	size_t Write( const float* buffer, const size_t sampleCount );
+
+	// Consumer side.
+
+	// Returns the number of samples that can currently be read.
+	size_t GetReadAvailable() const;
+
+	// Reads up to 'sampleCount' samples into the 'buffer', returning the number of samples read.
+	size_t Read( float* buffer, const size_t sampleCount );
+
+	// Records that a read could not be fully satisfied (called by the consumer).
+	void AddUnderrun();
+
+	// Returns the current fill level information (can be called from any thread).
+	Levels GetLevels() const;
+
+private:
+	// Sample data storage.
+	struct Storage {
+		std::vector<float> Samples;        // Sample data.
+		uint64_t StartPosition = 0;        // Position of the first sample held by this storage (earlier samples are held by the previous storage).
+		const Storage* Previous = nullptr; // Previous storage, holding any samples before the start position which have yet to be read.
+	};
+
+	// Copies 'sampleCount' samples, starting at the 'position', from the 'storage' into the 'buffer'.
+	static void CopyFromStorage( const Storage& storage, const uint64_t position, const size_t sampleCount, float* buffer );
+
+	// Frees the previous storage, once the consumer has read all of its samples (only called by the producer).
+	void ReleasePreviousStorage();
+
+	// Current storage (owned by the producer).
+	std::unique_ptr<Storage> m_Storage;
+
+	// Previous storage, prior to the buffer last being grown (owned by the producer).
+	std::unique_ptr<Storage> m_PreviousStorage;
+
+	// Current storage, as published to the consumer.
+	std::atomic<const Storage*> m_ReadStorage = nullptr;
+
+	// Capacity of the current storage.
+	std::atomic<size_t> m_Capacity = 0;
+
+	// Total number of samples written (only modified by the producer).
+	alignas( 64 ) std::atomic<uint64_t> m_WritePosition = 0;
+
+	// Total number of samples read (only modified by the consumer).
+	alignas( 64 ) std::atomic<uint64_t> m_ReadPosition = 0;
+
+	// Number of underruns (only modified by the consumer).
+	std::atomic<uint64_t> m_Underruns = 0;
+};
@@ -0,0 +1,187 @@
+#include "ScanBenchmark.h"
+
+#include "FolderScanner.h"
+
+#include "json.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+// Results file format version.
+constexpr int kResultsVersion = 1;
+
+// Number of artist folders in the synthetic tree.
+constexpr size_t kArtistCount = 200;
+
+// Number of album folders for each artist.
+constexpr size_t kAlbumCount = 10;
+
+// Number of files in each album folder.
+constexpr size_t kTrackCount = 100;
+
+// Simulated latency for each folder enumeration, as on a network share.
+constexpr std::chrono::milliseconds kSimulatedLatency( 2 );
+
+// Scanning thread counts for the parallel scans.
+static const std::vector<size_t> s_ThreadCounts = { 1, 2, 4, 8, 16 };
+
+// Returns the number of seconds elapsed since 'start'.
+static double GetElapsedSeconds( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Creates the synthetic tree at the 'root', returning false if the tree could not be created.
+static bool CreateTree( const std::filesystem::path& root )
+{
+	for ( size_t artist = 0; artist < kArtistCount; artist++ ) {
+		for ( size_t album = 0; album < kAlbumCount; album++ ) {
+			const std::filesystem::path folder = root / ( L"Artist " + std::to_wstring( artist ) ) / ( L"Album " + std::to_wstring( album ) );
+			std::error_code ec;
+			std::filesystem::create_directories( folder, ec );
+			if ( ec ) {
+				return false;
+			}
+			for ( size_t track = 0; track < kTrackCount; track++ ) {
+				std::ofstream stream( folder / ( L"Track " + std::to_wstring( track ) + L".flac" ) );
+				if ( !stream.good() ) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Recursively scans the 'folder' on a single thread using the 'enumerator', adding any files to 'files', and returning the number of folders enumerated.
+static size_t ScanSerial( const FolderScanner::Enumerator& enumerator, const std::filesystem::path& folder, std::set<std::filesystem::path>& files )
+{
+	std::vector<std::filesystem::path> folders;
+	std::vector<FolderScanner::File> found;
+	enumerator( folder, folders, found );
+	for ( auto& file : found ) {
+		files.insert( std::move( file.Path ) );
+	}
+	size_t folderCount = 1;
+	for ( const auto& subfolder : folders ) {
+		folderCount += ScanSerial( enumerator, subfolder, files );
+	}
+	return folderCount;
+}
+
+// Scans the synthetic tree at the 'root' using the 'enumerator', in the way the library maintainer did before scanning in parallel.
+// All files are collected before any are processed, and file information is then queried separately for each file.
+static ScanBenchmark::Result RunSerial( const FolderScanner::Enumerator& enumerator, const std::filesystem::path& root )
+{
+	ScanBenchmark::Result result;
+	const auto start = std::chrono::steady_clock::now();
+	std::set<std::filesystem::path> files;
+	result.Folders = ScanSerial( enumerator, root, files );
+	result.FirstFileMilliseconds = 1000 * GetElapsedSeconds( start );
+	for ( const auto& file : files ) {
+		std::error_code ec;
+		if ( const auto filetime = std::filesystem::last_write_time( file, ec ); !ec && ( std::filesystem::file_time_type::min() != filetime ) ) {
+			if ( const auto filesize = std::filesystem::file_size( file, ec ); !ec && ( static_cast<uintmax_t>( -1 ) != filesize ) ) {
+				++result.Files;
+			}
+		}
+	}
+	result.Seconds = GetElapsedSeconds( start );
+	if ( result.Seconds > 0 ) {
+		result.FilesPerSecond = result.Files / result.Seconds;
+	}
+	return result;
+}
+
+// Scans the synthetic tree at the 'root' using the 'enumerator', in parallel with the number of 'threads'.
+static ScanBenchmark::Result RunParallel( const FolderScanner::Enumerator& enumerator, const std::filesystem::path& root, const size_t threads )
+{
+	ScanBenchmark::Result result;
+	result.Threads = threads;
+	std::set<std::filesystem::path> files;
+	std::mutex filesMutex;
+	FolderScanner scanner( enumerator, nullptr /*stopPredicate*/ );
+	const auto start = std::chrono::steady_clock::now();
+	result.Folders = scanner.Scan( { { root, threads } }, [ &result, &files, &filesMutex, &start ] ( FolderScanner::File&& file )
+		{
+			std::lock_guard<std::mutex> lock( filesMutex );
+			if ( files.empty() ) {
+				result.FirstFileMilliseconds = 1000 * GetElapsedSeconds( start );
+			}
+			files.insert( std::move( file.Path ) );
+		} );
+	result.Seconds = GetElapsedSeconds( start );
+	result.Files = files.size();
+	if ( result.Seconds > 0 ) {
+		result.FilesPerSecond = result.Files / result.Seconds;
+	}
+	return result;
+}
+
+ScanBenchmark::Results ScanBenchmark::Run()
+{
+	Results results;
+	const std::filesystem::path root = std::filesystem::temp_directory_path() / L"VUPlayerScanBenchmark";
+	std::error_code ec;
+	std::filesystem::remove_all( root, ec );
+
+	const auto start = std::chrono::steady_clock::now();
+	if ( CreateTree( root ) ) {
+		results.CreateSeconds = GetElapsedSeconds( start );
+		results.TreeFolders = 1 + kArtistCount + kArtistCount * kAlbumCount;
+		results.TreeFiles = kArtistCount * kAlbumCount * kTrackCount;
+		results.LatencyMilliseconds = static_cast<double>( kSimulatedLatency.count() );
+
+		const FolderScanner::Enumerator localEnumerator = FolderScanner::EnumerateFolder;
+		const FolderScanner::Enumerator remoteEnumerator = [] ( const std::filesystem::path& folder, std::vector<std::filesystem::path>& folders, std::vector<FolderScanner::File>& files )
+		{
+			std::this_thread::sleep_for( kSimulatedLatency );
+			FolderScanner::EnumerateFolder( folder, folders, files );
+		};
+
+		for ( const auto& [enumerator, configurationResults] : { std::make_pair( &localEnumerator, &results.Local ), std::make_pair( &remoteEnumerator, &results.Remote ) } ) {
+			configurationResults->push_back( RunSerial( *enumerator, root ) );
+			for ( const auto threads : s_ThreadCounts ) {
+				configurationResults->push_back( RunParallel( *enumerator, root, threads ) );
+			}
+		}
+	}
+
+	std::filesystem::remove_all( root, ec );
+	return results;
+}
+
+bool ScanBenchmark::WriteResults( const Results& results, const std::filesystem::path& filename )
+{
+	try {
+		nlohmann::json doc;
+		doc[ "version" ] = kResultsVersion;
+		doc[ "treeFolders" ] = results.TreeFolders;
+		doc[ "treeFiles" ] = results.TreeFiles;
+		doc[ "createSeconds" ] = results.CreateSeconds;
+		doc[ "latencyMilliseconds" ] = results.LatencyMilliseconds;
+
+		for ( const auto& [name, configurationResults] : { std::make_pair( "local", &results.Local ), std::make_pair( "remote", &results.Remote ) } ) {
+			nlohmann::json scans = nlohmann::json::array();
+			for ( const auto& result : *configurationResults ) {
+				nlohmann::json scan;
+				scan[ "threads" ] = result.Threads;
+				scan[ "folders" ] = result.Folders;
+				scan[ "files" ] = result.Files;
+				scan[ "seconds" ] = result.Seconds;
+				scan[ "filesPerSecond" ] = result.FilesPerSecond;
+				scan[ "firstFileMilliseconds" ] = result.FirstFileMilliseconds;
+				scans.push_back( scan );
+			}
+			doc[ name ] = scans;
+		}
+
+		std::ofstream stream( filename );
+		stream << doc.dump( 2 /*indent*/ );
+		return stream.good();
+	} catch ( const nlohmann::json::exception& ) {}
+	return false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <filesystem>
+#include <vector>
+
+// Measures the performance of the library maintainer folder scan, using a synthetic folder tree which is created in the temporary folder.
+// The serial recursive scan, followed by a file information query for each file, is compared with the parallel scan (at several thread counts), which gets file information from the folder enumeration.
+// Each is measured on the local disk, and with a simulated latency for each folder enumeration (as on a network share).
+// The benchmark is run headless using the '-scanbenchmark' command line switch, and writes its results to a JSON file so that they can be compared across builds.
+class ScanBenchmark
+{
+public:
+	// Scan results for a single configuration.
+	struct Result {
+		size_t Threads = 0;                     // Number of scanning threads (or zero for the serial scan).
+		size_t Folders = 0;                     // Number of folders enumerated.
+		size_t Files = 0;                       // Number of files found.
+		double Seconds = 0;                     // Wall clock time for the scan, including file information, in seconds.
+		double FilesPerSecond = 0;              // Scan throughput.
+		double FirstFileMilliseconds = 0;       // Time until the first file was available for processing, in milliseconds.
+	};
+
+	// Benchmark results.
+	struct Results {
+		size_t TreeFolders = 0;                 // Number of folders in the synthetic tree.
+		size_t TreeFiles = 0;                   // Number of files in the synthetic tree.
+		double CreateSeconds = 0;               // Wall clock time to create the synthetic tree, in seconds.
+		double LatencyMilliseconds = 0;         // Simulated latency for each folder enumeration, in milliseconds.
+		std::vector<Result> Local;              // Results on the local disk (the serial scan, followed by the parallel scans).
+		std::vector<Result> Remote;             // Results with the simulated latency (the serial scan, followed by the parallel scans).
+	};
+
+	// Runs the benchmark, returning the results.
+	static Results Run();
+
+	// Writes the benchmark 'results' to a JSON 'filename'.
+	// Returns true if the results were written.
+	static bool WriteResults( const Results& results, const std::filesystem::path& filename );
+};
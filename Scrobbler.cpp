@@ -281,6 +281,8 @@ void Scrobbler::ReadCachedScrobbles()
 	std::lock_guard<std::mutex> lock( m_Mutex );
 	sqlite3* database = m_Database.GetDatabase();
 	if ( nullptr != database ) {
+		const Database::WriteScope scope( m_Database );
+
 		// Drop any cached scrobbles that are too old.
 		const time_t now = time( nullptr );
 		const time_t cutoff = now - s_ScrobblerCacheLength;
@@ -324,6 +326,8 @@ void Scrobbler::SaveCachedScrobbles()
 	if ( !m_PendingScrobbles.empty() ) {
 		sqlite3* database = m_Database.GetDatabase();
 		if ( nullptr != database ) {
+			const Database::WriteScope scope( m_Database );
+
 			// Ensure the cached scrobbles table exists in the application database.
 			const std::string scrobblerTableQuery = "CREATE TABLE IF NOT EXISTS Scrobbles(Timestamp, Artist, Title, Album, Track, Duration, PRIMARY KEY(Timestamp));";
 			sqlite3_exec( database, scrobblerTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
@@ -409,6 +413,7 @@ void Scrobbler::RemovePendingScrobbles( const Timestamps& timestamps )
 	if ( !timestamps.empty() ) {
 		sqlite3* database = m_Database.GetDatabase();
 		if ( nullptr != database ) {
+			const Database::WriteScope scope( m_Database );
 			sqlite3_stmt* stmt = nullptr;
 			const std::string dropQuery = "DELETE FROM Scrobbles WHERE Timestamp == ?1;";
 			if ( SQLITE_OK == sqlite3_prepare_v2( database, dropQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
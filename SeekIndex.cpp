@@ -0,0 +1,145 @@
+#include "SeekIndex.h"
+
+#include <algorithm>
+
+// Maximum number of seek indices to keep in memory.
+constexpr size_t kCacheSize = 64;
+
+SeekIndex::Cache SeekIndex::s_Cache( kCacheSize, SeekIndex::GetCacheLoadCallback( nullptr ), SeekIndex::GetCacheSaveCallback( nullptr ) );
+
+SeekIndex::SeekIndex( const std::wstring& filename, const long long filetime, const long long filesize ) :
+	m_Filename( filename ),
+	m_Filetime( filetime ),
+	m_Filesize( filesize )
+{
+}
+
+SeekIndex::~SeekIndex()
+{
+}
+
+SeekIndex::Ptr SeekIndex::Get( const std::wstring& filename )
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+	if ( filename.empty() || !GetFileAttributesEx( filename.c_str(), GetFileExInfoStandard, &attributes ) ) {
+		return nullptr;
+	}
+	const long long filetime = ( static_cast<long long>( attributes.ftLastWriteTime.dwHighDateTime ) << 32 ) + attributes.ftLastWriteTime.dwLowDateTime;
+	const long long filesize = ( static_cast<long long>( attributes.nFileSizeHigh ) << 32 ) + attributes.nFileSizeLow;
+	return s_Cache.Get( filename, { filename, filetime, filesize } ).value_or( nullptr );
+}
+
+void SeekIndex::SetStore( LoadCallback load, SaveCallback save )
+{
+	s_Cache.SetStore( GetCacheLoadCallback( load ), GetCacheSaveCallback( save ) );
+}
+
+void SeekIndex::SaveAll()
+{
+	s_Cache.SaveAll();
+}
+
+SeekIndex::Cache::LoadCallback SeekIndex::GetCacheLoadCallback( LoadCallback load )
+{
+	return [ load ] ( const Track& track, Ptr& seekIndex )
+	{
+		// An index is always created (even if there are no stored seek points), so that it can be shared between decoders.
+		seekIndex = std::make_shared<SeekIndex>( track.Filename, track.Filetime, track.Filesize );
+		if ( load ) {
+			load( track.Filename, track.Filetime, track.Filesize, seekIndex->m_Points );
+		}
+		return true;
+	};
+}
+
+SeekIndex::Cache::SaveCallback SeekIndex::GetCacheSaveCallback( SaveCallback save )
+{
+	return [ save ] ( const Track& track, const Ptr& seekIndex )
+	{
+		Points points;
+		{
+			std::lock_guard<std::mutex> lock( seekIndex->m_Mutex );
+			if ( !seekIndex->m_Modified ) {
+				return;
+			}
+			points = seekIndex->m_Points;
+			seekIndex->m_Modified = false;
+		}
+		if ( save ) {
+			save( track.Filename, track.Filetime, track.Filesize, points );
+		}
+	};
+}
+
+void SeekIndex::Add( const int64_t sample, const Point& point, const int64_t minimumInterval )
+{
+	if ( sample >= 0 ) {
+		bool firstModification = false;
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			const auto next = m_Points.lower_bound( sample );
+			const bool farFromNext = ( m_Points.end() == next ) || ( ( next->first - sample ) >= minimumInterval );
+			const bool farFromPrevious = ( m_Points.begin() == next ) || ( ( sample - std::prev( next )->first ) >= minimumInterval );
+			if ( farFromNext && farFromPrevious ) {
+				m_Points.insert( next, { sample, point } );
+				firstModification = !m_Modified;
+				m_Modified = true;
+			}
+		}
+		if ( firstModification ) {
+			// The points are modified in place, so the cache needs to be told that the index needs saving.
+			s_Cache.SetModified( m_Filename );
+		}
+	}
+}
+
+std::optional<std::pair<int64_t /*sample*/, SeekIndex::Point>> SeekIndex::Find( const int64_t sample, const int64_t maximumDistance )
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	if ( auto point = m_Points.upper_bound( sample ); m_Points.begin() != point ) {
+		--point;
+		if ( ( sample - point->first ) <= maximumDistance ) {
+			return *point;
+		}
+	}
+	return std::nullopt;
+}
+
+std::vector<uint8_t> SeekIndex::Serialise( const Points& points )
+{
+	// Each point is stored as three little-endian 64-bit values: sample position, byte offset, hint.
+	std::vector<uint8_t> blob;
+	blob.reserve( points.size() * 3 * sizeof( int64_t ) );
+	for ( const auto& [sample, point] : points ) {
+		for ( const int64_t value : { sample, point.Offset, point.Hint } ) {
+			for ( int byte = 0; byte < 8; byte++ ) {
+				blob.push_back( static_cast<uint8_t>( static_cast<uint64_t>( value ) >> ( 8 * byte ) ) );
+			}
+		}
+	}
+	return blob;
+}
+
+bool SeekIndex::Deserialise( const void* blob, const size_t size, Points& points )
+{
+	constexpr size_t kPointSize = 3 * sizeof( int64_t );
+	if ( ( nullptr == blob ) || ( 0 == size ) || ( 0 != ( size % kPointSize ) ) ) {
+		return false;
+	}
+	const uint8_t* data = static_cast<const uint8_t*>( blob );
+	const auto readValue = [ &data ] ()
+	{
+		uint64_t value = 0;
+		for ( int byte = 0; byte < 8; byte++ ) {
+			value |= static_cast<uint64_t>( *data++ ) << ( 8 * byte );
+		}
+		return static_cast<int64_t>( value );
+	};
+	for ( size_t index = 0; index < size / kPointSize; index++ ) {
+		const int64_t sample = readValue();
+		const int64_t offset = readValue();
+		const int64_t hint = readValue();
+		points.insert( { sample, { offset, hint } } );
+	}
+	return true;
+}
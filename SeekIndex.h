@@ -0,0 +1,106 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "KeyedCache.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Seek point index for a file, captured while the file is being decoded, which allows decoders to seek without searching the file.
+// Indices are shared between all decoders for the same file, and can optionally be persisted using a store (such as the media library).
+class SeekIndex
+{
+public:
+	// Seek index shared pointer type.
+	using Ptr = std::shared_ptr<SeekIndex>;
+
+	// A seek point.
+	struct Point {
+		int64_t Offset = -1;  // Byte offset in the file at which decoding can be (re)started (or -1 if unknown).
+		int64_t Hint = 0;     // Codec specific state hint (e.g. a packet timestamp), or zero if not used.
+	};
+
+	// Seek points, keyed by sample position.
+	using Points = std::map<int64_t /*sample*/, Point>;
+
+	// Loads the seek 'points' for a file, returning whether any points were loaded.
+	// The file modification time & size are passed, so that any stale index can be discarded.
+	using LoadCallback = std::function<bool( const std::wstring& /*filename*/, const long long /*filetime*/, const long long /*filesize*/, Points& /*points*/ )>;
+
+	// Saves the seek 'points' for a file, along with the file modification time & size.
+	using SaveCallback = std::function<void( const std::wstring& /*filename*/, const long long /*filetime*/, const long long /*filesize*/, const Points& /*points*/ )>;
+
+	// 'filename' - file name.
+	// 'filetime' - file modification time.
+	// 'filesize' - file size.
+	SeekIndex( const std::wstring& filename, const long long filetime, const long long filesize );
+
+	virtual ~SeekIndex();
+
+	// Returns the (shared) seek index for 'filename', or nullptr if the file does not exist (e.g. for streams).
+	// Any stored seek points are loaded before the index is returned, so this should be called when a decoder is opened (rather than from the audio thread).
+	static Ptr Get( const std::wstring& filename );
+
+	// Sets the callbacks used to 'load' and 'save' seek indices (either can be nullptr).
+	static void SetStore( LoadCallback load, SaveCallback save );
+
+	// Saves all modified seek indices to the store.
+	static void SaveAll();
+
+	// Adds a seek point at the 'sample' position, unless there is already a point within 'minimumInterval' samples.
+	void Add( const int64_t sample, const Point& point, const int64_t minimumInterval );
+
+	// Returns the last seek point at or before the 'sample' position, or nullopt if there is none within 'maximumDistance' samples of the position.
+	// Decoders resume from the seek point and decode forward to the position, so the distance bounds the seek time.
+	std::optional<std::pair<int64_t /*sample*/, Point>> Find( const int64_t sample, const int64_t maximumDistance );
+
+	// Serialises seek 'points' to a binary blob.
+	static std::vector<uint8_t> Serialise( const Points& points );
+
+	// Deserialises seek points from a binary 'blob' of 'size' bytes, returning whether the blob was valid.
+	static bool Deserialise( const void* blob, const size_t size, Points& points );
+
+private:
+	// Identifies a file, along with the file modification time & size to which an index applies.
+	struct Track {
+		std::wstring Filename;
+		long long Filetime = 0;
+		long long Filesize = 0;
+	};
+
+	// Seek index cache type, keyed by file name.
+	using Cache = KeyedCache<std::wstring, Track, Ptr>;
+
+	// Returns a cache load callback, which creates a seek index containing any seek points loaded using the store 'load' callback.
+	static Cache::LoadCallback GetCacheLoadCallback( LoadCallback load );
+
+	// Returns a cache save callback, which saves the seek points of a modified seek index using the store 'save' callback.
+	static Cache::SaveCallback GetCacheSaveCallback( SaveCallback save );
+
+	// Seek index cache.
+	static Cache s_Cache;
+
+	// File name.
+	const std::wstring m_Filename;
+
+	// File modification time.
+	const long long m_Filetime;
+
+	// File size.
+	const long long m_Filesize;
+
+	// Seek points.
+	Points m_Points;
+
+	// Seek points mutex.
+	std::mutex m_Mutex;
+
+	// Indicates whether seek points have been added since the index was last loaded or saved.
+	bool m_Modified = false;
+};
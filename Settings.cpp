@@ -31,7 +31,7 @@ std::optional<T> Settings::ReadSetting( const std::string& name )
 	if ( sqlite3* database = m_Database.GetDatabase(); nullptr != database ) {
 		sqlite3_stmt* stmt = nullptr;
 		const std::string query = "SELECT Value FROM Settings WHERE Setting=?1;";
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			if ( SQLITE_OK == sqlite3_bind_text( stmt, 1, name.c_str(), -1 /*strLen*/, SQLITE_STATIC ) ) {
 				if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					constexpr int kColumnIndex = 0;
@@ -58,7 +58,7 @@ std::optional<T> Settings::ReadSetting( const std::string& name )
 					}
 				}
 			}
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 	return value;
@@ -68,9 +68,10 @@ template <typename T>
 void Settings::WriteSetting( const std::string& name, const T& value )
 {
 	if ( sqlite3* database = m_Database.GetDatabase(); nullptr != database ) {
+		const Database::WriteScope scope( m_Database );
 		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
 		sqlite3_stmt* stmt = nullptr;
-		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+		if ( SQLITE_OK == m_Database.PrepareStatement( query, &stmt ) ) {
 			sqlite3_bind_text( stmt, 1, name.c_str(), -1 /*strLen*/, SQLITE_STATIC );
 			if constexpr ( std::is_floating_point_v<T> ) {
 				sqlite3_bind_double( stmt, 2, value );
@@ -88,7 +89,7 @@ void Settings::WriteSetting( const std::string& name, const T& value )
 				static_assert( !sizeof( T ), "Settings::WriteSetting - unsupported type" );
 			}
 			sqlite3_step( stmt );
-			sqlite3_finalize( stmt );
+			m_Database.ReleaseStatement( stmt );
 		}
 	}
 }
@@ -477,6 +478,7 @@ void Settings::SetPlaylistSettings( const PlaylistColumns& columns, const bool s
 {
 	sqlite3* database = m_Database.GetDatabase();
 	if ( nullptr != database ) {
+		const Database::WriteScope scope( m_Database );
 		const std::string clearTableQuery = "DELETE FROM PlaylistColumns;";
 		sqlite3_exec( database, clearTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 
@@ -719,6 +721,7 @@ void Settings::RemovePlaylist( const Playlist& playlist )
 {
 	sqlite3* database = m_Database.GetDatabase();
 	if ( nullptr != database ) {
+		const Database::WriteScope scope( m_Database );
 		const std::string& playlistID = playlist.GetID();
 		if ( IsValidGUID( playlistID ) ) {
 			const std::string dropFilesTableQuery = "DROP TABLE \"" + playlistID + "\";";
@@ -740,6 +743,8 @@ void Settings::SavePlaylist( Playlist& playlist )
 {
 	sqlite3* database = m_Database.GetDatabase();
 	if ( nullptr != database ) {
+		// The playlist is written in its own transaction, rather than as part of any batched library transaction.
+		const Database::WriteScope scope( m_Database );
 		const std::string playlistID = ( Playlist::Type::Favourites == playlist.GetType() ) ? "Favourites" : playlist.GetID();
 		if ( IsValidGUID( playlistID ) || ( Playlist::Type::Favourites == playlist.GetType() ) ) {
 			UpdatePlaylistTable( playlistID );
@@ -1204,6 +1209,16 @@ void Settings::SetPlaybackSettings( const bool randomPlay, const bool repeatTrac
 	WriteSetting( "Crossfade", crossfade );
 }
 
+float Settings::GetSilenceThreshold()
+{
+	return std::clamp( ReadSetting<float>( "SilenceThreshold" ).value_or( MinSilenceThreshold ), MinSilenceThreshold, MaxSilenceThreshold );
+}
+
+void Settings::SetSilenceThreshold( const float threshold )
+{
+	WriteSetting( "SilenceThreshold", std::clamp( threshold, MinSilenceThreshold, MaxSilenceThreshold ) );
+}
+
 void Settings::GetHotkeySettings( bool& enable, HotkeyList& hotkeys )
 {
 	enable = false;
@@ -1256,6 +1271,7 @@ void Settings::SetHotkeySettings( const bool enable, const HotkeyList& hotkeys )
 {
 	sqlite3* database = m_Database.GetDatabase();
 	if ( nullptr != database ) {
+		const Database::WriteScope scope( m_Database );
 		sqlite3_stmt* stmt = nullptr;
 		std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
 		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
@@ -42,7 +42,8 @@ public:
 	enum class OutputMode {
 		Standard,
 		WASAPIExclusive,
-		ASIO
+		ASIO,
+		Null      // Headless output, without an audio device (only selectable from the command line, so never stored).
 	};
 
 	// Gain mode.
@@ -438,6 +439,18 @@ public:
 	// 'crossfade' - whether crossfade is enabled.
 	void SetPlaybackSettings( const bool randomPlay, const bool repeatTrack, const bool repeatPlaylist, const bool crossfade );
 
+	// Minimum silence threshold, in dBFS.
+	static constexpr float MinSilenceThreshold = -120.0f;
+
+	// Maximum silence threshold, in dBFS.
+	static constexpr float MaxSilenceThreshold = -40.0f;
+
+	// Gets the level, in dBFS, at or below which samples are considered to be silent when skipping leading silence.
+	float GetSilenceThreshold();
+
+	// Sets the level, in dBFS, at or below which samples are considered to be silent when skipping leading silence.
+	void SetSilenceThreshold( const float threshold );
+
 	// Gets hotkey settings.
 	// 'enable' - out, whether hotkeys are enabled.
 	// 'hotkeys' - out, hotkeys.
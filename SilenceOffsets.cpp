@@ -0,0 +1,52 @@
+#include "SilenceOffsets.h"
+
+#include "Utility.h"
+
+// Maximum number of tracks for which silence offsets are kept in memory.
+constexpr size_t kCacheSize = 1024;
+
+KeyedCache<SilenceOffsets::Key, SilenceOffsets::Track, SilenceOffsets::Offsets> SilenceOffsets::s_Cache( kCacheSize );
+
+std::optional<SilenceOffsets::Track> SilenceOffsets::GetTrack( const MediaInfo& mediaInfo )
+{
+	if ( ( MediaInfo::Source::File != mediaInfo.GetSource() ) || mediaInfo.GetFilename().empty() || IsURL( mediaInfo.GetFilename() ) ) {
+		return std::nullopt;
+	}
+	Track track;
+	track.Filename = mediaInfo.GetFilename();
+	track.CueStart = mediaInfo.GetCueStart().value_or( -1 );
+	track.CueEnd = mediaInfo.GetCueEnd().value_or( -1 );
+	track.Filetime = mediaInfo.GetFiletime();
+	track.Filesize = mediaInfo.GetFilesize();
+	return track;
+}
+
+std::optional<SilenceOffsets::Offsets> SilenceOffsets::Get( const MediaInfo& mediaInfo, const float threshold )
+{
+	std::optional<Offsets> offsets;
+	if ( const auto track = GetTrack( mediaInfo ); track ) {
+		offsets = s_Cache.Get( { track->Filename, track->CueStart, track->CueEnd }, *track );
+		if ( offsets && ( offsets->Threshold != threshold ) ) {
+			// The offsets were detected using a different threshold.
+			offsets.reset();
+		}
+	}
+	return offsets;
+}
+
+void SilenceOffsets::Set( const MediaInfo& mediaInfo, const Offsets& offsets )
+{
+	if ( const auto track = GetTrack( mediaInfo ); track ) {
+		s_Cache.Set( { track->Filename, track->CueStart, track->CueEnd }, *track, offsets );
+	}
+}
+
+void SilenceOffsets::SetStore( LoadCallback load, SaveCallback save )
+{
+	s_Cache.SetStore( load, save );
+}
+
+void SilenceOffsets::SaveAll()
+{
+	s_Cache.SaveAll();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "KeyedCache.h"
+#include "MediaInfo.h"
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <tuple>
+
+// Leading & trailing silence offsets for tracks, which allow playback & crossfade calculations to seek past silence without decoding it.
+// Offsets are cached in memory, and can optionally be persisted using a store (such as the media library).
+class SilenceOffsets
+{
+public:
+	// Silence offsets for a track, in sample frames relative to the start of the track.
+	struct Offsets {
+		float Threshold = 0;              // Sample magnitude at or below which a sample was considered to be silent.
+		int64_t Leading = 0;              // Number of leading silent frames (i.e. the position of the first non-silent frame).
+		std::optional<int64_t> Trailing;  // Position following the last non-silent frame, or nullopt if not yet known.
+	};
+
+	// Identifies a track, along with the file modification time & size to which any offsets apply.
+	struct Track {
+		std::wstring Filename;
+		long CueStart = -1;       // Cue start position, or -1 if not applicable.
+		long CueEnd = -1;         // Cue end position, or -1 if not applicable.
+		long long Filetime = 0;
+		long long Filesize = 0;
+	};
+
+	// Loads the silence 'offsets' for a 'track', returning whether any offsets were loaded.
+	using LoadCallback = std::function<bool( const Track& /*track*/, Offsets& /*offsets*/ )>;
+
+	// Saves the silence 'offsets' for a 'track'.
+	using SaveCallback = std::function<void( const Track& /*track*/, const Offsets& /*offsets*/ )>;
+
+	// Returns the silence offsets for the 'mediaInfo' track, or nullopt if offsets detected using the 'threshold' are not known.
+	static std::optional<Offsets> Get( const MediaInfo& mediaInfo, const float threshold );
+
+	// Sets the silence 'offsets' for the 'mediaInfo' track.
+	static void Set( const MediaInfo& mediaInfo, const Offsets& offsets );
+
+	// Sets the callbacks used to 'load' and 'save' silence offsets (either can be nullptr).
+	static void SetStore( LoadCallback load, SaveCallback save );
+
+	// Saves all modified silence offsets to the store.
+	static void SaveAll();
+
+	// Returns the track corresponding to 'mediaInfo', or nullopt if the track is not a local file (and so cannot be analysed in advance).
+	static std::optional<Track> GetTrack( const MediaInfo& mediaInfo );
+
+private:
+	// Cache key, consisting of the file name, cue start & cue end.
+	using Key = std::tuple<std::wstring, long, long>;
+
+	// Silence offsets cache.
+	static KeyedCache<Key, Track, Offsets> s_Cache;
+};
@@ -1,11 +1,21 @@
 #include "SpectrumAnalyser.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 // Render thread millisecond interval.
 static const DWORD s_RenderThreadInterval = 15;
 
 // Decay factor.
 static const int s_DecayFactor = 40;
 
+// Whether each bar shows the maximum, rather than the mean, of the FFT bins it covers.
+static const bool s_BarMaximum = true;
+
+// Exponent which maps bar positions onto FFT bins (lower values give more of the width to lower frequencies).
+static const double s_BinExponent = 0.38;
+
 DWORD WINAPI SpectrumAnalyser::RenderThreadProc( LPVOID lpParam )
 {
 	SpectrumAnalyser* analyser = reinterpret_cast<SpectrumAnalyser*>( lpParam );
@@ -19,7 +29,13 @@ SpectrumAnalyser::SpectrumAnalyser( WndVisual& wndVisual ) :
 	Visual( wndVisual ),
 	m_RenderThread( NULL ),
 	m_RenderStopEvent( CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
-	m_Values()
+	m_Values(),
+	m_FFT(),
+	m_Bars(),
+	m_BarsWidth( 0 ),
+	m_BarsBarWidth( 0 ),
+	m_BarsFFTSize( 0 ),
+	m_Log10()
 {
 }
 
@@ -87,9 +103,8 @@ void SpectrumAnalyser::OnPaint()
 				m_Colour->SetStartPoint( D2D1::Point2F( 0, 0 ) );
 				m_Colour->SetEndPoint( D2D1::Point2F( 0, targetSize.height ) );
 
-				std::vector<float> fft;
-				GetOutput().GetFFTData( fft );
-				const size_t fftSize = fft.size();
+				GetOutput().GetFFTData( m_FFT );
+				const size_t fftSize = m_FFT.size();
 				if ( fftSize > 0 ) {
 					const long width = static_cast<long>( targetSize.width );
 
@@ -100,22 +115,26 @@ void SpectrumAnalyser::OnPaint()
 					const float decay = targetSize.height / s_DecayFactor;
 
 					const long barWidth = static_cast<long>( 3 * GetDPIScalingFactor() );
-					for ( long pos = 1; ( pos < width ); pos += barWidth ) {
-						const size_t bin = std::lround( pow( static_cast<float>( fftSize - 1 ), pow( ( static_cast<float>( pos ) / width ), 0.38 ) ) );
-						const float value = fft.at( bin );
-						float y = ( -targetSize.height / 4.0f ) * ( ( value < 0.0001 ) ? -4.0f : log10f( value ) );
-
-						if ( y < m_Values.at( pos ) ) {
-							m_Values.at( pos ) = y;
+					UpdateBars( width, barWidth, fftSize );
+					auto bar = m_Bars.begin();
+					for ( long pos = 1; ( pos < width ); pos += barWidth, ++bar ) {
+						const auto first = m_FFT.begin() + bar->first;
+						const auto last = m_FFT.begin() + bar->second;
+						const float value = s_BarMaximum ? *std::max_element( first, last ) : ( std::accumulate( first, last, 0.0f ) / ( bar->second - bar->first ) );
+						float y = ( -targetSize.height / 4.0f ) * std::max( -4.0f, m_Log10( value ) );
+
+						float& currentValue = m_Values[ pos ];
+						if ( y < currentValue ) {
+							currentValue = y;
 						} else {
-							m_Values.at( pos ) += decay;
-							if ( m_Values.at( pos ) > y ) {
-								m_Values.at( pos ) = y;
+							currentValue += decay;
+							if ( currentValue > y ) {
+								currentValue = y;
 							}
-							if ( m_Values.at( pos ) > targetSize.height ) {
-								m_Values.at( pos ) = targetSize.height;
+							if ( currentValue > targetSize.height ) {
+								currentValue = targetSize.height;
 							}
-							y = m_Values.at( pos );
+							y = currentValue;
 						}
 
 						const D2D1_RECT_F rect = D2D1::RectF( static_cast<FLOAT>( pos - 1 ) /*left*/, y /*top*/, static_cast<FLOAT>( pos + 1 ) /*right*/, targetSize.height );
@@ -128,6 +147,26 @@ void SpectrumAnalyser::OnPaint()
 	}
 }
 
+void SpectrumAnalyser::UpdateBars( const long width, const long barWidth, const size_t fftSize )
+{
+	if ( ( width == m_BarsWidth ) && ( barWidth == m_BarsBarWidth ) && ( fftSize == m_BarsFFTSize ) ) {
+		return;
+	}
+	m_BarsWidth = width;
+	m_BarsBarWidth = barWidth;
+	m_BarsFFTSize = fftSize;
+	m_Bars.clear();
+	const auto getBin = [ width, fftSize ] ( const long pos )
+	{
+		return static_cast<size_t>( std::lround( std::pow( static_cast<double>( fftSize - 1 ), std::pow( static_cast<double>( pos ) / width, s_BinExponent ) ) ) );
+	};
+	for ( long pos = 1; ( pos < width ); pos += barWidth ) {
+		const size_t firstBin = std::min( getBin( pos ), fftSize - 1 );
+		const size_t lastBin = std::clamp( getBin( pos + barWidth ), firstBin + 1, fftSize );
+		m_Bars.push_back( { firstBin, lastBin } );
+	}
+}
+
 void SpectrumAnalyser::OnSettingsChange()
 {
 	FreeResources();
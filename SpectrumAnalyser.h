@@ -2,6 +2,10 @@
 
 #include "Visual.h"
 
+#include "FFT.h"
+
+#include <utility>
+
 class SpectrumAnalyser : public Visual
 {
 public:
@@ -44,6 +48,9 @@ private:
 	// Stops the rendering thread.
 	void StopRenderThread();
 
+	// Updates the FFT bin range covered by each bar, if the 'width', 'barWidth' or 'fftSize' have changed.
+	void UpdateBars( const long width, const long barWidth, const size_t fftSize );
+
 	// Loads the resources using the 'deviceContext'.
 	void LoadResources( ID2D1DeviceContext* deviceContext );
 
@@ -61,4 +68,22 @@ private:
 
 	// Spectrum values.
 	std::vector<float> m_Values;
+
+	// FFT magnitudes.
+	std::vector<float> m_FFT;
+
+	// FFT bin range covered by each bar, as a half open range [first, last).
+	std::vector<std::pair<size_t, size_t>> m_Bars;
+
+	// Width for which the bars were calculated.
+	long m_BarsWidth;
+
+	// Bar width for which the bars were calculated.
+	long m_BarsBarWidth;
+
+	// FFT size for which the bars were calculated.
+	size_t m_BarsFFTSize;
+
+	// Base 10 logarithm lookup.
+	Log10Lookup m_Log10;
 };
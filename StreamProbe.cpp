@@ -0,0 +1,560 @@
+#include "StreamProbe.h"
+
+#include "OggPage.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <span>
+
+// Size of the region at the end of an Ogg file which is searched for the last page.
+constexpr uint64_t kOggTailSize = 0x10000;
+
+// Maximum number of WavPack blocks to search for the first audio block.
+constexpr int kMaxWavPackBlocks = 16;
+
+// Maximum number of MP4 box sample sizes to sum, when calculating the bitrate.
+constexpr uint32_t kMaxMP4SampleSizes = 0x100000;
+
+// MP4 edit list media rate for normal playback (as a 16.16 fixed point value).
+constexpr uint32_t kMP4NormalMediaRate = 0x00010000;
+
+// WavPack block header flags.
+constexpr uint32_t kWavPackBytesStoredMask = 0x3;
+constexpr uint32_t kWavPackMonoFlag = 0x4;
+constexpr uint32_t kWavPackFloatFlag = 0x80;
+constexpr uint32_t kWavPackInitialBlock = 0x800;
+constexpr uint32_t kWavPackFinalBlock = 0x1000;
+constexpr uint32_t kWavPackShiftLSB = 13;
+constexpr uint32_t kWavPackShiftMask = 0x1f << kWavPackShiftLSB;
+constexpr uint32_t kWavPackSampleRateLSB = 23;
+constexpr uint32_t kWavPackSampleRateMask = 0xf << kWavPackSampleRateLSB;
+constexpr uint32_t kWavPackFalseStereo = 0x40000000;
+constexpr uint32_t kWavPackDSDFlag = 0x80000000;
+
+// WavPack standard sample rates, indexed by the block header sample rate field.
+constexpr std::array<long, 15> kWavPackSampleRates = { 6000, 8000, 9600, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 64000, 88200, 96000, 192000 };
+
+// AAC sample rates, indexed by the audio specific config sampling frequency index.
+constexpr std::array<long, 13> kAACSampleRates = { 96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350 };
+
+// WAVE format tags.
+constexpr uint16_t kWaveFormatPCM = 0x0001;
+constexpr uint16_t kWaveFormatFloat = 0x0003;
+constexpr uint16_t kWaveFormatExtensible = 0xfffe;
+
+static uint16_t ReadLE16( const uint8_t* data )
+{
+	return static_cast<uint16_t>( data[ 0 ] | ( data[ 1 ] << 8 ) );
+}
+
+static uint32_t ReadLE32( const uint8_t* data )
+{
+	return static_cast<uint32_t>( data[ 0 ] ) | ( static_cast<uint32_t>( data[ 1 ] ) << 8 ) | ( static_cast<uint32_t>( data[ 2 ] ) << 16 ) | ( static_cast<uint32_t>( data[ 3 ] ) << 24 );
+}
+
+static uint16_t ReadBE16( const uint8_t* data )
+{
+	return static_cast<uint16_t>( ( data[ 0 ] << 8 ) | data[ 1 ] );
+}
+
+static uint32_t ReadBE32( const uint8_t* data )
+{
+	return ( static_cast<uint32_t>( data[ 0 ] ) << 24 ) | ( static_cast<uint32_t>( data[ 1 ] ) << 16 ) | ( static_cast<uint32_t>( data[ 2 ] ) << 8 ) | static_cast<uint32_t>( data[ 3 ] );
+}
+
+static uint64_t ReadBE64( const uint8_t* data )
+{
+	return ( static_cast<uint64_t>( ReadBE32( data ) ) << 32 ) | ReadBE32( data + 4 );
+}
+
+std::optional<StreamProbe::Info> StreamProbe::Validate( const Info& info )
+{
+	return ( ( info.SampleRate > 0 ) && ( info.Channels > 0 ) && ( info.Duration > 0 ) ) ? std::make_optional( info ) : std::nullopt;
+}
+
+std::optional<uint64_t> StreamProbe::GetFLACAudioOffset( FileSource& source )
+{
+	const uint64_t filesize = source.GetSize();
+	if ( const auto marker = source.GetSpan( 0, 4 ); ( 4 == marker.size() ) && ( 0 == memcmp( marker.data(), "fLaC", 4 ) ) ) {
+		uint64_t blockPos = 4;
+		for ( auto block = source.GetSpan( blockPos, 4 ); 4 == block.size(); block = source.GetSpan( blockPos, 4 ) ) {
+			const uint64_t currentPos = blockPos + 4;
+			const unsigned long blockSize = ( static_cast<unsigned long>( block[ 1 ] ) << 16 ) | ( static_cast<unsigned long>( block[ 2 ] ) << 8 ) | block[ 3 ];
+			if ( ( currentPos + blockSize ) >= filesize ) {
+				break;
+			}
+			const bool lastBlock = block[ 0 ] & 0x80;
+			if ( lastBlock ) {
+				return currentPos + blockSize;
+			}
+			blockPos = currentPos + blockSize;
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<StreamProbe::Info> StreamProbe::ProbeFLAC( const std::wstring& filename )
+{
+	FileSource::Ptr source = FileSource::Open( filename );
+	if ( !source ) {
+		return std::nullopt;
+	}
+
+	// The STREAMINFO block is required to be the first metadata block.
+	constexpr size_t kHeaderSize = 4 /*marker*/ + 4 /*blockHeader*/ + 34 /*streamInfo*/;
+	const auto header = source->GetSpan( 0, kHeaderSize );
+	if ( ( kHeaderSize != header.size() ) || ( 0 != memcmp( header.data(), "fLaC", 4 ) ) || ( 0 != ( header[ 4 ] & 0x7f ) ) ) {
+		return std::nullopt;
+	}
+
+	// Sample rate (20 bits), channels - 1 (3 bits), bits per sample - 1 (5 bits), total samples (36 bits).
+	const uint64_t properties = ReadBE64( header.data() + 18 );
+	Info info;
+	info.SampleRate = static_cast<long>( properties >> 44 );
+	info.Channels = static_cast<long>( ( ( properties >> 41 ) & 0x7 ) + 1 );
+	info.BitsPerSample = static_cast<long>( ( ( properties >> 36 ) & 0x1f ) + 1 );
+	const uint64_t totalSamples = properties & 0xfffffffffull;
+	if ( info.SampleRate > 0 ) {
+		info.Duration = static_cast<float>( totalSamples ) / info.SampleRate;
+	}
+	if ( const auto audioOffset = GetFLACAudioOffset( *source ); audioOffset && ( info.Duration > 0 ) ) {
+		const long long streamsize = static_cast<long long>( source->GetSize() - *audioOffset );
+		info.Bitrate = ( streamsize * 8 ) / ( info.Duration * 1000 );
+	}
+	return Validate( info );
+}
+
+std::optional<StreamProbe::Info> StreamProbe::ProbeOpus( const std::wstring& filename )
+{
+	FileSource::Ptr source = FileSource::Open( filename );
+	if ( !source ) {
+		return std::nullopt;
+	}
+
+	try {
+		// The first page contains only the identification header.
+		const OggPage firstPage( *source );
+		const auto& head = firstPage.GetContent();
+		if ( !firstPage.IsBOS() || ( head.size() < 19 ) || ( 0 != memcmp( head.data(), "OpusHead", 8 ) ) ) {
+			return std::nullopt;
+		}
+		const long channels = head[ 9 ];
+		const uint16_t preSkip = ReadLE16( head.data() + 10 );
+		const uint32_t serial = firstPage.GetSerialNumber();
+
+		// Find the last page in the file, which should belong to the same logical stream (otherwise the file is chained or multiplexed).
+		const uint64_t filesize = source->GetSize();
+		const uint64_t tailStart = ( filesize > kOggTailSize ) ? ( filesize - kOggTailSize ) : 0;
+		const auto tail = source->GetSpan( tailStart, static_cast<size_t>( filesize - tailStart ) );
+		const std::vector<uint8_t> tailData( tail.begin(), tail.end() );
+		for ( size_t offset = tailData.size(); offset-- > 0; ) {
+			if ( ( ( offset + 27 ) <= tailData.size() ) && ( 0 == memcmp( tailData.data() + offset, "OggS", 4 ) ) ) {
+				source->SetPosition( tailStart + offset );
+				try {
+					const OggPage lastPage( *source );
+					const uint64_t granule = lastPage.GetGranulePosition();
+					if ( ( lastPage.GetSerialNumber() != serial ) || ( granule <= preSkip ) ) {
+						return std::nullopt;
+					}
+					if ( granule != static_cast<uint64_t>( -1 ) ) {
+						Info info;
+						info.SampleRate = 48000;
+						info.Channels = channels;
+						info.Duration = static_cast<float>( granule - preSkip ) / 48000;
+						info.Bitrate = static_cast<float>( filesize * 8 ) / ( info.Duration * 1000 );
+						return Validate( info );
+					}
+				} catch ( const std::runtime_error& ) {
+					// Not a valid page, so keep searching.
+				}
+			}
+		}
+	} catch ( const std::runtime_error& ) {
+	}
+	return std::nullopt;
+}
+
+std::optional<StreamProbe::Info> StreamProbe::ProbeWavPack( const std::wstring& filename )
+{
+	FileSource::Ptr source = FileSource::Open( filename );
+	if ( !source ) {
+		return std::nullopt;
+	}
+
+	// Find the first block containing audio, which is required to hold all the channels (multichannel files need the channel info metadata).
+	constexpr size_t kHeaderSize = 32;
+	uint64_t blockPos = 0;
+	for ( int blockCount = 0; blockCount < kMaxWavPackBlocks; blockCount++ ) {
+		const auto header = source->GetSpan( blockPos, kHeaderSize );
+		if ( ( kHeaderSize != header.size() ) || ( 0 != memcmp( header.data(), "wvpk", 4 ) ) ) {
+			break;
+		}
+		const uint32_t blockSize = ReadLE32( header.data() + 4 );
+		const uint32_t totalSamplesLow = ReadLE32( header.data() + 12 );
+		const uint32_t blockSamples = ReadLE32( header.data() + 20 );
+		const uint32_t flags = ReadLE32( header.data() + 24 );
+		if ( blockSamples > 0 ) {
+			const uint32_t rateIndex = ( flags & kWavPackSampleRateMask ) >> kWavPackSampleRateLSB;
+			const bool singleBlock = ( kWavPackInitialBlock | kWavPackFinalBlock ) == ( flags & ( kWavPackInitialBlock | kWavPackFinalBlock ) );
+			if ( !singleBlock || ( flags & kWavPackDSDFlag ) || ( rateIndex >= kWavPackSampleRates.size() ) || ( 0xffffffff == totalSamplesLow ) ) {
+				break;
+			}
+			const uint64_t totalSamples = ( static_cast<uint64_t>( header[ 11 ] ) << 32 ) | totalSamplesLow;
+			Info info;
+			info.SampleRate = kWavPackSampleRates[ rateIndex ];
+			info.Channels = ( ( flags & kWavPackMonoFlag ) && !( flags & kWavPackFalseStereo ) ) ? 1 : 2;
+			info.BitsPerSample = ( flags & kWavPackFloatFlag ) ? 32 : static_cast<long>( ( ( flags & kWavPackBytesStoredMask ) + 1 ) * 8 - ( ( flags & kWavPackShiftMask ) >> kWavPackShiftLSB ) );
+			info.Duration = static_cast<float>( totalSamples ) / info.SampleRate;
+			if ( info.Duration > 0 ) {
+				// Include any correction file, as for the decoder.
+				std::error_code ec;
+				const uintmax_t correctionSize = std::filesystem::file_size( filename + L"c", ec );
+				const uint64_t totalSize = source->GetSize() + ( ec ? 0 : correctionSize );
+				info.Bitrate = static_cast<float>( totalSize * 8 ) / ( info.Duration * 1000 );
+			}
+			return Validate( info );
+		}
+		blockPos += 8 + static_cast<uint64_t>( blockSize );
+	}
+	return std::nullopt;
+}
+
+std::optional<StreamProbe::Info> StreamProbe::ProbeRIFF( const std::wstring& filename )
+{
+	FileSource::Ptr source = FileSource::Open( filename );
+	if ( !source ) {
+		return std::nullopt;
+	}
+
+	const auto riff = source->GetSpan( 0, 12 );
+	if ( ( 12 != riff.size() ) || ( 0 != memcmp( riff.data(), "RIFF", 4 ) ) || ( 0 != memcmp( riff.data() + 8, "WAVE", 4 ) ) ) {
+		return std::nullopt;
+	}
+
+	Info info;
+	uint16_t blockAlign = 0;
+	bool hasFormat = false;
+	const uint64_t filesize = source->GetSize();
+	uint64_t chunkPos = 12;
+	for ( auto chunk = source->GetSpan( chunkPos, 8 ); 8 == chunk.size(); chunk = source->GetSpan( chunkPos, 8 ) ) {
+		const uint32_t chunkSize = ReadLE32( chunk.data() + 4 );
+		if ( 0 == memcmp( chunk.data(), "fmt ", 4 ) ) {
+			const auto format = source->GetSpan( chunkPos + 8, std::min<uint32_t>( chunkSize, 40 ) );
+			if ( format.size() < 16 ) {
+				return std::nullopt;
+			}
+			uint16_t formatTag = ReadLE16( format.data() );
+			if ( ( kWaveFormatExtensible == formatTag ) && ( format.size() >= 26 ) ) {
+				// The first two bytes of the sub-format GUID hold the format tag.
+				formatTag = ReadLE16( format.data() + 24 );
+			}
+			if ( ( kWaveFormatPCM != formatTag ) && ( kWaveFormatFloat != formatTag ) ) {
+				return std::nullopt;
+			}
+			info.Channels = ReadLE16( format.data() + 2 );
+			info.SampleRate = static_cast<long>( ReadLE32( format.data() + 4 ) );
+			info.Bitrate = static_cast<float>( ReadLE32( format.data() + 8 ) ) * 8 / 1000;
+			blockAlign = ReadLE16( format.data() + 12 );
+			info.BitsPerSample = ReadLE16( format.data() + 14 );
+			hasFormat = true;
+		} else if ( 0 == memcmp( chunk.data(), "data", 4 ) ) {
+			if ( !hasFormat || ( 0 == blockAlign ) || ( info.SampleRate <= 0 ) ) {
+				return std::nullopt;
+			}
+			// Allow for files with an unset or overlong data chunk size.
+			const uint64_t dataSize = std::min<uint64_t>( chunkSize, filesize - ( chunkPos + 8 ) );
+			info.Duration = static_cast<float>( dataSize / blockAlign ) / info.SampleRate;
+			return Validate( info );
+		}
+		chunkPos += 8 + static_cast<uint64_t>( chunkSize ) + ( chunkSize & 1 );
+	}
+	return std::nullopt;
+}
+
+// MP4 box.
+struct MP4Box {
+	// Offset of the box content.
+	uint64_t Offset = 0;
+
+	// Size of the box content.
+	uint64_t Size = 0;
+};
+
+// Finds the first box of the 'type' within the 'parent' box, returning nullopt if there is no match.
+static std::optional<MP4Box> FindMP4Box( FileSource& source, const MP4Box& parent, const char* type )
+{
+	uint64_t position = parent.Offset;
+	const uint64_t end = parent.Offset + parent.Size;
+	while ( ( position + 8 ) <= end ) {
+		const auto header = source.GetSpan( position, 16 );
+		if ( header.size() < 8 ) {
+			break;
+		}
+		uint64_t boxSize = ReadBE32( header.data() );
+		uint64_t headerSize = 8;
+		if ( 1 == boxSize ) {
+			if ( header.size() < 16 ) {
+				break;
+			}
+			boxSize = ReadBE64( header.data() + 8 );
+			headerSize = 16;
+		} else if ( 0 == boxSize ) {
+			boxSize = end - position;
+		}
+		if ( ( boxSize < headerSize ) || ( ( position + boxSize ) > end ) ) {
+			break;
+		}
+		if ( 0 == memcmp( header.data() + 4, type, 4 ) ) {
+			return MP4Box{ position + headerSize, boxSize - headerSize };
+		}
+		position += boxSize;
+	}
+	return std::nullopt;
+}
+
+// Finds the box at the nested 'path' of box types, starting from the 'parent' box.
+static std::optional<MP4Box> FindMP4Box( FileSource& source, const MP4Box& parent, const std::initializer_list<const char*> path )
+{
+	std::optional<MP4Box> box = parent;
+	for ( auto type = path.begin(); box && ( path.end() != type ); type++ ) {
+		box = FindMP4Box( source, *box, *type );
+	}
+	return box;
+}
+
+// Reads the time scale & duration from an MP4 movie or media header 'box', returning nullopt if the header could not be read or the duration is unknown.
+static std::optional<std::pair<uint32_t, uint64_t>> ReadMP4Header( FileSource& source, const MP4Box& box )
+{
+	const auto header = source.GetSpan( box.Offset, 32 );
+	if ( header.size() < 24 ) {
+		return std::nullopt;
+	}
+	const bool version1 = ( 1 == header[ 0 ] );
+	if ( version1 && ( header.size() < 32 ) ) {
+		return std::nullopt;
+	}
+	const uint32_t timescale = ReadBE32( header.data() + ( version1 ? 20 : 12 ) );
+	const uint64_t duration = version1 ? ReadBE64( header.data() + 24 ) : ReadBE32( header.data() + 16 );
+	if ( ( 0 == timescale ) || ( 0 == duration ) || ( static_cast<uint64_t>( -1 ) == duration ) || ( !version1 && ( 0xffffffff == duration ) ) ) {
+		return std::nullopt;
+	}
+	return std::make_pair( timescale, duration );
+}
+
+// Returns the duration, in seconds, of the media presented by an MP4 edit list 'box'.
+// 'movieTimescale' - movie time scale, in which the edit duration is expressed.
+// 'mediaTimescale' - media time scale, in which the edit media time is expressed.
+// 'mediaDuration' - media duration, in the media time scale.
+// Only a single edit of the media at the normal rate is supported (as written by encoders to skip the encoder delay & padding),
+// otherwise nullopt is returned, so that the duration is determined by a decoder.
+static std::optional<double> ReadMP4EditDuration( FileSource& source, const MP4Box& box, const uint32_t movieTimescale, const uint32_t mediaTimescale, const uint64_t mediaDuration )
+{
+	const auto header = source.GetSpan( box.Offset, 8 );
+	if ( 8 != header.size() ) {
+		return std::nullopt;
+	}
+	const bool version1 = ( 1 == header[ 0 ] );
+	const uint32_t entryCount = ReadBE32( header.data() + 4 );
+	const size_t entrySize = version1 ? 20 : 12;
+	const auto entry = ( 1 == entryCount ) ? source.GetSpan( box.Offset + 8, entrySize ) : std::span<const uint8_t>();
+	if ( ( entrySize != entry.size() ) || ( box.Size < ( 8 + entrySize ) ) ) {
+		return std::nullopt;
+	}
+	const uint64_t segmentDuration = version1 ? ReadBE64( entry.data() ) : ReadBE32( entry.data() );
+	const int64_t mediaTime = version1 ? static_cast<int64_t>( ReadBE64( entry.data() + 8 ) ) : static_cast<int32_t>( ReadBE32( entry.data() + 4 ) );
+	const uint32_t mediaRate = ReadBE32( entry.data() + ( version1 ? 16 : 8 ) );
+	if ( ( 0 == segmentDuration ) || ( mediaTime < 0 ) || ( static_cast<uint64_t>( mediaTime ) >= mediaDuration ) || ( kMP4NormalMediaRate != mediaRate ) ) {
+		return std::nullopt;
+	}
+
+	// The edit should not extend beyond the end of the media (allowing for rounding to the movie time scale).
+	const double duration = static_cast<double>( segmentDuration ) / movieTimescale;
+	const double remaining = static_cast<double>( mediaDuration - mediaTime ) / mediaTimescale;
+	if ( duration > ( remaining + 1.0 / movieTimescale ) ) {
+		return std::nullopt;
+	}
+	return duration;
+}
+
+// Reads an MPEG-4 descriptor header at the 'position' within the 'data', returning the descriptor tag and size, and advancing the position past the header.
+static std::optional<std::pair<uint8_t, uint32_t>> ReadMP4Descriptor( const std::span<const uint8_t> data, size_t& position )
+{
+	if ( position >= data.size() ) {
+		return std::nullopt;
+	}
+	const uint8_t tag = data[ position++ ];
+	uint32_t size = 0;
+	for ( int count = 0; count < 4; count++ ) {
+		if ( position >= data.size() ) {
+			return std::nullopt;
+		}
+		const uint8_t value = data[ position++ ];
+		size = ( size << 7 ) | ( value & 0x7f );
+		if ( 0 == ( value & 0x80 ) ) {
+			break;
+		}
+	}
+	return std::make_pair( tag, size );
+}
+
+// Reads the sample rate & channel count from an AAC elementary stream descriptor, accepting only AAC-LC streams.
+static bool ReadAACConfig( const std::span<const uint8_t> esds, long& sampleRate, long& channels )
+{
+	// Skip the version & flags.
+	size_t position = 4;
+	const auto esDescriptor = ReadMP4Descriptor( esds, position );
+	if ( !esDescriptor || ( 0x03 != esDescriptor->first ) || ( ( position + 3 ) > esds.size() ) ) {
+		return false;
+	}
+	position += 2 /*esID*/;
+	const uint8_t esFlags = esds[ position++ ];
+	if ( esFlags & 0x80 ) {
+		position += 2 /*dependsOnID*/;
+	}
+	if ( esFlags & 0x40 ) {
+		if ( position >= esds.size() ) {
+			return false;
+		}
+		position += 1 + esds[ position ] /*url*/;
+	}
+	if ( esFlags & 0x20 ) {
+		position += 2 /*ocrID*/;
+	}
+
+	const auto decoderConfig = ReadMP4Descriptor( esds, position );
+	if ( !decoderConfig || ( 0x04 != decoderConfig->first ) || ( ( position + 13 ) > esds.size() ) || ( 0x40 != esds[ position ] ) ) {
+		return false;
+	}
+	position += 13;
+
+	const auto specificInfo = ReadMP4Descriptor( esds, position );
+	if ( !specificInfo || ( 0x05 != specificInfo->first ) || ( specificInfo->second < 2 ) || ( ( position + 2 ) > esds.size() ) ) {
+		return false;
+	}
+
+	// Audio object type (5 bits), sampling frequency index (4 bits), channel configuration (4 bits).
+	const uint16_t config = ReadBE16( esds.data() + position );
+	const uint32_t objectType = config >> 11;
+	const uint32_t frequencyIndex = ( config >> 7 ) & 0xf;
+	const uint32_t channelConfig = ( config >> 3 ) & 0xf;
+	if ( ( 2 != objectType ) || ( frequencyIndex >= kAACSampleRates.size() ) || ( 0 == channelConfig ) || ( channelConfig > 7 ) ) {
+		return false;
+	}
+
+	// Streams at lower sample rates might use implicitly signalled SBR, which can only be detected by decoding.
+	sampleRate = kAACSampleRates[ frequencyIndex ];
+	if ( sampleRate <= 24000 ) {
+		return false;
+	}
+	channels = ( 7 == channelConfig ) ? 8 : static_cast<long>( channelConfig );
+	return true;
+}
+
+std::optional<StreamProbe::Info> StreamProbe::ProbeMP4( const std::wstring& filename )
+{
+	FileSource::Ptr source = FileSource::Open( filename );
+	if ( !source ) {
+		return std::nullopt;
+	}
+
+	const MP4Box file = { 0, source->GetSize() };
+	const auto ftyp = FindMP4Box( *source, file, "ftyp" );
+	const auto moov = ftyp ? FindMP4Box( *source, file, "moov" ) : std::nullopt;
+	if ( !moov ) {
+		return std::nullopt;
+	}
+
+	// Find the first sound track.
+	uint64_t position = moov->Offset;
+	while ( const auto trak = FindMP4Box( *source, { position, moov->Offset + moov->Size - position }, "trak" ) ) {
+		position = trak->Offset + trak->Size;
+		const auto mdia = FindMP4Box( *source, *trak, "mdia" );
+		const auto hdlr = mdia ? FindMP4Box( *source, *mdia, "hdlr" ) : std::nullopt;
+		if ( const auto handler = hdlr ? source->GetSpan( hdlr->Offset, 12 ) : std::span<const uint8_t>(); ( 12 != handler.size() ) || ( 0 != memcmp( handler.data() + 8, "soun", 4 ) ) ) {
+			continue;
+		}
+
+		Info info;
+
+		// Media header, containing the time scale & duration.
+		const auto mdhd = FindMP4Box( *source, *mdia, "mdhd" );
+		const auto mediaHeader = mdhd ? ReadMP4Header( *source, *mdhd ) : std::nullopt;
+		if ( !mediaHeader ) {
+			return std::nullopt;
+		}
+		const auto [timescale, duration] = *mediaHeader;
+		info.Duration = static_cast<float>( static_cast<double>( duration ) / timescale );
+
+		// An edit list trims the encoder delay & padding from the media, which the decoders apply to the duration.
+		if ( const auto elst = FindMP4Box( *source, *trak, { "edts", "elst" } ); elst ) {
+			const auto mvhd = FindMP4Box( *source, *moov, "mvhd" );
+			const auto movieHeader = mvhd ? ReadMP4Header( *source, *mvhd ) : std::nullopt;
+			const auto editDuration = movieHeader ? ReadMP4EditDuration( *source, *elst, movieHeader->first, timescale, duration ) : std::nullopt;
+			if ( !editDuration ) {
+				return std::nullopt;
+			}
+			info.Duration = static_cast<float>( *editDuration );
+		}
+
+		// Sample description, which should contain a single audio sample entry.
+		const auto stbl = FindMP4Box( *source, *mdia, { "minf", "stbl" } );
+		const auto stsd = stbl ? FindMP4Box( *source, *stbl, "stsd" ) : std::nullopt;
+		if ( !stsd || ( stsd->Size < 8 ) ) {
+			return std::nullopt;
+		}
+		const MP4Box entries = { stsd->Offset + 8, stsd->Size - 8 };
+		if ( const auto mp4a = FindMP4Box( *source, entries, "mp4a" ); mp4a && ( mp4a->Size >= 28 ) ) {
+			const auto sampleEntry = source->GetSpan( mp4a->Offset, 28 );
+			if ( 28 != sampleEntry.size() ) {
+				return std::nullopt;
+			}
+			// QuickTime sound sample description versions 1 & 2 have additional fields.
+			const uint16_t version = ReadBE16( sampleEntry.data() + 8 );
+			const uint64_t entrySize = 28 + ( ( 1 == version ) ? 16 : ( ( 2 == version ) ? 36 : 0 ) );
+			if ( ( version > 2 ) || ( mp4a->Size < entrySize ) ) {
+				return std::nullopt;
+			}
+			info.BitsPerSample = ReadBE16( sampleEntry.data() + 18 );
+			const auto esds = FindMP4Box( *source, { mp4a->Offset + entrySize, mp4a->Size - entrySize }, "esds" );
+			if ( !esds || !ReadAACConfig( source->GetSpan( esds->Offset, static_cast<size_t>( std::min<uint64_t>( esds->Size, 256 ) ) ), info.SampleRate, info.Channels ) ) {
+				return std::nullopt;
+			}
+		} else if ( const auto alac = FindMP4Box( *source, entries, "alac" ); alac && ( alac->Size >= 28 ) ) {
+			// The ALAC specific config box follows the audio sample entry.
+			const auto config = FindMP4Box( *source, { alac->Offset + 28, alac->Size - 28 }, "alac" );
+			const auto specificConfig = config ? source->GetSpan( config->Offset, 28 ) : std::span<const uint8_t>();
+			if ( 28 != specificConfig.size() ) {
+				return std::nullopt;
+			}
+			info.BitsPerSample = specificConfig[ 9 ];
+			info.Channels = specificConfig[ 13 ];
+			info.SampleRate = static_cast<long>( ReadBE32( specificConfig.data() + 24 ) );
+		} else {
+			return std::nullopt;
+		}
+
+		// Calculate the bitrate from the total size of the samples.
+		if ( const auto stsz = FindMP4Box( *source, *stbl, "stsz" ); stsz && ( stsz->Size >= 12 ) ) {
+			if ( const auto sizes = source->GetSpan( stsz->Offset, 12 ); 12 == sizes.size() ) {
+				const uint32_t sampleSize = ReadBE32( sizes.data() + 4 );
+				const uint32_t sampleCount = ReadBE32( sizes.data() + 8 );
+				uint64_t totalSize = 0;
+				if ( 0 != sampleSize ) {
+					totalSize = static_cast<uint64_t>( sampleSize ) * sampleCount;
+				} else if ( sampleCount <= kMaxMP4SampleSizes ) {
+					const auto table = source->GetSpan( stsz->Offset + 12, static_cast<size_t>( sampleCount ) * 4 );
+					for ( size_t offset = 0; ( offset + 4 ) <= table.size(); offset += 4 ) {
+						totalSize += ReadBE32( table.data() + offset );
+					}
+				}
+				if ( totalSize > 0 ) {
+					info.Bitrate = static_cast<float>( totalSize * 8 ) / ( info.Duration * 1000 );
+				}
+			}
+		}
+		return Validate( info );
+	}
+	return std::nullopt;
+}
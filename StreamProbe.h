@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FileSource.h"
+
+#include <optional>
+#include <string>
+
+// Reads stream properties by parsing container headers only, as a lightweight alternative to opening a decoder.
+// Each probe returns nullopt if the file is not of the expected format, or if its properties cannot be reliably determined from the headers,
+// in which case a decoder should be opened instead.
+class StreamProbe
+{
+public:
+	// Stream properties.
+	struct Info {
+		// Sample rate, in Hz.
+		long SampleRate = 0;
+
+		// Channel count.
+		long Channels = 0;
+
+		// Bits per sample, if applicable.
+		std::optional<long> BitsPerSample;
+
+		// Duration, in seconds.
+		float Duration = 0;
+
+		// Bitrate, in kbps.
+		std::optional<float> Bitrate;
+	};
+
+	// Probes a FLAC file.
+	static std::optional<Info> ProbeFLAC( const std::wstring& filename );
+
+	// Probes an Ogg Opus file (consisting of a single logical stream).
+	static std::optional<Info> ProbeOpus( const std::wstring& filename );
+
+	// Probes a WavPack file.
+	static std::optional<Info> ProbeWavPack( const std::wstring& filename );
+
+	// Probes a RIFF WAVE file containing PCM or floating point data.
+	static std::optional<Info> ProbeRIFF( const std::wstring& filename );
+
+	// Probes an MP4 file containing an AAC-LC or ALAC audio track.
+	static std::optional<Info> ProbeMP4( const std::wstring& filename );
+
+	// Returns the file offset of the first audio frame in a FLAC 'source', or nullopt if the metadata blocks could not be read.
+	static std::optional<uint64_t> GetFLACAudioOffset( FileSource& source );
+
+private:
+	// Returns the 'info' if it is complete, otherwise nullopt.
+	static std::optional<Info> Validate( const Info& info );
+};
@@ -3,7 +3,6 @@
 #include "Utility.h"
 
 #include <bitset>
-#include <fstream>
 #include <functional>
 #include <regex>
 
@@ -57,9 +56,12 @@ constexpr uint32_t kCodePageISO8859_1 = 28591u;
 
 TagReader::TagReader( const std::filesystem::path& filepath )
 {
-	if ( !ParseID3v2Tag( filepath ) ) {
-		if ( !ParseAPETag( filepath ) ) {
-			ParseID3v1Tag( filepath );
+	// Tags are parsed directly from the file data, which is memory mapped where possible.
+	if ( const auto source = FileSource::Open( filepath ); source ) {
+		if ( !ParseID3v2Tag( *source ) ) {
+			if ( !ParseAPETag( *source ) ) {
+				ParseID3v1Tag( *source );
+			}
 		}
 	}
 }
@@ -77,32 +79,31 @@ std::optional<Tags> TagReader::GetTags() const
 	return std::make_optional( m_Tags );
 }
 
-bool TagReader::ParseID3v2Tag( const std::filesystem::path& filepath )
+std::span<const char> TagReader::GetFileData( FileSource& source, const uint64_t offset, const size_t size )
 {
-	if ( std::ifstream stream( filepath, std::ios::binary ); stream.good() ) {
-		stream.seekg( 0, std::ios::end );
-		const uint64_t filesize = stream.tellg();
-		stream.seekg( 0 );
-		if ( stream.good() ) {
-			std::vector<char> tag( kID3v2TagHeaderSize );
-			stream.read( tag.data(), kID3v2TagHeaderSize );
-			if ( stream.good() ) {
-				const auto tagSize = GetID3v2TagSize( tag.data() );
-				constexpr uint64_t kMaximumID3v2TagSize = 0x10000000;
-				if ( ( tagSize > kID3v2FrameHeaderSize ) && ( kID3v2TagHeaderSize + tagSize <= std::min( filesize, kMaximumID3v2TagSize ) ) ) {
-					tag.resize( kID3v2TagHeaderSize + tagSize );
-					stream.read( tag.data() + kID3v2TagHeaderSize, tagSize );
-					if ( stream.good() ) {
-						return ParseID3v2Tag( tag );
-					}
-				}
+	const auto data = source.GetSpan( offset, size );
+	if ( data.size() != size )
+		return {};
+
+	return { reinterpret_cast<const char*>( data.data() ), data.size() };
+}
+
+bool TagReader::ParseID3v2Tag( FileSource& source )
+{
+	const uint64_t filesize = source.GetSize();
+	if ( const auto header = GetFileData( source, 0, kID3v2TagHeaderSize ); !header.empty() ) {
+		const auto tagSize = GetID3v2TagSize( header.data() );
+		constexpr uint64_t kMaximumID3v2TagSize = 0x10000000;
+		if ( ( tagSize > kID3v2FrameHeaderSize ) && ( kID3v2TagHeaderSize + tagSize <= std::min( filesize, kMaximumID3v2TagSize ) ) ) {
+			if ( const auto tag = GetFileData( source, 0, kID3v2TagHeaderSize + tagSize ); !tag.empty() ) {
+				return ParseID3v2Tag( tag );
 			}
 		}
 	}
 	return false;
 }
 
-bool TagReader::ParseID3v2Tag( const std::vector<char>& tag )
+bool TagReader::ParseID3v2Tag( const std::span<const char> tag )
 {
 	if ( tag.size() < kID3v2TagHeaderSize )
 		return false;
@@ -309,7 +310,7 @@ std::string TagReader::GetID3v2Genre( const std::string& contentType )
 	return value;
 }
 
-bool TagReader::ParseAPETag( const std::filesystem::path& filepath )
+bool TagReader::ParseAPETag( FileSource& source )
 {
 	struct Footer {
 		std::array<char, 8>   magic = {};
@@ -327,40 +328,33 @@ bool TagReader::ParseAPETag( const std::filesystem::path& filepath )
 			( footer.item_count > 0 );		
 	};
 
-	std::function<bool(std::ifstream& stream, Footer& footer, std::vector<char>& tag)> readAPETag = [isValidFooter](std::ifstream& stream, Footer& footer, std::vector<char>& tag) {
-		if ( !stream.good() )
-			return false;
-		
+	std::function<bool(FileSource& source, const uint64_t footerOffset, Footer& footer, std::span<const char>& tag)> readAPETag = [isValidFooter](FileSource& source, const uint64_t footerOffset, Footer& footer, std::span<const char>& tag) {
 		constexpr uint64_t kMaximumApeTagSize = 0x10000000;
-		stream.read( reinterpret_cast<char*>( &footer ), sizeof( Footer ) );
-		if ( stream.good() && isValidFooter( footer ) && ( footer.tag_size <= std::min( static_cast<uint64_t>( stream.tellg() ), kMaximumApeTagSize ) ) ) {
-			tag.resize( footer.tag_size - sizeof( Footer ) );
-			stream.seekg( 0ll - footer.tag_size, std::ios::cur );
-			stream.read( tag.data(), tag.size() );
-			return stream.good();
+		if ( const auto data = GetFileData( source, footerOffset, sizeof( Footer ) ); !data.empty() ) {
+			std::copy( data.begin(), data.end(), reinterpret_cast<char*>( &footer ) );
+			const uint64_t footerEnd = footerOffset + sizeof( Footer );
+			if ( isValidFooter( footer ) && ( footer.tag_size <= std::min( footerEnd, kMaximumApeTagSize ) ) ) {
+				tag = GetFileData( source, footerEnd - footer.tag_size, footer.tag_size - sizeof( Footer ) );
+				return !tag.empty();
+			}
 		}
 
 		return false;
 	};
 
-	std::ifstream stream( filepath, std::ios::binary );
-	if ( !stream.good() )
+	const uint64_t filesize = source.GetSize();
+	if ( filesize < sizeof( Footer ) )
 		return false;
 
 	Footer footer;
-	std::vector<char> apeTag;
+	std::span<const char> apeTag;
 
 	// Search for a footer at the end of the file.
-	stream.seekg( 0ll - sizeof( Footer ), std::ios::end );
-	bool validApeTag = readAPETag( stream, footer, apeTag );
-	if ( !validApeTag ) {
+	bool validApeTag = readAPETag( source, filesize - sizeof( Footer ), footer, apeTag );
+	if ( !validApeTag && ( filesize >= kID3v1TagSize + sizeof( Footer ) ) ) {
 		// Search for a footer immediately preceding an ID3v1 tag.
-		std::array<char, 3> id3TagHeader = {};
-		stream.seekg( 0ll - kID3v1TagSize, std::ios::end );
-		stream.read( id3TagHeader.data(), id3TagHeader.size() );
-		if ( "TAG" == std::string( id3TagHeader.data(), 3 ) ) {
-			stream.seekg( 0ll - kID3v1TagSize - static_cast<int32_t>( sizeof( Footer ) ), std::ios::end );
-			validApeTag = readAPETag( stream, footer, apeTag );
+		if ( const auto id3TagHeader = GetFileData( source, filesize - kID3v1TagSize, 3 ); ( 3 == id3TagHeader.size() ) && ( "TAG" == std::string( id3TagHeader.data(), 3 ) ) ) {
+			validApeTag = readAPETag( source, filesize - kID3v1TagSize - sizeof( Footer ), footer, apeTag );
 		}
 	}
 
@@ -400,16 +394,13 @@ bool TagReader::ParseAPETag( const std::filesystem::path& filepath )
 	return !m_Tags.empty();
 }
 
-bool TagReader::ParseID3v1Tag( const std::filesystem::path& filepath )
+bool TagReader::ParseID3v1Tag( FileSource& source )
 {
-	std::ifstream stream( filepath, std::ios::binary );
-	if ( !stream.good() )
+	if ( source.GetSize() < kID3v1TagSize )
 		return false;
 
-	std::vector<char> tag( kID3v1TagSize );
-	stream.seekg( 0ll - kID3v1TagSize, std::ios::end );
-	stream.read( tag.data(), tag.size() );
-	if ( stream.good() && ( "TAG" == std::string( tag.data(), 3 ) ) ) {
+	const auto tag = GetFileData( source, source.GetSize() - kID3v1TagSize, kID3v1TagSize );
+	if ( !tag.empty() && ( "TAG" == std::string( tag.data(), 3 ) ) ) {
 		constexpr std::pair<uint32_t, uint32_t> kTitleTag = { 3, 30 };
 		constexpr std::pair<uint32_t, uint32_t> kArtistTag = { kTitleTag.first + kTitleTag.second, 30 };
 		constexpr std::pair<uint32_t, uint32_t> kAlbumTag = { kArtistTag.first + kArtistTag.second, 30 };
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "FileSource.h"
 #include "Tag.h"
 
 #include <array>
+#include <span>
 
 // ID3 and APE tag reader
 class TagReader
@@ -35,15 +37,18 @@ private:
 
 	// Parses an ID3v2.3 tag, returning whether any tags were read.
 	// https://id3.org/id3v2.3.0
-	bool ParseID3v2Tag( const std::filesystem::path& filepath );
-	bool ParseID3v2Tag( const std::vector<char>& id3v2Tag );
+	bool ParseID3v2Tag( FileSource& source );
+	bool ParseID3v2Tag( const std::span<const char> id3v2Tag );
 
 	// Parses an APE tag, returning whether any tags were read.
 	// https://wiki.hydrogenaudio.org/index.php?title=APEv2_specification
-	bool ParseAPETag( const std::filesystem::path& filepath );
+	bool ParseAPETag( FileSource& source );
 
 	// Parses an ID3v1 tag, returning whether any tags were read.
-	bool ParseID3v1Tag( const std::filesystem::path& filepath );
+	bool ParseID3v1Tag( FileSource& source );
+
+	// Returns a view of 'size' bytes at the 'offset' in the file 'source' (or an empty view if the file is too small).
+	static std::span<const char> GetFileData( FileSource& source, const uint64_t offset, const size_t size );
 
 	// Parsed tags.
 	Tags m_Tags;
@@ -7,6 +7,7 @@
 #include "DlgOptions.h"
 #include "DlgTrackInfo.h"
 
+#include "Metrics.h"
 #include "Utility.h"
 
 #include <dbt.h>
@@ -44,6 +45,9 @@ static const UINT MSG_PLAYLISTMENUEND = MSG_PLAYLISTMENUSTART + 50;
 // Online documentation location.
 static const wchar_t s_OnlineDocs[] = L"https://github.com/jfchapman/vuplayer/wiki";
 
+// Last folder setting for saving playback diagnostics.
+static const std::string s_DiagnosticsFolderSetting = "Diagnostics";
+
 // Database filename.
 #ifdef _DEBUG
 static const wchar_t s_Database[] = L"VUPlayerDebug.db";
@@ -57,7 +61,7 @@ VUPlayer* VUPlayer::Get()
 }
 
 VUPlayer::VUPlayer( const HINSTANCE instance, const HWND hwnd, const std::list<std::wstring>& startupFilenames,
-	const bool portable, const Database::Mode databaseMode ) :
+	const bool portable, const Database::Mode databaseMode, const std::optional<NullSink::Options>& nullOutput ) :
 	m_hInst( instance ),
 	m_hWnd( hwnd ),
 	m_hAccel( LoadAccelerators( m_hInst, MAKEINTRESOURCE( IDC_VUPLAYER ) ) ),
@@ -67,7 +71,7 @@ VUPlayer::VUPlayer( const HINSTANCE instance, const HWND hwnd, const std::list<s
 	m_Library( m_Database, m_Handlers ),
 	m_Maintainer( m_hInst, m_Library, m_Handlers ),
 	m_Settings( m_Database, m_Library ),
-	m_Output( m_hInst, m_hWnd, m_Handlers, m_Settings ),
+	m_Output( m_hInst, m_hWnd, m_Handlers, m_Settings, nullOutput ),
 	m_GainCalculator( m_Library, m_Handlers ),
 	m_Scrobbler( m_Database, m_Settings ),
 	m_MusicBrainz( m_hInst, m_hWnd ),
@@ -1209,6 +1213,10 @@ void VUPlayer::OnCommand( const int commandID )
 			ShellExecute( NULL, L"open", s_OnlineDocs, NULL, NULL, SW_SHOWNORMAL );
 			break;
 		}
+		case ID_HELP_SAVEDIAGNOSTICS: {
+			OnSaveDiagnostics();
+			break;
+		}
 		case ID_TOOLBAR_FILE:
 		case ID_TOOLBAR_PLAYLIST:
 		case ID_TOOLBAR_FAVOURITES:
@@ -1899,6 +1907,60 @@ void VUPlayer::OnConvert()
 	}
 }
 
+void VUPlayer::OnSaveDiagnostics()
+{
+	WCHAR title[ MAX_PATH ] = {};
+	LoadString( m_hInst, IDS_DIAGNOSTICS_TITLE, title, MAX_PATH );
+
+	WCHAR filter[ MAX_PATH ] = {};
+	LoadString( m_hInst, IDS_DIAGNOSTICS_FILTERJSON, filter, MAX_PATH );
+	const std::wstring filter1( filter );
+	const std::wstring filter2( L"*.json" );
+	LoadString( m_hInst, IDS_DIAGNOSTICS_FILTERCSV, filter, MAX_PATH );
+	const std::wstring filter3( filter );
+	const std::wstring filter4( L"*.csv" );
+	std::vector<WCHAR> filterStr;
+	filterStr.reserve( MAX_PATH );
+	filterStr.insert( filterStr.end(), filter1.begin(), filter1.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter2.begin(), filter2.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter3.begin(), filter3.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter4.begin(), filter4.end() );
+	filterStr.push_back( 0 );
+	filterStr.push_back( 0 );
+
+	WCHAR buffer[ MAX_PATH ] = L"VUPlayerDiagnostics";
+	const std::wstring initialFolder = m_Settings.GetLastFolder( s_DiagnosticsFolderSetting );
+
+	OPENFILENAME ofn = {};
+	ofn.lStructSize = sizeof( OPENFILENAME );
+	ofn.hwndOwner = m_hWnd;
+	ofn.lpstrTitle = title;
+	ofn.lpstrFilter = &filterStr[ 0 ];
+	ofn.nFilterIndex = 1;
+	ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST | OFN_EXPLORER;
+	ofn.lpstrFile = buffer;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.lpstrInitialDir = initialFolder.empty() ? nullptr : initialFolder.c_str();
+	if ( FALSE != GetSaveFileName( &ofn ) ) {
+		const std::wstring fileExt = ( 2 == ofn.nFilterIndex ) ? L"csv" : L"json";
+		std::wstring filename = ofn.lpstrFile;
+		m_Settings.SetLastFolder( s_DiagnosticsFolderSetting, filename.substr( 0, ofn.nFileOffset ) );
+		if ( !filename.empty() ) {
+			if ( GetFileExtension( filename ) != fileExt ) {
+				filename += L"." + fileExt;
+			}
+			if ( L"csv" == fileExt ) {
+				Metrics::WriteCSV( filename );
+			} else {
+				Metrics::WriteJSON( filename );
+			}
+		}
+	}
+}
+
 bool VUPlayer::IsScrobblerAvailable()
 {
 	const bool available = m_Scrobbler.IsAvailable();
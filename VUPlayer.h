@@ -86,8 +86,9 @@ public:
 	// 'startupFilenames' - tracks to play (or the playlist to open) on startup.
 	// 'portable' - whether to run in 'portable' mode (i.e. no persistent metadata).
 	// 'databaseMode' - database access mode.
+	// 'nullOutput' - null sink options, to play without an audio device.
 	VUPlayer( const HINSTANCE instance, const HWND hwnd, const std::list<std::wstring>& startupFilenames,
-		const bool portable, const Database::Mode databaseMode );
+		const bool portable, const Database::Mode databaseMode, const std::optional<NullSink::Options>& nullOutput );
 
 	virtual ~VUPlayer();
 
@@ -269,6 +270,9 @@ private:
 	// Called when the convert tracks command is received.
 	void OnConvert();
 
+	// Called when the save playback diagnostics command is received.
+	void OnSaveDiagnostics();
+
 	// Loads the default artwork, defined in the application settings, and returns a bitmap.
 	// Returns null if the artwork was not loaded.
 	std::unique_ptr<Gdiplus::Bitmap> LoadDefaultArtwork();
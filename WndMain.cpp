@@ -1,10 +1,22 @@
 #include "stdafx.h"
 
+#include "DecoderBenchmark.h"
+#include "EqualiserBenchmark.h"
+#include "FFTBenchmark.h"
+#include "LibraryBenchmark.h"
+#include "PreBufferBenchmark.h"
+#include "ProbeBenchmark.h"
+#include "SampleConversionBenchmark.h"
+#include "SampleMixerBenchmark.h"
+#include "ScanBenchmark.h"
 #include "Utility.h"
 #include "VUPlayer.h"
 
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #define MAX_LOADSTRING 100
 
@@ -33,6 +45,74 @@ static const TCHAR s_portableCmdLineSwitch[] = L"-portable";
 // Command line switch to set the database access mode.
 static const TCHAR s_databasemodeCmdLineSwitch[] = L"-mode";
 
+// Command line switch to play without an audio device (followed by 'fast' or 'realtime' pacing).
+static const TCHAR s_nullOutputCmdLineSwitch[] = L"-nulloutput";
+
+// Command line switch to write the output to a wave file when playing without an audio device (followed by the file name, without the file extension).
+static const TCHAR s_nullOutputFileCmdLineSwitch[] = L"-nulloutputfile";
+
+// Headless benchmark, which is run instead of starting the application.
+struct BenchmarkSwitch {
+	// Command line switch to run the benchmark.
+	LPCWSTR Switch;
+
+	// Number of arguments following the command line switch.
+	int ArgumentCount;
+
+	// Runs the benchmark with the 'args' following the command line switch, returning the process exit code (non-zero if the benchmark or its correctness check failed).
+	int ( *Run )( const std::vector<std::wstring>& args );
+};
+
+// Command line switches to run each benchmark (the final argument of each is the results filename).
+static const std::array<BenchmarkSwitch, 9> s_benchmarkCmdLineSwitches = { {
+	// Decoder benchmark (followed by the corpus folder & the results filename).
+	{ L"-benchmark", 2, [] ( const std::vector<std::wstring>& args ) {
+		const Handlers handlers;
+		const DecoderBenchmark decoderBenchmark( handlers );
+		return DecoderBenchmark::WriteResults( decoderBenchmark.Run( args[ 0 ] ), args[ 1 ] ) ? 0 : 1;
+	} },
+
+	// FFT correctness check & benchmark.
+	{ L"-fftbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return FFTBenchmark::WriteResults( FFTBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Equaliser correctness check & benchmark.
+	{ L"-eqbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return EqualiserBenchmark::WriteResults( EqualiserBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Output mixer correctness check & benchmark.
+	{ L"-mixerbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return SampleMixerBenchmark::WriteResults( SampleMixerBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Sample conversion correctness check & benchmark.
+	{ L"-conversionbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return SampleConversionBenchmark::WriteResults( SampleConversionBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Media library benchmark.
+	{ L"-librarybenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return LibraryBenchmark::WriteResults( LibraryBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Library scan benchmark.
+	{ L"-scanbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return ScanBenchmark::WriteResults( ScanBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Stream probe correctness check & scan throughput benchmark.
+	{ L"-probebenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return ProbeBenchmark::WriteResults( ProbeBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} },
+
+	// Pre-buffer stress test & benchmark.
+	{ L"-prebufferbenchmark", 1, [] ( const std::vector<std::wstring>& args ) {
+		return PreBufferBenchmark::WriteResults( PreBufferBenchmark::Run(), args[ 0 ] ) ? 0 : 1;
+	} }
+} };
+
 // Makes a basic check to see whether a command line entry represents Audio CD autoplay.
 // Returns the Audio CD path to autoplay, or an empty string otherwise.
 std::wstring AutoplayAudioCD( LPCWSTR cmdLineEntry )
@@ -66,6 +146,8 @@ int APIENTRY wWinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstanc
 	std::list<std::wstring> cmdLineFiles;
 	bool portable = false;
 	Database::Mode mode = Database::Mode::Disk;
+	std::optional<NullSink::Options> nullOutput;
+	std::optional<std::pair<const BenchmarkSwitch*, std::vector<std::wstring> /*args*/>> benchmark;
 
 	int numArgs = 0;
 	LPWSTR* args = CommandLineToArgvW( GetCommandLine(), &numArgs );
@@ -86,6 +168,36 @@ int APIENTRY wWinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstanc
 					} catch ( const std::logic_error& ) {
 					}
 				}
+			} else if ( 0 == _wcsicmp( args[ argc ], s_nullOutputCmdLineSwitch ) ) {
+				// Handle the '-nulloutput' command-line switch (and the following pacing argument).
+				if ( !nullOutput ) {
+					nullOutput = NullSink::Options();
+				}
+				if ( ( argc + 1 ) < numArgs ) {
+					if ( 0 == _wcsicmp( args[ argc + 1 ], L"realtime" ) ) {
+						nullOutput->Realtime = true;
+						++argc;
+					} else if ( 0 == _wcsicmp( args[ argc + 1 ], L"fast" ) ) {
+						nullOutput->Realtime = false;
+						++argc;
+					}
+				}
+			} else if ( 0 == _wcsicmp( args[ argc ], s_nullOutputFileCmdLineSwitch ) ) {
+				// Handle the '-nulloutputfile' command-line switch (and the following file name argument).
+				if ( ( argc + 1 ) < numArgs ) {
+					if ( !nullOutput ) {
+						nullOutput = NullSink::Options();
+					}
+					nullOutput->Filename = args[ argc + 1 ];
+					++argc;
+				}
+			} else if ( const auto benchmarkSwitch = std::find_if( s_benchmarkCmdLineSwitches.begin(), s_benchmarkCmdLineSwitches.end(),
+				[ arg = args[ argc ] ] ( const BenchmarkSwitch& entry ) { return 0 == _wcsicmp( arg, entry.Switch ); } ); s_benchmarkCmdLineSwitches.end() != benchmarkSwitch ) {
+				// Handle a benchmark command-line switch (and the following arguments).
+				if ( ( argc + benchmarkSwitch->ArgumentCount ) < numArgs ) {
+					benchmark = std::make_pair( &*benchmarkSwitch, std::vector<std::wstring>( args + argc + 1, args + argc + 1 + benchmarkSwitch->ArgumentCount ) );
+					argc += benchmarkSwitch->ArgumentCount;
+				}
 			} else {
 				const DWORD attributes = GetFileAttributes( args[ argc ] );
 				if ( ( INVALID_FILE_ATTRIBUTES != attributes ) && !( FILE_ATTRIBUTE_DIRECTORY & attributes ) ) {
@@ -105,6 +217,11 @@ int APIENTRY wWinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstanc
 		LocalFree( args );
 	}
 
+	if ( benchmark ) {
+		// Run the benchmark headless, and exit.
+		return benchmark->first->Run( benchmark->second );
+	}
+
 	// Limit application to a single instance
 	const HANDLE hMutex = CreateMutex( NULL /*attributes*/, FALSE /*initialOwner*/, g_szWindowClass );
 	if ( ( NULL != hMutex ) && ( ERROR_ALREADY_EXISTS == GetLastError() ) ) {
@@ -156,7 +273,7 @@ int APIENTRY wWinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstanc
 
 	SetErrorMode( SEM_FAILCRITICALERRORS );
 
-	VUPlayer* vuplayer = new VUPlayer( g_hInst, g_hWnd, cmdLineFiles, portable, mode );
+	VUPlayer* vuplayer = new VUPlayer( g_hInst, g_hWnd, cmdLineFiles, portable, mode, nullOutput );
 
 	SetWindowLongPtr( g_hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>( vuplayer ) );
 	MSG msg;